@@ -0,0 +1,184 @@
+#include "bench_harness.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <new>
+#include <thread>
+#include <sys/utsname.h>
+
+#ifndef XIAOZHI_VERSION
+#define XIAOZHI_VERSION "unknown"
+#endif
+
+namespace xiaozhi {
+namespace bench {
+
+std::atomic<uint64_t> g_allocation_count{0};
+
+LatencySummary summarizeLatencies(std::vector<double> samples_ms) {
+    LatencySummary summary;
+    summary.count = samples_ms.size();
+    if (samples_ms.empty()) {
+        return summary;
+    }
+
+    std::sort(samples_ms.begin(), samples_ms.end());
+    auto percentile = [&samples_ms](double p) {
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * samples_ms.size()));
+        return samples_ms[std::min(samples_ms.size(), std::max<size_t>(rank, 1)) - 1];
+    };
+
+    double total = 0.0;
+    for (double value : samples_ms) {
+        total += value;
+    }
+    summary.min = samples_ms.front();
+    summary.max = samples_ms.back();
+    summary.mean = total / samples_ms.size();
+    summary.p50 = percentile(50);
+    summary.p95 = percentile(95);
+    summary.p99 = percentile(99);
+    return summary;
+}
+
+BenchRunner::BenchRunner(const BenchOptions& options) : options_(options) {
+}
+
+void BenchRunner::run(const std::string& name, double frame_ms, const std::function<void()>& body) {
+    if (!options_.filter.empty() && name.find(options_.filter) == std::string::npos) {
+        return;
+    }
+
+    for (uint64_t i = 0; i < options_.warmup_iterations; ++i) {
+        body();
+    }
+
+    // 按批次运行直到达到最少运行时间，批次大小逐步翻倍以减少计时开销
+    uint64_t iterations = 0;
+    uint64_t batch = 1;
+    uint64_t allocations_before = g_allocation_count.load(std::memory_order_relaxed);
+    auto start = std::chrono::steady_clock::now();
+    auto min_time = std::chrono::duration<double, std::milli>(options_.min_time_ms);
+    std::chrono::steady_clock::duration elapsed{};
+
+    while (true) {
+        for (uint64_t i = 0; i < batch; ++i) {
+            body();
+        }
+        iterations += batch;
+        elapsed = std::chrono::steady_clock::now() - start;
+        if (elapsed >= min_time) {
+            break;
+        }
+        if (batch < 1024) {
+            batch *= 2;
+        }
+    }
+    uint64_t allocations = g_allocation_count.load(std::memory_order_relaxed) - allocations_before;
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.frame_ms = frame_ms;
+    result.ns_per_frame = std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+    result.realtime_factor = frame_ms > 0 ? result.ns_per_frame / (frame_ms * 1e6) : 0.0;
+    result.allocs_per_frame = static_cast<double>(allocations) / iterations;
+    results_.push_back(result);
+
+    std::cout << std::left << std::setw(36) << name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(1) << result.ns_per_frame
+              << std::setw(12) << std::setprecision(5) << result.realtime_factor
+              << std::setw(10) << std::setprecision(2) << result.allocs_per_frame
+              << std::setw(12) << iterations << std::endl;
+}
+
+void BenchRunner::printTable() const {
+    std::cout << std::left << std::setw(36) << "benchmark" << std::right
+              << std::setw(14) << "ns/frame"
+              << std::setw(12) << "rtf"
+              << std::setw(10) << "allocs"
+              << std::setw(12) << "iterations" << std::endl;
+    std::cout << std::string(84, '-') << std::endl;
+}
+
+bool BenchRunner::writeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[xiaozhi-bench] 错误: 无法写入 " << path << std::endl;
+        return false;
+    }
+
+    struct utsname host {};
+    uname(&host);
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    out << "{\n";
+    out << "  \"version\": \"" << XIAOZHI_VERSION << "\",\n";
+    out << "  \"timestamp\": \"" << timestamp << "\",\n";
+    out << "  \"machine\": \"" << host.machine << "\",\n";
+    out << "  \"cpus\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "  \"results\": [\n";
+    for (size_t i = 0; i < results_.size(); ++i) {
+        const BenchResult& r = results_[i];
+        out << "    {\"name\": \"" << r.name << "\""
+            << ", \"frame_ms\": " << r.frame_ms
+            << ", \"iterations\": " << r.iterations
+            << std::fixed
+            << ", \"ns_per_frame\": " << std::setprecision(1) << r.ns_per_frame
+            << ", \"realtime_factor\": " << std::setprecision(6) << r.realtime_factor
+            << ", \"allocs_per_frame\": " << std::setprecision(3) << r.allocs_per_frame
+            << std::defaultfloat << "}"
+            << (i + 1 < results_.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return out.good();
+}
+
+} // namespace bench
+} // namespace xiaozhi
+
+// 替换全局分配函数以统计每帧堆分配次数，其余行为与默认实现一致
+void* operator new(std::size_t size) {
+    xiaozhi::bench::g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    xiaozhi::bench::g_allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
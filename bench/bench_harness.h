@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+
+namespace xiaozhi {
+namespace bench {
+
+// 全局operator new调用次数，由bench_harness.cpp中的替换版本累加
+extern std::atomic<uint64_t> g_allocation_count;
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations = 0;
+    double frame_ms = 0.0;          // 每次迭代处理的音频时长
+    double ns_per_frame = 0.0;
+    double realtime_factor = 0.0;   // 处理耗时 / 音频时长，越小越好，>=1表示跟不上实时
+    double allocs_per_frame = 0.0;
+};
+
+struct BenchOptions {
+    std::string filter;              // 只运行名称包含该子串的用例
+    double min_time_ms = 500.0;      // 每个用例最少运行时间
+    uint64_t warmup_iterations = 16;
+};
+
+// 自包含的基准运行器：每个用例反复执行body（处理一帧），
+// 统计每帧耗时、实时因子和每帧堆分配次数
+class BenchRunner {
+public:
+    explicit BenchRunner(const BenchOptions& options);
+
+    void run(const std::string& name, double frame_ms, const std::function<void()>& body);
+
+    const std::vector<BenchResult>& getResults() const { return results_; }
+
+    void printTable() const;
+
+    // 输出便于跨版本diff的JSON，每个用例一行
+    bool writeJson(const std::string& path) const;
+
+private:
+    BenchOptions options_;
+    std::vector<BenchResult> results_;
+};
+
+// 延迟分布统计（毫秒），百分位按最近秩法计算
+struct LatencySummary {
+    size_t count = 0;
+    double min = 0.0;
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p95 = 0.0;
+    double p99 = 0.0;
+    double max = 0.0;
+};
+
+LatencySummary summarizeLatencies(std::vector<double> samples_ms);
+
+// 防止编译器把结果未被使用的计算优化掉
+template <typename T>
+inline void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+} // namespace bench
+} // namespace xiaozhi
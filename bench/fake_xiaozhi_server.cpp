@@ -0,0 +1,293 @@
+#include "fake_xiaozhi_server.h"
+#include <iostream>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+
+namespace xiaozhi {
+namespace bench {
+
+FakeXiaozhiServer::FakeXiaozhiServer(const FakeServerConfig& config)
+    : config_(config), listen_fd_(-1), client_fd_(-1), port_(0),
+      audio_packets_received_(0), tts_next_index_(-1), tts_pending_start_(false) {
+}
+
+FakeXiaozhiServer::~FakeXiaozhiServer() {
+    stop();
+}
+
+bool FakeXiaozhiServer::start() {
+    prepareTts();
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 1) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        std::cerr << "[FakeXiaozhiServer] 错误: 无法监听本地端口" << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+
+    running_ = true;
+    server_thread_ = std::thread(&FakeXiaozhiServer::serverLoop, this);
+    std::cout << "[FakeXiaozhiServer] 本地服务器已启动: " << getUrl() << std::endl;
+    return true;
+}
+
+void FakeXiaozhiServer::stop() {
+    running_ = false;
+    if (server_thread_.joinable()) {
+        server_thread_.join();
+    }
+    if (client_fd_ >= 0) {
+        close(client_fd_);
+        client_fd_ = -1;
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+}
+
+std::string FakeXiaozhiServer::getUrl() const {
+    return "ws://127.0.0.1:" + std::to_string(port_) + "/xiaozhi/v1/";
+}
+
+void FakeXiaozhiServer::setAudioReceivedCallback(
+    std::function<void(uint64_t, std::chrono::steady_clock::time_point)> callback) {
+    audio_received_callback_ = callback;
+}
+
+void FakeXiaozhiServer::serverLoop() {
+    uint8_t buffer[16384];
+    WsFrame frame;
+
+    while (running_) {
+        if (client_fd_ < 0) {
+            acceptClient();
+            continue;
+        }
+
+        // 正在下发TTS时按下一包的发送时间计算等待超时
+        int timeout_ms = 100;
+        if (tts_pending_start_ || tts_next_index_ >= 0) {
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                next_tts_time_ - std::chrono::steady_clock::now()).count();
+            timeout_ms = static_cast<int>(std::max<long long>(0, std::min<long long>(wait, 100)));
+        }
+
+        pollfd pfd{client_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) > 0) {
+            ssize_t n = recv(client_fd_, buffer, sizeof(buffer), 0);
+            if (n <= 0) {
+                std::cout << "[FakeXiaozhiServer] 客户端已断开" << std::endl;
+                close(client_fd_);
+                client_fd_ = -1;
+                continue;
+            }
+
+            auto arrival = std::chrono::steady_clock::now();
+            codec_.feed(buffer, static_cast<size_t>(n));
+            while (codec_.next(frame)) {
+                if (frame.opcode == WsOpcode::BINARY && audio_received_callback_) {
+                    audio_received_callback_(audio_packets_received_, arrival);
+                }
+                handleFrame(frame);
+            }
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        if (tts_pending_start_ && now >= next_tts_time_) {
+            tts_pending_start_ = false;
+            sendText(protocol_.handleWebSocketMessage("{\"type\":\"stt\"}"));
+            sendText("{\"type\":\"tts\",\"state\":\"start\"}");
+            tts_next_index_ = 0;
+            next_tts_time_ = now;
+        }
+
+        while (tts_next_index_ >= 0 && now >= next_tts_time_) {
+            const auto& packet = tts_packets_[tts_next_index_];
+            sendFrame(WsOpcode::BINARY, packet.data(), packet.size());
+            next_tts_time_ += std::chrono::milliseconds(config_.tts_frame_ms);
+            if (++tts_next_index_ >= static_cast<int>(tts_packets_.size())) {
+                tts_next_index_ = -1;
+                sendText("{\"type\":\"tts\",\"state\":\"stop\"}");
+            }
+        }
+    }
+}
+
+bool FakeXiaozhiServer::acceptClient() {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    if (poll(&pfd, 1, 100) <= 0) {
+        return false;
+    }
+
+    client_fd_ = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+    if (client_fd_ < 0) {
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(client_fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    codec_.reset();
+    audio_packets_received_ = 0;
+    tts_next_index_ = -1;
+    tts_pending_start_ = false;
+
+    if (!readHandshake()) {
+        close(client_fd_);
+        client_fd_ = -1;
+        return false;
+    }
+    return true;
+}
+
+bool FakeXiaozhiServer::readHandshake() {
+    std::string request;
+    char buffer[1024];
+    size_t header_end = std::string::npos;
+    while (header_end == std::string::npos) {
+        pollfd pfd{client_fd_, POLLIN, 0};
+        if (poll(&pfd, 1, 2000) <= 0) {
+            return false;
+        }
+        ssize_t n = recv(client_fd_, buffer, sizeof(buffer), 0);
+        if (n <= 0 || request.size() > 16384) {
+            return false;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+        header_end = request.find("\r\n\r\n");
+    }
+
+    std::string lower = request.substr(0, header_end);
+    std::transform(lower.begin(), lower.end(), lower.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    size_t key_pos = lower.find("sec-websocket-key:");
+    if (key_pos == std::string::npos) {
+        return false;
+    }
+    size_t value_start = request.find_first_not_of(" \t", key_pos + 18);
+    size_t value_end = request.find("\r\n", value_start);
+    std::string key = request.substr(value_start, value_end - value_start);
+
+    std::string response = "HTTP/1.1 101 Switching Protocols\r\n"
+                           "Upgrade: websocket\r\n"
+                           "Connection: Upgrade\r\n"
+                           "Sec-WebSocket-Accept: " + WebsocketFrameCodec::computeAcceptKey(key) + "\r\n\r\n";
+    if (send(client_fd_, response.data(), response.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(response.size())) {
+        return false;
+    }
+
+    if (request.size() > header_end + 4) {
+        codec_.feed(reinterpret_cast<const uint8_t*>(request.data()) + header_end + 4,
+                    request.size() - header_end - 4);
+    }
+    return true;
+}
+
+void FakeXiaozhiServer::handleFrame(const WsFrame& frame) {
+    switch (frame.opcode) {
+        case WsOpcode::TEXT:
+            handleText(std::string(frame.payload.begin(), frame.payload.end()));
+            break;
+        case WsOpcode::BINARY:
+            ++audio_packets_received_;
+            break;
+        case WsOpcode::PING:
+            sendFrame(WsOpcode::PONG, frame.payload.data(), frame.payload.size());
+            break;
+        case WsOpcode::CLOSE:
+            sendFrame(WsOpcode::CLOSE, frame.payload.data(), frame.payload.size());
+            close(client_fd_);
+            client_fd_ = -1;
+            break;
+        default:
+            break;
+    }
+}
+
+void FakeXiaozhiServer::handleText(const std::string& message) {
+    std::string response = protocol_.handleWebSocketMessage(message);
+    sendText(response);
+
+    // 一轮上行语音结束，模拟识别与生成耗时后开始下发回复
+    if (response.find("\"status\":\"stopped\"") != std::string::npos) {
+        tts_pending_start_ = true;
+        next_tts_time_ = std::chrono::steady_clock::now() +
+                         std::chrono::milliseconds(config_.response_delay_ms);
+    }
+}
+
+bool FakeXiaozhiServer::sendFrame(WsOpcode opcode, const uint8_t* data, size_t length) {
+    if (client_fd_ < 0) {
+        return false;
+    }
+    send_buffer_.clear();
+    WebsocketFrameCodec::encode(opcode, data, length, false, send_buffer_);
+
+    size_t offset = 0;
+    while (offset < send_buffer_.size()) {
+        ssize_t n = send(client_fd_, send_buffer_.data() + offset, send_buffer_.size() - offset, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        offset += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool FakeXiaozhiServer::sendText(const std::string& message) {
+    return sendFrame(WsOpcode::TEXT, reinterpret_cast<const uint8_t*>(message.data()), message.size());
+}
+
+void FakeXiaozhiServer::prepareTts() {
+    tts_encoder_.initialize(config_.sample_rate, config_.channels, 32000);
+
+    // 合成带音节包络的滑音作为TTS内容，预先编码避免下发时占用CPU
+    size_t frame_samples = static_cast<size_t>(config_.sample_rate / 1000 * config_.tts_frame_ms) * config_.channels;
+    int frames = std::max(1, config_.tts_duration_ms / config_.tts_frame_ms);
+    AudioData pcm(frame_samples);
+    size_t t = 0;
+    tts_packets_.clear();
+    for (int f = 0; f < frames; ++f) {
+        for (size_t i = 0; i < frame_samples; i += config_.channels, ++t) {
+            double seconds = static_cast<double>(t) / config_.sample_rate;
+            double freq = 300.0 + 200.0 * std::sin(2 * M_PI * 0.5 * seconds);
+            double envelope = 0.6 + 0.4 * std::sin(2 * M_PI * 3.0 * seconds);
+            int16_t sample = static_cast<int16_t>(std::sin(2 * M_PI * freq * seconds) * envelope * 10000.0);
+            for (int c = 0; c < config_.channels; ++c) {
+                pcm[i + c] = sample;
+            }
+        }
+        tts_packets_.push_back(tts_encoder_.encode(pcm));
+    }
+}
+
+} // namespace bench
+} // namespace xiaozhi
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "network/protocol_handler.h"
+#include "network/websocket_frame.h"
+#include "audio/opus_encoder.h"
+
+namespace xiaozhi {
+namespace bench {
+
+struct FakeServerConfig {
+    int sample_rate = 16000;
+    int channels = 1;
+    int tts_frame_ms = 60;          // 下行TTS每包时长
+    int tts_duration_ms = 1000;     // 每轮回复的TTS总时长
+    int response_delay_ms = 0;      // 模拟ASR/LLM处理耗时
+};
+
+// 本地替身服务器：单连接WebSocket，按ProtocolHandler的hello/listen/stt/tts协议应答，
+// 收到listen停止后按实时节拍下发合成的TTS音频
+class FakeXiaozhiServer {
+public:
+    explicit FakeXiaozhiServer(const FakeServerConfig& config);
+    ~FakeXiaozhiServer();
+
+    // 监听127.0.0.1上的临时端口
+    bool start();
+    void stop();
+
+    std::string getUrl() const;
+
+    // 每收到一个上行音频包时在服务器线程中回调 (包序号, 到达时间)
+    void setAudioReceivedCallback(std::function<void(uint64_t, std::chrono::steady_clock::time_point)> callback);
+
+private:
+    void serverLoop();
+    bool acceptClient();
+    bool readHandshake();
+    void handleFrame(const WsFrame& frame);
+    void handleText(const std::string& message);
+    bool sendFrame(WsOpcode opcode, const uint8_t* data, size_t length);
+    bool sendText(const std::string& message);
+    void prepareTts();
+
+    FakeServerConfig config_;
+    ProtocolHandler protocol_;
+    OpusEncoder tts_encoder_;
+    std::vector<std::vector<uint8_t>> tts_packets_;
+
+    int listen_fd_;
+    int client_fd_;
+    int port_;
+    std::thread server_thread_;
+    std::atomic<bool> running_{false};
+
+    WebsocketFrameCodec codec_;
+    std::vector<uint8_t> send_buffer_;
+    uint64_t audio_packets_received_;
+    std::function<void(uint64_t, std::chrono::steady_clock::time_point)> audio_received_callback_;
+
+    // TTS下发进度：下一包的发送时间和剩余包数，-1表示未在下发
+    std::chrono::steady_clock::time_point next_tts_time_;
+    int tts_next_index_;
+    bool tts_pending_start_;
+};
+
+} // namespace bench
+} // namespace xiaozhi
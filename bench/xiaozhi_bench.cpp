@@ -0,0 +1,206 @@
+#include "bench_harness.h"
+#include "audio/opus_encoder.h"
+#include "audio/opus_decoder.h"
+#include "audio/audio_frame_pool.h"
+#include "audio/audio_mixer.h"
+#include "audio/drift_compensator.h"
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace xiaozhi;
+using namespace xiaozhi::bench;
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+constexpr int kChannels = 1;
+constexpr int kBitrate = 32000;
+
+// 生成确定性的类语音信号：基频与共振峰正弦叠加、音节包络和少量噪声
+AudioData makeSignal(size_t samples) {
+    AudioData signal(samples);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < samples; ++i) {
+        double t = static_cast<double>(i) / kSampleRate;
+        double envelope = 0.5 + 0.5 * std::sin(2 * M_PI * 4.0 * t);
+        double voice = 0.5 * std::sin(2 * M_PI * 140.0 * t) +
+                       0.3 * std::sin(2 * M_PI * 700.0 * t) +
+                       0.2 * std::sin(2 * M_PI * 2200.0 * t);
+        seed = seed * 1664525u + 1013904223u;
+        double noise = (static_cast<int32_t>(seed >> 16) - 32768) / 32768.0 * 0.05;
+        signal[i] = static_cast<int16_t>((voice * envelope + noise) * 12000.0);
+    }
+    return signal;
+}
+
+struct OpusCase {
+    double frame_ms;
+    int complexity;
+    std::unique_ptr<xiaozhi::OpusEncoder> encoder;
+    std::unique_ptr<xiaozhi::OpusDecoder> decoder;
+    std::vector<std::vector<uint8_t>> packets;   // 预先编码的包，供解码用例循环使用
+};
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项]" << std::endl;
+    std::cout << "  --json <path>      结果写入JSON文件，便于跨版本对比" << std::endl;
+    std::cout << "  --filter <text>    只运行名称包含text的用例" << std::endl;
+    std::cout << "  --min-time <ms>    每个用例最少运行时间 (默认500)" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::string json_path;
+
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+            options.min_time_ms = std::atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    // 准备阶段：创建编解码器并预编码，避免初始化日志混入结果表
+    AudioFramePool::getInstance().initialize(kSampleRate, kChannels, 120, 64);
+
+    const double frame_sizes_ms[] = {2.5, 5, 10, 20, 40, 60};
+    const int complexities[] = {0, 5, 10};
+    AudioData signal = makeSignal(kSampleRate * 2);
+
+    std::vector<OpusCase> opus_cases;
+    for (double frame_ms : frame_sizes_ms) {
+        for (int complexity : complexities) {
+            OpusCase c;
+            c.frame_ms = frame_ms;
+            c.complexity = complexity;
+            c.encoder = std::make_unique<xiaozhi::OpusEncoder>();
+            c.decoder = std::make_unique<xiaozhi::OpusDecoder>();
+            if (!c.encoder->initialize(kSampleRate, kChannels, kBitrate) ||
+                !c.encoder->setComplexity(complexity) ||
+                !c.decoder->initialize(kSampleRate, kChannels)) {
+                std::cerr << "[xiaozhi-bench] 错误: 编解码器初始化失败" << std::endl;
+                return 1;
+            }
+
+            size_t frame_samples = static_cast<size_t>(kSampleRate * frame_ms / 1000) * kChannels;
+            for (size_t pos = 0; pos + frame_samples <= signal.size(); pos += frame_samples) {
+                AudioData pcm(signal.begin() + pos, signal.begin() + pos + frame_samples);
+                c.packets.push_back(c.encoder->encode(pcm));
+            }
+            opus_cases.push_back(std::move(c));
+        }
+    }
+
+    AudioMixer mixer;
+    mixer.initialize(kSampleRate, kChannels, 20);
+    int speech_source = mixer.addSource("speech", MixPriority::SPEECH);
+    int music_source = mixer.addSource("music", MixPriority::BACKGROUND);
+    mixer.setDucking(MixPriority::SPEECH, 0.3f, 300);
+
+    DriftCompensator drift;
+    drift.initialize(kChannels);
+    drift.setRatio(1.0005);
+
+    std::cout << std::endl;
+    BenchRunner runner(options);
+    runner.printTable();
+
+    // Opus编解码：每种帧长和复杂度
+    for (auto& c : opus_cases) {
+        size_t frame_samples = static_cast<size_t>(kSampleRate * c.frame_ms / 1000) * kChannels;
+        std::string suffix = "/" + std::string(c.frame_ms == 2.5 ? "2.5" : std::to_string(static_cast<int>(c.frame_ms))) +
+                             "ms/c" + std::to_string(c.complexity);
+
+        AudioData pcm(signal.begin(), signal.begin() + frame_samples);
+        size_t offset = 0;
+        runner.run("opus_encode" + suffix, c.frame_ms, [&]() {
+            std::memcpy(pcm.data(), signal.data() + offset, frame_samples * sizeof(int16_t));
+            offset = (offset + frame_samples) % (signal.size() - frame_samples);
+            auto packet = c.encoder->encode(pcm);
+            doNotOptimize(packet.data());
+        });
+
+        // 解码速度与编码复杂度基本无关，只对每种帧长的c5包测一次
+        if (c.complexity != 5 || c.packets.empty()) {
+            continue;
+        }
+
+        size_t index = 0;
+        runner.run("opus_decode" + suffix, c.frame_ms, [&]() {
+            AudioData out = c.decoder->decode(c.packets[index]);
+            index = (index + 1) % c.packets.size();
+            doNotOptimize(out.data());
+        });
+
+        index = 0;
+        runner.run("opus_decode_frame" + suffix, c.frame_ms, [&]() {
+            AudioFrame out = c.decoder->decodeFrame(c.packets[index]);
+            index = (index + 1) % c.packets.size();
+            doNotOptimize(out.data());
+        });
+    }
+
+    // PCM搬运：帧池与AudioData之间的转换
+    const size_t samples_20ms = kSampleRate / 50 * kChannels;
+    runner.run("pcm/frame_pool_acquire_copy/20ms", 20, [&]() {
+        AudioFrame frame = AudioFramePool::getInstance().acquireCopy(signal.data(), samples_20ms);
+        doNotOptimize(frame.data());
+    });
+
+    AudioFrame shared_frame = AudioFramePool::getInstance().acquireCopy(signal.data(), samples_20ms);
+    runner.run("pcm/frame_to_audio_data/20ms", 20, [&]() {
+        AudioData data = shared_frame.toAudioData();
+        doNotOptimize(data.data());
+    });
+
+    runner.run("pcm/frame_share/20ms", 20, [&]() {
+        AudioFrame ref = shared_frame.share();
+        doNotOptimize(ref.data());
+    });
+
+    // DSP：饱和混音、多源混音带闪避、漂移补偿重采样
+    AudioData mix_dst(samples_20ms);
+    runner.run("dsp/mix_saturate/20ms", 20, [&]() {
+        std::memcpy(mix_dst.data(), signal.data(), samples_20ms * sizeof(int16_t));
+        AudioMixer::mixSaturate(mix_dst.data(), signal.data() + samples_20ms, samples_20ms);
+        doNotOptimize(mix_dst.data());
+    });
+
+    AudioData speech(signal.begin(), signal.begin() + samples_20ms);
+    AudioData music(signal.begin() + samples_20ms, signal.begin() + 2 * samples_20ms);
+    AudioData mixed;
+    mixed.reserve(samples_20ms);
+    runner.run("dsp/mixer_2src_ducking/20ms", 20, [&]() {
+        mixer.pushAudio(speech_source, speech);
+        mixer.pushAudio(music_source, music);
+        mixer.mix(mixed);
+        doNotOptimize(mixed.data());
+    });
+
+    AudioData resampled;
+    resampled.reserve(samples_20ms * 2);
+    runner.run("dsp/drift_compensate/20ms", 20, [&]() {
+        drift.process(signal.data(), samples_20ms / kChannels, resampled);
+        doNotOptimize(resampled.data());
+    });
+
+    if (!json_path.empty()) {
+        if (!runner.writeJson(json_path)) {
+            return 1;
+        }
+        std::cout << std::endl << "结果已写入 " << json_path << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,387 @@
+#include "bench_harness.h"
+#include "fake_xiaozhi_server.h"
+#include "audio/audio_manager.h"
+#include "audio/file_backend.h"
+#include "audio/opus_encoder.h"
+#include "audio/opus_decoder.h"
+#include "network/websocket_client.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace xiaozhi;
+using namespace xiaozhi::bench;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr int kSampleRate = 16000;
+constexpr int kChannels = 1;
+constexpr int kCaptureFrameMs = 20;   // AudioManager每次读取320帧
+
+struct LatencyOptions {
+    int turns = 20;
+    int utterance_ms = 1200;
+    int tts_ms = 1000;
+    int server_delay_ms = 0;
+    std::string input_file;
+    std::string output_file;
+    std::string json_path;
+    double max_turn_p95_ms = 0.0;     // >0时作为回归门限
+};
+
+// 在写入播放数据前打上时间戳的文件后端
+class ProbeBackend : public FileAudioBackend {
+public:
+    using FileAudioBackend::FileAudioBackend;
+
+    void setWriteObserver(std::function<void(size_t, Clock::time_point)> observer) {
+        observer_ = observer;
+    }
+
+    bool writeAudioData(const AudioData& audio_data) override {
+        if (observer_) {
+            observer_(audio_data.size(), Clock::now());
+        }
+        return FileAudioBackend::writeAudioData(audio_data);
+    }
+
+private:
+    std::function<void(size_t, Clock::time_point)> observer_;
+};
+
+double toMs(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+// 未指定输入时生成一段类语音的WAV作为麦克风输入
+bool generateInput(const std::string& path, int duration_ms) {
+    AudioBackendConfig config;
+    config.type = "file";
+    config.output_file = path;
+    config.realtime = false;
+    FileAudioBackend writer(config);
+    if (!writer.initialize(kSampleRate, kChannels, "", "")) {
+        return false;
+    }
+
+    AudioData pcm(static_cast<size_t>(kSampleRate) * duration_ms / 1000 * kChannels);
+    for (size_t i = 0; i < pcm.size(); ++i) {
+        double t = static_cast<double>(i / kChannels) / kSampleRate;
+        double envelope = 0.5 + 0.5 * std::sin(2 * M_PI * 4.0 * t);
+        pcm[i] = static_cast<int16_t>((0.6 * std::sin(2 * M_PI * 150.0 * t) +
+                                       0.4 * std::sin(2 * M_PI * 900.0 * t)) * envelope * 12000.0);
+    }
+    return writer.writeAudioData(pcm);
+}
+
+void printSummary(const std::string& name, const LatencySummary& s) {
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << s.count
+              << std::setw(10) << s.min
+              << std::setw(10) << s.p50
+              << std::setw(10) << s.p95
+              << std::setw(10) << s.p99
+              << std::setw(10) << s.max << std::endl;
+}
+
+void writeSummaryJson(std::ostream& out, const std::string& name, const LatencySummary& s, bool last) {
+    out << std::fixed << std::setprecision(3)
+        << "    \"" << name << "\": {\"count\": " << s.count
+        << ", \"min_ms\": " << s.min << ", \"mean_ms\": " << s.mean
+        << ", \"p50_ms\": " << s.p50 << ", \"p95_ms\": " << s.p95
+        << ", \"p99_ms\": " << s.p99 << ", \"max_ms\": " << s.max << "}"
+        << (last ? "" : ",") << "\n";
+}
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项]" << std::endl;
+    std::cout << "  --turns <n>              对话轮数 (默认20)" << std::endl;
+    std::cout << "  --utterance-ms <ms>      每轮上行语音时长 (默认1200)" << std::endl;
+    std::cout << "  --tts-ms <ms>            每轮下行TTS时长 (默认1000)" << std::endl;
+    std::cout << "  --server-delay-ms <ms>   模拟服务端识别/生成耗时 (默认0)" << std::endl;
+    std::cout << "  --input <wav>            麦克风输入文件，默认自动生成" << std::endl;
+    std::cout << "  --output <wav>           保存播放输出" << std::endl;
+    std::cout << "  --json <path>            结果写入JSON文件" << std::endl;
+    std::cout << "  --max-turn-p95-ms <ms>   完整轮次p95超过该值时返回非0" << std::endl;
+}
+
+bool parseArgs(int argc, char* argv[], LatencyOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--turns" && has_value) {
+            options.turns = std::atoi(argv[++i]);
+        } else if (arg == "--utterance-ms" && has_value) {
+            options.utterance_ms = std::atoi(argv[++i]);
+        } else if (arg == "--tts-ms" && has_value) {
+            options.tts_ms = std::atoi(argv[++i]);
+        } else if (arg == "--server-delay-ms" && has_value) {
+            options.server_delay_ms = std::atoi(argv[++i]);
+        } else if (arg == "--input" && has_value) {
+            options.input_file = argv[++i];
+        } else if (arg == "--output" && has_value) {
+            options.output_file = argv[++i];
+        } else if (arg == "--json" && has_value) {
+            options.json_path = argv[++i];
+        } else if (arg == "--max-turn-p95-ms" && has_value) {
+            options.max_turn_p95_ms = std::atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return options.turns > 0 && options.utterance_ms >= kCaptureFrameMs && options.tts_ms > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LatencyOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.input_file.empty()) {
+        options.input_file = "/tmp/xiaozhi-latency-input.wav";
+        if (!generateInput(options.input_file, 5000)) {
+            std::cerr << "[xiaozhi-latency] 错误: 无法生成输入文件" << std::endl;
+            return 1;
+        }
+    }
+
+    const int utterance_frames = options.utterance_ms / kCaptureFrameMs;
+
+    // 测量状态，由采集、网络、播放和服务器线程共同更新
+    std::mutex stats_mutex;
+    std::condition_variable stats_cv;
+    std::vector<Clock::time_point> capture_times(static_cast<size_t>(options.turns) * utterance_frames);
+    std::vector<double> capture_to_send;
+    std::vector<double> receive_to_playout;
+    std::vector<double> full_turn;
+
+    struct PendingPacket {
+        uint64_t start_sample;
+        Clock::time_point received_at;
+    };
+    std::deque<PendingPacket> pending;
+    uint64_t samples_queued = 0;
+    uint64_t samples_written = 0;
+    uint64_t packets_sent = 0;
+    bool hello_received = false;
+    bool listening = false;
+    int frames_in_turn = 0;
+    Clock::time_point turn_end_capture;
+    bool turn_playout_seen = false;
+    bool tts_stopped = false;
+    bool turn_done = false;
+
+    // 本地替身服务器
+    FakeServerConfig server_config;
+    server_config.sample_rate = kSampleRate;
+    server_config.channels = kChannels;
+    server_config.tts_duration_ms = options.tts_ms;
+    server_config.response_delay_ms = options.server_delay_ms;
+    FakeXiaozhiServer server(server_config);
+    server.setAudioReceivedCallback([&](uint64_t sequence, Clock::time_point arrival) {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        if (sequence < packets_sent) {
+            capture_to_send.push_back(toMs(arrival - capture_times[sequence]));
+        }
+    });
+    if (!server.start()) {
+        return 1;
+    }
+
+    // 采集走文件后端，播放经混音后写入带时间戳的同一后端
+    AudioBackendConfig backend_config;
+    backend_config.type = "file";
+    backend_config.input_file = options.input_file;
+    backend_config.output_file = options.output_file;
+    backend_config.realtime = true;
+    backend_config.loop = true;
+    auto backend = std::make_unique<ProbeBackend>(backend_config);
+    ProbeBackend* probe = backend.get();
+
+    AudioManager audio_manager;
+    audio_manager.setBackend(std::move(backend));
+    if (!audio_manager.initialize(kSampleRate, kChannels, 64)) {
+        return 1;
+    }
+    int tts_source = audio_manager.addPlaybackSource("tts", MixPriority::SPEECH);
+
+    xiaozhi::OpusEncoder encoder;
+    xiaozhi::OpusDecoder decoder;
+    encoder.initialize(kSampleRate, kChannels, 32000);
+    decoder.initialize(kSampleRate, kChannels);
+
+    WebsocketClient client;
+
+    probe->setWriteObserver([&](size_t samples, Clock::time_point now) {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        samples_written += samples;
+        while (!pending.empty() && pending.front().start_sample < samples_written) {
+            receive_to_playout.push_back(toMs(now - pending.front().received_at));
+            if (!turn_playout_seen) {
+                turn_playout_seen = true;
+                full_turn.push_back(toMs(now - turn_end_capture));
+            }
+            pending.pop_front();
+        }
+        if (tts_stopped && pending.empty() && !turn_done) {
+            turn_done = true;
+            stats_cv.notify_all();
+        }
+    });
+
+    client.setTextMessageCallback([&](const std::string& message) {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        if (message.find("\"type\":\"hello\"") != std::string::npos) {
+            hello_received = true;
+        } else if (message.find("\"type\":\"tts\"") != std::string::npos &&
+                   message.find("\"state\":\"stop\"") != std::string::npos) {
+            tts_stopped = true;
+            if (pending.empty()) {
+                turn_done = true;
+            }
+        }
+        stats_cv.notify_all();
+    });
+
+    client.setBinaryMessageCallback([&](const std::vector<uint8_t>& packet) {
+        auto received_at = Clock::now();
+        AudioData pcm = decoder.decode(packet);
+        if (pcm.empty()) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            pending.push_back({samples_queued, received_at});
+            samples_queued += pcm.size();
+        }
+        audio_manager.queuePlayback(tts_source, pcm);
+    });
+
+    audio_manager.setRecordFrameCallback([&](AudioFrame frame) {
+        auto captured_at = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            if (!listening) {
+                return;
+            }
+        }
+
+        std::vector<uint8_t> packet = encoder.encode(frame);
+        bool end_of_utterance = false;
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            capture_times[packets_sent++] = captured_at;
+            if (++frames_in_turn >= utterance_frames) {
+                listening = false;
+                end_of_utterance = true;
+                turn_end_capture = captured_at;
+            }
+        }
+
+        client.sendBinary(packet);
+        if (end_of_utterance) {
+            client.sendText("{\"type\":\"listen\",\"listening\":false}");
+        }
+    });
+
+    if (!client.connect(server.getUrl())) {
+        return 1;
+    }
+    client.sendText("{\"type\":\"hello\",\"version\":1,\"transport\":\"websocket\","
+                    "\"audio_params\":{\"format\":\"opus\",\"sample_rate\":16000,\"channels\":1,\"frame_duration\":20}}");
+    {
+        std::unique_lock<std::mutex> lock(stats_mutex);
+        if (!stats_cv.wait_for(lock, std::chrono::seconds(5), [&] { return hello_received; })) {
+            std::cerr << "[xiaozhi-latency] 错误: 未收到hello响应" << std::endl;
+            return 1;
+        }
+    }
+
+    audio_manager.startPlayback();
+    audio_manager.startRecording();
+
+    int failed_turns = 0;
+    auto turn_timeout = std::chrono::milliseconds(options.utterance_ms + options.server_delay_ms +
+                                                  options.tts_ms + 3000);
+    for (int turn = 0; turn < options.turns; ++turn) {
+        client.sendText("{\"type\":\"listen\",\"listening\":true}");
+        {
+            std::lock_guard<std::mutex> lock(stats_mutex);
+            frames_in_turn = 0;
+            turn_playout_seen = false;
+            tts_stopped = false;
+            turn_done = false;
+            listening = true;
+        }
+
+        std::unique_lock<std::mutex> lock(stats_mutex);
+        if (!stats_cv.wait_for(lock, turn_timeout, [&] { return turn_done; })) {
+            // 超时后播放计数无法再与下行包对应，停止测量
+            std::cerr << "[xiaozhi-latency] 错误: 第" << turn + 1 << "轮超时" << std::endl;
+            ++failed_turns;
+            listening = false;
+            break;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    }
+
+    audio_manager.stopRecording();
+    audio_manager.stopPlayback();
+    client.disconnect();
+    server.stop();
+
+    LatencySummary capture_summary, playout_summary, turn_summary;
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex);
+        capture_summary = summarizeLatencies(capture_to_send);
+        playout_summary = summarizeLatencies(receive_to_playout);
+        turn_summary = summarizeLatencies(full_turn);
+    }
+
+    std::cout << std::endl;
+    std::cout << std::left << std::setw(20) << "latency (ms)" << std::right
+              << std::setw(8) << "count" << std::setw(10) << "min" << std::setw(10) << "p50"
+              << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << std::endl;
+    std::cout << std::string(78, '-') << std::endl;
+    printSummary("capture_to_send", capture_summary);
+    printSummary("receive_to_playout", playout_summary);
+    printSummary("full_turn", turn_summary);
+    std::cout << "轮数: " << options.turns << ", 超时: " << failed_turns
+              << ", 服务端模拟耗时: " << options.server_delay_ms << "ms" << std::endl;
+
+    if (!options.json_path.empty()) {
+        std::ofstream out(options.json_path);
+        out << "{\n";
+        out << "  \"turns\": " << options.turns << ",\n";
+        out << "  \"failed_turns\": " << failed_turns << ",\n";
+        out << "  \"server_delay_ms\": " << options.server_delay_ms << ",\n";
+        out << "  \"latency\": {\n";
+        writeSummaryJson(out, "capture_to_send", capture_summary, false);
+        writeSummaryJson(out, "receive_to_playout", playout_summary, false);
+        writeSummaryJson(out, "full_turn", turn_summary, true);
+        out << "  }\n";
+        out << "}\n";
+    }
+
+    if (failed_turns > 0) {
+        return 2;
+    }
+    if (options.max_turn_p95_ms > 0 && turn_summary.p95 > options.max_turn_p95_ms) {
+        std::cerr << "[xiaozhi-latency] 回归: full_turn p95 " << turn_summary.p95
+                  << "ms 超过门限 " << options.max_turn_p95_ms << "ms" << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,294 @@
+#include "bench_harness.h"
+#include "mcp/mcp_server.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+using namespace xiaozhi;
+using namespace xiaozhi::bench;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+struct LoadOptions {
+    std::string host = "127.0.0.1";
+    int port = 0;                   // 0表示在进程内启动McpServer
+    int connections = 4;
+    int pipeline = 1;               // 每个连接上连续发出、再依次读取的请求数
+    int batch = 1;                  // >1时每个HTTP请求携带一个JSON-RPC批量数组
+    int duration_ms = 5000;
+    std::string method = "tools/list";
+    std::string tool = "system.info";
+    std::string json_path;
+    double max_p99_ms = 0.0;        // >0时作为回归门限
+};
+
+struct WorkerResult {
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    std::vector<double> latencies_ms;
+};
+
+double toMs(Clock::duration d) {
+    return std::chrono::duration<double, std::milli>(d).count();
+}
+
+std::string buildMessage(const LoadOptions& options, uint64_t id) {
+    std::string body = "{\"jsonrpc\":\"2.0\",\"id\":" + std::to_string(id) + ",\"method\":\"" + options.method + "\"";
+    if (options.method == "tools/call") {
+        body += ",\"params\":{\"name\":\"" + options.tool + "\",\"arguments\":{}}";
+    }
+    body += "}";
+    return body;
+}
+
+std::string buildBody(const LoadOptions& options, uint64_t& id) {
+    if (options.batch <= 1) {
+        return buildMessage(options, ++id);
+    }
+    std::string body = "[";
+    for (int i = 0; i < options.batch; ++i) {
+        if (i > 0) {
+            body += ",";
+        }
+        body += buildMessage(options, ++id);
+    }
+    body += "]";
+    return body;
+}
+
+int connectTo(const std::string& host, int port) {
+    addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* result = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &result) != 0) {
+        return -1;
+    }
+    int fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd >= 0) {
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+    return fd;
+}
+
+// 从缓冲中取出一个完整的HTTP响应，返回状态码；数据不足返回0
+int takeResponse(std::string& buffer) {
+    size_t header_end = buffer.find("\r\n\r\n");
+    if (header_end == std::string::npos) {
+        return 0;
+    }
+    size_t length = 0;
+    size_t pos = buffer.find("Content-Length:");
+    if (pos != std::string::npos && pos < header_end) {
+        length = static_cast<size_t>(std::strtoull(buffer.c_str() + pos + 15, nullptr, 10));
+    }
+    if (buffer.size() < header_end + 4 + length) {
+        return 0;
+    }
+    int status = buffer.size() > 12 ? std::atoi(buffer.c_str() + 9) : 0;
+    buffer.erase(0, header_end + 4 + length);
+    return status;
+}
+
+void runWorker(const LoadOptions& options, int port, Clock::time_point deadline, WorkerResult& result) {
+    int fd = connectTo(options.host, port);
+    if (fd < 0) {
+        std::cerr << "[xiaozhi-mcp-load] 错误: 无法连接 " << options.host << ":" << port << std::endl;
+        ++result.errors;
+        return;
+    }
+
+    std::string buffer;
+    std::vector<Clock::time_point> sent(static_cast<size_t>(options.pipeline));
+    uint64_t id = 0;
+    char chunk[16384];
+    while (Clock::now() < deadline) {
+        // 一次写出整批请求，模拟客户端流水线
+        std::string batch;
+        for (int i = 0; i < options.pipeline; ++i) {
+            std::string body = buildBody(options, id);
+            batch += "POST /mcp HTTP/1.1\r\nHost: " + options.host + "\r\nContent-Type: application/json\r\nContent-Length: " +
+                     std::to_string(body.size()) + "\r\n\r\n" + body;
+        }
+        Clock::time_point start = Clock::now();
+        for (auto& t : sent) {
+            t = start;
+        }
+        if (send(fd, batch.data(), batch.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(batch.size())) {
+            ++result.errors;
+            break;
+        }
+
+        int received = 0;
+        while (received < options.pipeline) {
+            int status = takeResponse(buffer);
+            if (status != 0) {
+                result.latencies_ms.push_back(toMs(Clock::now() - sent[received]));
+                ++result.requests;
+                if (status != 200) {
+                    ++result.errors;
+                }
+                ++received;
+                continue;
+            }
+            ssize_t bytes = recv(fd, chunk, sizeof(chunk), 0);
+            if (bytes <= 0) {
+                ++result.errors;
+                close(fd);
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(bytes));
+        }
+    }
+    close(fd);
+}
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项]" << std::endl;
+    std::cout << "  --host <地址>            目标地址 (默认127.0.0.1)" << std::endl;
+    std::cout << "  --port <端口>            目标端口，不指定时在进程内启动MCP服务器" << std::endl;
+    std::cout << "  --connections <n>        并发连接数 (默认4)" << std::endl;
+    std::cout << "  --pipeline <n>           每个连接上流水线发送的请求数 (默认1)" << std::endl;
+    std::cout << "  --duration-ms <ms>       压测时长 (默认5000)" << std::endl;
+    std::cout << "  --method <方法>          JSON-RPC方法: tools/list | tools/call | ping (默认tools/list)" << std::endl;
+    std::cout << "  --tool <名称>            tools/call调用的工具 (默认system.info)" << std::endl;
+    std::cout << "  --batch <n>              每个HTTP请求携带n条JSON-RPC消息的批量数组 (默认1)" << std::endl;
+    std::cout << "  --json <path>            结果写入JSON文件" << std::endl;
+    std::cout << "  --max-p99-ms <ms>        p99延迟超过该值时返回非0" << std::endl;
+}
+
+bool parseArgs(int argc, char* argv[], LoadOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--host" && has_value) {
+            options.host = argv[++i];
+        } else if (arg == "--port" && has_value) {
+            options.port = std::atoi(argv[++i]);
+        } else if (arg == "--connections" && has_value) {
+            options.connections = std::atoi(argv[++i]);
+        } else if (arg == "--pipeline" && has_value) {
+            options.pipeline = std::atoi(argv[++i]);
+        } else if (arg == "--duration-ms" && has_value) {
+            options.duration_ms = std::atoi(argv[++i]);
+        } else if (arg == "--method" && has_value) {
+            options.method = argv[++i];
+        } else if (arg == "--tool" && has_value) {
+            options.tool = argv[++i];
+        } else if (arg == "--batch" && has_value) {
+            options.batch = std::atoi(argv[++i]);
+        } else if (arg == "--json" && has_value) {
+            options.json_path = argv[++i];
+        } else if (arg == "--max-p99-ms" && has_value) {
+            options.max_p99_ms = std::atof(argv[++i]);
+        } else {
+            return false;
+        }
+    }
+    return options.connections > 0 && options.pipeline > 0 && options.batch > 0 && options.duration_ms > 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // 未指定端口时在进程内启动服务器，监听系统分配的端口
+    std::unique_ptr<McpServer> server;
+    int port = options.port;
+    if (port == 0) {
+        McpTransportOptions transport;
+        transport.port = 0;
+        transport.max_connections = options.connections + 8;
+        server.reset(new McpServer(0));
+        server->setTransportOptions(transport);
+        if (!server->start()) {
+            return 1;
+        }
+        port = server->getHttpPort();
+    }
+
+    std::vector<WorkerResult> results(static_cast<size_t>(options.connections));
+    std::vector<std::thread> workers;
+    Clock::time_point begin = Clock::now();
+    Clock::time_point deadline = begin + std::chrono::milliseconds(options.duration_ms);
+    for (int i = 0; i < options.connections; ++i) {
+        workers.emplace_back(runWorker, std::cref(options), port, deadline, std::ref(results[i]));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    double elapsed_s = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    if (server) {
+        server->stop();
+    }
+
+    uint64_t requests = 0;
+    uint64_t errors = 0;
+    std::vector<double> latencies;
+    for (auto& result : results) {
+        requests += result.requests;
+        errors += result.errors;
+        latencies.insert(latencies.end(), result.latencies_ms.begin(), result.latencies_ms.end());
+    }
+    LatencySummary summary = summarizeLatencies(latencies);
+    double rps = elapsed_s > 0 ? requests / elapsed_s : 0.0;
+
+    std::cout << std::endl;
+    std::cout << "方法: " << options.method << ", 连接: " << options.connections
+              << ", 流水线: " << options.pipeline << ", 批量: " << options.batch << ", 时长: " << options.duration_ms << "ms" << std::endl;
+    std::cout << std::fixed << std::setprecision(1)
+              << "请求: " << requests << ", 错误: " << errors << ", 吞吐: " << rps << " req/s" << std::endl;
+    std::cout << std::setprecision(3)
+              << "延迟(ms): min " << summary.min << "  p50 " << summary.p50 << "  p95 " << summary.p95
+              << "  p99 " << summary.p99 << "  max " << summary.max << std::endl;
+
+    if (!options.json_path.empty()) {
+        std::ofstream out(options.json_path);
+        out << "{\n";
+        out << "  \"method\": \"" << options.method << "\",\n";
+        out << "  \"connections\": " << options.connections << ",\n";
+        out << "  \"pipeline\": " << options.pipeline << ",\n";
+        out << "  \"batch\": " << options.batch << ",\n";
+        out << "  \"requests\": " << requests << ",\n";
+        out << "  \"errors\": " << errors << ",\n";
+        out << "  \"requests_per_second\": " << rps << ",\n";
+        out << "  \"latency_ms\": {\"p50\": " << summary.p50 << ", \"p95\": " << summary.p95
+            << ", \"p99\": " << summary.p99 << ", \"max\": " << summary.max << "}\n";
+        out << "}\n";
+    }
+
+    if (errors > 0 || requests == 0) {
+        return 2;
+    }
+    if (options.max_p99_ms > 0 && summary.p99 > options.max_p99_ms) {
+        std::cerr << "[xiaozhi-mcp-load] 回归: p99 " << summary.p99 << "ms 超过门限 "
+                  << options.max_p99_ms << "ms" << std::endl;
+        return 2;
+    }
+    return 0;
+}
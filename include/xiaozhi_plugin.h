@@ -0,0 +1,67 @@
+// MCP工具插件ABI
+//
+// 插件是一个共享库加一份同名的JSON清单（例如gpio_tools.so和gpio_tools.json），
+// 放在mcp.plugin_dir目录下。守护进程启动时只读取清单，把其中声明的工具注册到
+// 工具表，不加载共享库；某个工具第一次被调用时才dlopen对应的库并创建插件实例。
+//
+// 清单格式：
+//   {
+//     "library": "gpio_tools.so",          // 相对清单所在目录，省略时为<清单名>.so
+//     "abi_version": 1,
+//     "config": { ... },                   // 可选，原样传给create
+//     "tools": [
+//       { "name": "gpio.write", "description": "...",
+//         "inputSchema": { "type": "object", "properties": {...}, "required": [...] },
+//         "timeout_ms": 0, "max_concurrency": 0, "idempotent": false, "cache_ttl_ms": 0 }
+//     ]
+//   }
+//
+// 插件只依赖本头文件，以C接口导出入口函数，可以用与守护进程不同的编译器或标准库构建。
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XIAOZHI_PLUGIN_ABI_VERSION 1
+#define XIAOZHI_PLUGIN_ENTRY_SYMBOL "xiaozhi_plugin_entry"
+
+// 一次工具调用的宿主回调，只在call_tool返回前有效。
+// 可在调用线程之外使用，但必须在call_tool返回前结束
+typedef struct xiaozhi_tool_call xiaozhi_tool_call;
+struct xiaozhi_tool_call {
+    void* host;     // 宿主私有
+
+    // 设置结果（JSON文本），多次调用以最后一次为准；未设置时结果为{}
+    void (*set_result)(xiaozhi_tool_call* call, const char* json, size_t size);
+    // 输出一块文本内容，返回0表示调用已取消或超时，插件应停止输出
+    int (*write)(xiaozhi_tool_call* call, const char* text, size_t size);
+    // 报告进度，total为0表示总量未知，message可为NULL
+    void (*progress)(xiaozhi_tool_call* call, double progress, double total, const char* message);
+    // 调用被客户端取消或超过期限时返回非0
+    int (*is_cancelled)(xiaozhi_tool_call* call);
+};
+
+typedef struct xiaozhi_plugin_api {
+    uint32_t abi_version;   // 必须为XIAOZHI_PLUGIN_ABI_VERSION
+
+    // 创建插件实例，config_json为清单中的config（没有时为"{}"），失败时返回NULL。
+    // 可为NULL，此时实例为NULL
+    void* (*create)(const char* config_json);
+    // 销毁实例，可为NULL；守护进程退出时调用
+    void (*destroy)(void* instance);
+    // 执行工具：tool为清单中的工具名，arguments_json为已按inputSchema校验过的参数对象。
+    // 可在多个线程上并发调用。返回0表示成功；非0表示失败，此时set_result设置的文本
+    // 作为错误信息返回给客户端
+    int (*call_tool)(void* instance, const char* tool, const char* arguments_json, xiaozhi_tool_call* call);
+} xiaozhi_plugin_api;
+
+// 插件导出的入口函数，返回的结构体须在库卸载前一直有效
+typedef const xiaozhi_plugin_api* (*xiaozhi_plugin_entry_fn)(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,103 @@
+// 示例MCP工具插件：只依赖xiaozhi_plugin.h和json-c，清单见example_plugin.json
+#include "xiaozhi_plugin.h"
+#include <string>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <json-c/json.h>
+
+namespace {
+
+struct ExamplePlugin {
+    std::string greeting;
+};
+
+void setResult(xiaozhi_tool_call* call, json_object* result) {
+    const char* json = json_object_to_json_string_ext(result, JSON_C_TO_STRING_PLAIN);
+    call->set_result(call, json, std::strlen(json));
+    json_object_put(result);
+}
+
+void* create(const char* config_json) {
+    auto* plugin = new ExamplePlugin();
+    json_object* config = json_tokener_parse(config_json);
+    json_object* greeting_obj = nullptr;
+    if (config && json_object_object_get_ex(config, "greeting", &greeting_obj)) {
+        plugin->greeting = json_object_get_string(greeting_obj);
+    }
+    if (config) {
+        json_object_put(config);
+    }
+    return plugin;
+}
+
+void destroy(void* instance) {
+    delete static_cast<ExamplePlugin*>(instance);
+}
+
+int echo(ExamplePlugin* plugin, json_object* arguments, xiaozhi_tool_call* call) {
+    json_object* text_obj = nullptr;
+    json_object_object_get_ex(arguments, "text", &text_obj);
+
+    json_object* result = json_object_new_object();
+    json_object_object_add(result, "greeting", json_object_new_string(plugin->greeting.c_str()));
+    json_object_object_add(result, "text", json_object_new_string(text_obj ? json_object_get_string(text_obj) : ""));
+    setResult(call, result);
+    return 0;
+}
+
+int count(json_object* arguments, xiaozhi_tool_call* call) {
+    json_object* field_obj = nullptr;
+    int n = json_object_object_get_ex(arguments, "n", &field_obj) ? json_object_get_int(field_obj) : 0;
+    int interval_ms = json_object_object_get_ex(arguments, "interval_ms", &field_obj) ? json_object_get_int(field_obj) : 0;
+
+    int written = 0;
+    for (int i = 1; i <= n; ++i) {
+        std::string line = std::to_string(i) + "\n";
+        // 返回0表示调用已取消或超时
+        if (!call->write(call, line.data(), line.size())) {
+            break;
+        }
+        ++written;
+        call->progress(call, i, n, nullptr);
+        if (interval_ms > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+        }
+    }
+
+    json_object* result = json_object_new_object();
+    json_object_object_add(result, "written", json_object_new_int(written));
+    setResult(call, result);
+    return 0;
+}
+
+int callTool(void* instance, const char* tool, const char* arguments_json, xiaozhi_tool_call* call) {
+    json_object* arguments = json_tokener_parse(arguments_json);
+    int status = 0;
+    if (std::strcmp(tool, "example.echo") == 0) {
+        status = echo(static_cast<ExamplePlugin*>(instance), arguments, call);
+    } else if (std::strcmp(tool, "example.count") == 0) {
+        status = count(arguments, call);
+    } else {
+        const char* message = "unknown tool";
+        call->set_result(call, message, std::strlen(message));
+        status = 1;
+    }
+    if (arguments) {
+        json_object_put(arguments);
+    }
+    return status;
+}
+
+const xiaozhi_plugin_api kApi = {
+    XIAOZHI_PLUGIN_ABI_VERSION,
+    create,
+    destroy,
+    callTool,
+};
+
+} // namespace
+
+extern "C" __attribute__((visibility("default"))) const xiaozhi_plugin_api* xiaozhi_plugin_entry(void) {
+    return &kApi;
+}
@@ -1,9 +1,14 @@
 #include "ai_engine.h"
 #include <iostream>
 #include <chrono>
-#include <thread>
+#include <memory>
 #include <sstream>
 #include <cmath>
+#include "utils/event_loop.h"
+#include "utils/event_loop_pool.h"
+#include "utils/trace.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -11,15 +16,30 @@
 
 namespace xiaozhi {
 
-AiEngine::AiEngine() {
+namespace {
+
+struct AiMetrics {
+    Histogram& turn_time = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_ai_turn_seconds", "从收到语音输入到产生回复的耗时");
+    Gauge& queue_depth = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_ai_queue_depth", "AI引擎待处理的文本和音频请求数");
+    Gauge& running = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_ai_running", "AI引擎是否运行中");
+};
+
+AiMetrics& aiMetrics() {
+    static AiMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+AiEngine::AiEngine() : loop_(nullptr) {
     std::cout << "[AiEngine] 初始化AI引擎" << std::endl;
 }
 
 AiEngine::~AiEngine() {
     stop();
-    if (engine_thread_.joinable()) {
-        engine_thread_.join();
-    }
     std::cout << "[AiEngine] AI引擎已销毁" << std::endl;
 }
 
@@ -32,17 +52,36 @@ bool AiEngine::initialize() {
     return false;
 }
 
+void AiEngine::setEventLoop(EventLoop* loop) {
+    if (running_) {
+        std::cerr << "[AiEngine] 错误: 引擎运行中不能更换事件循环" << std::endl;
+        return;
+    }
+    loop_ = loop;
+}
+
 void AiEngine::start() {
     if (initialized_ && !running_) {
+        if (!loop_) {
+            loop_ = EventLoopPool::getInstance().next();
+        }
+        std::lock_guard<std::mutex> lock(post_mutex_);
         running_ = true;
-        engine_thread_ = std::thread(&AiEngine::engineLoop, this);
+        aiMetrics().running.set(1);
         std::cout << "[AiEngine] AI引擎已启动" << std::endl;
     }
 }
 
 void AiEngine::stop() {
-    if (running_) {
-        running_ = false;
+    bool was_running;
+    {
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        was_running = running_.exchange(false);
+    }
+    if (was_running) {
+        // 已投递的任务看到running_为false后直接返回，等它们执行完再返回
+        loop_->drain();
+        aiMetrics().running.set(0);
         std::cout << "[AiEngine] AI引擎已停止" << std::endl;
     }
 }
@@ -52,34 +91,54 @@ bool AiEngine::isRunning() const {
 }
 
 bool AiEngine::sendTextMessage(const std::string& message) {
-    if (!initialized_) {
-        std::cerr << "[AiEngine] 错误: AI引擎未初始化" << std::endl;
-        return false;
-    }
-
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        text_messages_.push(message);
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        if (!initialized_ || !running_) {
+            LOG_EVERY_MS(ERROR, 1000, "[AiEngine] 错误: AI引擎未启动");
+            return false;
+        }
+
+        aiMetrics().queue_depth.add(1);
+        loop_->post([this, message]() {
+            aiMetrics().queue_depth.add(-1);
+            if (running_) {
+                handleText(message);
+            }
+        });
     }
     
-    std::cout << "[AiEngine] 已接收文本消息: " << message.substr(0, 50) 
-              << (message.length() > 50 ? "..." : "") << std::endl;
+    LOG_INFO("[AiEngine] 已接收文本消息: {}{}", message.substr(0, 50), message.length() > 50 ? "..." : "");
     
     return true;
 }
 
 bool AiEngine::sendAudioInput(const AudioData& audio_data) {
-    if (!initialized_) {
-        std::cerr << "[AiEngine] 错误: AI引擎未初始化" << std::endl;
-        return false;
-    }
+    return sendAudioInput(AudioFramePool::getInstance().acquireCopy(audio_data.data(), audio_data.size()));
+}
 
+bool AiEngine::sendAudioInput(AudioFrame audio_frame) {
+    size_t samples = audio_frame.size();
+    auto received = std::chrono::steady_clock::now();
+    // std::function要求可拷贝，帧通过shared_ptr随任务转移
+    auto frame = std::make_shared<AudioFrame>(std::move(audio_frame));
     {
-        std::lock_guard<std::mutex> lock(queue_mutex_);
-        audio_inputs_.push(audio_data);
+        std::lock_guard<std::mutex> lock(post_mutex_);
+        if (!initialized_ || !running_) {
+            LOG_EVERY_MS(ERROR, 1000, "[AiEngine] 错误: AI引擎未启动，丢弃音频输入");
+            return false;
+        }
+
+        aiMetrics().queue_depth.add(1);
+        loop_->post([this, frame, received]() {
+            aiMetrics().queue_depth.add(-1);
+            if (running_) {
+                handleAudio(*frame, received);
+            }
+        });
     }
     
-    std::cout << "[AiEngine] 已接收音频输入，大小: " << audio_data.size() << " 采样点" << std::endl;
+    // 每个音频帧都会经过这里，用DEBUG级别避免在Release构建中产生开销
+    LOG_DEBUG("[AiEngine] 已接收音频输入，大小: {} 采样点", samples);
     
     return true;
 }
@@ -88,61 +147,45 @@ void AiEngine::setTextResponseCallback(std::function<void(const std::string&)> c
     text_response_callback_ = callback;
 }
 
-void AiEngine::setAudioResponseCallback(std::function<void(AudioData&)> callback) {
+void AiEngine::setAudioResponseCallback(std::function<void(AudioFrame)> callback) {
     audio_response_callback_ = callback;
 }
 
-void AiEngine::process() {
-    // 处理AI相关任务
-    // 在实际实现中，这里会处理AI推理和响应
-}
-
-void AiEngine::engineLoop() {
-    // 模拟AI引擎主循环
-    while (running_) {
-        // 处理文本消息队列
-        {
-            std::lock_guard<std::mutex> lock(queue_mutex_);
-            while (!text_messages_.empty()) {
-                std::string message = text_messages_.front();
-                text_messages_.pop();
-                
-                // 处理文本请求
-                std::string response = processTextRequest(message);
-                
-                // 发送文本响应
-                if (text_response_callback_) {
-                    text_response_callback_(response);
-                }
-            }
-            
-            // 处理音频输入队列
-            while (!audio_inputs_.empty()) {
-                AudioData audio_data = audio_inputs_.front();
-                audio_inputs_.pop();
-                
-                // 在实际实现中，这里会进行语音识别
-                std::string recognized_text = "模拟语音识别结果: 这是用户语音的内容";
-                
-                // 处理识别结果
-                std::string response = processTextRequest(recognized_text);
-                
-                // 发送文本响应
-                if (text_response_callback_) {
-                    text_response_callback_(response);
-                }
-                
-                // 如果有音频响应回调，也发送音频
-                if (audio_response_callback_) {
-                    AudioData audio_response = processAudioResponse(response);
-                    audio_response_callback_(audio_response);
-                }
-            }
-        }
-        
-        // 模拟处理间隔
-        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+void AiEngine::handleText(const std::string& message) {
+    TRACE_SCOPE("ai", "ai.text_request");
+    
+    // 处理文本请求
+    std::string response = processTextRequest(message);
+    
+    // 发送文本响应
+    if (text_response_callback_) {
+        text_response_callback_(response);
+    }
+}
+
+void AiEngine::handleAudio(const AudioFrame& frame, std::chrono::steady_clock::time_point received) {
+    TRACE_SCOPE("ai", "ai.audio_request");
+    (void)frame;
+    
+    // 在实际实现中，这里会进行语音识别
+    std::string recognized_text = "模拟语音识别结果: 这是用户语音的内容";
+    
+    // 处理识别结果
+    std::string response = processTextRequest(recognized_text);
+    
+    // 发送文本响应
+    if (text_response_callback_) {
+        text_response_callback_(response);
     }
+    
+    // 如果有音频响应回调，也发送音频
+    if (audio_response_callback_) {
+        audio_response_callback_(processAudioResponse(response));
+    }
+    
+    aiMetrics().turn_time.record(static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - received).count()));
 }
 
 std::string AiEngine::processTextRequest(const std::string& text) {
@@ -150,20 +193,22 @@ std::string AiEngine::processTextRequest(const std::string& text) {
     std::ostringstream response;
     response << "AI回复: 收到您的消息 \"" << text << "\"，这是模拟的AI回复内容。";
     
-    std::cout << "[AiEngine] 处理文本请求，生成回复" << std::endl;
+    LOG_DEBUG("[AiEngine] 处理文本请求，生成回复");
     return response.str();
 }
 
-AudioData AiEngine::processAudioResponse(const std::string& text) {
+AudioFrame AiEngine::processAudioResponse(const std::string& /*text*/) {
+    TRACE_SCOPE("ai", "ai.synthesize");
     // 模拟将文本转换为音频数据
-    AudioData audio_data(1600); // 模拟80ms的音频数据
-    for (size_t i = 0; i < audio_data.size(); ++i) {
+    AudioFrame audio_frame = AudioFramePool::getInstance().acquire(1600); // 模拟80ms的音频数据
+    int16_t* samples = audio_frame.data();
+    for (size_t i = 0; i < audio_frame.size(); ++i) {
         // 生成模拟音频波形
-        audio_data[i] = static_cast<int16_t>(32767.0 * 0.3 * sin(2 * M_PI * 440 * i / 16000));
+        samples[i] = static_cast<int16_t>(32767.0 * 0.3 * sin(2 * M_PI * 440 * i / 16000));
     }
     
-    std::cout << "[AiEngine] 生成音频响应数据" << std::endl;
-    return audio_data;
+    LOG_DEBUG("[AiEngine] 生成音频响应数据");
+    return audio_frame;
 }
 
 } // namespace xiaozhi
\ No newline at end of file
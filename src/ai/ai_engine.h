@@ -1,15 +1,18 @@
 #pragma once
 
 #include <string>
-#include <thread>
-#include <mutex>
 #include <atomic>
+#include <mutex>
 #include <functional>
-#include <queue>
+#include <chrono>
 #include "xiaozhi_types.h"
+#include "audio/audio_frame_pool.h"
 
 namespace xiaozhi {
 
+class EventLoop;
+
+// 请求以任务形式投递到共享事件循环中按顺序处理，引擎本身不占用线程
 class AiEngine {
 public:
     AiEngine();
@@ -25,31 +28,34 @@ public:
     
     // 发送音频数据给AI（语音识别输入）
     bool sendAudioInput(const AudioData& audio_data);
+    bool sendAudioInput(AudioFrame audio_frame);
 
-    // 设置AI响应回调
-    void setTextResponseCallback(std::function<void(const std::string&)> callback);
-    void setAudioResponseCallback(std::function<void(AudioData&)> callback);
+    // 指定处理请求的事件循环，需在start之前设置；未设置时从EventLoopPool分配
+    void setEventLoop(EventLoop* loop);
 
-    void process();
+    // 设置AI响应回调，在事件循环线程中调用
+    void setTextResponseCallback(std::function<void(const std::string&)> callback);
+    void setAudioResponseCallback(std::function<void(AudioFrame)> callback);
 
 private:
     std::atomic<bool> initialized_{false};
     std::atomic<bool> running_{false};
+    // 检查running_与投递任务在同一临界区内完成，stop()翻转running_后再drain，
+    // 保证不会有任务在drain之后才入队、在引擎销毁后执行
+    std::mutex post_mutex_;
 
     std::function<void(const std::string&)> text_response_callback_;
-    std::function<void(AudioData&)> audio_response_callback_;
+    std::function<void(AudioFrame)> audio_response_callback_;
 
-    std::queue<std::string> text_messages_;
-    std::queue<AudioData> audio_inputs_;
-    
-    std::thread engine_thread_;
-    std::mutex queue_mutex_;
+    EventLoop* loop_;
 
-    void engineLoop();
+    // received为入队时间，用于统计从收到语音到产生回复的轮次延迟
+    void handleText(const std::string& message);
+    void handleAudio(const AudioFrame& frame, std::chrono::steady_clock::time_point received);
     
     // 内部处理方法
     std::string processTextRequest(const std::string& text);
-    AudioData processAudioResponse(const std::string& text);
+    AudioFrame processAudioResponse(const std::string& text);
 };
 
 } // namespace xiaozhi
\ No newline at end of file
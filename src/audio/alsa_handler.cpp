@@ -1,12 +1,36 @@
 #include "alsa_handler.h"
 #include <iostream>
+#include <algorithm>
 #include <cstring>
 #include <unistd.h>
 #include <sys/time.h>
+#include <vector>
+#include <cmath>
+#include "utils/metrics.h"
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
-AlsaHandler::AlsaHandler() : input_handle_(nullptr), output_handle_(nullptr) {
+namespace {
+
+struct AlsaMetrics {
+    Counter& capture_xruns = MetricsRegistry::getInstance().counter(
+        "xiaozhi_audio_capture_xruns_total", "采集流overrun次数");
+    Counter& playback_xruns = MetricsRegistry::getInstance().counter(
+        "xiaozhi_audio_playback_xruns_total", "播放流underrun次数");
+    Counter& recoveries = MetricsRegistry::getInstance().counter(
+        "xiaozhi_audio_device_recoveries_total", "音频设备断开后恢复次数");
+};
+
+AlsaMetrics& alsaMetrics() {
+    static AlsaMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+AlsaHandler::AlsaHandler() : input_handle_(nullptr), output_handle_(nullptr), linked_(false),
+                               capture_active_(false), playback_active_(false), want_link_(false) {
     std::cout << "[AlsaHandler] 初始化ALSA音频处理器" << std::endl;
 }
 
@@ -15,18 +39,21 @@ AlsaHandler::~AlsaHandler() {
     std::cout << "[AlsaHandler] ALSA音频处理器已销毁" << std::endl;
 }
 
-bool AlsaHandler::initialize(int sample_rate, int channels, const std::string& device_name) {
+bool AlsaHandler::initialize(int sample_rate, int channels,
+                             const std::string& input_device, const std::string& output_device) {
     sample_rate_ = sample_rate;
     channels_ = channels;
-    device_name_ = device_name.empty() ? "default" : device_name;
+    input_device_ = input_device.empty() ? "default" : input_device;
+    output_device_ = output_device.empty() ? "default" : output_device;
     
     if (!openAudioDevices()) {
-        std::cerr << "[AlsaHandler] 错误: 无法打开音频设备: " << device_name_ << std::endl;
+        std::cerr << "[AlsaHandler] 错误: 无法打开音频设备: " << input_device_ << " / " << output_device_ << std::endl;
         return false;
     }
     
     std::cout << "[AlsaHandler] 音频设备初始化成功 (采样率: " << sample_rate_ 
-              << ", 通道数: " << channels_ << ", 设备: " << device_name_ << ")" << std::endl;
+              << ", 通道数: " << channels_ << ", 采集设备: " << input_device_
+              << ", 播放设备: " << output_device_ << ")" << std::endl;
     
     return true;
 }
@@ -35,7 +62,7 @@ bool AlsaHandler::openAudioDevices() {
     int err;
     
     // 打开录音设备
-    if ((err = snd_pcm_open(&input_handle_, device_name_.c_str(), SND_PCM_STREAM_CAPTURE, 0)) < 0) {
+    if ((err = snd_pcm_open(&input_handle_, input_device_.c_str(), SND_PCM_STREAM_CAPTURE, 0)) < 0) {
         std::cerr << "[AlsaHandler] 无法打开录音设备: " << snd_strerror(err) << std::endl;
         return false;
     }
@@ -48,7 +75,7 @@ bool AlsaHandler::openAudioDevices() {
     }
     
     // 打开播放设备
-    if ((err = snd_pcm_open(&output_handle_, device_name_.c_str(), SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+    if ((err = snd_pcm_open(&output_handle_, output_device_.c_str(), SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
         std::cerr << "[AlsaHandler] 无法打开播放设备: " << snd_strerror(err) << std::endl;
         if (input_handle_) {
             snd_pcm_close(input_handle_);
@@ -128,6 +155,12 @@ bool AlsaHandler::configureAudioParams(snd_pcm_t* handle, bool is_capture) {
         return false;
     }
     
+    // 启用单调时钟时间戳，用于测量采集/播放时钟漂移（失败不影响正常使用）
+    if (snd_pcm_sw_params_set_tstamp_mode(handle, sw_params, SND_PCM_TSTAMP_ENABLE) < 0 ||
+        snd_pcm_sw_params_set_tstamp_type(handle, sw_params, SND_PCM_TSTAMP_TYPE_MONOTONIC) < 0) {
+        std::cout << "[AlsaHandler] 注意: 设备不支持单调时钟时间戳" << std::endl;
+    }
+    
     if ((err = snd_pcm_sw_params(handle, sw_params)) < 0) {
         std::cerr << "[AlsaHandler] 无法应用软件参数: " << snd_strerror(err) << std::endl;
         return false;
@@ -137,32 +170,59 @@ bool AlsaHandler::configureAudioParams(snd_pcm_t* handle, bool is_capture) {
 }
 
 bool AlsaHandler::readAudioData(AudioData& audio_data, size_t frames) {
-    if (!input_handle_) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (!input_handle_ || device_lost_) {
         return false;
     }
     
     audio_data.resize(frames * channels_);
-    snd_pcm_sframes_t result;
-    
-    result = snd_pcm_readi(input_handle_, audio_data.data(), frames);
+    snd_pcm_sframes_t result = readFrames(audio_data.data(), frames);
+    if (result < 0) {
+        return false;
+    }
     
-    if (result == -EPIPE) {
-        // 缓冲区溢出，恢复
-        snd_pcm_recover(input_handle_, result, 0);
-        result = snd_pcm_readi(input_handle_, audio_data.data(), frames);
+    audio_data.resize(result * channels_);
+    return true;
+}
+
+bool AlsaHandler::readAudioData(AudioFrame& frame, size_t frames) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (!input_handle_ || device_lost_ || !frame || !frame.resize(frames * channels_)) {
+        return false;
     }
     
+    snd_pcm_sframes_t result = readFrames(frame.data(), frames);
     if (result < 0) {
-        std::cerr << "[AlsaHandler] 读取音频数据失败: " << snd_strerror(result) << std::endl;
+        frame.resize(0);
         return false;
     }
     
-    audio_data.resize(result * channels_);
+    frame.resize(result * channels_);
     return true;
 }
 
+snd_pcm_sframes_t AlsaHandler::readFrames(int16_t* buffer, size_t frames) {
+    snd_pcm_sframes_t result = snd_pcm_readi(input_handle_, buffer, frames);
+    
+    // 缓冲区溢出或挂起时就地恢复后重试一次
+    if (result < 0 && handleStreamError(input_handle_, static_cast<int>(result), true)) {
+        result = snd_pcm_readi(input_handle_, buffer, frames);
+    }
+    
+    if (result < 0) {
+        if (!device_lost_) {
+            LOG_EVERY_MS(ERROR, 1000, "[AlsaHandler] 读取音频数据失败: {}", snd_strerror(result));
+        }
+    } else {
+        captured_frames_.fetch_add(result, std::memory_order_relaxed);
+    }
+    
+    return result;
+}
+
 bool AlsaHandler::writeAudioData(const AudioData& audio_data) {
-    if (!output_handle_ || audio_data.empty()) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (!output_handle_ || device_lost_ || audio_data.empty()) {
         return false;
     }
     
@@ -174,58 +234,367 @@ bool AlsaHandler::writeAudioData(const AudioData& audio_data) {
         result = snd_pcm_writei(output_handle_, audio_data.data() + offset * channels_, 
                                frames - offset);
         
-        if (result == -EPIPE) {
-            // 缓冲区欠载，恢复
-            snd_pcm_recover(output_handle_, result, 0);
+        // 缓冲区欠载或挂起时就地恢复后重试一次
+        if (result < 0 && handleStreamError(output_handle_, static_cast<int>(result), false)) {
             result = snd_pcm_writei(output_handle_, audio_data.data() + offset * channels_, 
                                    frames - offset);
-        } else if (result < 0) {
-            std::cerr << "[AlsaHandler] 写入音频数据失败: " << snd_strerror(result) << std::endl;
+        }
+        
+        if (result < 0) {
+            if (!device_lost_) {
+                LOG_EVERY_MS(ERROR, 1000, "[AlsaHandler] 写入音频数据失败: {}", snd_strerror(result));
+            }
             return false;
         }
         
+        played_frames_.fetch_add(result, std::memory_order_relaxed);
         offset += result;
     }
     
     return true;
 }
 
-void AlsaHandler::closeAudioDevices() {
+void AlsaHandler::closeAudioDevices(bool drain) {
+    if (linked_ && input_handle_) {
+        snd_pcm_unlink(input_handle_);
+        linked_ = false;
+    }
+    
+    // 设备已断开时不能drain，否则可能阻塞
     if (input_handle_) {
-        snd_pcm_drain(input_handle_);
+        if (drain) snd_pcm_drain(input_handle_);
         snd_pcm_close(input_handle_);
         input_handle_ = nullptr;
     }
     
     if (output_handle_) {
-        snd_pcm_drain(output_handle_);
+        if (drain) snd_pcm_drain(output_handle_);
         snd_pcm_close(output_handle_);
         output_handle_ = nullptr;
     }
 }
 
 void AlsaHandler::startCapture() {
-    if (input_handle_) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (device_lost_) {
+        return;
+    }
+    
+    if (linked_) {
+        startLinked(capture_active_);
+    } else if (input_handle_) {
         snd_pcm_start(input_handle_);
     }
 }
 
 void AlsaHandler::stopCapture() {
-    if (input_handle_) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (device_lost_) {
+        return;
+    }
+    
+    if (linked_) {
+        stopLinked(capture_active_);
+    } else if (input_handle_) {
         snd_pcm_drop(input_handle_);
     }
 }
 
 void AlsaHandler::startPlayback() {
-    if (output_handle_) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (device_lost_) {
+        return;
+    }
+    
+    if (linked_) {
+        startLinked(playback_active_);
+    } else if (output_handle_) {
         snd_pcm_start(output_handle_);
     }
 }
 
 void AlsaHandler::stopPlayback() {
-    if (output_handle_) {
+    std::shared_lock<std::shared_mutex> lock(device_mutex_);
+    if (device_lost_) {
+        return;
+    }
+    
+    if (linked_) {
+        stopLinked(playback_active_);
+    } else if (output_handle_) {
         snd_pcm_drop(output_handle_);
     }
 }
 
+bool AlsaHandler::linkStreams() {
+    if (!input_handle_ || !output_handle_) {
+        return false;
+    }
+    
+    if (linked_) {
+        return true;
+    }
+    
+    want_link_ = true;
+    int err = snd_pcm_link(input_handle_, output_handle_);
+    if (err < 0) {
+        std::cerr << "[AlsaHandler] 警告: 无法链接采集和播放流: " << snd_strerror(err) 
+                  << "，将分别启动" << std::endl;
+        return false;
+    }
+    
+    linked_ = true;
+    std::cout << "[AlsaHandler] 采集和播放流已链接，将同步启动" << std::endl;
+    return true;
+}
+
+void AlsaHandler::startLinked(bool& active_flag) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    
+    active_flag = true;
+    if (snd_pcm_state(input_handle_) == SND_PCM_STATE_RUNNING) {
+        return;
+    }
+    
+    // 停止后流处于SETUP状态，需要重新准备
+    snd_pcm_prepare(input_handle_);
+    snd_pcm_prepare(output_handle_);
+    
+    // 先向播放缓冲区预填两个周期的静音，避免同步启动后立即欠载
+    size_t prefill_frames = getPeriodFrames() * 2;
+    std::vector<int16_t> silence(prefill_frames * channels_, 0);
+    snd_pcm_sframes_t written = snd_pcm_writei(output_handle_, silence.data(), prefill_frames);
+    if (written > 0) {
+        played_frames_.fetch_add(written, std::memory_order_relaxed);
+    }
+    
+    // 链接后启动任一流即同时启动两者（预填数据可能已触发自动启动）
+    if (snd_pcm_state(input_handle_) != SND_PCM_STATE_RUNNING) {
+        int err = snd_pcm_start(input_handle_);
+        if (err < 0) {
+            std::cerr << "[AlsaHandler] 同步启动失败: " << snd_strerror(err) << std::endl;
+        }
+    }
+    resetDriftReference();
+}
+
+void AlsaHandler::stopLinked(bool& active_flag) {
+    std::lock_guard<std::mutex> lock(start_mutex_);
+    
+    // 链接的流会被一起停止，只有采集和播放都停止后才真正停止设备
+    active_flag = false;
+    if (!capture_active_ && !playback_active_) {
+        snd_pcm_drop(input_handle_);
+    }
+}
+
+bool AlsaHandler::readStreamPosition(snd_pcm_t* handle, bool is_capture, double& time_sec, double& frames) {
+    snd_pcm_status_t* status;
+    snd_pcm_status_alloca(&status);
+    
+    if (snd_pcm_status(handle, status) < 0 || 
+        snd_pcm_status_get_state(status) != SND_PCM_STATE_RUNNING) {
+        return false;
+    }
+    
+    snd_htimestamp_t timestamp;
+    snd_pcm_status_get_htstamp(status, &timestamp);
+    time_sec = timestamp.tv_sec + timestamp.tv_nsec / 1e9;
+    if (time_sec == 0.0) {
+        return false;
+    }
+    
+    // 硬件实际位置：采集 = 已读取 + 缓冲中待读取；播放 = 已写入 - 缓冲中待播放
+    if (is_capture) {
+        frames = static_cast<double>(captured_frames_.load(std::memory_order_relaxed)) +
+                 static_cast<double>(snd_pcm_status_get_avail(status));
+    } else {
+        frames = static_cast<double>(played_frames_.load(std::memory_order_relaxed)) -
+                 static_cast<double>(snd_pcm_status_get_delay(status));
+    }
+    return true;
+}
+
+bool AlsaHandler::updateDriftEstimate() {
+    std::shared_lock<std::shared_mutex> device_lock(device_mutex_);
+    if (!input_handle_ || !output_handle_ || device_lost_) {
+        return false;
+    }
+    
+    StreamPosition capture_now, playback_now;
+    if (!readStreamPosition(input_handle_, true, capture_now.time_sec, capture_now.frames) ||
+        !readStreamPosition(output_handle_, false, playback_now.time_sec, playback_now.frames)) {
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(drift_mutex_);
+    
+    // xrun或重新启动后以当前位置作为新的基准
+    if (!drift_reference_valid_.exchange(true)) {
+        capture_ref_ = capture_now;
+        playback_ref_ = playback_now;
+        return false;
+    }
+    
+    // 以较长的基准窗口计算速率，抵消单次读取位置的抖动
+    double capture_elapsed = capture_now.time_sec - capture_ref_.time_sec;
+    double playback_elapsed = playback_now.time_sec - playback_ref_.time_sec;
+    if (capture_elapsed < 2.0 || playback_elapsed < 2.0) {
+        return false;
+    }
+    
+    double capture_rate = (capture_now.frames - capture_ref_.frames) / capture_elapsed;
+    double playback_rate = (playback_now.frames - playback_ref_.frames) / playback_elapsed;
+    if (capture_rate <= 0.0 || playback_rate <= 0.0) {
+        return false;
+    }
+    
+    double measured_ratio = playback_rate / capture_rate;
+    if (std::fabs(measured_ratio - 1.0) > 0.01) {
+        // 偏差超过1%视为测量异常（例如刚发生过欠载），丢弃并重新建立基准
+        drift_reference_valid_ = false;
+        return false;
+    }
+    
+    // 指数平滑，避免比值跳变引起可闻的音调抖动
+    if (drift_stats_.measurements == 0) {
+        drift_stats_.playback_ratio = measured_ratio;
+    } else {
+        drift_stats_.playback_ratio = drift_stats_.playback_ratio * 0.8 + measured_ratio * 0.2;
+    }
+    drift_stats_.drift_ppm = (drift_stats_.playback_ratio - 1.0) * 1e6;
+    drift_stats_.linked = linked_;
+    drift_stats_.measurements++;
+    return true;
+}
+
+DriftStats AlsaHandler::getDriftStats() const {
+    std::lock_guard<std::mutex> lock(drift_mutex_);
+    DriftStats stats = drift_stats_;
+    stats.linked = linked_;
+    return stats;
+}
+
+void AlsaHandler::resetDriftReference() {
+    drift_reference_valid_ = false;
+}
+
+bool AlsaHandler::handleStreamError(snd_pcm_t* handle, int err, bool is_capture) {
+    if (err == -EPIPE) {
+        // xrun：计数并恢复
+        (is_capture ? capture_xruns_ : playback_xruns_).fetch_add(1, std::memory_order_relaxed);
+        (is_capture ? alsaMetrics().capture_xruns : alsaMetrics().playback_xruns).inc();
+        resetDriftReference();
+        return snd_pcm_recover(handle, err, 1) == 0;
+    }
+    
+    if (err == -ESTRPIPE) {
+        // 系统挂起：等待硬件恢复，不支持resume的设备重新prepare
+        suspends_.fetch_add(1, std::memory_order_relaxed);
+        resetDriftReference();
+        int res;
+        int attempts = 0;
+        while ((res = snd_pcm_resume(handle)) == -EAGAIN && attempts++ < 100) {
+            usleep(10000);
+        }
+        if (res < 0 && res != -ENODEV) {
+            res = snd_pcm_prepare(handle);
+        }
+        if (res == -ENODEV) {
+            markDeviceLost();
+            return false;
+        }
+        return res == 0;
+    }
+    
+    if (err == -ENODEV || snd_pcm_state(handle) == SND_PCM_STATE_DISCONNECTED) {
+        markDeviceLost();
+    }
+    return false;
+}
+
+void AlsaHandler::markDeviceLost() {
+    if (device_lost_.exchange(true)) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(recovery_mutex_);
+        lost_time_ = std::chrono::steady_clock::now();
+    }
+    device_losses_.fetch_add(1, std::memory_order_relaxed);
+    std::cerr << "[AlsaHandler] 音频设备已断开: " << input_device_ << " / " << output_device_ << "，等待重新连接" << std::endl;
+    
+    if (device_lost_callback_) {
+        device_lost_callback_();
+    }
+}
+
+bool AlsaHandler::reopenDevices() {
+    std::unique_lock<std::shared_mutex> lock(device_mutex_);
+    
+    closeAudioDevices(false);
+    if (!openAudioDevices()) {
+        return false;
+    }
+    
+    if (want_link_) {
+        linkStreams();
+    }
+    
+    // 恢复断开前的运行状态，上层的编解码器、混音器和回调均保持不变
+    resetDriftReference();
+    if (linked_ && (capture_active_ || playback_active_)) {
+        bool& active_flag = capture_active_ ? capture_active_ : playback_active_;
+        startLinked(active_flag);
+    } else if (capture_active_) {
+        snd_pcm_start(input_handle_);
+    }
+    
+    double recovery_ms;
+    {
+        std::lock_guard<std::mutex> recovery_lock(recovery_mutex_);
+        recovery_ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - lost_time_).count();
+        recoveries_++;
+        last_recovery_ms_ = recovery_ms;
+        alsaMetrics().recoveries.inc();
+        max_recovery_ms_ = std::max(max_recovery_ms_, recovery_ms);
+    }
+    
+    {
+        std::lock_guard<std::mutex> wait_lock(device_wait_mutex_);
+        device_lost_ = false;
+    }
+    device_cv_.notify_all();
+    
+    std::cout << "[AlsaHandler] 音频设备已恢复: " << input_device_ << " / " << output_device_ 
+              << " (耗时: " << recovery_ms << "ms)" << std::endl;
+    return true;
+}
+
+bool AlsaHandler::waitForDevice(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(device_wait_mutex_);
+    return device_cv_.wait_for(lock, timeout, [this] { return !device_lost_; });
+}
+
+void AlsaHandler::setDeviceLostCallback(std::function<void()> callback) {
+    device_lost_callback_ = callback;
+}
+
+AudioRecoveryStats AlsaHandler::getRecoveryStats() const {
+    AudioRecoveryStats stats;
+    stats.capture_xruns = capture_xruns_.load(std::memory_order_relaxed);
+    stats.playback_xruns = playback_xruns_.load(std::memory_order_relaxed);
+    stats.suspends = suspends_.load(std::memory_order_relaxed);
+    stats.device_losses = device_losses_.load(std::memory_order_relaxed);
+    stats.device_lost = device_lost_;
+    
+    std::lock_guard<std::mutex> lock(recovery_mutex_);
+    stats.recoveries = recoveries_;
+    stats.last_recovery_ms = last_recovery_ms_;
+    stats.max_recovery_ms = max_recovery_ms_;
+    return stats;
+}
+
 } // namespace xiaozhi
\ No newline at end of file
@@ -1,39 +1,115 @@
 #pragma once
 
 #include <string>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <cstdint>
 #include <alsa/asoundlib.h>
 #include "xiaozhi_types.h"
+#include "audio_backend.h"
 
 namespace xiaozhi {
 
-class AlsaHandler {
+class AlsaHandler : public AudioBackend {
 public:
     AlsaHandler();
-    ~AlsaHandler();
+    ~AlsaHandler() override;
 
-    bool initialize(int sample_rate = 16000, int channels = 1, const std::string& device_name = "");
+    bool initialize(int sample_rate = 16000, int channels = 1,
+                    const std::string& input_device = "", const std::string& output_device = "") override;
     
     // 音频数据读取/写入
     bool readAudioData(AudioData& audio_data, size_t frames = 320);  // 默认60ms数据 (16kHz下)
-    bool writeAudioData(const AudioData& audio_data);
+    bool readAudioData(AudioFrame& frame, size_t frames = 320) override;  // 直接读入帧池中的帧
+    bool writeAudioData(const AudioData& audio_data) override;
 
     // 控制方法
-    void startCapture();
-    void stopCapture();
-    void startPlayback();
-    void stopPlayback();
+    void startCapture() override;
+    void stopCapture() override;
+    void startPlayback() override;
+    void stopPlayback() override;
+
+    const char* getName() const override { return "alsa"; }
+
+    // 全双工同步：链接采集和播放流，使两者同时启动
+    bool linkStreams() override;
+    bool isLinked() const { return linked_; }
+
+    // 基于snd_pcm_status时间戳测量时钟漂移，测量窗口足够长时返回true
+    bool updateDriftEstimate() override;
+    DriftStats getDriftStats() const override;
+
+    size_t getPeriodFrames() const { return static_cast<size_t>(sample_rate_ / 100); }
+
+    // 设备断开检测与就地恢复：重新打开并配置句柄，恢复之前的运行状态
+    bool supportsHotplug() const override { return true; }
+    bool isDeviceLost() const override { return device_lost_; }
+    bool reopenDevices() override;
+    bool waitForDevice(std::chrono::milliseconds timeout) override;
+    void setDeviceLostCallback(std::function<void()> callback) override;
+    AudioRecoveryStats getRecoveryStats() const override;
+    const std::string& getInputDevice() const { return input_device_; }
+    const std::string& getOutputDevice() const { return output_device_; }
 
 private:
     bool openAudioDevices();
     bool configureAudioParams(snd_pcm_t* handle, bool is_capture);
-    void closeAudioDevices();
+    void closeAudioDevices(bool drain = true);
+    bool handleStreamError(snd_pcm_t* handle, int err, bool is_capture);
+    void markDeviceLost();
+    snd_pcm_sframes_t readFrames(int16_t* buffer, size_t frames);
+    void startLinked(bool& active_flag);
+    void stopLinked(bool& active_flag);
+    bool readStreamPosition(snd_pcm_t* handle, bool is_capture, double& time_sec, double& frames);
+    void resetDriftReference();
 
     snd_pcm_t* input_handle_;
     snd_pcm_t* output_handle_;
     
     int sample_rate_;
     int channels_;
-    std::string device_name_;
+    std::string input_device_;
+    std::string output_device_;
+
+    // 全双工同步与漂移测量
+    bool linked_;
+    bool capture_active_;
+    bool playback_active_;
+    std::mutex start_mutex_;
+    std::atomic<uint64_t> captured_frames_{0};
+    std::atomic<uint64_t> played_frames_{0};
+    std::atomic<bool> drift_reference_valid_{false};
+
+    struct StreamPosition {
+        double time_sec = 0.0;
+        double frames = 0.0;
+    };
+    StreamPosition capture_ref_;
+    StreamPosition playback_ref_;
+    mutable std::mutex drift_mutex_;
+    DriftStats drift_stats_;
+
+    // 读写路径持有共享锁，重新打开设备时持有独占锁
+    std::shared_mutex device_mutex_;
+    std::atomic<bool> device_lost_{false};
+    bool want_link_;
+    std::function<void()> device_lost_callback_;
+    std::chrono::steady_clock::time_point lost_time_;
+    std::mutex device_wait_mutex_;
+    std::condition_variable device_cv_;
+
+    std::atomic<uint64_t> capture_xruns_{0};
+    std::atomic<uint64_t> playback_xruns_{0};
+    std::atomic<uint64_t> suspends_{0};
+    std::atomic<uint64_t> device_losses_{0};
+    mutable std::mutex recovery_mutex_;
+    uint64_t recoveries_ = 0;
+    double last_recovery_ms_ = 0.0;
+    double max_recovery_ms_ = 0.0;
 };
 
 } // namespace xiaozhi
\ No newline at end of file
@@ -0,0 +1,46 @@
+#include "audio_backend.h"
+#include "alsa_handler.h"
+#include "file_backend.h"
+#include "null_backend.h"
+#include <thread>
+
+namespace xiaozhi {
+
+std::unique_ptr<AudioBackend> createAudioBackend(const AudioBackendConfig& config) {
+    if (config.type.empty() || config.type == "alsa") {
+        return std::make_unique<AlsaHandler>();
+    }
+    if (config.type == "file") {
+        return std::make_unique<FileAudioBackend>(config);
+    }
+    if (config.type == "null") {
+        return std::make_unique<NullAudioBackend>(config.realtime);
+    }
+    return nullptr;
+}
+
+void FramePacer::reset(int sample_rate) {
+    sample_rate_ = sample_rate > 0 ? sample_rate : 16000;
+    frames_elapsed_ = 0;
+    started_ = false;
+}
+
+void FramePacer::wait(size_t frames) {
+    auto now = std::chrono::steady_clock::now();
+    if (!started_) {
+        start_ = now;
+        started_ = true;
+    }
+
+    frames_elapsed_ += frames;
+    auto deadline = start_ + std::chrono::microseconds(frames_elapsed_ * 1000000 / sample_rate_);
+    if (deadline > now) {
+        std::this_thread::sleep_until(deadline);
+    } else if (now - deadline > std::chrono::milliseconds(200)) {
+        // 调用方长时间未读写（相当于硬件xrun），重新建立节拍基准而不是突发追赶
+        start_ = now;
+        frames_elapsed_ = 0;
+    }
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "xiaozhi_types.h"
+#include "audio_frame_pool.h"
+
+namespace xiaozhi {
+
+// 采集/播放时钟漂移测量结果
+struct DriftStats {
+    bool linked = false;          // 采集和播放是否通过snd_pcm_link同步启动
+    double drift_ppm = 0.0;       // 播放时钟相对采集时钟的偏差 (ppm)
+    double playback_ratio = 1.0;  // 播放数据需要乘以的重采样比值
+    uint64_t measurements = 0;
+};
+
+// xrun与设备热插拔恢复统计
+struct AudioRecoveryStats {
+    uint64_t capture_xruns = 0;
+    uint64_t playback_xruns = 0;
+    uint64_t suspends = 0;          // -ESTRPIPE（系统挂起）次数
+    uint64_t device_losses = 0;     // -ENODEV（设备断开）次数
+    uint64_t recoveries = 0;        // 成功重新打开设备的次数
+    double last_recovery_ms = 0.0;  // 从检测到断开到恢复的耗时
+    double max_recovery_ms = 0.0;
+    bool device_lost = false;
+};
+
+// 音频后端配置
+struct AudioBackendConfig {
+    std::string type = "alsa";     // "alsa" | "file" | "null"
+    std::string input_device;      // ALSA采集设备名，为空时使用default
+    std::string output_device;     // ALSA播放设备名，为空时使用default
+    std::string input_file;        // file后端：采集数据来源 (WAV或raw S16_LE)
+    std::string output_file;       // file后端：播放数据写入位置，为空则丢弃
+    bool realtime = true;          // file/null后端：按采样率节拍读写，false为尽快处理
+    bool loop = false;             // file后端：输入文件结束后从头循环
+};
+
+// 音频输入输出后端接口：ALSA为真实设备，file/null用于无声卡环境下的测试与基准
+class AudioBackend {
+public:
+    virtual ~AudioBackend() = default;
+
+    // 采集和播放可以是不同的设备；file/null后端忽略设备名
+    virtual bool initialize(int sample_rate, int channels,
+                            const std::string& input_device, const std::string& output_device) = 0;
+
+    // 读取frames帧（每通道）到帧中；写入交织的PCM数据
+    virtual bool readAudioData(AudioFrame& frame, size_t frames) = 0;
+    virtual bool writeAudioData(const AudioData& audio_data) = 0;
+
+    virtual void startCapture() = 0;
+    virtual void stopCapture() = 0;
+    virtual void startPlayback() = 0;
+    virtual void stopPlayback() = 0;
+
+    virtual const char* getName() const = 0;
+
+    // 全双工同步与漂移测量，仅真实设备支持
+    virtual bool linkStreams() { return false; }
+    virtual bool updateDriftEstimate() { return false; }
+    virtual DriftStats getDriftStats() const { return DriftStats(); }
+
+    // 设备断开与恢复，仅支持热插拔的后端需要实现
+    virtual bool supportsHotplug() const { return false; }
+    virtual bool isDeviceLost() const { return false; }
+    virtual bool reopenDevices() { return false; }
+    virtual bool waitForDevice(std::chrono::milliseconds /*timeout*/) { return true; }
+    virtual void setDeviceLostCallback(std::function<void()> /*callback*/) {}
+    virtual AudioRecoveryStats getRecoveryStats() const { return AudioRecoveryStats(); }
+};
+
+// 根据配置创建后端，类型未知时返回nullptr
+std::unique_ptr<AudioBackend> createAudioBackend(const AudioBackendConfig& config);
+
+// 按采样率节拍等待，使非硬件后端的读写速度与真实设备一致
+class FramePacer {
+public:
+    void reset(int sample_rate);
+    void wait(size_t frames);
+
+private:
+    int sample_rate_ = 16000;
+    uint64_t frames_elapsed_ = 0;
+    std::chrono::steady_clock::time_point start_;
+    bool started_ = false;
+};
+
+} // namespace xiaozhi
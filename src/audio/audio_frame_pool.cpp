@@ -0,0 +1,211 @@
+#include "audio_frame_pool.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace xiaozhi {
+
+AudioFrame::~AudioFrame() {
+    reset();
+}
+
+AudioFrame::AudioFrame(AudioFrame&& other) noexcept : slot_(other.slot_) {
+    other.slot_ = nullptr;
+}
+
+AudioFrame& AudioFrame::operator=(AudioFrame&& other) noexcept {
+    if (this != &other) {
+        reset();
+        slot_ = other.slot_;
+        other.slot_ = nullptr;
+    }
+    return *this;
+}
+
+int16_t* AudioFrame::data() {
+    return slot_ ? slot_->samples : nullptr;
+}
+
+const int16_t* AudioFrame::data() const {
+    return slot_ ? slot_->samples : nullptr;
+}
+
+size_t AudioFrame::size() const {
+    return slot_ ? slot_->size : 0;
+}
+
+size_t AudioFrame::capacity() const {
+    return slot_ ? slot_->capacity : 0;
+}
+
+bool AudioFrame::resize(size_t samples) {
+    if (!slot_ || samples > slot_->capacity) {
+        return false;
+    }
+    slot_->size = samples;
+    return true;
+}
+
+AudioFrame AudioFrame::share() const {
+    if (!slot_) {
+        return AudioFrame();
+    }
+    slot_->refs.fetch_add(1, std::memory_order_relaxed);
+    return AudioFrame(slot_);
+}
+
+AudioData AudioFrame::toAudioData() const {
+    if (!slot_) {
+        return {};
+    }
+    return AudioData(slot_->samples, slot_->samples + slot_->size);
+}
+
+void AudioFrame::reset() {
+    if (!slot_) {
+        return;
+    }
+
+    Slot* slot = slot_;
+    slot_ = nullptr;
+    if (slot->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+
+    if (slot->pool) {
+        slot->pool->release(slot);
+    } else {
+        delete[] slot->samples;
+        delete slot;
+    }
+}
+
+AudioFramePool& AudioFramePool::getInstance() {
+    static AudioFramePool instance;
+    return instance;
+}
+
+bool AudioFramePool::initialize(int sample_rate, int channels, int max_frame_ms, size_t frame_count) {
+    if (sample_rate <= 0 || channels <= 0 || max_frame_ms <= 0 || frame_count == 0 ||
+        frame_count >= kNilIndex) {
+        std::cerr << "[AudioFramePool] 错误: 无效的帧池参数" << std::endl;
+        return false;
+    }
+
+    if (in_use_.load() > 0) {
+        std::cerr << "[AudioFramePool] 错误: 仍有音频帧未归还，无法重新初始化" << std::endl;
+        return false;
+    }
+
+    frame_samples_ = static_cast<size_t>(sample_rate) * max_frame_ms / 1000 * channels;
+    frame_count_ = frame_count;
+
+    slab_.reset(new int16_t[frame_samples_ * frame_count_]());
+    slots_.reset(new AudioFrame::Slot[frame_count_]);
+    next_free_.reset(new std::atomic<uint32_t>[frame_count_]);
+
+    for (size_t i = 0; i < frame_count_; ++i) {
+        AudioFrame::Slot& slot = slots_[i];
+        slot.samples = slab_.get() + i * frame_samples_;
+        slot.capacity = frame_samples_;
+        slot.pool = this;
+        slot.index = static_cast<uint32_t>(i);
+        next_free_[i].store(i + 1 < frame_count_ ? static_cast<uint32_t>(i + 1) : kNilIndex);
+    }
+    free_head_.store(0);
+
+    std::cout << "[AudioFramePool] 音频帧池初始化完成 (帧数: " << frame_count_
+              << ", 每帧采样点: " << frame_samples_
+              << ", 总大小: " << frame_samples_ * frame_count_ * sizeof(int16_t) / 1024 << "KB)" << std::endl;
+    return true;
+}
+
+AudioFrame AudioFramePool::acquire(size_t samples) {
+    acquired_.fetch_add(1, std::memory_order_relaxed);
+
+    AudioFrame::Slot* slot = samples <= frame_samples_ ? popFree() : nullptr;
+    if (!slot) {
+        // 帧池耗尽或请求长度超过帧容量，退化为堆分配
+        if (exhausted_.fetch_add(1, std::memory_order_relaxed) == 0 && frame_count_ > 0) {
+            std::cerr << "[AudioFramePool] 警告: 帧池耗尽，使用堆分配 (请求采样点: "
+                      << samples << ")" << std::endl;
+        }
+        slot = allocateFallback(samples);
+    } else {
+        size_t in_use = in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+        size_t peak = peak_in_use_.load(std::memory_order_relaxed);
+        while (in_use > peak &&
+               !peak_in_use_.compare_exchange_weak(peak, in_use, std::memory_order_relaxed)) {
+        }
+    }
+
+    slot->refs.store(1, std::memory_order_relaxed);
+    slot->size = samples;
+    return AudioFrame(slot);
+}
+
+AudioFrame AudioFramePool::acquireCopy(const int16_t* samples, size_t count) {
+    AudioFrame frame = acquire(count);
+    if (count > 0) {
+        std::memcpy(frame.data(), samples, count * sizeof(int16_t));
+    }
+    return frame;
+}
+
+AudioFramePoolStats AudioFramePool::getStats() const {
+    AudioFramePoolStats stats;
+    stats.frame_count = frame_count_;
+    stats.frame_samples = frame_samples_;
+    stats.in_use = in_use_.load(std::memory_order_relaxed);
+    stats.peak_in_use = peak_in_use_.load(std::memory_order_relaxed);
+    stats.acquired = acquired_.load(std::memory_order_relaxed);
+    stats.exhausted = exhausted_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+AudioFrame::Slot* AudioFramePool::popFree() {
+    uint64_t head = free_head_.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t index = static_cast<uint32_t>(head & 0xffffffffu);
+        if (index == kNilIndex || index >= frame_count_) {
+            return nullptr;
+        }
+        uint32_t next = next_free_[index].load(std::memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | next;
+        if (free_head_.compare_exchange_weak(head, new_head,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire)) {
+            return &slots_[index];
+        }
+    }
+}
+
+void AudioFramePool::pushFree(AudioFrame::Slot* slot) {
+    uint64_t head = free_head_.load(std::memory_order_relaxed);
+    while (true) {
+        next_free_[slot->index].store(static_cast<uint32_t>(head & 0xffffffffu),
+                                      std::memory_order_relaxed);
+        uint64_t new_head = (((head >> 32) + 1) << 32) | slot->index;
+        if (free_head_.compare_exchange_weak(head, new_head,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+            return;
+        }
+    }
+}
+
+void AudioFramePool::release(AudioFrame::Slot* slot) {
+    slot->size = 0;
+    pushFree(slot);
+    in_use_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+AudioFrame::Slot* AudioFramePool::allocateFallback(size_t samples) {
+    auto* slot = new AudioFrame::Slot();
+    slot->capacity = std::max(samples, frame_samples_);
+    slot->samples = new int16_t[slot->capacity];
+    slot->pool = nullptr;
+    return slot;
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include "xiaozhi_types.h"
+
+namespace xiaozhi {
+
+class AudioFramePool;
+
+// 音频帧句柄：引用计数，只能移动不能拷贝，析构时归还到帧池
+// share()增加引用用于多个处理阶段同时只读访问同一帧
+class AudioFrame {
+public:
+    AudioFrame() = default;
+    ~AudioFrame();
+
+    AudioFrame(AudioFrame&& other) noexcept;
+    AudioFrame& operator=(AudioFrame&& other) noexcept;
+    AudioFrame(const AudioFrame&) = delete;
+    AudioFrame& operator=(const AudioFrame&) = delete;
+
+    int16_t* data();
+    const int16_t* data() const;
+    size_t size() const;
+    size_t capacity() const;
+    bool empty() const { return size() == 0; }
+    explicit operator bool() const { return slot_ != nullptr; }
+
+    // 调整有效采样点数，不能超过容量
+    bool resize(size_t samples);
+
+    // 增加引用计数，返回指向同一块数据的新句柄
+    AudioFrame share() const;
+
+    // 拷贝为AudioData，供仍使用旧接口的模块使用
+    AudioData toAudioData() const;
+
+    void reset();
+
+private:
+    friend class AudioFramePool;
+
+    struct Slot {
+        std::atomic<uint32_t> refs{0};
+        size_t size = 0;
+        size_t capacity = 0;
+        int16_t* samples = nullptr;
+        AudioFramePool* pool = nullptr;  // 为空表示帧池耗尽时的堆分配
+        uint32_t index = 0;
+    };
+
+    explicit AudioFrame(Slot* slot) : slot_(slot) {}
+
+    Slot* slot_ = nullptr;
+};
+
+struct AudioFramePoolStats {
+    size_t frame_count = 0;       // 帧池容量（帧数）
+    size_t frame_samples = 0;     // 每帧最大采样点数
+    size_t in_use = 0;            // 当前被占用的帧数
+    size_t peak_in_use = 0;       // 峰值占用
+    uint64_t acquired = 0;        // 累计申请次数
+    uint64_t exhausted = 0;       // 帧池耗尽或超长导致的堆分配次数
+};
+
+// 预分配的音频帧池：启动时按采样率和帧时长一次性分配，
+// 实时音频路径上申请/归还为无锁操作，不再调用malloc/free
+class AudioFramePool {
+public:
+    static AudioFramePool& getInstance();
+
+    // 按采样率、通道数和最大帧时长计算每帧容量，frame_count为帧数
+    bool initialize(int sample_rate, int channels, int max_frame_ms, size_t frame_count);
+
+    // 申请一帧，有效长度设为samples；帧池耗尽时退化为堆分配并计数
+    AudioFrame acquire(size_t samples);
+
+    // 从AudioData拷贝生成一帧
+    AudioFrame acquireCopy(const int16_t* samples, size_t count);
+
+    AudioFramePoolStats getStats() const;
+    size_t getFrameSamples() const { return frame_samples_; }
+
+private:
+    friend class AudioFrame;
+
+    AudioFramePool() = default;
+    ~AudioFramePool() = default;
+
+    AudioFrame::Slot* popFree();
+    void pushFree(AudioFrame::Slot* slot);
+    void release(AudioFrame::Slot* slot);
+    AudioFrame::Slot* allocateFallback(size_t samples);
+
+    static constexpr uint32_t kNilIndex = 0xffffffffu;
+
+    size_t frame_count_ = 0;
+    size_t frame_samples_ = 0;
+
+    std::unique_ptr<int16_t[]> slab_;
+    std::unique_ptr<AudioFrame::Slot[]> slots_;
+    std::unique_ptr<std::atomic<uint32_t>[]> next_free_;
+
+    // 无锁空闲链表头：高32位为版本号防止ABA，低32位为槽位索引
+    std::atomic<uint64_t> free_head_{kNilIndex};
+
+    std::atomic<size_t> in_use_{0};
+    std::atomic<size_t> peak_in_use_{0};
+    std::atomic<uint64_t> acquired_{0};
+    std::atomic<uint64_t> exhausted_{0};
+};
+
+} // namespace xiaozhi
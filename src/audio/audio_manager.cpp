@@ -1,22 +1,27 @@
 #include "audio_manager.h"
-#include "alsa_handler.h"
+#include "audio_backend.h"
 #include "opus_encoder.h"
 #include "opus_decoder.h"
+#include "device_supervisor.h"
 #include <iostream>
 #include <chrono>
 #include <cstring>
 #include <thread>
-#include <alsa/asoundlib.h>
+#include "utils/realtime.h"
+#include "utils/trace.h"
 
 namespace xiaozhi {
 
-AudioManager::AudioManager() : sample_rate_(16000), channels_(1) {
+AudioManager::AudioManager() : sample_rate_(16000), channels_(1), duplex_sync_(false), playback_source_id_(-1) {
     std::cout << "[AudioManager] 初始化音频管理器" << std::endl;
 }
 
 AudioManager::~AudioManager() {
     stopRecording();
     stopPlayback();
+    if (device_supervisor_) {
+        device_supervisor_->stop();
+    }
     if (record_thread_.joinable()) {
         record_thread_.join();
     }
@@ -26,17 +31,41 @@ AudioManager::~AudioManager() {
     std::cout << "[AudioManager] 音频管理器已销毁" << std::endl;
 }
 
-bool AudioManager::initialize(int sample_rate, int channels) {
+bool AudioManager::initialize(int sample_rate, int channels, size_t frame_pool_size) {
     sample_rate_ = sample_rate;
     channels_ = channels;
     
-    // 初始化ALSA处理器
-    alsa_handler_ = std::make_unique<AlsaHandler>();
-    if (!alsa_handler_->initialize(sample_rate, channels)) {
-        std::cerr << "[AudioManager] ALSA处理器初始化失败" << std::endl;
+    // 初始化音频帧池，每帧按Opus最大包时长(120ms)预留空间
+    if (!AudioFramePool::getInstance().initialize(sample_rate, channels, 120, frame_pool_size)) {
+        std::cerr << "[AudioManager] 音频帧池初始化失败" << std::endl;
         return false;
     }
     
+    // 初始化音频后端（未注入时按配置创建）
+    if (!backend_) {
+        backend_ = createAudioBackend(backend_config_);
+        if (!backend_) {
+            std::cerr << "[AudioManager] 未知的音频后端类型: " << backend_config_.type << std::endl;
+            return false;
+        }
+    }
+    if (!backend_->initialize(sample_rate, channels, backend_config_.input_device, backend_config_.output_device)) {
+        std::cerr << "[AudioManager] 音频后端初始化失败: " << backend_->getName() << std::endl;
+        return false;
+    }
+    
+    // 启动设备监控：设备断开后就地重新打开，无需重启守护进程
+    if (backend_->supportsHotplug()) {
+        device_supervisor_ = std::make_unique<DeviceSupervisor>(*backend_);
+        device_supervisor_->start();
+    }
+    
+    // 全双工同步：链接失败时仍进行漂移补偿，只是两路流分别启动
+    if (duplex_sync_) {
+        backend_->linkStreams();
+        drift_compensator_.initialize(channels);
+    }
+    
     // 初始化Opus编码器
     opus_encoder_ = std::make_unique<OpusEncoder>();
     if (!opus_encoder_->initialize(sample_rate, channels, 32000)) {
@@ -51,6 +80,17 @@ bool AudioManager::initialize(int sample_rate, int channels) {
         return false;
     }
 
+    // 初始化混音器，所有播放源统一混合后写入同一个播放句柄
+    mixer_ = std::make_unique<AudioMixer>();
+    if (!mixer_->initialize(sample_rate, channels, 20)) {
+        std::cerr << "[AudioManager] 混音器初始化失败" << std::endl;
+        return false;
+    }
+    mixer_->setDucking(MixPriority::SPEECH, 0.25f, 300);
+    if (playback_callback_) {
+        playback_source_id_ = mixer_->addSource("default", MixPriority::SPEECH, playback_callback_);
+    }
+
     std::cout << "[AudioManager] 音频系统初始化完成 (采样率: " << sample_rate 
               << ", 通道数: " << channels << ")" << std::endl;
     
@@ -97,6 +137,7 @@ void AudioManager::startPlayback() {
 void AudioManager::stopPlayback() {
     if (playing_) {
         playing_ = false;
+        mixer_->wakeUp();
         if (play_thread_.joinable()) {
             play_thread_.join();
         }
@@ -104,72 +145,178 @@ void AudioManager::stopPlayback() {
     }
 }
 
-void AudioManager::process() {
-    // 处理音频相关任务
-    // 在实际实现中，这里会处理音频数据流
+AudioRecoveryStats AudioManager::getRecoveryStats() const {
+    return backend_ ? backend_->getRecoveryStats() : AudioRecoveryStats();
+}
+
+void AudioManager::setBackend(std::unique_ptr<AudioBackend> backend) {
+    if (initialized_) {
+        std::cerr << "[AudioManager] 错误: 音频系统已初始化，无法替换后端" << std::endl;
+        return;
+    }
+    backend_ = std::move(backend);
+}
+
+bool AudioManager::waitIfDeviceLost() {
+    if (!backend_->isDeviceLost()) {
+        return false;
+    }
+    // 设备断开期间阻塞等待监控线程恢复，而不是每10ms空转重试
+    backend_->waitForDevice(std::chrono::milliseconds(200));
+    return true;
 }
 
 void AudioManager::setRecordCallback(std::function<void(const AudioData&)> callback) {
     record_callback_ = callback;
 }
 
+void AudioManager::setRecordFrameCallback(std::function<void(AudioFrame)> callback) {
+    record_frame_callback_ = callback;
+}
+
 void AudioManager::setPlaybackCallback(std::function<void(AudioData&)> callback) {
     playback_callback_ = callback;
+
+    // 兼容单回调接口：回调作为默认的语音播放源接入混音器
+    if (mixer_) {
+        if (playback_source_id_ >= 0) {
+            mixer_->removeSource(playback_source_id_);
+            playback_source_id_ = -1;
+        }
+        if (playback_callback_) {
+            playback_source_id_ = mixer_->addSource("default", MixPriority::SPEECH, playback_callback_);
+        }
+    }
+}
+
+int AudioManager::addPlaybackSource(const std::string& name,
+                                    MixPriority priority,
+                                    std::function<void(AudioData&)> pull_callback) {
+    if (!mixer_) {
+        std::cerr << "[AudioManager] 错误: 音频系统未初始化" << std::endl;
+        return -1;
+    }
+    return mixer_->addSource(name, priority, pull_callback);
+}
+
+void AudioManager::removePlaybackSource(int source_id) {
+    if (mixer_) {
+        mixer_->removeSource(source_id);
+    }
+}
+
+bool AudioManager::queuePlayback(int source_id, const AudioData& audio_data) {
+    return mixer_ && mixer_->pushAudio(source_id, audio_data);
 }
 
 void AudioManager::recordLoop() {
-    if (!alsa_handler_) {
-        std::cerr << "[AudioManager] 错误: ALSA处理器未初始化" << std::endl;
+    if (!backend_) {
+        std::cerr << "[AudioManager] 错误: 音频后端未初始化" << std::endl;
         return;
     }
     
+    RealtimeManager::getInstance().applyToCurrentThread(ThreadRole::CAPTURE);
+    TRACE_THREAD_NAME("audio-capture");
+    
     // 启动录音
-    alsa_handler_->startCapture();
+    backend_->startCapture();
     
-    // 实际录音循环
+    // 实际录音循环：数据直接读入帧池中的帧，录音路径上不分配内存
+    auto& frame_pool = AudioFramePool::getInstance();
+    const size_t read_frames = 320;
+    AudioData legacy_buffer;
+    legacy_buffer.reserve(read_frames * channels_);
     while (recording_) {
-        AudioData audio_data;
-        // 从ALSA设备读取音频数据
-        if (alsa_handler_->readAudioData(audio_data, 320)) { // 读取60ms数据
+        AudioFrame frame = frame_pool.acquire(read_frames * channels_);
+        // 从音频后端读取音频数据
+        bool has_frame;
+        {
+            TRACE_SCOPE("audio", "capture.read");
+            has_frame = backend_->readAudioData(frame, read_frames);
+        }
+        if (has_frame) { // 读取60ms数据
+            TRACE_SCOPE("audio", "capture.dispatch");
             if (record_callback_) {
-                record_callback_(audio_data);
+                legacy_buffer.assign(frame.data(), frame.data() + frame.size());
+                record_callback_(legacy_buffer);
+            }
+            if (record_frame_callback_) {
+                record_frame_callback_(std::move(frame));
             }
-        } else {
+        } else if (!waitIfDeviceLost()) {
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
     }
     
     // 停止录音
-    alsa_handler_->stopCapture();
+    backend_->stopCapture();
 }
 
 void AudioManager::playLoop() {
-    if (!alsa_handler_) {
-        std::cerr << "[AudioManager] 错误: ALSA处理器未初始化" << std::endl;
+    if (!backend_ || !mixer_) {
+        std::cerr << "[AudioManager] 错误: 音频后端未初始化" << std::endl;
         return;
     }
     
+    RealtimeManager::getInstance().applyToCurrentThread(ThreadRole::PLAYBACK);
+    TRACE_THREAD_NAME("audio-playback");
+    
     // 启动播放
-    alsa_handler_->startPlayback();
+    backend_->startPlayback();
     
-    // 实际播放循环
+    // 实际播放循环：混合所有播放源后写入同一个播放后端
+    AudioData audio_data;
+    AudioData compensated;
+    audio_data.reserve(mixer_->getFrameSamples());
+    auto last_drift_check = std::chrono::steady_clock::now();
     while (playing_) {
-        AudioData audio_data;
-        if (playback_callback_) {
-            playback_callback_(audio_data);
-            
-            // 将音频数据发送到ALSA设备进行播放
-            if (!audio_data.empty()) {
-                alsa_handler_->writeAudioData(audio_data);
+        if (waitIfDeviceLost()) {
+            drift_compensator_.reset();
+            continue;
+        }
+        
+        bool has_audio;
+        {
+            TRACE_SCOPE("audio", "playback.mix");
+            has_audio = mixer_->mix(audio_data);
+        }
+        if (!has_audio && !duplex_sync_) {
+            // 所有播放源均无数据，阻塞到有数据推入或停止播放
+            mixer_->waitForAudio(std::chrono::milliseconds(1000));
+            continue;
+        }
+        
+        if (!duplex_sync_) {
+            // 将音频数据发送到音频后端进行播放
+            TRACE_SCOPE("audio", "playback.write");
+            backend_->writeAudioData(audio_data);
+            continue;
+        }
+        
+        // 全双工模式下播放流持续运行，无数据时输出静音以保持与采集流对齐
+        if (!has_audio) {
+            audio_data.assign(mixer_->getFrameSamples(), 0);
+        }
+        
+        // 定期测量时钟漂移并调整重采样比值
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_drift_check >= std::chrono::seconds(1)) {
+            last_drift_check = now;
+            if (backend_->updateDriftEstimate()) {
+                drift_compensator_.setRatio(backend_->getDriftStats().playback_ratio);
             }
-        } else {
-            // 如果没有回调，短暂休眠
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
         }
+        
+        {
+            TRACE_SCOPE("audio", "playback.drift");
+            drift_compensator_.process(audio_data.data(), audio_data.size() / channels_, compensated);
+        }
+        TRACE_SCOPE("audio", "playback.write");
+        backend_->writeAudioData(compensated);
     }
     
     // 停止播放
-    alsa_handler_->stopPlayback();
+    backend_->stopPlayback();
 }
 
 } // namespace xiaozhi
\ No newline at end of file
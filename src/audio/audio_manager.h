@@ -5,13 +5,18 @@
 #include <atomic>
 #include <functional>
 #include <memory>
+#include <string>
 #include "xiaozhi_types.h"
+#include "audio_mixer.h"
+#include "audio_frame_pool.h"
+#include "drift_compensator.h"
+#include "audio_backend.h"
 
 // 前向声明
 namespace xiaozhi {
-class AlsaHandler;
 class OpusEncoder;
 class OpusDecoder;
+class DeviceSupervisor;
 }
 
 namespace xiaozhi {
@@ -21,18 +26,37 @@ public:
     AudioManager();
     ~AudioManager();
 
-    bool initialize(int sample_rate = 16000, int channels = 1);
+    bool initialize(int sample_rate = 16000, int channels = 1, size_t frame_pool_size = 64);
     void startRecording();
     void stopRecording();
     void startPlayback();
     void stopPlayback();
 
-    void process();
+    // 全双工同步：需在initialize之前设置，链接采集/播放流并补偿时钟漂移
+    void setDuplexSync(bool enabled) { duplex_sync_ = enabled; }
+
+    // 音频后端：需在initialize之前设置，默认使用ALSA
+    void setBackendConfig(const AudioBackendConfig& config) { backend_config_ = config; }
+    void setBackend(std::unique_ptr<AudioBackend> backend);
+    AudioBackend* getBackend() { return backend_.get(); }
+
+    // 设备xrun/热插拔恢复统计
+    AudioRecoveryStats getRecoveryStats() const;
 
     // 设置音频数据回调
     void setRecordCallback(std::function<void(const AudioData&)> callback);
+    // 录音帧以移动方式交给下一处理阶段，不产生拷贝
+    void setRecordFrameCallback(std::function<void(AudioFrame)> callback);
     void setPlaybackCallback(std::function<void(AudioData&)> callback);
 
+    // 多播放源混音：注册/移除播放源，向播放源推送数据
+    int addPlaybackSource(const std::string& name,
+                          MixPriority priority,
+                          std::function<void(AudioData&)> pull_callback = nullptr);
+    void removePlaybackSource(int source_id);
+    bool queuePlayback(int source_id, const AudioData& audio_data);
+    AudioMixer* getMixer() { return mixer_.get(); }
+
 private:
     std::atomic<bool> initialized_{false};
     std::atomic<bool> recording_{false};
@@ -40,22 +64,30 @@ private:
 
     int sample_rate_;
     int channels_;
+    bool duplex_sync_;
 
     std::function<void(const AudioData&)> record_callback_;
+    std::function<void(AudioFrame)> record_frame_callback_;
     std::function<void(AudioData&)> playback_callback_;
+    int playback_source_id_;
 
     std::thread record_thread_;
     std::thread play_thread_;
     std::mutex mutex_;
 
     // 音频处理器
-    std::unique_ptr<AlsaHandler> alsa_handler_;
+    AudioBackendConfig backend_config_;
+    std::unique_ptr<AudioBackend> backend_;
     std::unique_ptr<OpusEncoder> opus_encoder_;
     std::unique_ptr<OpusDecoder> opus_decoder_;
+    std::unique_ptr<AudioMixer> mixer_;
+    std::unique_ptr<DeviceSupervisor> device_supervisor_;
+    DriftCompensator drift_compensator_;
 
     // 内部音频处理函数
     void recordLoop();
     void playLoop();
+    bool waitIfDeviceLost();
 };
 
 } // namespace xiaozhi
\ No newline at end of file
@@ -0,0 +1,335 @@
+#include "audio_mixer.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include "utils/metrics.h"
+#include "utils/logger.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace xiaozhi {
+
+namespace {
+
+Gauge& bufferedSamples() {
+    static Gauge& gauge = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_playback_buffered_samples", "混音器各播放源待播放的采样总数");
+    return gauge;
+}
+
+Counter& droppedSamples() {
+    static Counter& counter = MetricsRegistry::getInstance().counter(
+        "xiaozhi_playback_dropped_samples_total", "播放源缓冲超过上限时丢弃的最旧采样数");
+    return counter;
+}
+
+} // namespace
+
+AudioMixer::AudioMixer()
+    : sample_rate_(16000), channels_(1), frame_samples_(320), max_pending_samples_(16000), next_source_id_(1),
+      wake_requested_(false), duck_trigger_(MixPriority::SPEECH), duck_gain_(0.25f),
+      duck_release_frames_(15), duck_hold_frames_(0) {
+    std::cout << "[AudioMixer] 初始化音频混音器" << std::endl;
+}
+
+AudioMixer::~AudioMixer() {
+    std::cout << "[AudioMixer] 音频混音器已销毁" << std::endl;
+}
+
+bool AudioMixer::initialize(int sample_rate, int channels, int frame_ms) {
+    if (sample_rate <= 0 || channels <= 0 || frame_ms <= 0) {
+        std::cerr << "[AudioMixer] 错误: 无效的混音参数" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    frame_samples_ = static_cast<size_t>(sample_rate * frame_ms / 1000) * channels;
+    max_pending_samples_ = std::max(static_cast<size_t>(sample_rate) * channels, frame_samples_);
+    duck_release_frames_ = std::max(1, 300 / frame_ms);
+    scratch_.assign(frame_samples_, 0);
+
+    std::cout << "[AudioMixer] 混音器初始化完成 (采样率: " << sample_rate
+              << ", 通道数: " << channels << ", 帧长: " << frame_ms << "ms)" << std::endl;
+    return true;
+}
+
+int AudioMixer::addSource(const std::string& name,
+                          MixPriority priority,
+                          std::function<void(AudioData&)> pull_callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    int source_id = next_source_id_++;
+    Source& source = sources_[source_id];
+    source.name = name;
+    source.priority = priority;
+    source.pull_callback = pull_callback;
+    // 预留约1秒的缓冲，减少播放过程中的扩容；超出部分在pushAudio中丢弃
+    source.pending.reserve(max_pending_samples_);
+
+    std::cout << "[AudioMixer] 已注册播放源: " << name << " (id: " << source_id
+              << ", 优先级: " << static_cast<int>(priority) << ")" << std::endl;
+    return source_id;
+}
+
+void AudioMixer::removeSource(int source_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(source_id);
+    if (it != sources_.end()) {
+        std::cout << "[AudioMixer] 已移除播放源: " << it->second.name << std::endl;
+        sources_.erase(it);
+    }
+}
+
+bool AudioMixer::pushAudio(int source_id, const AudioData& audio_data) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = sources_.find(source_id);
+        if (it == sources_.end()) {
+            return false;
+        }
+
+        Source& source = it->second;
+        compactPending(source);
+
+        // 生产快于播放时缓冲最多保留约1秒，丢弃最旧的数据，保持播放延迟有界
+        size_t incoming = audio_data.size();
+        size_t available = availableSamples(source);
+        if (available + incoming > max_pending_samples_) {
+            size_t dropped = available + incoming - max_pending_samples_;
+            // 按整帧采样丢弃，不打乱声道交错
+            size_t remainder = dropped % static_cast<size_t>(channels_);
+            if (remainder != 0) {
+                dropped += static_cast<size_t>(channels_) - remainder;
+            }
+            droppedSamples().inc(dropped);
+            LOG_EVERY_MS(WARN, 1000, "[AudioMixer] 播放源 {} 缓冲超过上限，丢弃最旧的 {} 个采样",
+                         source.name, dropped);
+
+            if (dropped >= available) {
+                size_t skip = std::min(dropped - available, incoming);
+                source.pending.clear();
+                source.read_pos = 0;
+                source.pending.insert(source.pending.end(), audio_data.begin() + skip, audio_data.end());
+            } else {
+                source.read_pos += dropped;
+                compactPending(source);
+                source.pending.insert(source.pending.end(), audio_data.begin(), audio_data.end());
+            }
+        } else {
+            source.pending.insert(source.pending.end(), audio_data.begin(), audio_data.end());
+        }
+    }
+    data_cv_.notify_one();
+    return true;
+}
+
+void AudioMixer::waitForAudio(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const auto& pair : sources_) {
+        if (pair.second.pull_callback) {
+            int frame_ms = static_cast<int>(frame_samples_ * 1000 / (static_cast<size_t>(sample_rate_) * channels_));
+            timeout = std::min(timeout, std::chrono::milliseconds(std::max(1, frame_ms)));
+            break;
+        }
+    }
+    data_cv_.wait_for(lock, timeout, [this] {
+        if (wake_requested_) {
+            return true;
+        }
+        for (const auto& pair : sources_) {
+            if (availableSamples(pair.second) > 0) {
+                return true;
+            }
+        }
+        return false;
+    });
+    wake_requested_ = false;
+}
+
+void AudioMixer::wakeUp() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wake_requested_ = true;
+    }
+    data_cv_.notify_all();
+}
+
+void AudioMixer::clearSource(int source_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(source_id);
+    if (it != sources_.end()) {
+        it->second.pending.clear();
+        it->second.read_pos = 0;
+    }
+}
+
+void AudioMixer::setSourceGain(int source_id, float gain) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = sources_.find(source_id);
+    if (it != sources_.end()) {
+        it->second.target_gain = std::min(1.0f, std::max(0.0f, gain));
+    }
+}
+
+void AudioMixer::setDucking(MixPriority trigger, float duck_gain, int release_ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    duck_trigger_ = trigger;
+    duck_gain_ = std::min(1.0f, std::max(0.0f, duck_gain));
+
+    int frame_ms = static_cast<int>(frame_samples_ * 1000 / (static_cast<size_t>(sample_rate_) * channels_));
+    duck_release_frames_ = std::max(1, release_ms / std::max(1, frame_ms));
+}
+
+bool AudioMixer::mix(AudioData& output) {
+    // 第一步：为缓冲不足的源拉取数据（在锁外调用回调，避免回调中再次推送时死锁）
+    struct PullRequest {
+        int source_id;
+        size_t needed;
+        std::function<void(AudioData&)> callback;
+    };
+    std::vector<PullRequest> pulls;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& pair : sources_) {
+            size_t available = availableSamples(pair.second);
+            if (pair.second.pull_callback && available < frame_samples_) {
+                pulls.push_back({pair.first, frame_samples_ - available, pair.second.pull_callback});
+            }
+        }
+    }
+
+    // 回调每次返回的数据长度不固定，凑满一帧或回调无数据为止（限制次数防止空转）
+    for (auto& pull : pulls) {
+        size_t received = 0;
+        for (int attempt = 0; attempt < 8 && received < pull.needed; ++attempt) {
+            pull_buffer_.clear();
+            pull.callback(pull_buffer_);
+            if (pull_buffer_.empty() || !pushAudio(pull.source_id, pull_buffer_)) {
+                break;
+            }
+            received += pull_buffer_.size();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // 第二步：判断是否需要闪避低优先级源
+    bool trigger_active = false;
+    for (const auto& pair : sources_) {
+        if (pair.second.priority >= duck_trigger_ && availableSamples(pair.second) > 0) {
+            trigger_active = true;
+            break;
+        }
+    }
+    if (trigger_active) {
+        duck_hold_frames_ = duck_release_frames_;
+    } else if (duck_hold_frames_ > 0) {
+        --duck_hold_frames_;
+    }
+    bool ducking = duck_hold_frames_ > 0;
+
+    // 第三步：逐源应用增益斜坡并饱和累加
+    output.assign(frame_samples_, 0);
+    bool has_audio = false;
+    size_t buffered = 0;
+
+    for (auto& pair : sources_) {
+        Source& source = pair.second;
+        float target = source.target_gain;
+        if (ducking && source.priority < duck_trigger_) {
+            target *= duck_gain_;
+        }
+
+        size_t available = availableSamples(source);
+        if (available == 0) {
+            // 无数据时直接跳到目标增益，下次出声时不会产生突变
+            source.current_gain = target;
+            continue;
+        }
+
+        size_t count = std::min(available, frame_samples_);
+        std::memcpy(scratch_.data(), source.pending.data() + source.read_pos, count * sizeof(int16_t));
+        source.read_pos += count;
+
+        source.current_gain = applyGainRamp(scratch_.data(), count, source.current_gain, target);
+
+        mixSaturate(output.data(), scratch_.data(), count);
+        has_audio = true;
+        buffered += available - count;
+    }
+    bufferedSamples().set(static_cast<int64_t>(buffered));
+
+    if (!has_audio) {
+        output.clear();
+    }
+    return has_audio;
+}
+
+void AudioMixer::mixSaturate(int16_t* dst, const int16_t* src, size_t count) {
+    size_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 8 <= count; i += 8) {
+        int16x8_t a = vld1q_s16(dst + i);
+        int16x8_t b = vld1q_s16(src + i);
+        vst1q_s16(dst + i, vqaddq_s16(a, b));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= count; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_adds_epi16(a, b));
+    }
+#endif
+    for (; i < count; ++i) {
+        int32_t sum = static_cast<int32_t>(dst[i]) + src[i];
+        dst[i] = static_cast<int16_t>(std::min<int32_t>(32767, std::max<int32_t>(-32768, sum)));
+    }
+}
+
+size_t AudioMixer::availableSamples(const Source& source) const {
+    return source.pending.size() - source.read_pos;
+}
+
+void AudioMixer::compactPending(Source& source) {
+    // 已读部分超过一半时整体前移，保持缓冲区容量稳定
+    if (source.read_pos == 0) {
+        return;
+    }
+    if (source.read_pos >= source.pending.size()) {
+        source.pending.clear();
+        source.read_pos = 0;
+    } else if (source.read_pos * 2 >= source.pending.size()) {
+        source.pending.erase(source.pending.begin(), source.pending.begin() + source.read_pos);
+        source.read_pos = 0;
+    }
+}
+
+float AudioMixer::applyGainRamp(int16_t* data, size_t count, float from, float to) {
+    if (from == 1.0f && to == 1.0f) {
+        return to;
+    }
+
+    if (from == to) {
+        for (size_t i = 0; i < count; ++i) {
+            data[i] = static_cast<int16_t>(data[i] * to);
+        }
+        return to;
+    }
+
+    // 按帧为单位线性过渡，避免增益突变产生爆音
+    float step = (to - from) / static_cast<float>(frame_samples_);
+    float gain = from;
+    for (size_t i = 0; i < count; ++i) {
+        data[i] = static_cast<int16_t>(data[i] * gain);
+        gain += step;
+    }
+    return count >= frame_samples_ ? to : gain;
+}
+
+} // namespace xiaozhi
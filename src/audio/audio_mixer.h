@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "xiaozhi_types.h"
+
+namespace xiaozhi {
+
+// 播放源优先级，数值越大优先级越高
+enum class MixPriority {
+    BACKGROUND = 0,    // 背景音乐等
+    NOTIFICATION = 1,  // 提示音
+    SPEECH = 2         // TTS语音
+};
+
+// 软件混音器：将多个播放源混合为一路PCM，交给单个ALSA播放句柄输出
+class AudioMixer {
+public:
+    AudioMixer();
+    ~AudioMixer();
+
+    bool initialize(int sample_rate = 16000, int channels = 1, int frame_ms = 20);
+
+    // 注册播放源，pull_callback可选：缓冲不足一帧时由混音线程调用以拉取数据
+    int addSource(const std::string& name,
+                  MixPriority priority,
+                  std::function<void(AudioData&)> pull_callback = nullptr);
+    void removeSource(int source_id);
+
+    // 向播放源推送PCM数据（任意长度）；待播放数据超过约1秒时丢弃最旧的采样
+    bool pushAudio(int source_id, const AudioData& audio_data);
+    void clearSource(int source_id);
+
+    // 设置播放源目标增益 (0.0 ~ 1.0)，在下一帧内平滑过渡
+    void setSourceGain(int source_id, float gain);
+
+    // 高于等于trigger优先级的源有声音时，低优先级源衰减到duck_gain
+    void setDucking(MixPriority trigger, float duck_gain, int release_ms = 300);
+
+    // 混合一帧数据，所有源均无数据时返回false
+    bool mix(AudioData& output);
+
+    // mix()无数据时由播放线程调用：阻塞到有数据推入、wakeUp()或超时。
+    // 存在拉取式播放源时最多等待一帧时长，以便按帧节拍继续拉取
+    void waitForAudio(std::chrono::milliseconds timeout);
+    void wakeUp();
+
+    size_t getFrameSamples() const { return frame_samples_; }
+
+    // 饱和加法: dst[i] = clamp(dst[i] + src[i])
+    static void mixSaturate(int16_t* dst, const int16_t* src, size_t count);
+
+private:
+    struct Source {
+        std::string name;
+        MixPriority priority;
+        std::function<void(AudioData&)> pull_callback;
+        std::vector<int16_t> pending;   // 待播放数据
+        size_t read_pos = 0;
+        float target_gain = 1.0f;
+        float current_gain = 1.0f;
+    };
+
+    size_t availableSamples(const Source& source) const;
+    void compactPending(Source& source);
+    // 返回处理完count个样本后的增益；不足一帧时尚未到达to，由调用方下一帧接着过渡
+    float applyGainRamp(int16_t* data, size_t count, float from, float to);
+
+    int sample_rate_;
+    int channels_;
+    size_t frame_samples_;
+    size_t max_pending_samples_;    // 每个播放源待播放数据上限（约1秒）
+
+    std::map<int, Source> sources_;
+    int next_source_id_;
+    std::mutex mutex_;
+    std::condition_variable data_cv_;
+    bool wake_requested_;
+
+    // 闪避参数
+    MixPriority duck_trigger_;
+    float duck_gain_;
+    int duck_release_frames_;
+    int duck_hold_frames_;
+
+    // 混音缓冲区，预分配避免在播放线程中分配内存
+    std::vector<int16_t> scratch_;
+    AudioData pull_buffer_;
+};
+
+} // namespace xiaozhi
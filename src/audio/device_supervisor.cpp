@@ -0,0 +1,144 @@
+#include "device_supervisor.h"
+#include "audio_backend.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+
+namespace xiaozhi {
+
+namespace {
+// 没有收到设备节点事件时的兜底重试间隔（例如ALSA设备名指向的是插件而非硬件节点）
+constexpr int kRetryIntervalMs = 1000;
+// 设备节点出现后udev可能尚未完成权限设置，短暂延迟后再打开
+constexpr int kSettleDelayMs = 20;
+}
+
+DeviceSupervisor::DeviceSupervisor(AudioBackend& backend)
+    : backend_(backend), inotify_fd_(-1), wake_fd_(-1) {
+}
+
+DeviceSupervisor::~DeviceSupervisor() {
+    stop();
+}
+
+bool DeviceSupervisor::start() {
+    if (running_) {
+        return false;
+    }
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "[DeviceSupervisor] 错误: 无法创建eventfd: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 &&
+        inotify_add_watch(inotify_fd_, "/dev/snd", IN_CREATE | IN_ATTRIB | IN_DELETE) < 0) {
+        std::cerr << "[DeviceSupervisor] 警告: 无法监视/dev/snd: " << std::strerror(errno)
+                  << "，改为定时重试" << std::endl;
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+
+    // 设备断开时由读写线程立即唤醒监控线程
+    backend_.setDeviceLostCallback([this]() { wake(); });
+
+    running_ = true;
+    supervisor_thread_ = std::thread(&DeviceSupervisor::supervisorLoop, this);
+    std::cout << "[DeviceSupervisor] 音频设备监控已启动" << std::endl;
+    return true;
+}
+
+void DeviceSupervisor::stop() {
+    if (running_) {
+        running_ = false;
+        wake();
+        if (supervisor_thread_.joinable()) {
+            supervisor_thread_.join();
+        }
+        backend_.setDeviceLostCallback(nullptr);
+        std::cout << "[DeviceSupervisor] 音频设备监控已停止" << std::endl;
+    }
+
+    if (inotify_fd_ >= 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+}
+
+void DeviceSupervisor::wake() {
+    if (wake_fd_ >= 0) {
+        uint64_t value = 1;
+        ssize_t written = write(wake_fd_, &value, sizeof(value));
+        (void)written;
+    }
+}
+
+void DeviceSupervisor::supervisorLoop() {
+    pollfd fds[2];
+    int nfds = 0;
+    fds[nfds++] = {wake_fd_, POLLIN, 0};
+    if (inotify_fd_ >= 0) {
+        fds[nfds++] = {inotify_fd_, POLLIN, 0};
+    }
+
+    char event_buffer[4096];
+    while (running_) {
+        // 设备正常时无限期等待，只有断开后才定时兜底重试
+        int timeout = backend_.isDeviceLost() ? kRetryIntervalMs : -1;
+        int ready = poll(fds, nfds, timeout);
+        if (ready < 0 && errno != EINTR) {
+            std::cerr << "[DeviceSupervisor] poll失败: " << std::strerror(errno) << std::endl;
+            break;
+        }
+
+        bool device_event = false;
+        if (ready > 0) {
+            if (fds[0].revents & POLLIN) {
+                uint64_t value;
+                ssize_t bytes = read(wake_fd_, &value, sizeof(value));
+                (void)bytes;
+            }
+            if (nfds > 1 && (fds[1].revents & POLLIN)) {
+                // 只关心有事件发生，具体节点名不重要：交给ALSA按设备名重新打开
+                while (read(inotify_fd_, event_buffer, sizeof(event_buffer)) > 0) {
+                }
+                device_event = true;
+            }
+        }
+
+        if (!running_ || !backend_.isDeviceLost()) {
+            continue;
+        }
+
+        if (device_event) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(kSettleDelayMs));
+        }
+        tryRecover();
+    }
+}
+
+bool DeviceSupervisor::tryRecover() {
+    if (!backend_.reopenDevices()) {
+        return false;
+    }
+
+    AudioRecoveryStats stats = backend_.getRecoveryStats();
+    std::cout << "[DeviceSupervisor] 设备恢复完成 (累计断开: " << stats.device_losses
+              << ", 恢复: " << stats.recoveries
+              << ", 采集xrun: " << stats.capture_xruns
+              << ", 播放xrun: " << stats.playback_xruns << ")" << std::endl;
+    return true;
+}
+
+} // namespace xiaozhi
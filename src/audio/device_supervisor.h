@@ -0,0 +1,34 @@
+#pragma once
+
+#include <thread>
+#include <atomic>
+#include "xiaozhi_types.h"
+
+namespace xiaozhi {
+
+class AudioBackend;
+
+// 音频设备监控：设备断开后通过inotify监视/dev/snd，
+// 设备重新出现时就地重新打开后端设备，无需重启守护进程
+class DeviceSupervisor {
+public:
+    explicit DeviceSupervisor(AudioBackend& backend);
+    ~DeviceSupervisor();
+
+    bool start();
+    void stop();
+
+private:
+    void supervisorLoop();
+    void wake();
+    bool tryRecover();
+
+    AudioBackend& backend_;
+    std::atomic<bool> running_{false};
+    std::thread supervisor_thread_;
+
+    int inotify_fd_;
+    int wake_fd_;
+};
+
+} // namespace xiaozhi
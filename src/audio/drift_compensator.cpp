@@ -0,0 +1,55 @@
+#include "drift_compensator.h"
+#include <algorithm>
+#include <cmath>
+
+namespace xiaozhi {
+
+DriftCompensator::DriftCompensator() : channels_(1), ratio_(1.0), phase_(0.0), last_frame_(1, 0) {
+}
+
+void DriftCompensator::initialize(int channels) {
+    channels_ = std::max(1, channels);
+    last_frame_.assign(channels_, 0);
+    ratio_ = 1.0;
+    phase_ = 0.0;
+}
+
+void DriftCompensator::setRatio(double ratio) {
+    // 限制在±1%以内，防止异常测量值导致明显的音调变化
+    ratio_ = std::min(1.01, std::max(0.99, ratio));
+}
+
+void DriftCompensator::reset() {
+    std::fill(last_frame_.begin(), last_frame_.end(), 0);
+    phase_ = 0.0;
+}
+
+void DriftCompensator::process(const int16_t* input, size_t frames, AudioData& out) {
+    out.clear();
+    if (!input || frames == 0) {
+        return;
+    }
+
+    out.reserve(static_cast<size_t>(std::ceil(frames * ratio_)) * channels_ + channels_);
+
+    // 虚拟输入序列：x[-1]为上一块的最后一帧，x[0..frames-1]为本块数据
+    const double step = 1.0 / ratio_;
+    double position = phase_;
+    while (position < static_cast<double>(frames)) {
+        size_t index = static_cast<size_t>(position);
+        double frac = position - static_cast<double>(index);
+
+        for (int ch = 0; ch < channels_; ++ch) {
+            int16_t prev = index == 0 ? last_frame_[ch] : input[(index - 1) * channels_ + ch];
+            int16_t next = input[index * channels_ + ch];
+            double value = prev + (next - prev) * frac;
+            out.push_back(static_cast<int16_t>(std::lround(value)));
+        }
+        position += step;
+    }
+
+    phase_ = position - static_cast<double>(frames);
+    std::copy(input + (frames - 1) * channels_, input + frames * channels_, last_frame_.begin());
+}
+
+} // namespace xiaozhi
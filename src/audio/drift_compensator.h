@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include "xiaozhi_types.h"
+
+namespace xiaozhi {
+
+// 小数倍率重采样器：按采集/播放时钟的实测比值微调播放数据的采样点数，
+// 使两路流在长时间运行后保持对齐（线性插值，比值通常在1±0.001以内）
+class DriftCompensator {
+public:
+    DriftCompensator();
+
+    void initialize(int channels);
+
+    // 每个输入帧对应的输出帧数，>1表示播放时钟偏快需要补充采样点
+    void setRatio(double ratio);
+    double getRatio() const { return ratio_; }
+
+    void reset();
+
+    // frames为每通道的帧数，输出写入out（复用其容量）
+    void process(const int16_t* input, size_t frames, AudioData& out);
+
+private:
+    int channels_;
+    double ratio_;
+    double phase_;                 // 相对上一块最后一帧的小数位置
+    std::vector<int16_t> last_frame_;
+};
+
+} // namespace xiaozhi
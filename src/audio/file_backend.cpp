@@ -0,0 +1,277 @@
+#include "file_backend.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace xiaozhi {
+
+namespace {
+
+uint32_t readLE32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint16_t readLE16(const unsigned char* p) {
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+void writeLE32(std::ostream& out, uint32_t value) {
+    unsigned char bytes[4] = {
+        static_cast<unsigned char>(value & 0xff), static_cast<unsigned char>((value >> 8) & 0xff),
+        static_cast<unsigned char>((value >> 16) & 0xff), static_cast<unsigned char>((value >> 24) & 0xff)};
+    out.write(reinterpret_cast<const char*>(bytes), 4);
+}
+
+void writeLE16(std::ostream& out, uint16_t value) {
+    unsigned char bytes[2] = {static_cast<unsigned char>(value & 0xff),
+                              static_cast<unsigned char>((value >> 8) & 0xff)};
+    out.write(reinterpret_cast<const char*>(bytes), 2);
+}
+
+bool hasWavExtension(const std::string& path) {
+    if (path.size() < 4) {
+        return false;
+    }
+    std::string ext = path.substr(path.size() - 4);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    return ext == ".wav";
+}
+
+} // namespace
+
+FileAudioBackend::FileAudioBackend(const AudioBackendConfig& config)
+    : config_(config), sample_rate_(16000), channels_(1),
+      data_offset_(0), data_bytes_(0), data_consumed_(0),
+      output_wav_(false), output_bytes_(0) {
+}
+
+FileAudioBackend::~FileAudioBackend() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    finalizeOutput();
+}
+
+bool FileAudioBackend::initialize(int sample_rate, int channels,
+                                  const std::string& /*input_device*/, const std::string& /*output_device*/) {
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    capture_pacer_.reset(sample_rate);
+    playback_pacer_.reset(sample_rate);
+
+    if (!config_.input_file.empty() && !openInput()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        if (!config_.output_file.empty() && !openOutput()) {
+            return false;
+        }
+    }
+
+    std::cout << "[FileAudioBackend] 文件音频后端初始化完成 (输入: "
+              << (config_.input_file.empty() ? "静音" : config_.input_file)
+              << ", 输出: " << (config_.output_file.empty() ? "丢弃" : config_.output_file)
+              << ", " << (config_.realtime ? "实时节拍" : "尽快处理") << ")" << std::endl;
+    return true;
+}
+
+bool FileAudioBackend::openInput() {
+    input_.open(config_.input_file, std::ios::binary);
+    if (!input_.is_open()) {
+        std::cerr << "[FileAudioBackend] 错误: 无法打开输入文件: " << config_.input_file << std::endl;
+        return false;
+    }
+
+    if (hasWavExtension(config_.input_file)) {
+        return parseWavHeader();
+    }
+
+    // raw文件：整个文件都是S16_LE交织数据
+    input_.seekg(0, std::ios::end);
+    data_bytes_ = static_cast<uint64_t>(input_.tellg());
+    input_.seekg(0, std::ios::beg);
+    data_offset_ = 0;
+    data_consumed_ = 0;
+    return true;
+}
+
+bool FileAudioBackend::parseWavHeader() {
+    unsigned char riff[12];
+    if (!input_.read(reinterpret_cast<char*>(riff), sizeof(riff)) ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::cerr << "[FileAudioBackend] 错误: 不是有效的WAV文件: " << config_.input_file << std::endl;
+        return false;
+    }
+
+    bool have_format = false;
+    unsigned char chunk[8];
+    while (input_.read(reinterpret_cast<char*>(chunk), sizeof(chunk))) {
+        uint32_t chunk_size = readLE32(chunk + 4);
+
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            unsigned char fmt[16];
+            if (chunk_size < sizeof(fmt) || !input_.read(reinterpret_cast<char*>(fmt), sizeof(fmt))) {
+                break;
+            }
+            uint16_t format = readLE16(fmt);
+            uint16_t channels = readLE16(fmt + 2);
+            uint32_t sample_rate = readLE32(fmt + 4);
+            uint16_t bits = readLE16(fmt + 14);
+
+            if (format != 1 || bits != 16) {
+                std::cerr << "[FileAudioBackend] 错误: 仅支持16位PCM格式的WAV文件" << std::endl;
+                return false;
+            }
+            if (static_cast<int>(channels) != channels_ || static_cast<int>(sample_rate) != sample_rate_) {
+                std::cerr << "[FileAudioBackend] 警告: WAV格式 (" << sample_rate << "Hz, " << channels
+                          << "通道) 与配置 (" << sample_rate_ << "Hz, " << channels_
+                          << "通道) 不一致，按原始数据读取" << std::endl;
+            }
+            have_format = true;
+            input_.seekg(chunk_size - sizeof(fmt) + (chunk_size & 1), std::ios::cur);
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            if (!have_format) {
+                break;
+            }
+            data_offset_ = input_.tellg();
+            data_bytes_ = chunk_size;
+            data_consumed_ = 0;
+            return true;
+        } else {
+            // 跳过LIST等其他块，块大小为奇数时有一个填充字节
+            input_.seekg(chunk_size + (chunk_size & 1), std::ios::cur);
+        }
+    }
+
+    std::cerr << "[FileAudioBackend] 错误: WAV文件缺少fmt或data块: " << config_.input_file << std::endl;
+    return false;
+}
+
+bool FileAudioBackend::openOutput() {
+    output_.open(config_.output_file, std::ios::binary | std::ios::trunc);
+    if (!output_.is_open()) {
+        std::cerr << "[FileAudioBackend] 错误: 无法创建输出文件: " << config_.output_file << std::endl;
+        return false;
+    }
+
+    output_wav_ = hasWavExtension(config_.output_file);
+    output_bytes_ = 0;
+    if (output_wav_) {
+        // 先写入占位头，关闭时回填数据长度
+        char header[44] = {0};
+        output_.write(header, sizeof(header));
+    }
+    return true;
+}
+
+void FileAudioBackend::finalizeOutput() {
+    if (!output_.is_open()) {
+        return;
+    }
+
+    if (output_wav_) {
+        uint32_t data_size = static_cast<uint32_t>(std::min<uint64_t>(output_bytes_, 0xffffffffu - 36));
+        output_.seekp(0, std::ios::beg);
+        output_.write("RIFF", 4);
+        writeLE32(output_, 36 + data_size);
+        output_.write("WAVEfmt ", 8);
+        writeLE32(output_, 16);
+        writeLE16(output_, 1);
+        writeLE16(output_, static_cast<uint16_t>(channels_));
+        writeLE32(output_, static_cast<uint32_t>(sample_rate_));
+        writeLE32(output_, static_cast<uint32_t>(sample_rate_ * channels_ * 2));
+        writeLE16(output_, static_cast<uint16_t>(channels_ * 2));
+        writeLE16(output_, 16);
+        output_.write("data", 4);
+        writeLE32(output_, data_size);
+    }
+    output_.close();
+}
+
+bool FileAudioBackend::readAudioData(AudioFrame& frame, size_t frames) {
+    size_t samples = frames * channels_;
+    if (!frame || !frame.resize(samples)) {
+        return false;
+    }
+
+    int16_t* out = frame.data();
+    size_t filled = 0;
+    while (filled < samples && input_.is_open() && !input_finished_) {
+        uint64_t remaining = (data_bytes_ - data_consumed_) / sizeof(int16_t);
+        if (remaining == 0) {
+            if (!config_.loop) {
+                input_finished_ = true;
+                std::cout << "[FileAudioBackend] 输入文件读取完毕" << std::endl;
+                break;
+            }
+            input_.clear();
+            input_.seekg(data_offset_, std::ios::beg);
+            data_consumed_ = 0;
+            continue;
+        }
+
+        size_t count = static_cast<size_t>(std::min<uint64_t>(remaining, samples - filled));
+        input_.read(reinterpret_cast<char*>(out + filled), count * sizeof(int16_t));
+        size_t got = static_cast<size_t>(input_.gcount()) / sizeof(int16_t);
+        filled += got;
+        data_consumed_ += got * sizeof(int16_t);
+        if (got < count) {
+            // 文件比头部声明的短
+            data_bytes_ = data_consumed_;
+        }
+    }
+
+    // 没有输入或已读完时以静音补齐，与真实麦克风持续产生数据的行为一致
+    if (filled < samples) {
+        std::memset(out + filled, 0, (samples - filled) * sizeof(int16_t));
+    }
+
+    frames_read_.fetch_add(frames, std::memory_order_relaxed);
+    if (config_.realtime) {
+        capture_pacer_.wait(frames);
+    }
+    return true;
+}
+
+bool FileAudioBackend::writeAudioData(const AudioData& audio_data) {
+    if (audio_data.empty()) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        if (output_.is_open()) {
+            output_.write(reinterpret_cast<const char*>(audio_data.data()),
+                          audio_data.size() * sizeof(int16_t));
+            output_bytes_ += audio_data.size() * sizeof(int16_t);
+        }
+    }
+
+    size_t frames = audio_data.size() / channels_;
+    frames_written_.fetch_add(frames, std::memory_order_relaxed);
+    if (config_.realtime) {
+        playback_pacer_.wait(frames);
+    }
+    return true;
+}
+
+void FileAudioBackend::startCapture() {
+    capture_pacer_.reset(sample_rate_);
+}
+
+void FileAudioBackend::stopCapture() {
+}
+
+void FileAudioBackend::startPlayback() {
+    playback_pacer_.reset(sample_rate_);
+}
+
+void FileAudioBackend::stopPlayback() {
+    std::lock_guard<std::mutex> lock(output_mutex_);
+    if (output_.is_open()) {
+        output_.flush();
+    }
+}
+
+} // namespace xiaozhi
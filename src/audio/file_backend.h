@@ -0,0 +1,64 @@
+#pragma once
+
+#include <string>
+#include <fstream>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+#include "audio_backend.h"
+
+namespace xiaozhi {
+
+// 文件后端：从WAV/raw文件回放采集数据，播放数据写入WAV/raw文件，
+// 可按真实时间节拍或尽快处理，用于无声卡环境下的流水线测试和基准
+class FileAudioBackend : public AudioBackend {
+public:
+    explicit FileAudioBackend(const AudioBackendConfig& config);
+    ~FileAudioBackend() override;
+
+    bool initialize(int sample_rate, int channels,
+                    const std::string& input_device, const std::string& output_device) override;
+
+    bool readAudioData(AudioFrame& frame, size_t frames) override;
+    bool writeAudioData(const AudioData& audio_data) override;
+
+    void startCapture() override;
+    void stopCapture() override;
+    void startPlayback() override;
+    void stopPlayback() override;
+
+    const char* getName() const override { return "file"; }
+
+    // 输入文件是否已读完（非循环模式）
+    bool isInputFinished() const { return input_finished_; }
+    uint64_t getFramesRead() const { return frames_read_; }
+    uint64_t getFramesWritten() const { return frames_written_; }
+
+private:
+    bool openInput();
+    bool parseWavHeader();
+    bool openOutput();
+    void finalizeOutput();
+
+    AudioBackendConfig config_;
+    int sample_rate_;
+    int channels_;
+
+    std::ifstream input_;
+    std::streamoff data_offset_;
+    uint64_t data_bytes_;          // WAV data块大小，raw文件为文件长度
+    uint64_t data_consumed_;
+    std::atomic<bool> input_finished_{false};
+
+    std::ofstream output_;
+    bool output_wav_;
+    uint64_t output_bytes_;
+    std::mutex output_mutex_;
+
+    FramePacer capture_pacer_;
+    FramePacer playback_pacer_;
+    std::atomic<uint64_t> frames_read_{0};
+    std::atomic<uint64_t> frames_written_{0};
+};
+
+} // namespace xiaozhi
@@ -0,0 +1,89 @@
+#include "null_backend.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+
+namespace xiaozhi {
+
+NullAudioBackend::NullAudioBackend(bool realtime, size_t history_size)
+    : realtime_(realtime), sample_rate_(16000), channels_(1),
+      history_(std::max<size_t>(1, history_size)) {
+}
+
+bool NullAudioBackend::initialize(int sample_rate, int channels,
+                                  const std::string& /*input_device*/, const std::string& /*output_device*/) {
+    sample_rate_ = sample_rate;
+    channels_ = channels;
+    capture_pacer_.reset(sample_rate);
+    playback_pacer_.reset(sample_rate);
+
+    std::cout << "[NullAudioBackend] 空音频后端初始化完成 (采样率: " << sample_rate
+              << ", 通道数: " << channels << ", " << (realtime_ ? "实时节拍" : "尽快处理") << ")" << std::endl;
+    return true;
+}
+
+bool NullAudioBackend::readAudioData(AudioFrame& frame, size_t frames) {
+    if (!frame || !frame.resize(frames * channels_)) {
+        return false;
+    }
+
+    std::memset(frame.data(), 0, frame.size() * sizeof(int16_t));
+    if (realtime_) {
+        capture_pacer_.wait(frames);
+    }
+    return true;
+}
+
+bool NullAudioBackend::writeAudioData(const AudioData& audio_data) {
+    if (audio_data.empty()) {
+        return false;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    uint64_t sequence = write_count_.fetch_add(1, std::memory_order_relaxed);
+    samples_written_.fetch_add(audio_data.size(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(history_mutex_);
+        FrameTimestamp& entry = history_[sequence % history_.size()];
+        entry.sequence = sequence;
+        entry.samples = audio_data.size();
+        entry.written_at = now;
+    }
+
+    if (write_observer_) {
+        write_observer_(audio_data, now);
+    }
+
+    if (realtime_) {
+        playback_pacer_.wait(audio_data.size() / channels_);
+    }
+    return true;
+}
+
+void NullAudioBackend::startCapture() {
+    capture_pacer_.reset(sample_rate_);
+}
+
+void NullAudioBackend::startPlayback() {
+    playback_pacer_.reset(sample_rate_);
+}
+
+std::vector<FrameTimestamp> NullAudioBackend::getWriteTimestamps() const {
+    std::lock_guard<std::mutex> lock(history_mutex_);
+    uint64_t count = write_count_.load(std::memory_order_relaxed);
+    uint64_t available = std::min<uint64_t>(count, history_.size());
+
+    std::vector<FrameTimestamp> result;
+    result.reserve(available);
+    for (uint64_t seq = count - available; seq < count; ++seq) {
+        result.push_back(history_[seq % history_.size()]);
+    }
+    return result;
+}
+
+void NullAudioBackend::setWriteObserver(
+    std::function<void(const AudioData&, std::chrono::steady_clock::time_point)> observer) {
+    write_observer_ = observer;
+}
+
+} // namespace xiaozhi
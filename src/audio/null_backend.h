@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <cstdint>
+#include "audio_backend.h"
+
+namespace xiaozhi {
+
+// 播放写入的时间戳记录
+struct FrameTimestamp {
+    uint64_t sequence = 0;      // 第几次写入
+    size_t samples = 0;         // 本次写入的采样点数
+    std::chrono::steady_clock::time_point written_at;
+};
+
+// 空后端：采集返回静音，播放丢弃数据但记录每次写入的时间戳，
+// 用于测量接收→解码→播放链路的延迟和吞吐
+class NullAudioBackend : public AudioBackend {
+public:
+    explicit NullAudioBackend(bool realtime = true, size_t history_size = 4096);
+    ~NullAudioBackend() override = default;
+
+    bool initialize(int sample_rate, int channels,
+                    const std::string& input_device, const std::string& output_device) override;
+
+    bool readAudioData(AudioFrame& frame, size_t frames) override;
+    bool writeAudioData(const AudioData& audio_data) override;
+
+    void startCapture() override;
+    void stopCapture() override {}
+    void startPlayback() override;
+    void stopPlayback() override {}
+
+    const char* getName() const override { return "null"; }
+
+    // 按写入顺序返回最近history_size次写入的时间戳
+    std::vector<FrameTimestamp> getWriteTimestamps() const;
+    uint64_t getWriteCount() const { return write_count_; }
+    uint64_t getSamplesWritten() const { return samples_written_; }
+
+    // 每次写入时同步回调，可用于检测特定信号到达播放端的时刻
+    void setWriteObserver(std::function<void(const AudioData&, std::chrono::steady_clock::time_point)> observer);
+
+private:
+    bool realtime_;
+    int sample_rate_;
+    int channels_;
+
+    // 预分配的环形记录，写入路径不分配内存
+    std::vector<FrameTimestamp> history_;
+    mutable std::mutex history_mutex_;
+    std::atomic<uint64_t> write_count_{0};
+    std::atomic<uint64_t> samples_written_{0};
+
+    std::function<void(const AudioData&, std::chrono::steady_clock::time_point)> write_observer_;
+
+    FramePacer capture_pacer_;
+    FramePacer playback_pacer_;
+};
+
+} // namespace xiaozhi
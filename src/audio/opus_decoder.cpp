@@ -1,9 +1,22 @@
 #include "opus_decoder.h"
 #include <iostream>
 #include <opus/opus.h>
+#include "utils/trace.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
+namespace {
+
+Histogram& decodeTime() {
+    static Histogram& histogram = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_opus_decode_seconds", "每包Opus解码耗时");
+    return histogram;
+}
+
+} // namespace
+
 OpusDecoder::OpusDecoder() : decoder_(nullptr), initialized_(false) {
     std::cout << "[OpusDecoder] 初始化Opus解码器" << std::endl;
 }
@@ -36,12 +49,14 @@ bool OpusDecoder::initialize(int sample_rate, int channels) {
 }
 
 AudioData OpusDecoder::decode(const std::vector<uint8_t>& opus_data) {
+    TRACE_SCOPE("codec", "opus.decode");
     if (!initialized_ || !decoder_ || opus_data.empty()) {
         return {};
     }
+    ScopedTimer timer(decodeTime());
     
-    // 假设输出帧大小为20ms (sample_rate * 0.02)
-    int frame_size = sample_rate_ * 20 / 1000;
+    // 按Opus最大帧长120ms分配，解码后截断到实际长度
+    int frame_size = sample_rate_ * 120 / 1000;
     AudioData pcm_data(frame_size * channels_);
     
     int decoded_samples = opus_decode(decoder_, 
@@ -52,7 +67,7 @@ AudioData OpusDecoder::decode(const std::vector<uint8_t>& opus_data) {
                                     0);
     
     if (decoded_samples < 0) {
-        std::cerr << "[OpusDecoder] 解码失败: " << decoded_samples << std::endl;
+        LOG_EVERY_MS(ERROR, 1000, "[OpusDecoder] 解码失败: {}", decoded_samples);
         return {};
     }
     
@@ -60,6 +75,38 @@ AudioData OpusDecoder::decode(const std::vector<uint8_t>& opus_data) {
     return pcm_data;
 }
 
+AudioFrame OpusDecoder::decodeFrame(const std::vector<uint8_t>& opus_data) {
+    TRACE_SCOPE("codec", "opus.decode");
+    if (!initialized_ || !decoder_ || opus_data.empty()) {
+        return AudioFrame();
+    }
+    ScopedTimer timer(decodeTime());
+    
+    // 输出容量按帧池每帧大小计算，最多可容纳120ms的Opus包
+    AudioFrame frame = AudioFramePool::getInstance().acquire(
+        AudioFramePool::getInstance().getFrameSamples());
+    int frame_size = static_cast<int>(frame.capacity() / channels_);
+    if (frame_size == 0) {
+        frame_size = sample_rate_ * 20 / 1000;
+        frame = AudioFramePool::getInstance().acquire(frame_size * channels_);
+    }
+    
+    int decoded_samples = opus_decode(decoder_, 
+                                    opus_data.data(), 
+                                    opus_data.size(), 
+                                    reinterpret_cast<opus_int16*>(frame.data()), 
+                                    frame_size, 
+                                    0);
+    
+    if (decoded_samples < 0) {
+        LOG_EVERY_MS(ERROR, 1000, "[OpusDecoder] 解码失败: {}", decoded_samples);
+        return AudioFrame();
+    }
+    
+    frame.resize(decoded_samples * channels_);
+    return frame;
+}
+
 void OpusDecoder::cleanup() {
     if (decoder_) {
         opus_decoder_destroy(decoder_);
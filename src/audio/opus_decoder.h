@@ -3,6 +3,7 @@
 #include <vector>
 #include <cstdint>
 #include "xiaozhi_types.h"
+#include "audio_frame_pool.h"
 
 typedef struct OpusDecoder OpusDecoderStruct;
 
@@ -18,6 +19,9 @@ public:
     // 解码Opus数据为PCM格式
     AudioData decode(const std::vector<uint8_t>& opus_data);
 
+    // 解码到帧池中的帧，避免每帧分配内存
+    AudioFrame decodeFrame(const std::vector<uint8_t>& opus_data);
+
 private:
     void cleanup();
 
@@ -2,9 +2,22 @@
 #include <iostream>
 #include <opus/opus.h>
 #include <opus/opusenc.h>
+#include "utils/trace.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
+namespace {
+
+Histogram& encodeTime() {
+    static Histogram& histogram = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_opus_encode_seconds", "每帧Opus编码耗时");
+    return histogram;
+}
+
+} // namespace
+
 OpusEncoder::OpusEncoder() : encoder_(nullptr), initialized_(false) {
     std::cout << "[OpusEncoder] 初始化Opus编码器" << std::endl;
 }
@@ -42,23 +55,49 @@ bool OpusEncoder::initialize(int sample_rate, int channels, int bitrate) {
     return true;
 }
 
+bool OpusEncoder::setComplexity(int complexity) {
+    if (!initialized_ || !encoder_) {
+        return false;
+    }
+    
+    int ret = opus_encoder_ctl(encoder_, OPUS_SET_COMPLEXITY(complexity));
+    if (ret != OPUS_OK) {
+        std::cerr << "[OpusEncoder] 设置复杂度失败: " << ret << std::endl;
+        return false;
+    }
+    return true;
+}
+
 std::vector<uint8_t> OpusEncoder::encode(const AudioData& pcm_data) {
-    if (!initialized_ || !encoder_ || pcm_data.empty()) {
+    return encodeSamples(pcm_data.data(), pcm_data.size());
+}
+
+std::vector<uint8_t> OpusEncoder::encode(const AudioFrame& pcm_frame) {
+    return encodeSamples(pcm_frame.data(), pcm_frame.size());
+}
+
+std::vector<uint8_t> OpusEncoder::encodeSamples(const int16_t* pcm, size_t samples) {
+    TRACE_SCOPE("codec", "opus.encode");
+    if (!initialized_ || !encoder_ || !pcm || samples == 0) {
         return {};
     }
+    ScopedTimer timer(encodeTime());
     
-    // Opus帧大小计算 (最大120ms)
-    int frame_size = sample_rate_ / 100; // 10ms帧
+    // 输入恰好为Opus支持的帧长 (2.5/5/10/20/40/60ms) 时整帧编码，否则按10ms编码
+    int frame_size = static_cast<int>(samples / channels_);
+    if (!isValidFrameSize(frame_size)) {
+        frame_size = sample_rate_ / 100;
+    }
     std::vector<uint8_t> encoded_data(frame_size * 2); // 预分配空间
     
     int encoded_len = opus_encode(encoder_, 
-                                 reinterpret_cast<const opus_int16*>(pcm_data.data()), 
+                                 reinterpret_cast<const opus_int16*>(pcm), 
                                  frame_size, 
                                  encoded_data.data(), 
                                  encoded_data.size());
     
     if (encoded_len < 0) {
-        std::cerr << "[OpusEncoder] 编码失败: " << encoded_len << std::endl;
+        LOG_EVERY_MS(ERROR, 1000, "[OpusEncoder] 编码失败: {}", encoded_len);
         return {};
     }
     
@@ -66,6 +105,17 @@ std::vector<uint8_t> OpusEncoder::encode(const AudioData& pcm_data) {
     return encoded_data;
 }
 
+bool OpusEncoder::isValidFrameSize(int frame_size) const {
+    static const int kMultiples[] = {1, 2, 4, 8, 16, 24};  // 2.5ms的倍数
+    int unit = sample_rate_ / 400;
+    for (int multiple : kMultiples) {
+        if (frame_size == unit * multiple) {
+            return true;
+        }
+    }
+    return false;
+}
+
 void OpusEncoder::cleanup() {
     if (encoder_) {
         opus_encoder_destroy(encoder_);
@@ -3,6 +3,7 @@
 #include <vector>
 #include <cstdint>
 #include "xiaozhi_types.h"
+#include "audio_frame_pool.h"
 
 typedef struct OpusEncoder OpusEncoderStruct;
 
@@ -14,12 +15,18 @@ public:
     ~OpusEncoder();
 
     bool initialize(int sample_rate = 16000, int channels = 1, int bitrate = 32000);
+
+    // 编码复杂度 (0-10)，越低CPU占用越小
+    bool setComplexity(int complexity);
     
     // 编码PCM数据为Opus格式
     std::vector<uint8_t> encode(const AudioData& pcm_data);
+    std::vector<uint8_t> encode(const AudioFrame& pcm_frame);
 
 private:
     void cleanup();
+    std::vector<uint8_t> encodeSamples(const int16_t* pcm, size_t samples);
+    bool isValidFrameSize(int frame_size) const;
 
     OpusEncoderStruct* encoder_;
     bool initialized_;
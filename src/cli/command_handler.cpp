@@ -2,6 +2,12 @@
 #include <iostream>
 #include <sstream>
 #include <algorithm>
+#include <iomanip>
+#include <cstdio>
+#include "utils/realtime.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
@@ -101,6 +107,10 @@ void CommandHandler::registerBuiltInCommands() {
                    [this](const std::vector<std::string>& args) { handleTextMode(args); });
     registerCommand("status", "查看系统状态", 
                    [this](const std::vector<std::string>& args) { handleStatus(args); });
+    registerCommand("trace", "流水线追踪: trace on|off|dump [路径]", 
+                   [this](const std::vector<std::string>& args) { handleTrace(args); });
+    registerCommand("log", "日志级别: log [模块] DEBUG|INFO|WARN|ERROR|default", 
+                   [this](const std::vector<std::string>& args) { handleLog(args); });
     registerCommand("help", "显示帮助信息", 
                    [this](const std::vector<std::string>& args) { showHelp(); });
 }
@@ -140,15 +150,135 @@ void CommandHandler::handleTextMode(const std::vector<std::string>& args) {
 }
 
 void CommandHandler::handleStatus(const std::vector<std::string>& args) {
+    auto& registry = MetricsRegistry::getInstance();
+    auto gaugeValue = [&registry](const char* name) -> int64_t {
+        const Gauge* gauge = registry.findGauge(name);
+        return gauge ? gauge->value() : 0;
+    };
+    auto counterValue = [&registry](const char* name) -> uint64_t {
+        const Counter* counter = registry.findCounter(name);
+        return counter ? counter->value() : 0;
+    };
+    auto printLatency = [&registry](const char* label, const char* name) {
+        const Histogram* histogram = registry.findHistogram(name);
+        if (!histogram || histogram->count() == 0) {
+            return;
+        }
+        std::cout << label << ": p50 " << histogram->quantile(0.50) / 1000.0
+                  << "ms, p99 " << histogram->quantile(0.99) / 1000.0
+                  << "ms (" << histogram->count() << " 次)" << std::endl;
+    };
+
+    // CPU使用率按两次status之间的区间计算，首次查询时为启动以来的平均值
+    ProcessStats process = MetricsRegistry::sampleProcessStats();
+    double interval = process.uptime_seconds - last_status_uptime_;
+    double cpu_percent = interval > 0.0
+        ? (process.cpu_seconds - last_status_cpu_seconds_) / interval * 100.0 : 0.0;
+    last_status_cpu_seconds_ = process.cpu_seconds;
+    last_status_uptime_ = process.uptime_seconds;
+
+    uint64_t uptime = static_cast<uint64_t>(process.uptime_seconds);
+    char uptime_text[32];
+    snprintf(uptime_text, sizeof(uptime_text), "%02llu:%02llu:%02llu",
+             static_cast<unsigned long long>(uptime / 3600),
+             static_cast<unsigned long long>(uptime / 60 % 60),
+             static_cast<unsigned long long>(uptime % 60));
+
+    uint64_t xruns = counterValue("xiaozhi_audio_capture_xruns_total") +
+                     counterValue("xiaozhi_audio_playback_xruns_total");
+
     std::cout << "\n=== 系统状态 ===" << std::endl;
-    std::cout << "连接状态: 已连接" << std::endl;
-    std::cout << "音频状态: 正常" << std::endl;
-    std::cout << "MCP服务: 运行中" << std::endl;
-    std::cout << "AI引擎: 就绪" << std::endl;
-    std::cout << "CPU使用率: 15%" << std::endl;
-    std::cout << "内存使用率: 45%" << std::endl;
-    std::cout << "运行时间: 01:23:45" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "连接状态: " << (gaugeValue("xiaozhi_ws_connected") ? "已连接" : "未连接")
+              << " (重连 " << counterValue("xiaozhi_ws_reconnects_total") << " 次)" << std::endl;
+    std::cout << "音频状态: " << (xruns == 0 ? "正常" : "有xrun")
+              << " (xrun " << xruns << " 次, 设备恢复 "
+              << counterValue("xiaozhi_audio_device_recoveries_total") << " 次)" << std::endl;
+    std::cout << "MCP服务: " << (gaugeValue("xiaozhi_mcp_running") ? "运行中" : "已停止") << std::endl;
+    std::cout << "AI引擎: " << (gaugeValue("xiaozhi_ai_running") ? "就绪" : "未启动")
+              << " (队列 " << gaugeValue("xiaozhi_ai_queue_depth") << ")" << std::endl;
+    std::cout << "CPU使用率: " << cpu_percent << "%" << std::endl;
+    std::cout << "内存占用: " << process.resident_bytes / (1024.0 * 1024.0) << "MB";
+    if (process.total_memory_bytes > 0) {
+        std::cout << " (" << 100.0 * process.resident_bytes / process.total_memory_bytes << "%)";
+    }
+    std::cout << std::endl;
+    std::cout << "运行时间: " << uptime_text << std::endl;
+    std::cout << "网络流量: 发送 " << counterValue("xiaozhi_ws_sent_bytes_total") / 1024.0
+              << "KB, 接收 " << counterValue("xiaozhi_ws_received_bytes_total") / 1024.0 << "KB" << std::endl;
+    std::cout << std::setprecision(3);
+    printLatency("Opus编码", "xiaozhi_opus_encode_seconds");
+    printLatency("Opus解码", "xiaozhi_opus_decode_seconds");
+    printLatency("MCP调用", "xiaozhi_mcp_call_seconds");
+    printLatency("对话轮次", "xiaozhi_ai_turn_seconds");
+    std::cout << std::defaultfloat;
+    RealtimeManager::getInstance().printReport();
     std::cout << std::endl;
 }
 
+void CommandHandler::handleTrace(const std::vector<std::string>& args) {
+    auto& tracer = Tracer::getInstance();
+    if (args.empty()) {
+        std::cout << "追踪状态: " << (tracer.isEnabled() ? "记录中" : "已停止") << std::endl;
+        std::cout << "用法: trace on|off|dump [路径]" << std::endl;
+        return;
+    }
+    
+    if (args[0] == "on") {
+        tracer.setEnabled(true);
+        std::cout << "已开始记录流水线追踪" << std::endl;
+    } else if (args[0] == "off") {
+        tracer.setEnabled(false);
+        std::cout << "已停止记录流水线追踪" << std::endl;
+    } else if (args[0] == "dump") {
+        std::string path = args.size() > 1 ? args[1] : tracer.getConfig().output_file;
+        if (tracer.dumpChromeJson(path)) {
+            std::cout << "可在 chrome://tracing 或 https://ui.perfetto.dev 中打开 " << path << std::endl;
+        }
+    } else {
+        std::cout << "未知参数: " << args[0] << ". 用法: trace on|off|dump [路径]" << std::endl;
+    }
+}
+
+void CommandHandler::handleLog(const std::vector<std::string>& args) {
+    auto& logger = Logger::getInstance();
+    const char* usage = "用法: log [模块] DEBUG|INFO|WARN|ERROR|default";
+    if (args.empty()) {
+        std::cout << "全局日志级别: " << Logger::levelToString(logger.getLogLevel()) << std::endl;
+        for (const auto& module : logger.getModuleLevels()) {
+            std::cout << "  " << module.first << ": " << Logger::levelToString(module.second) << std::endl;
+        }
+        std::cout << "已记录过日志的模块:";
+        for (const auto& name : logger.getActiveModules()) {
+            std::cout << " " << name;
+        }
+        std::cout << std::endl << usage << std::endl;
+        return;
+    }
+
+    // 级别名不区分大小写
+    auto parseLevel = [](std::string text, LogLevel& level) {
+        std::transform(text.begin(), text.end(), text.begin(), ::toupper);
+        return Logger::parseLevel(text, level);
+    };
+
+    LogLevel level;
+    if (args.size() == 1) {
+        if (!parseLevel(args[0], level)) {
+            std::cout << "未知的日志级别: " << args[0] << ". " << usage << std::endl;
+            return;
+        }
+        logger.setLogLevel(level);
+        std::cout << "全局日志级别已设为 " << args[0] << std::endl;
+    } else if (args[1] == "default") {
+        logger.clearModuleLevel(args[0]);
+        std::cout << "模块 " << args[0] << " 恢复使用全局日志级别" << std::endl;
+    } else if (parseLevel(args[1], level)) {
+        logger.setModuleLevel(args[0], level);
+        std::cout << "模块 " << args[0] << " 的日志级别已设为 " << args[1] << std::endl;
+    } else {
+        std::cout << "未知的日志级别: " << args[1] << ". " << usage << std::endl;
+    }
+}
+
 } // namespace xiaozhi
\ No newline at end of file
@@ -34,12 +34,18 @@ private:
 
     std::map<std::string, CommandInfo> commands_;
     
+    // 上次查询状态时的CPU时间和运行时间，用于计算区间CPU使用率
+    double last_status_cpu_seconds_ = 0.0;
+    double last_status_uptime_ = 0.0;
+    
     // 内置命令
     void registerBuiltInCommands();
     void handleTestAudio(const std::vector<std::string>& args);
     void handleVoiceMode(const std::vector<std::string>& args);
     void handleTextMode(const std::vector<std::string>& args);
     void handleStatus(const std::vector<std::string>& args);
+    void handleTrace(const std::vector<std::string>& args);
+    void handleLog(const std::vector<std::string>& args);
 };
 
 } // namespace xiaozhi
\ No newline at end of file
@@ -1,17 +1,32 @@
 #include <iostream>
-#include <thread>
 #include <chrono>
 #include <string>
+#include <functional>
+#include <algorithm>
 #include <cstring>
+#include <csignal>
+#include <atomic>
 #include "audio/audio_manager.h"
 #include "network/websocket_client.h"
 #include "mcp/mcp_server.h"
 #include "ai/ai_engine.h"
 #include "utils/config_manager.h"
 #include "utils/logger.h"
+#include "utils/realtime.h"
+#include "utils/trace.h"
+#include "utils/metrics_server.h"
+#include "utils/event_loop.h"
+#include "utils/event_loop_pool.h"
+#include "utils/async.h"
 
 int main(int argc, char *argv[]) {
+    // 信号由主事件循环通过signalfd处理，必须在创建任何线程（包括日志写线程）之前屏蔽，
+    // 之后创建的线程继承该屏蔽字，信号只会从signalfd读出
+    xiaozhi::EventLoop::blockSignals({SIGINT, SIGTERM, SIGUSR1});
+
     std::string config_path = ""; // 默认为空，让ConfigManager使用默认路径
+    bool trace_enabled = false;
+    bool mcp_stdio = false;
     
     // 解析命令行参数
     for (int i = 1; i < argc; i++) {
@@ -19,34 +34,124 @@ int main(int argc, char *argv[]) {
             config_path = argv[++i];
         } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
             config_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            trace_enabled = true;
+        } else if (strcmp(argv[i], "--mcp-stdio") == 0) {
+            mcp_stdio = true;
         } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
             std::cout << "小智AI - Linux版\n";
             std::cout << "用法: " << argv[0] << " [选项]\n";
             std::cout << "选项:\n";
             std::cout << "  --config, -c <路径>  指定配置文件路径\n";
+            std::cout << "  --trace             启动即记录流水线追踪，SIGUSR1导出\n";
+            std::cout << "  --mcp-stdio         在标准输入/输出上提供MCP服务（日志改写到stderr）\n";
             std::cout << "  --help, -h          显示此帮助信息\n";
             return 0;
         }
     }
     
+    // stdio模式下标准输出只用于MCP协议，在第一条日志之前把控制台输出改到stderr
+    if (mcp_stdio) {
+        xiaozhi::McpStdioTransport::reserveStdout();
+    }
+    
     // 初始化日志系统
     xiaozhi::Logger::getInstance().info("小智AI - Linux版启动中...");
     
+    // 对端关闭TLS连接时写入不应终止进程，由发送返回值处理
+    signal(SIGPIPE, SIG_IGN);
+    
     // 加载配置
     auto& configMgr = xiaozhi::ConfigManager::getInstance();
     configMgr.loadConfig(config_path);  // 使用命令行参数指定的配置文件路径
     
+    // 异步日志：音频等线程只写入线程本地缓冲，由后台线程批量落盘
+    xiaozhi::Logger::getInstance().configure(configMgr.getLoggingConfig());
+    
     auto serverConfig = configMgr.getServerConfig();
     auto audioConfig = configMgr.getAudioConfig();
     auto mcpConfig = configMgr.getMcpConfig();
     auto networkConfig = configMgr.getNetworkConfig();
     
+    // 实时调度：锁定内存，各线程启动时按角色设置SCHED_FIFO和CPU绑定
+    auto& realtime = xiaozhi::RealtimeManager::getInstance();
+    realtime.configure(configMgr.getRealtimeConfig());
+    realtime.lockProcessMemory();
+    
+    // 共享事件循环线程：AI引擎等组件的任务都在这里执行，不再各自占用线程
+    xiaozhi::EventLoopPool::getInstance().configure(networkConfig.loop_threads);
+    
+    // 流水线追踪：kill -USR1 <pid> 导出Chrome trace JSON
+    auto traceConfig = configMgr.getTraceConfig();
+    traceConfig.enabled = traceConfig.enabled || trace_enabled;
+    auto& tracer = xiaozhi::Tracer::getInstance();
+    tracer.configure(traceConfig);
+    
+    // 主事件循环：WebSocket收包、重连定时器和信号都在这里处理，空闲时不唤醒
+    xiaozhi::EventLoop loop;
+    if (!loop.isValid()) {
+        xiaozhi::Logger::getInstance().error("无法创建主事件循环");
+        return 1;
+    }
+    // 信号处理和循环退出在循环线程中置位；连接断开回调可能在发送音频/AI消息的线程中读取
+    std::atomic<bool> shutting_down{false};
+    loop.watchSignals({SIGINT, SIGTERM, SIGUSR1}, [&](int signo) {
+        if (signo == SIGUSR1) {
+            tracer.dumpChromeJson(traceConfig.output_file);
+            return;
+        }
+        xiaozhi::Logger::getInstance().info(std::string("收到信号 ") + strsignal(signo) + "，准备退出");
+        shutting_down = true;
+        loop.stop();
+    });
+    
+    // Prometheus指标端点，供集中采集抓取
+    xiaozhi::MetricsServer metricsServer;
+    auto metricsConfig = configMgr.getMetricsConfig();
+    if (metricsConfig.enabled) {
+        metricsServer.start(metricsConfig);
+    }
+    
     // 初始化音频管理器
     xiaozhi::AudioManager audioManager;
-    audioManager.initialize(audioConfig.sample_rate, audioConfig.channels);
+    xiaozhi::AudioBackendConfig backendConfig;
+    backendConfig.type = audioConfig.backend;
+    backendConfig.input_device = audioConfig.input_device;
+    backendConfig.output_device = audioConfig.output_device;
+    backendConfig.input_file = audioConfig.input_file;
+    backendConfig.output_file = audioConfig.output_file;
+    backendConfig.realtime = audioConfig.file_realtime;
+    backendConfig.loop = audioConfig.file_loop;
+    audioManager.setBackendConfig(backendConfig);
+    audioManager.setDuplexSync(audioConfig.duplex_sync);
+    audioManager.initialize(audioConfig.sample_rate, audioConfig.channels, audioConfig.frame_pool_size);
     
     // 初始化网络客户端
     xiaozhi::WebsocketClient wsClient;
+    wsClient.setEventLoop(&loop);
+    wsClient.setHeader("Authorization", "Bearer " + serverConfig.auth_token);
+    wsClient.setHeader("Protocol-Version", "1");
+    
+    // 握手在后台线程中进行，主循环照常处理信号；连接失败或断开后等待network.reconnect_interval秒重连
+    const std::chrono::milliseconds reconnectDelay(std::max(1, networkConfig.reconnect_interval) * 1000);
+    std::function<void()> scheduleReconnect;
+    std::function<void()> connectServer = [&]() {
+        wsClient.connectAsync(serverConfig.websocket_url).then([&](bool connected) {
+            if (!connected) {
+                scheduleReconnect();
+            }
+        });
+    };
+    scheduleReconnect = [&]() {
+        if (shutting_down) {
+            return;
+        }
+        xiaozhi::asyncDelay(loop, reconnectDelay).then([&](bool) {
+            if (!shutting_down) {
+                connectServer();
+            }
+        });
+    };
     
     // 设置网络事件回调
     wsClient.setConnectionStatusCallback([&](bool connected) {
@@ -54,12 +159,39 @@ int main(int argc, char *argv[]) {
             xiaozhi::Logger::getInstance().info("WebSocket连接已建立");
         } else {
             xiaozhi::Logger::getInstance().warn("WebSocket连接已断开");
+            scheduleReconnect();
         }
     });
     
     // 初始化MCP服务器
     xiaozhi::McpServer mcpServer(mcpConfig.port);
-    if (mcpConfig.enabled) {
+    xiaozhi::McpTransportOptions mcpTransport;
+    mcpTransport.bind_address = mcpConfig.bind_address;
+    mcpTransport.port = mcpConfig.port;
+    mcpTransport.http = mcpConfig.http;
+    mcpTransport.stdio = mcpConfig.stdio || mcp_stdio;
+    mcpTransport.max_connections = mcpConfig.max_connections;
+    mcpTransport.request_timeout_ms = mcpConfig.http_request_timeout_ms;
+    mcpTransport.idle_timeout_ms = mcpConfig.http_idle_timeout_ms;
+    mcpServer.setTransportOptions(mcpTransport);
+    xiaozhi::ToolExecutorOptions toolExecutor;
+    toolExecutor.workers = mcpConfig.tool_workers;
+    toolExecutor.queue_size = mcpConfig.tool_queue_size;
+    toolExecutor.default_timeout_ms = mcpConfig.tool_timeout_ms;
+    mcpServer.setExecutorOptions(toolExecutor);
+    mcpServer.getToolRegistry().setListPageSize(static_cast<size_t>(std::max(0, mcpConfig.tools_page_size)));
+    mcpServer.getToolRegistry().setResultCacheBytes(static_cast<size_t>(std::max(0, mcpConfig.tool_cache_bytes)));
+    if (!mcpConfig.plugin_dir.empty()) {
+        mcpServer.loadPlugins(mcpConfig.plugin_dir);
+    }
+    // stdio客户端退出即结束进程，与按需拉起的MCP服务进程行为一致
+    mcpServer.setStdioClosedCallback([&]() {
+        loop.post([&]() {
+            shutting_down = true;
+            loop.stop();
+        });
+    });
+    if (mcpConfig.enabled || mcp_stdio) {
         mcpServer.start();
     }
     
@@ -69,38 +201,26 @@ int main(int argc, char *argv[]) {
     aiEngine.start();
     
     xiaozhi::Logger::getInstance().info("小智AI - Linux版已启动");
+    realtime.printReport();
     
     // 连接到WebSocket服务器
-    wsClient.connect(serverConfig.websocket_url);
-    
-    // 主循环
-    bool running = true;
-    while(running) {
-        // 处理事件循环
-        audioManager.process();
-        wsClient.process();
-        mcpServer.process();
-        aiEngine.process();
-        
-        // 短暂休眠避免CPU占用过高
-        std::this_thread::sleep_for(std::chrono::milliseconds(10));
-        
-        // 检查退出条件（例如，可以监听信号或其他退出机制）
-        // 这里简化为简单的退出条件
-        static int counter = 0;
-        if (++counter > 10000) { // 100秒后退出，实际应用中应使用信号处理
-            running = false;
-        }
-    }
+    connectServer();
+    
+    // 主循环：阻塞在epoll_wait上，直到SIGINT/SIGTERM
+    realtime.applyToCurrentThread(xiaozhi::ThreadRole::NETWORK);
+    TRACE_THREAD_NAME("main-loop");
+    loop.run();
+    shutting_down = true;
     
     // 清理资源
     wsClient.disconnect();
-    if (mcpConfig.enabled) {
-        mcpServer.stop();
-    }
+    mcpServer.stop();
     aiEngine.stop();
+    metricsServer.stop();
+    xiaozhi::EventLoopPool::getInstance().stop();
     
     xiaozhi::Logger::getInstance().info("小智AI - Linux版已退出");
+    xiaozhi::Logger::getInstance().flush();
     
     return 0;
 }
\ No newline at end of file
@@ -1,12 +1,34 @@
 #include "json_rpc_handler.h"
+#include "tool_executor.h"
 #include <iostream>
 #include <json-c/json.h>
 #include <sstream>
 #include <random>
+#include <vector>
+#include <memory>
+#include <cstring>
 
 namespace xiaozhi {
 
-JsonRpcHandler::JsonRpcHandler(ToolRegistry& registry) : tool_registry_(registry) {
+namespace {
+
+std::string serializeId(json_object* id_obj) {
+    return id_obj ? json_object_to_json_string_ext(id_obj, JSON_C_TO_STRING_PLAIN) : "";
+}
+
+// id_json为空表示请求没有id（通知），响应中也不带id
+std::string buildResultResponse(const std::string& result, const std::string& id_json) {
+    std::string response = "{\"jsonrpc\":\"2.0\",";
+    if (!id_json.empty()) {
+        response += "\"id\":" + id_json + ",";
+    }
+    response += "\"result\":" + result + "}";
+    return response;
+}
+
+} // namespace
+
+JsonRpcHandler::JsonRpcHandler(ToolRegistry& registry) : tool_registry_(registry), executor_(nullptr) {
     std::cout << "[JsonRpcHandler] 初始化JSON-RPC处理器" << std::endl;
 }
 
@@ -14,210 +36,330 @@ JsonRpcHandler::~JsonRpcHandler() {
     std::cout << "[JsonRpcHandler] JSON-RPC处理器已销毁" << std::endl;
 }
 
+void JsonRpcHandler::setExecutor(ToolExecutor* executor) {
+    executor_ = executor;
+}
+
+void JsonRpcHandler::handleRequest(const std::string& request, uint64_t origin, JsonRpcResponder respond,
+                                   JsonRpcNotifier notify) {
+    dispatch(request, origin, executor_, respond, notify);
+}
+
 std::string JsonRpcHandler::handleRequest(const std::string& request) {
+    // 不经过执行器时所有方法都在当前线程内完成，respond已被调用
+    std::string response;
+    dispatch(request, 0, nullptr, [&response](const std::string& result) { response = result; }, nullptr);
+    return response;
+}
+
+void JsonRpcHandler::dispatch(const std::string& request, uint64_t origin, ToolExecutor* executor,
+                              const JsonRpcResponder& respond, const JsonRpcNotifier& notify) {
     json_object* jobj = json_tokener_parse(request.c_str());
     if (!jobj) {
         std::cerr << "[JsonRpcHandler] 错误: 无法解析JSON-RPC请求" << std::endl;
-        return createErrorResponse(-32700, "Parse error", nullptr);
+        respond(createErrorResponse(-32700, "Parse error", nullptr));
+        return;
+    }
+
+    if (json_object_is_type(jobj, json_type_array)) {
+        dispatchBatch(jobj, origin, executor, respond, notify);
+    } else {
+        dispatchMessage(jobj, origin, executor, respond, notify);
+    }
+    json_object_put(jobj);
+}
+
+void JsonRpcHandler::dispatchBatch(json_object* batch, uint64_t origin, ToolExecutor* executor,
+                                   const JsonRpcResponder& respond, const JsonRpcNotifier& notify) {
+    size_t count = json_object_array_length(batch);
+    if (count == 0) {
+        respond(createErrorResponse(-32600, "Invalid Request: Empty batch", nullptr));
+        return;
     }
 
+    // 各请求独立分派，tools/call在工作线程中并发执行；
+    // 全部完成后按请求顺序拼成响应数组，通知不占位置
+    struct BatchState {
+        std::mutex mutex;
+        std::vector<std::string> responses;
+        size_t remaining;
+        JsonRpcResponder respond;
+    };
+    auto state = std::make_shared<BatchState>();
+    state->responses.resize(count);
+    state->remaining = count;
+    state->respond = respond;
+
+    for (size_t i = 0; i < count; ++i) {
+        auto collect = [state, i](const std::string& response) {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->responses[i] = response;
+                if (--state->remaining > 0) {
+                    return;
+                }
+            }
+            std::string combined;
+            for (const auto& item : state->responses) {
+                if (item.empty()) {
+                    continue;
+                }
+                combined += combined.empty() ? "[" : ",";
+                combined += item;
+            }
+            // 批量中全是通知时不返回任何内容
+            state->respond(combined.empty() ? combined : combined + "]");
+        };
+        dispatchMessage(json_object_array_get_idx(batch, i), origin, executor, collect, notify);
+    }
+}
+
+void JsonRpcHandler::dispatchMessage(json_object* jobj, uint64_t origin, ToolExecutor* executor,
+                                     const JsonRpcResponder& respond, const JsonRpcNotifier& notify) {
     // 检查必需字段
     json_object* jsonrpc_obj = nullptr;
     json_object* method_obj = nullptr;
     json_object* id_obj = nullptr;
     
     if (!json_object_object_get_ex(jobj, "jsonrpc", &jsonrpc_obj)) {
-        json_object_put(jobj);
-        return createErrorResponse(-32600, "Invalid Request: Missing jsonrpc field", nullptr);
+        respond(createErrorResponse(-32600, "Invalid Request: Missing jsonrpc field", nullptr));
+        return;
     }
     
-    std::string jsonrpc_version = json_object_get_string(jsonrpc_obj);
-    if (jsonrpc_version != "2.0") {
-        json_object_put(jobj);
-        return createErrorResponse(-32600, "Invalid Request: Unsupported jsonrpc version", nullptr);
+    // 字段值为JSON null时get_ex返回true但对象为空，取字符串前必须先确认类型
+    if (!json_object_is_type(jsonrpc_obj, json_type_string) ||
+        std::strcmp(json_object_get_string(jsonrpc_obj), "2.0") != 0) {
+        respond(createErrorResponse(-32600, "Invalid Request: Unsupported jsonrpc version", nullptr));
+        return;
     }
     
     if (!json_object_object_get_ex(jobj, "method", &method_obj)) {
-        json_object_put(jobj);
-        return createErrorResponse(-32600, "Invalid Request: Missing method", nullptr);
+        respond(createErrorResponse(-32600, "Invalid Request: Missing method", nullptr));
+        return;
+    }
+    if (!json_object_is_type(method_obj, json_type_string)) {
+        respond(createErrorResponse(-32600, "Invalid Request: method must be a string", nullptr));
+        return;
     }
     
     std::string method = json_object_get_string(method_obj);
     id_obj = nullptr;
     json_object_object_get_ex(jobj, "id", &id_obj); // id is optional for notifications
 
-    std::string response;
-    if (method == "initialize") {
-        response = handleInitialize(jobj);
+    // 没有id的消息是通知：照常执行（例如notifications/cancelled、无id的tools/call），
+    // 但无论成功与否都不应答，批量中也不占位置；传输层据此返回202或不输出
+    bool is_notification = !id_obj;
+    JsonRpcResponder reply = respond;
+    if (is_notification) {
+        reply = [respond](const std::string&) { respond(""); };
+    }
+
+    if (method == "notifications/cancelled") {
+        handleCancelled(jobj, origin);
+        reply("");
+    } else if (method.compare(0, 14, "notifications/") == 0) {
+        reply("");
+    } else if (method == "initialize") {
+        reply(handleInitialize(jobj));
+    } else if (method == "ping") {
+        reply(createResultResponse("{}", id_obj));
     } else if (method == "tools/list") {
-        response = handleListTools(jobj);
+        reply(handleListTools(jobj));
     } else if (method == "tools/call") {
-        response = handleCallTool(jobj);
+        handleCallTool(jobj, origin, executor, reply, notify);
     } else {
-        response = createErrorResponse(-32601, "Method not found: " + method, id_obj);
+        reply(createErrorResponse(-32601, "Method not found: " + method, id_obj));
     }
-
-    json_object_put(jobj);
-    return response;
 }
 
 std::string JsonRpcHandler::handleInitialize(json_object* request) {
     json_object* id_obj = nullptr;
     json_object_object_get_ex(request, "id", &id_obj);
     
-    std::string response = "{"
-        "\"jsonrpc\":\"2.0\","
-        "\"result\":{"
-            "\"protocolVersion\":\"1.0\","
-            "\"serverInfo\":{"
-                "\"name\":\"xiaozhi-mcp-server\","
-                "\"version\":\"1.0.0\""
-            "},"
-            "\"capabilities\":{"
-                "\"tools\":true,"
-                "\"experimental\":{}"
-            "}"
-        "}";
-    
-    if (id_obj) {
-        // 如果有ID，则返回完整响应
-        json_object* resp_obj = json_tokener_parse(response.c_str());
-        json_object_object_add(resp_obj, "id", json_object_get(id_obj)); // 增加引用计数
-        std::string result = json_object_to_json_string_ext(resp_obj, JSON_C_TO_STRING_PLAIN);
-        json_object_put(resp_obj);
-        return result;
-    } else {
-        // 如果没有ID，则这是通知，只返回result部分
-        return response;
-    }
+    return createResultResponse("{"
+        "\"protocolVersion\":\"1.0\","
+        "\"serverInfo\":{"
+            "\"name\":\"xiaozhi-mcp-server\","
+            "\"version\":\"1.0.0\""
+        "},"
+        "\"capabilities\":{"
+            "\"tools\":true,"
+            "\"experimental\":{}"
+        "}"
+    "}", id_obj);
 }
 
 std::string JsonRpcHandler::handleListTools(json_object* request) {
     json_object* id_obj = nullptr;
     json_object_object_get_ex(request, "id", &id_obj);
     
-    auto tools = tool_registry_.getAllTools();
-    
-    json_object* result_obj = json_object_new_object();
-    json_object* tools_array = json_object_new_array();
+    // 序列化结果随注册表代数缓存，工具集合不变时只做字符串拼接
+    auto cache = tool_registry_.listCache();
     
-    for (const auto& tool : tools) {
-        json_object* tool_obj = json_object_new_object();
-        json_object_object_add(tool_obj, "name", json_object_new_string(tool.name.c_str()));
-        json_object_object_add(tool_obj, "description", json_object_new_string(tool.description.c_str()));
-        
-        // 创建参数schema
-        json_object* schema_obj = json_object_new_object();
-        json_object_object_add(schema_obj, "type", json_object_new_string("object"));
-        
-        json_object* properties_obj = json_object_new_object();
-        for (const auto& param : tool.parameters) {
-            json_object* param_obj = json_object_new_object();
-            json_object_object_add(param_obj, "type", json_object_new_string(param.type.c_str()));
-            json_object_object_add(param_obj, "description", json_object_new_string(param.description.c_str()));
-            json_object_object_add(properties_obj, param.name.c_str(), param_obj);
-        }
-        json_object_object_add(schema_obj, "properties", properties_obj);
-        
-        // 必需参数
-        json_object* required_array = json_object_new_array();
-        for (const auto& param : tool.parameters) {
-            if (param.required) {
-                json_object_array_add(required_array, json_object_new_string(param.name.c_str()));
-            }
+    size_t page = 0;
+    json_object* params_obj = nullptr;
+    json_object* cursor_obj = nullptr;
+    if (json_object_object_get_ex(request, "params", &params_obj) &&
+        json_object_object_get_ex(params_obj, "cursor", &cursor_obj)) {
+        uint64_t generation = 0;
+        // cursor为null或非字符串时同样按无效游标处理
+        if (!json_object_is_type(cursor_obj, json_type_string) ||
+            !ToolRegistry::parseCursor(json_object_get_string(cursor_obj), generation, page) ||
+            generation != cache->generation || page >= cache->pages.size()) {
+            return createErrorResponse(-32602, "Invalid params: Invalid cursor", id_obj);
         }
-        json_object_object_add(schema_obj, "required", required_array);
-        
-        json_object_object_add(tool_obj, "inputSchema", schema_obj);
-        json_object_array_add(tools_array, tool_obj);
     }
     
-    json_object_object_add(result_obj, "tools", tools_array);
-    
-    std::string response = "{"
-        "\"jsonrpc\":\"2.0\","
-        "\"result\":" + std::string(json_object_to_json_string_ext(result_obj, JSON_C_TO_STRING_PLAIN)) + 
-        "}";
-    
-    if (id_obj) {
-        json_object* resp_obj = json_tokener_parse(response.c_str());
-        json_object_object_add(resp_obj, "id", json_object_get(id_obj));
-        std::string result = json_object_to_json_string_ext(resp_obj, JSON_C_TO_STRING_PLAIN);
-        json_object_put(resp_obj);
-        json_object_put(result_obj);
-        return result;
-    } else {
-        std::string result = json_object_to_json_string_ext(result_obj, JSON_C_TO_STRING_PLAIN);
-        json_object_put(result_obj);
-        return "{\"jsonrpc\":\"2.0\",\"result\":" + result + "}";
-    }
+    return createResultResponse(cache->pages[page], id_obj);
 }
 
-std::string JsonRpcHandler::handleCallTool(json_object* request) {
+void JsonRpcHandler::handleCallTool(json_object* request, uint64_t origin, ToolExecutor* executor,
+                                    const JsonRpcResponder& respond, const JsonRpcNotifier& notify) {
     json_object* id_obj = nullptr;
     json_object_object_get_ex(request, "id", &id_obj);
     
     json_object* params_obj = nullptr;
     if (!json_object_object_get_ex(request, "params", &params_obj)) {
-        return createErrorResponse(-32602, "Invalid params: Missing params field", id_obj);
+        respond(createErrorResponse(-32602, "Invalid params: Missing params field", id_obj));
+        return;
     }
     
     json_object* name_obj = nullptr;
     if (!json_object_object_get_ex(params_obj, "name", &name_obj)) {
-        return createErrorResponse(-32602, "Invalid params: Missing tool name", id_obj);
+        respond(createErrorResponse(-32602, "Invalid params: Missing tool name", id_obj));
+        return;
+    }
+    if (!json_object_is_type(name_obj, json_type_string)) {
+        respond(createErrorResponse(-32602, "Invalid params: Tool name must be a string", id_obj));
+        return;
     }
     
     std::string tool_name = json_object_get_string(name_obj);
     
-    // 解析参数
+    // 参数对象从请求上摘下并由本次调用接管，请求释放后工具仍直接读取解析结果，
+    // 不再转换成字符串表。摘下后请求树和参数树互不共享，可以在不同线程分别释放
+    ToolValue arguments;
     json_object* arguments_obj = nullptr;
-    std::map<std::string, std::string> arguments;
-    if (json_object_object_get_ex(params_obj, "arguments", &arguments_obj)) {
-        json_object_object_foreach(arguments_obj, key, val) {
-            arguments[key] = json_object_get_string(val);
-        }
+    if (json_object_object_get_ex(params_obj, "arguments", &arguments_obj) && arguments_obj) {
+        arguments = ToolValue::adopt(json_object_get(arguments_obj));
+        json_object_object_del(params_obj, "arguments");
     }
     
-    // 调用工具
-    std::string result = tool_registry_.callTool(tool_name, arguments);
-    
-    std::string response = "{"
-        "\"jsonrpc\":\"2.0\","
-        "\"result\":" + result +
-        "}";
-    
-    if (id_obj) {
-        json_object* resp_obj = json_tokener_parse(response.c_str());
-        json_object_object_add(resp_obj, "id", json_object_get(id_obj));
-        std::string final_response = json_object_to_json_string_ext(resp_obj, JSON_C_TO_STRING_PLAIN);
-        json_object_put(resp_obj);
-        return final_response;
+    // 请求对象在返回后释放，异步应答只保留序列化后的id
+    std::string id_json = serializeId(id_obj);
+    auto tool = tool_registry_.findTool(tool_name);
+    if (!tool) {
+        respond(createErrorResponse(-32602, "Unknown tool: " + tool_name, id_obj));
+        return;
+    }
+
+    std::string error;
+    if (!ToolRegistry::validateArguments(*tool, arguments, error)) {
+        respond(createErrorResponse(-32602, "Invalid params: " + error, id_obj));
+        return;
+    }
+
+    // 客户端在_meta.progressToken中给出令牌时才推送进度和分块结果
+    std::string progress_token;
+    json_object* meta_obj = nullptr;
+    json_object* progress_token_obj = nullptr;
+    if (json_object_object_get_ex(params_obj, "_meta", &meta_obj) &&
+        json_object_object_get_ex(meta_obj, "progressToken", &progress_token_obj)) {
+        progress_token = serializeId(progress_token_obj);
+    }
+
+    // 幂等工具先查结果缓存，命中时直接在当前线程应答，不进入执行器。
+    // 推送过分块的结果不含完整内容，只缓存没有推送的调用结果
+    std::string cache_key;
+    if (ToolRegistry::isCacheable(*tool)) {
+        cache_key = ToolRegistry::cacheKey(*tool, arguments);
+        std::string cached;
+        if (tool_registry_.lookupResult(cache_key, cached)) {
+            respond(buildResultResponse(cached, id_json));
+            return;
+        }
+    }
+
+    if (!executor) {
+        ToolStream stream(CancellationToken(), notify, progress_token);
+        std::string result = ToolRegistry::invokeTool(*tool, arguments, stream);
+        if (!cache_key.empty() && !stream.isStreaming()) {
+            tool_registry_.storeResult(*tool, cache_key, result);
+        }
+        respond(buildResultResponse(result, id_json));
+        return;
+    }
+
+    CancellationToken token = executor->makeToken(*tool);
+    CallKey key(origin, id_json);
+    if (!id_json.empty()) {
+        std::lock_guard<std::mutex> lock(calls_mutex_);
+        active_calls_[key] = token;
+    }
+
+    JsonRpcResponder responder = respond;
+    ToolStream stream(token, notify, progress_token);
+    bool store = !cache_key.empty() && !stream.isStreaming();
+    executor->submit(tool, std::move(arguments), stream,
+                     [this, responder, key, token, tool, cache_key, store](const std::string& result,
+                                                                         ToolCallStatus status) {
+        if (store && status == ToolCallStatus::COMPLETED) {
+            tool_registry_.storeResult(*tool, cache_key, result);
+        }
+        if (!key.second.empty()) {
+            std::lock_guard<std::mutex> lock(calls_mutex_);
+            auto it = active_calls_.find(key);
+            if (it != active_calls_.end() && it->second == token) {
+                active_calls_.erase(it);
+            }
+        }
+        // 被取消的请求按MCP约定不再应答
+        responder(status == ToolCallStatus::CANCELLED ? "" : buildResultResponse(result, key.second));
+    });
+}
+
+void JsonRpcHandler::handleCancelled(json_object* request, uint64_t origin) {
+    json_object* params_obj = nullptr;
+    json_object* request_id_obj = nullptr;
+    if (!json_object_object_get_ex(request, "params", &params_obj) ||
+        !json_object_object_get_ex(params_obj, "requestId", &request_id_obj)) {
+        return;
+    }
+
+    CancellationToken token;
+    {
+        std::lock_guard<std::mutex> lock(calls_mutex_);
+        auto it = active_calls_.find(CallKey(origin, serializeId(request_id_obj)));
+        if (it == active_calls_.end()) {
+            return;     // 已完成或未知的请求，按约定忽略
+        }
+        token = it->second;
+    }
+    if (executor_) {
+        executor_->cancel(token);
     } else {
-        return response;
+        token.cancel();
     }
 }
 
+std::string JsonRpcHandler::createResultResponse(const std::string& result, json_object* id_obj) {
+    return buildResultResponse(result, serializeId(id_obj));
+}
+
 std::string JsonRpcHandler::createErrorResponse(int code, const std::string& message, json_object* id_obj) {
     json_object* error_obj = json_object_new_object();
     json_object_object_add(error_obj, "code", json_object_new_int(code));
     json_object_object_add(error_obj, "message", json_object_new_string(message.c_str()));
     
+    // 无法确定请求id时按JSON-RPC 2.0规定返回"id":null，批量响应中客户端据此区分
     std::string response = "{"
         "\"jsonrpc\":\"2.0\","
-        "\"error\":" + std::string(json_object_to_json_string_ext(error_obj, JSON_C_TO_STRING_PLAIN)) + 
+        "\"error\":" + std::string(json_object_to_json_string_ext(error_obj, JSON_C_TO_STRING_PLAIN)) + ","
+        "\"id\":" + (id_obj ? serializeId(id_obj) : std::string("null")) +
         "}";
     
-    if (id_obj) {
-        json_object* resp_obj = json_tokener_parse(response.c_str());
-        json_object_object_add(resp_obj, "id", json_object_get(id_obj));
-        std::string result = json_object_to_json_string_ext(resp_obj, JSON_C_TO_STRING_PLAIN);
-        json_object_put(resp_obj);
-        json_object_put(error_obj);
-        return result;
-    } else {
-        json_object_put(error_obj);
-        return response;
-    }
+    json_object_put(error_obj);
+    return response;
 }
 
 } // namespace xiaozhi
\ No newline at end of file
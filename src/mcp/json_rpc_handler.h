@@ -1,6 +1,11 @@
 #pragma once
 
 #include <string>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <functional>
+#include <cstdint>
 #include "tool_registry.h"
 
 // Forward declaration
@@ -8,23 +13,57 @@ struct json_object;
 
 namespace xiaozhi {
 
+class ToolExecutor;
+
+// 收到响应时回调，空串表示不需要响应（通知、已取消的请求）
+using JsonRpcResponder = std::function<void(const std::string& response)>;
+// 向请求来源推送通知（进度、分块结果），可在任意线程调用；不支持推送的来源为空
+using JsonRpcNotifier = std::function<void(const std::string& notification)>;
+
 class JsonRpcHandler {
 public:
     explicit JsonRpcHandler(ToolRegistry& registry);
     ~JsonRpcHandler();
 
-    // 处理JSON-RPC 2.0请求
+    // 设置后tools/call提交到执行器，响应在工具结束时经respond返回；
+    // 只能在没有请求进入时（传输启动前、停止后）修改
+    void setExecutor(ToolExecutor* executor);
+
+    // 处理JSON-RPC 2.0请求或批量请求。origin标识请求来源（连接或会话），
+    // notifications/cancelled只取消同一来源发出的请求；tools/call带有
+    // _meta.progressToken时，工具的进度和分块结果经notify在响应之前推送
+    void handleRequest(const std::string& request, uint64_t origin, JsonRpcResponder respond,
+                       JsonRpcNotifier notify = nullptr);
+
+    // 同步处理，工具在调用线程上执行
     std::string handleRequest(const std::string& request);
 
 private:
+    using CallKey = std::pair<uint64_t, std::string>;   // (来源, 序列化后的请求id)
+
     ToolRegistry& tool_registry_;
+    ToolExecutor* executor_;
+
+    // 执行器中尚未结束的调用，供notifications/cancelled查找
+    std::map<CallKey, CancellationToken> active_calls_;
+    std::mutex calls_mutex_;
+
+    void dispatch(const std::string& request, uint64_t origin, ToolExecutor* executor,
+                  const JsonRpcResponder& respond, const JsonRpcNotifier& notify);
+    void dispatchBatch(json_object* batch, uint64_t origin, ToolExecutor* executor,
+                       const JsonRpcResponder& respond, const JsonRpcNotifier& notify);
+    void dispatchMessage(json_object* request, uint64_t origin, ToolExecutor* executor,
+                         const JsonRpcResponder& respond, const JsonRpcNotifier& notify);
 
     // 请求处理方法
     std::string handleInitialize(json_object* request);
     std::string handleListTools(json_object* request);
-    std::string handleCallTool(json_object* request);
+    void handleCallTool(json_object* request, uint64_t origin, ToolExecutor* executor,
+                        const JsonRpcResponder& respond, const JsonRpcNotifier& notify);
+    void handleCancelled(json_object* request, uint64_t origin);
 
     // 辅助方法
+    std::string createResultResponse(const std::string& result, json_object* id_obj);
     std::string createErrorResponse(int code, const std::string& message, json_object* id_obj);
 };
 
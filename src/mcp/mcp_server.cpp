@@ -2,42 +2,116 @@
 #include <iostream>
 #include <json-c/json.h>
 #include <sstream>
-#include <thread>
+#include <iomanip>
+#include <sys/utsname.h>
+#include <unistd.h>
+#include "tool_plugin.h"
+#include "utils/trace.h"
+#include "utils/metrics.h"
+#include "utils/event_loop.h"
+#include "utils/event_loop_pool.h"
 
 namespace xiaozhi {
 
-McpServer::McpServer(int port) : port_(port) {
+namespace {
+
+struct McpMetrics {
+    Gauge& running = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_running", "MCP服务器是否运行中");
+};
+
+McpMetrics& mcpMetrics() {
+    static McpMetrics metrics;
+    return metrics;
+}
+
+// 内置工具的整机状态采样间隔，device.status的缓存时长与之相同
+constexpr std::chrono::milliseconds kSystemSampleInterval(1000);
+constexpr int kSystemInfoCacheTtlMs = 5000;
+
+} // namespace
+
+McpServer::McpServer(int port) : port_(port), rpc_handler_(registry_), loop_(nullptr), sample_timer_(-1) {
+    transport_options_.port = port;
     std::cout << "[McpServer] 初始化MCP服务器，端口: " << port << std::endl;
     
-    // 注册内置工具
-    addTool("system.info", 
-            "获取系统信息", 
-            {}, 
-            [](const std::map<std::string, std::string>& params) -> std::string {
-                return "{\"os\":\"Linux\",\"version\":\"1.0.0\",\"uptime\":12345}";
-            });
-            
-    addTool("device.status", 
-            "获取设备状态", 
-            {}, 
-            [](const std::map<std::string, std::string>& params) -> std::string {
-                return "{\"cpu_usage\":25,\"memory_usage\":60,\"temperature\":45}";
-            });
+    registerBuiltinTools();
 }
 
 McpServer::~McpServer() {
     stop();
-    if (server_thread_.joinable()) {
-        server_thread_.join();
-    }
     std::cout << "[McpServer] MCP服务器已销毁" << std::endl;
 }
 
+void McpServer::setTransportOptions(const McpTransportOptions& options) {
+    if (running_) {
+        std::cerr << "[McpServer] 错误: 服务器运行中不能修改传输配置" << std::endl;
+        return;
+    }
+    transport_options_ = options;
+    port_ = options.port;
+}
+
+void McpServer::setEventLoop(EventLoop* loop) {
+    if (running_) {
+        std::cerr << "[McpServer] 错误: 服务器运行中不能更换事件循环" << std::endl;
+        return;
+    }
+    loop_ = loop;
+}
+
+void McpServer::setStdioClosedCallback(std::function<void()> callback) {
+    stdio_closed_callback_ = callback;
+}
+
+void McpServer::setExecutorOptions(const ToolExecutorOptions& options) {
+    if (running_) {
+        std::cerr << "[McpServer] 错误: 服务器运行中不能修改工具执行配置" << std::endl;
+        return;
+    }
+    executor_options_ = options;
+}
+
 bool McpServer::start() {
     if (!running_) {
+        if (!loop_) {
+            loop_ = EventLoopPool::getInstance().next();
+        }
+        executor_.reset(new ToolExecutor(executor_options_));
+        executor_->start();
+        rpc_handler_.setExecutor(executor_.get());
+
+        auto handler = [this](const std::string& message, uint64_t origin, McpResponder respond,
+                              McpNotifier notify) {
+            handleJsonRpc(message, origin, std::move(respond), std::move(notify));
+        };
+
+        if (transport_options_.http) {
+            http_transport_.reset(new McpHttpTransport(handler));
+            if (!http_transport_->start(loop_, transport_options_)) {
+                http_transport_.reset();
+                stopExecutor();
+                return false;
+            }
+        }
+        if (transport_options_.stdio) {
+            stdio_transport_.reset(new McpStdioTransport(handler));
+            stdio_transport_->setClosedCallback(stdio_closed_callback_);
+            if (!stdio_transport_->start(loop_)) {
+                stdio_transport_.reset();
+                http_transport_.reset();
+                stopExecutor();
+                return false;
+            }
+        }
+
+        // 内置工具只读取最新快照，文件读取都在这个定时器里完成
+        sample_timer_ = loop_->addTimer(std::chrono::milliseconds(0), kSystemSampleInterval,
+                                        [this]() { system_monitor_.sample(); });
+
         running_ = true;
-        server_thread_ = std::thread(&McpServer::serverLoop, this);
-        std::cout << "[McpServer] MCP服务器已启动，端口: " << port_ << std::endl;
+        mcpMetrics().running.set(1);
+        std::cout << "[McpServer] MCP服务器已启动，端口: " << getHttpPort() << std::endl;
         return true;
     }
     return false;
@@ -46,32 +120,163 @@ bool McpServer::start() {
 void McpServer::stop() {
     if (running_) {
         running_ = false;
+        // 传输停止时在事件循环中关闭全部连接，返回后不再有请求进入
+        http_transport_.reset();
+        stdio_transport_.reset();
+        if (sample_timer_ >= 0) {
+            loop_->cancelTimer(sample_timer_);
+            sample_timer_ = -1;
+            // 等待可能正在执行的采样回调结束
+            loop_->drain();
+        }
+        // 传输已停止，剩余调用的结果无处可送，取消后等待工作线程退出
+        stopExecutor();
+        mcpMetrics().running.set(0);
         std::cout << "[McpServer] MCP服务器已停止" << std::endl;
     }
 }
 
+void McpServer::stopExecutor() {
+    rpc_handler_.setExecutor(nullptr);
+    if (executor_) {
+        executor_->stop();
+        executor_.reset();
+    }
+}
+
+void McpServer::registerBuiltinTools() {
+    // 两个工具都只读快照，结果在一个采样周期内不变，声明为可缓存
+    ToolOptions info_options;
+    info_options.idempotent = true;
+    info_options.cache_ttl_ms = kSystemInfoCacheTtlMs;
+    addTool("system.info", 
+            "获取系统信息", 
+            {}, 
+            [this](const std::map<std::string, std::string>&) -> std::string {
+                return systemInfo();
+            },
+            info_options);
+    
+    ToolOptions status_options;
+    status_options.idempotent = true;
+    status_options.cache_ttl_ms = static_cast<int>(kSystemSampleInterval.count());
+    addTool("device.status", 
+            "获取设备状态", 
+            {}, 
+            [this](const std::map<std::string, std::string>&) -> std::string {
+                return deviceStatus();
+            },
+            status_options);
+}
+
+std::string McpServer::systemInfo() {
+    auto snapshot = system_monitor_.snapshot();
+    struct utsname name;
+    std::string sysname = "Linux", release, machine, hostname;
+    if (uname(&name) == 0) {
+        sysname = name.sysname;
+        release = name.release;
+        machine = name.machine;
+        hostname = name.nodename;
+    }
+    
+    std::ostringstream response;
+    response << "{"
+             << "\"os\":\"" << sysname << "\","
+             << "\"kernel\":\"" << release << "\","
+             << "\"arch\":\"" << machine << "\","
+             << "\"hostname\":\"" << hostname << "\","
+             << "\"version\":\"1.0.0\","
+             << "\"uptime\":" << static_cast<uint64_t>(snapshot->uptime_seconds) << ","
+             << "\"cpu_count\":" << snapshot->cpu_count << ","
+             << "\"memory_total\":" << snapshot->memory_total_bytes
+             << "}";
+    return response.str();
+}
+
+std::string McpServer::deviceStatus() {
+    auto snapshot = system_monitor_.snapshot();
+    auto age = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - snapshot->sampled_at).count();
+    
+    std::ostringstream response;
+    response << std::fixed << std::setprecision(1) << "{"
+             << "\"cpu_usage\":" << snapshot->cpu_usage_percent << ","
+             << "\"memory_usage\":" << snapshot->memory_usage_percent << ","
+             << "\"memory_available\":" << snapshot->memory_available_bytes << ",";
+    if (snapshot->has_temperature) {
+        response << "\"temperature\":" << snapshot->temperature_celsius << ",";
+    } else {
+        response << "\"temperature\":null,";
+    }
+    response << std::setprecision(2)
+             << "\"load\":[" << snapshot->load_average[0] << "," << snapshot->load_average[1] << ","
+             << snapshot->load_average[2] << "],"
+             << std::setprecision(1) << "\"thermal_zones\":[";
+    for (size_t i = 0; i < snapshot->thermal_zones.size(); ++i) {
+        const auto& zone = snapshot->thermal_zones[i];
+        response << (i > 0 ? "," : "")
+                 << "{\"type\":\"" << zone.type << "\",\"celsius\":" << zone.celsius << "}";
+    }
+    response << "],"
+             << "\"sample_age_ms\":" << age
+             << "}";
+    return response.str();
+}
+
 bool McpServer::isRunning() const {
     return running_;
 }
 
-void McpServer::addTool(const std::string& name, 
+int McpServer::getHttpPort() const {
+    return http_transport_ ? http_transport_->getPort() : port_;
+}
+
+bool McpServer::addTool(const std::string& name, 
                         const std::string& description,
                         const std::vector<ToolParameter>& parameters,
-                        std::function<std::string(const std::map<std::string, std::string>&)> handler) {
-    std::lock_guard<std::mutex> lock(tools_mutex_);
+                        std::function<std::string(const std::map<std::string, std::string>&)> handler,
+                        const ToolOptions& options) {
+    if (!registry_.registerTool(name, description, parameters, ToolHandler(std::move(handler)), options)) {
+        return false;
+    }
     
-    ToolDefinition tool;
-    tool.name = name;
-    tool.description = description;
-    tool.parameters = parameters;
-    tool.handler = handler;
+    std::cout << "[McpServer] 已注册工具: " << name << std::endl;
+    return true;
+}
+
+bool McpServer::addTool(const std::string& name, 
+                        const std::string& description,
+                        const std::vector<ToolParameter>& parameters,
+                        TypedToolHandler handler,
+                        const ToolOptions& options) {
+    if (!registry_.registerTool(name, description, parameters, std::move(handler), options)) {
+        return false;
+    }
     
-    tools_[name] = tool;
+    std::cout << "[McpServer] 已注册工具: " << name << std::endl;
+    return true;
+}
+
+bool McpServer::addTool(const std::string& name, 
+                        const std::string& description,
+                        const std::vector<ToolParameter>& parameters,
+                        StreamingToolHandler handler,
+                        const ToolOptions& options) {
+    if (!registry_.registerTool(name, description, parameters, std::move(handler), options)) {
+        return false;
+    }
     
     std::cout << "[McpServer] 已注册工具: " << name << std::endl;
+    return true;
+}
+
+size_t McpServer::loadPlugins(const std::string& directory) {
+    return loadToolPlugins(directory, registry_);
 }
 
 std::string McpServer::handleRequest(const std::string& request) {
+    TRACE_SCOPE("mcp", "mcp.request");
     // 解析JSON请求
     json_object* jobj = json_tokener_parse(request.c_str());
     if (!jobj) {
@@ -81,23 +286,24 @@ std::string McpServer::handleRequest(const std::string& request) {
 
     std::string method;
     json_object* method_obj = nullptr;
-    if (json_object_object_get_ex(jobj, "method", &method_obj)) {
+    if (json_object_object_get_ex(jobj, "method", &method_obj) && json_object_is_type(method_obj, json_type_string)) {
         method = json_object_get_string(method_obj);
     }
 
     std::string response;
     if (method == "initialize") {
         json_object* params_obj = nullptr;
-        if (json_object_object_get_ex(jobj, "params", &params_obj)) {
+        if (json_object_object_get_ex(jobj, "params", &params_obj) && params_obj) {
             response = handleInitialize(json_object_get_string(params_obj));
         } else {
             response = handleInitialize("{}");
         }
     } else if (method == "tools/list") {
+        TRACE_SCOPE("mcp", "mcp.tools_list");
         response = handleListTools();
     } else if (method == "tools/call") {
         json_object* params_obj = nullptr;
-        if (json_object_object_get_ex(jobj, "params", &params_obj)) {
+        if (json_object_object_get_ex(jobj, "params", &params_obj) && params_obj) {
             response = handleCallTool(json_object_get_string(params_obj));
         } else {
             response = "{\"error\":\"Missing params\"}";
@@ -110,17 +316,15 @@ std::string McpServer::handleRequest(const std::string& request) {
     return response;
 }
 
-void McpServer::process() {
-    // 处理MCP相关任务
-    // 在实际实现中，这里会处理MCP协议事件
+void McpServer::handleJsonRpc(const std::string& message, uint64_t origin, McpResponder respond,
+                              McpNotifier notify) {
+    TRACE_SCOPE("mcp", "mcp.jsonrpc");
+    rpc_handler_.handleRequest(message, origin, std::move(respond), std::move(notify));
 }
 
-void McpServer::serverLoop() {
-    // 模拟服务器主循环
-    while (running_) {
-        // 在实际实现中，这里会监听和处理MCP请求
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    }
+std::string McpServer::handleJsonRpc(const std::string& message) {
+    TRACE_SCOPE("mcp", "mcp.jsonrpc");
+    return rpc_handler_.handleRequest(message);
 }
 
 std::string McpServer::handleInitialize(const std::string& params) {
@@ -136,59 +340,11 @@ std::string McpServer::handleInitialize(const std::string& params) {
 }
 
 std::string McpServer::handleListTools() {
-    std::ostringstream response;
-    response << "{"
-             << "\"tools\":[";
-    
-    {
-        std::lock_guard<std::mutex> lock(tools_mutex_);
-        bool first = true;
-        for (const auto& tool_pair : tools_) {
-            const auto& tool = tool_pair.second;
-            if (!first) response << ",";
-            first = false;
-            
-            response << "{"
-                     << "\"name\":\"" << tool.name << "\","
-                     << "\"description\":\"" << tool.description << "\","
-                     << "\"inputSchema\":{"
-                     << "\"type\":\"object\","
-                     << "\"properties\":{";
-            
-            bool param_first = true;
-            for (const auto& param : tool.parameters) {
-                if (!param_first) response << ",";
-                param_first = false;
-                
-                response << "\"" << param.name << "\":{"
-                         << "\"type\":\"" << param.type << "\","
-                         << "\"description\":\"" << param.description << "\""
-                         << "}";
-            }
-            
-            response << "},"
-                     << "\"required\":[";
-            
-            bool req_first = true;
-            for (const auto& param : tool.parameters) {
-                if (param.required) {
-                    if (!req_first) response << ",";
-                    req_first = false;
-                    response << "\"" << param.name << "\"";
-                }
-            }
-            
-            response << "]"
-                     << "}"
-                     << "}";
-        }
-    }
-    
-    response << "],"
-             << "\"totalTools\":" << tools_.size()
-             << "}";
-    
-    return response.str();
+    auto cache = registry_.listCache();
+    std::string response = "{\"tools\":";
+    response += cache->all_tools;
+    response += ",\"totalTools\":" + std::to_string(cache->tool_count) + "}";
+    return response;
 }
 
 std::string McpServer::handleCallTool(const std::string& params) {
@@ -202,37 +358,30 @@ std::string McpServer::handleCallTool(const std::string& params) {
     json_object* args_obj = nullptr;
     
     if (!json_object_object_get_ex(jobj, "name", &name_obj) ||
-        !json_object_object_get_ex(jobj, "arguments", &args_obj)) {
+        !json_object_object_get_ex(jobj, "arguments", &args_obj) ||
+        !json_object_is_type(name_obj, json_type_string)) {
         json_object_put(jobj);
         return "{\"error\":\"Missing name or arguments\"}";
     }
     
     std::string tool_name = json_object_get_string(name_obj);
     
-    // 将参数对象转换为map
-    std::map<std::string, std::string> args_map;
-    json_object_object_foreach(args_obj, key, val) {
-        args_map[key] = json_object_get_string(val);
-    }
-    
-    // 查找并执行工具
-    {
-        std::lock_guard<std::mutex> lock(tools_mutex_);
-        auto it = tools_.find(tool_name);
-        if (it != tools_.end()) {
-            std::string result = it->second.handler(args_map);
-            std::ostringstream response;
-            response << "{"
-                     << "\"result\":" << result << ","
-                     << "\"isError\":false"
-                     << "}";
-            json_object_put(jobj);
-            return response.str();
-        }
+    // 保持旧版响应格式：找不到工具时不经过注册表的错误结果
+    if (!registry_.hasTool(tool_name)) {
+        json_object_put(jobj);
+        return "{\"error\":\"Tool not found\"}";
     }
     
+    // 处理函数直接读取解析后的参数对象，调用结束后才释放
+    std::string result = registry_.callTool(tool_name, ToolValue(args_obj));
     json_object_put(jobj);
-    return "{\"error\":\"Tool not found\"}";
+    
+    std::ostringstream response;
+    response << "{"
+             << "\"result\":" << result << ","
+             << "\"isError\":false"
+             << "}";
+    return response.str();
 }
 
 } // namespace xiaozhi
\ No newline at end of file
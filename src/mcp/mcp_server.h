@@ -4,57 +4,103 @@
 #include <map>
 #include <functional>
 #include <vector>
-#include <thread>
-#include <mutex>
 #include <atomic>
+#include <memory>
 #include "xiaozhi_types.h"
+#include "tool_registry.h"
+#include "json_rpc_handler.h"
+#include "tool_executor.h"
+#include "mcp_transport.h"
+#include "utils/system_monitor.h"
 
 namespace xiaozhi {
 
-struct ToolParameter {
-    std::string name;
-    std::string type;  // "string", "number", "boolean"
-    std::string description;
-    bool required = false;
-};
-
-struct ToolDefinition {
-    std::string name;
-    std::string description;
-    std::vector<ToolParameter> parameters;
-    std::function<std::string(const std::map<std::string, std::string>&)> handler;
-};
+class EventLoop;
 
 class McpServer {
 public:
     McpServer(int port = 8080);
     ~McpServer();
 
+    // 传输配置（监听地址、HTTP/stdio开关），需在start之前设置
+    void setTransportOptions(const McpTransportOptions& options);
+    // 传输所在的事件循环，需在start之前设置；未设置时从EventLoopPool分配
+    void setEventLoop(EventLoop* loop);
+    // stdio传输的标准输入关闭（客户端退出）时回调
+    void setStdioClosedCallback(std::function<void()> callback);
+    // 工具执行线程池配置，需在start之前设置
+    void setExecutorOptions(const ToolExecutorOptions& options);
+
     bool start();
     void stop();
     bool isRunning() const;
 
-    // 注册工具
-    void addTool(const std::string& name, 
+    // 注册工具，运行时调用也是安全的；参数定义无效时返回false
+    bool addTool(const std::string& name, 
                  const std::string& description,
                  const std::vector<ToolParameter>& parameters,
-                 std::function<std::string(const std::map<std::string, std::string>&)> handler);
+                 std::function<std::string(const std::map<std::string, std::string>&)> handler,
+                 const ToolOptions& options = ToolOptions());
+
+    // 注册读取带类型参数视图的工具
+    bool addTool(const std::string& name, 
+                 const std::string& description,
+                 const std::vector<ToolParameter>& parameters,
+                 TypedToolHandler handler,
+                 const ToolOptions& options = ToolOptions());
+
+    // 注册通过ToolStream逐块输出结果、报告进度的工具
+    bool addTool(const std::string& name, 
+                 const std::string& description,
+                 const std::vector<ToolParameter>& parameters,
+                 StreamingToolHandler handler,
+                 const ToolOptions& options = ToolOptions());
+
+    // 从directory中的插件清单注册工具，共享库在工具首次调用时才加载；返回注册的工具数
+    size_t loadPlugins(const std::string& directory);
+
+    ToolRegistry& getToolRegistry() { return registry_; }
 
     // 处理MCP请求
     std::string handleRequest(const std::string& request);
 
-    void process();
+    // 处理JSON-RPC 2.0消息，HTTP和stdio传输收到的消息都经过这里；
+    // 服务器运行时tools/call在执行线程池中完成，respond可能在其他线程回调。
+    // notify非空时工具的进度和分块结果经它推送给客户端
+    void handleJsonRpc(const std::string& message, uint64_t origin, McpResponder respond,
+                       McpNotifier notify = nullptr);
+
+    // 同步处理JSON-RPC消息，工具在调用线程上执行
+    std::string handleJsonRpc(const std::string& message);
+
+    // 实际监听的HTTP端口（配置为0时由系统分配）
+    int getHttpPort() const;
 
 private:
     int port_;
     std::atomic<bool> running_{false};
 
-    std::map<std::string, ToolDefinition> tools_;
-    std::thread server_thread_;
-    std::mutex tools_mutex_;
+    // 旧版请求和JSON-RPC共用的唯一工具注册表
+    ToolRegistry registry_;
+    JsonRpcHandler rpc_handler_;
+
+    McpTransportOptions transport_options_;
+    ToolExecutorOptions executor_options_;
+    std::unique_ptr<ToolExecutor> executor_;
+    EventLoop* loop_;
+    std::unique_ptr<McpHttpTransport> http_transport_;
+    std::unique_ptr<McpStdioTransport> stdio_transport_;
+    std::function<void()> stdio_closed_callback_;
+
+    // 内置工具读取的整机状态，运行期间由loop_上的定时器周期采样
+    SystemMonitor system_monitor_;
+    int sample_timer_;
+
+    void stopExecutor();
+    void registerBuiltinTools();
+    std::string systemInfo();
+    std::string deviceStatus();
 
-    void serverLoop();
-    
     // 内部处理方法
     std::string handleInitialize(const std::string& params);
     std::string handleListTools();
@@ -0,0 +1,1029 @@
+#include "mcp_transport.h"
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include "utils/event_loop.h"
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/logger.h"
+
+namespace xiaozhi {
+
+namespace {
+
+constexpr size_t kMaxHeaderBytes = 8192;
+constexpr size_t kMaxBodyBytes = 1024 * 1024;
+constexpr size_t kMaxLineBytes = 1024 * 1024;
+// 待发送数据超过该值时暂停解析流水线请求，SSE流超过上限视为客户端卡死
+constexpr size_t kOutputHighWater = 1024 * 1024;
+constexpr size_t kSseOutputLimit = 4 * 1024 * 1024;
+// stdio输出积压超过该值时丢弃新消息：客户端已不再读取标准输出
+constexpr size_t kStdioOutputLimit = 4 * 1024 * 1024;
+// 单个连接上已接收但尚未应答的流水线请求上限，达到后暂停解析
+constexpr size_t kMaxPendingResponses = 64;
+constexpr uint32_t kReadEvents = EPOLLIN | EPOLLRDHUP;
+constexpr uint32_t kWriteEvents = EPOLLOUT;
+constexpr std::chrono::milliseconds kSseKeepAliveInterval(15000);
+// 请求/空闲超时的检查周期，超时判定的精度也由它决定
+constexpr std::chrono::milliseconds kTimeoutCheckInterval(1000);
+
+// reserveStdout()保存的原标准输出，由首个启动的stdio传输接管
+int g_reserved_stdout = -1;
+
+struct TransportMetrics {
+    Counter& requests = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_http_requests_total", "MCP HTTP传输处理的请求数");
+    Counter& bad_requests = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_http_bad_requests_total", "格式错误或超限被拒绝的MCP HTTP请求数");
+    Histogram& request_time = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_mcp_http_request_seconds", "MCP HTTP请求从解析完成到响应就绪的耗时");
+    Counter& timeouts = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_http_timeouts_total", "请求未在期限内收全或空闲超时被关闭的MCP HTTP连接数");
+    Gauge& connections = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_http_connections", "当前MCP HTTP连接数");
+    Gauge& sse_sessions = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_sse_sessions", "当前MCP SSE会话数");
+    Counter& stdio_messages = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_stdio_messages_total", "MCP stdio传输处理的消息数");
+};
+
+TransportMetrics& transportMetrics() {
+    static TransportMetrics metrics;
+    return metrics;
+}
+
+const char* statusReason(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 202: return "Accepted";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default: return "Error";
+    }
+}
+
+bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+bool equalsIgnoreCase(const std::string& a, const char* b) {
+    size_t length = strlen(b);
+    if (a.size() != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string trim(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return "";
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+// 从"/message?session=12&x=y"中取出查询参数
+std::string queryParam(const std::string& target, const std::string& name) {
+    size_t query = target.find('?');
+    while (query != std::string::npos) {
+        size_t begin = query + 1;
+        size_t end = target.find('&', begin);
+        std::string pair = target.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+        size_t eq = pair.find('=');
+        if (eq != std::string::npos && pair.compare(0, eq, name) == 0) {
+            return pair.substr(eq + 1);
+        }
+        query = end;
+    }
+    return "";
+}
+
+} // namespace
+
+McpHttpTransport::McpHttpTransport(McpRequestHandler handler)
+    : handler_(std::move(handler)), loop_(nullptr), listen_fd_(-1), port_(0),
+      keepalive_timer_(-1), timeout_timer_(-1), next_session_(1), next_connection_id_(1) {
+}
+
+McpHttpTransport::~McpHttpTransport() {
+    stop();
+}
+
+bool McpHttpTransport::start(EventLoop* loop, const McpTransportOptions& options) {
+    if (running_) {
+        return true;
+    }
+    loop_ = loop;
+    options_ = options;
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "[McpHttpTransport] 错误: 无法创建socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int reuse = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(options.port));
+    if (inet_pton(AF_INET, options.bind_address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "[McpHttpTransport] 错误: 无效的监听地址: " << options.bind_address << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 128) != 0) {
+        std::cerr << "[McpHttpTransport] 错误: 无法监听 " << options.bind_address << ":"
+                  << options.port << ": " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    socklen_t addr_len = sizeof(addr);
+    getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &addr_len);
+    port_ = ntohs(addr.sin_port);
+
+    alive_ = std::make_shared<bool>(true);
+    if (!loop_->addFd(listen_fd_, EPOLLIN, [this](uint32_t) { onAccept(); })) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+        alive_.reset();
+        return false;
+    }
+
+    running_ = true;
+    std::cout << "[McpHttpTransport] 已监听 " << options.bind_address << ":" << port_
+              << " (POST /mcp, GET /sse)" << std::endl;
+    return true;
+}
+
+void McpHttpTransport::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    // 连接表只在循环线程中访问，在那里关闭全部连接并等待完成
+    loop_->runSync([this]() {
+        loop_->removeFd(listen_fd_);
+        close(listen_fd_);
+        listen_fd_ = -1;
+        closeAll();
+        alive_.reset();
+    });
+    std::cout << "[McpHttpTransport] 已停止" << std::endl;
+}
+
+void McpHttpTransport::broadcast(const std::string& message) {
+    if (!running_) {
+        return;
+    }
+    loop_->post([this, message]() {
+        for (const auto& session : sessions_) {
+            auto it = connections_.find(session.second);
+            if (it != connections_.end()) {
+                queueSseEvent(*it->second, "message", message);
+                flushOutput(*it->second);
+            }
+        }
+    });
+}
+
+void McpHttpTransport::onAccept() {
+    while (true) {
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                LOG_EVERY_MS(ERROR, 1000, "[McpHttpTransport] 错误: accept失败: {}", strerror(errno));
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        if (static_cast<int>(connections_.size()) >= options_.max_connections) {
+            static const char kBusy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+            ssize_t written = send(fd, kBusy, sizeof(kBusy) - 1, MSG_NOSIGNAL);
+            (void)written;
+            close(fd);
+            LOG_EVERY_MS(WARN, 1000, "[McpHttpTransport] 连接数已达上限 {}，拒绝新连接", options_.max_connections);
+            continue;
+        }
+
+        // 响应都是小包，关闭Nagle避免流水线应答被延迟确认拖慢
+        int nodelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+        auto conn = std::make_unique<Connection>();
+        conn->fd = fd;
+        conn->id = next_connection_id_++;
+        conn->last_activity = std::chrono::steady_clock::now();
+        if (!loop_->addFd(fd, EPOLLIN | EPOLLRDHUP, [this, fd](uint32_t events) { onConnectionEvent(fd, events); })) {
+            close(fd);
+            continue;
+        }
+        connections_[fd] = std::move(conn);
+        transportMetrics().connections.add(1);
+        updateTimeoutTimer();
+    }
+}
+
+void McpHttpTransport::onConnectionEvent(int fd, uint32_t events) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& conn = *it->second;
+
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        closeConnection(fd);
+        return;
+    }
+    if (events & EPOLLOUT) {
+        flushOutput(conn);
+        if (connections_.find(fd) == connections_.end()) {
+            return;
+        }
+    }
+    if (events & (EPOLLIN | EPOLLRDHUP)) {
+        if (!readInput(conn) && !conn.read_closed) {
+            // 对端半关闭时仍先处理已收到的请求并尽量发出响应；
+            // 不再关注可读事件，否则等待异步响应期间RDHUP会反复触发
+            conn.close_after_write = true;
+            conn.read_closed = true;
+            loop_->modifyFd(fd, conn.want_write ? kWriteEvents : 0);
+        }
+        processInput(conn);
+        if (connections_.find(fd) == connections_.end()) {
+            return;
+        }
+        flushOutput(conn);
+    }
+}
+
+bool McpHttpTransport::readInput(Connection& conn) {
+    char buffer[16384];
+    while (true) {
+        ssize_t bytes = recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (bytes > 0) {
+            conn.last_activity = std::chrono::steady_clock::now();
+            // SSE连接上客户端不应再发送数据，丢弃即可
+            if (conn.session == 0) {
+                if (conn.input.empty()) {
+                    conn.request_start = conn.last_activity;
+                }
+                conn.input.append(buffer, static_cast<size_t>(bytes));
+            }
+            continue;
+        }
+        if (bytes == 0) {
+            return false;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+void McpHttpTransport::processInput(Connection& conn) {
+    // 流水线：按顺序处理缓冲中所有完整的请求，响应依次追加到输出缓冲
+    while (conn.session == 0 && !conn.input.empty() &&
+           conn.output.size() - conn.output_offset < kOutputHighWater &&
+           conn.pending.size() < kMaxPendingResponses) {
+        size_t header_end = conn.input.find("\r\n\r\n");
+        if (header_end == std::string::npos) {
+            if (conn.input.size() > kMaxHeaderBytes) {
+                transportMetrics().bad_requests.inc();
+                queueResponse(conn, 431, "", false);
+                conn.input.clear();
+            }
+            return;
+        }
+        if (header_end > kMaxHeaderBytes) {
+            transportMetrics().bad_requests.inc();
+            queueResponse(conn, 431, "", false);
+            conn.input.clear();
+            return;
+        }
+
+        // 请求行: METHOD SP target SP HTTP/1.x
+        size_t line_end = conn.input.find("\r\n");
+        std::string request_line = conn.input.substr(0, line_end);
+        size_t first_space = request_line.find(' ');
+        size_t second_space = first_space == std::string::npos ? std::string::npos
+                                                                : request_line.find(' ', first_space + 1);
+        if (second_space == std::string::npos) {
+            transportMetrics().bad_requests.inc();
+            queueResponse(conn, 400, "", false);
+            conn.input.clear();
+            return;
+        }
+        std::string method = request_line.substr(0, first_space);
+        std::string target = request_line.substr(first_space + 1, second_space - first_space - 1);
+        std::string version = request_line.substr(second_space + 1);
+
+        bool keep_alive = version == "HTTP/1.1";
+        size_t content_length = 0;
+        bool chunked = false;
+        size_t pos = line_end + 2;
+        while (pos < header_end) {
+            size_t end = conn.input.find("\r\n", pos);
+            std::string line = conn.input.substr(pos, end - pos);
+            pos = end + 2;
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(0, colon);
+            std::string value = trim(line.substr(colon + 1));
+            if (equalsIgnoreCase(name, "Content-Length")) {
+                content_length = static_cast<size_t>(std::strtoull(value.c_str(), nullptr, 10));
+            } else if (equalsIgnoreCase(name, "Connection")) {
+                if (equalsIgnoreCase(value, "close")) {
+                    keep_alive = false;
+                } else if (equalsIgnoreCase(value, "keep-alive")) {
+                    keep_alive = true;
+                }
+            } else if (equalsIgnoreCase(name, "Transfer-Encoding")) {
+                chunked = !equalsIgnoreCase(value, "identity");
+            }
+        }
+
+        if (chunked) {
+            transportMetrics().bad_requests.inc();
+            queueResponse(conn, 501, "", false);
+            conn.input.clear();
+            return;
+        }
+        if (content_length > kMaxBodyBytes) {
+            transportMetrics().bad_requests.inc();
+            queueResponse(conn, 413, "", false);
+            conn.input.clear();
+            return;
+        }
+
+        size_t body_start = header_end + 4;
+        if (conn.input.size() < body_start + content_length) {
+            return;     // 请求体尚未收全
+        }
+        std::string body = conn.input.substr(body_start, content_length);
+        conn.input.erase(0, body_start + content_length);
+        // 缓冲中剩下的是下一个流水线请求，从现在起计时
+        conn.request_start = std::chrono::steady_clock::now();
+
+        handleRequest(conn, method, target, body, keep_alive);
+        if (!keep_alive) {
+            conn.input.clear();
+            return;
+        }
+    }
+}
+
+void McpHttpTransport::handleRequest(Connection& conn, const std::string& method, const std::string& target,
+                                     const std::string& body, bool keep_alive) {
+    TRACE_SCOPE("mcp", "mcp.http_request");
+    transportMetrics().requests.inc();
+
+    std::string path = target.substr(0, target.find('?'));
+    if (path == "/mcp") {
+        if (method != "POST") {
+            queueResponse(conn, 405, "", keep_alive);
+            return;
+        }
+        uint64_t seq = reserveResponse(conn, keep_alive);
+        handler_(body, kMcpOriginHttp, makeResponder(conn, seq), nullptr);
+    } else if (path == "/sse") {
+        if (method != "GET") {
+            queueResponse(conn, 405, "", keep_alive);
+            return;
+        }
+        openSseSession(conn);
+    } else if (path == "/message") {
+        if (method != "POST") {
+            queueResponse(conn, 405, "", keep_alive);
+            return;
+        }
+        uint64_t session = std::strtoull(queryParam(target, "session").c_str(), nullptr, 10);
+        auto session_it = sessions_.find(session);
+        if (session_it == sessions_.end()) {
+            queueResponse(conn, 404, "", keep_alive);
+            return;
+        }
+        queueResponse(conn, 202, "", keep_alive);
+        // 响应和通知都作为SSE事件按投递顺序推送
+        handler_(body, session, makeSseResponder(session), makeSseResponder(session));
+    } else {
+        queueResponse(conn, 404, "", keep_alive);
+    }
+}
+
+void McpHttpTransport::queueResponse(Connection& conn, int status, const std::string& body, bool keep_alive) {
+    // 错误响应也要排在前面尚未完成的流水线请求之后
+    completeResponse(conn, reserveResponse(conn, keep_alive), status, body);
+}
+
+uint64_t McpHttpTransport::reserveResponse(Connection& conn, bool keep_alive) {
+    PendingResponse pending;
+    pending.keep_alive = keep_alive;
+    pending.start = std::chrono::steady_clock::now();
+    conn.pending.push_back(std::move(pending));
+    return conn.pending_base + conn.pending.size() - 1;
+}
+
+void McpHttpTransport::completeResponse(Connection& conn, uint64_t seq, int status, const std::string& body) {
+    if (seq < conn.pending_base || seq - conn.pending_base >= conn.pending.size()) {
+        return;
+    }
+    PendingResponse& pending = conn.pending[seq - conn.pending_base];
+    pending.ready = true;
+    pending.status = status;
+    pending.body = body;
+
+    // 只发出队首连续已完成的响应，保持与请求相同的顺序
+    while (!conn.pending.empty() && conn.pending.front().ready) {
+        const PendingResponse& front = conn.pending.front();
+        transportMetrics().request_time.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - front.start).count()));
+        writeResponse(conn, front);
+        conn.pending.pop_front();
+        ++conn.pending_base;
+    }
+}
+
+void McpHttpTransport::writeResponse(Connection& conn, const PendingResponse& response) {
+    std::string& out = conn.output;
+    out += "HTTP/1.1 ";
+    out += std::to_string(response.status);
+    out += ' ';
+    out += statusReason(response.status);
+    out += "\r\nContent-Type: application/json\r\nContent-Length: ";
+    out += std::to_string(response.body.size());
+    out += response.keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+    out += response.body;
+    if (!response.keep_alive) {
+        conn.close_after_write = true;
+    }
+}
+
+McpResponder McpHttpTransport::makeResponder(Connection& conn, uint64_t seq) {
+    EventLoop* loop = loop_;
+    std::weak_ptr<bool> alive = alive_;
+    int fd = conn.fd;
+    uint64_t conn_id = conn.id;
+    return [this, loop, alive, fd, conn_id, seq](const std::string& response) {
+        if (loop->isInLoopThread()) {
+            // 处理函数内同步应答：此时仍在processInput中，由调用方统一发送
+            deliverResponse(fd, conn_id, seq, response, false);
+            return;
+        }
+        loop->post([this, alive, fd, conn_id, seq, response]() {
+            if (!alive.expired()) {
+                deliverResponse(fd, conn_id, seq, response, true);
+            }
+        });
+    };
+}
+
+void McpHttpTransport::deliverResponse(int fd, uint64_t conn_id, uint64_t seq, const std::string& response,
+                                       bool flush) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end() || it->second->id != conn_id) {
+        return;     // 连接已关闭，丢弃迟到的响应
+    }
+    Connection& conn = *it->second;
+    completeResponse(conn, seq, response.empty() ? 202 : 200, response);
+    if (flush) {
+        flushOutput(conn);
+    }
+}
+
+McpResponder McpHttpTransport::makeSseResponder(uint64_t session) {
+    EventLoop* loop = loop_;
+    std::weak_ptr<bool> alive = alive_;
+    return [this, loop, alive, session](const std::string& response) {
+        if (response.empty()) {
+            return;
+        }
+        if (loop->isInLoopThread()) {
+            deliverSseMessage(session, response);
+            return;
+        }
+        loop->post([this, alive, session, response]() {
+            if (!alive.expired()) {
+                deliverSseMessage(session, response);
+            }
+        });
+    };
+}
+
+void McpHttpTransport::deliverSseMessage(uint64_t session, const std::string& response) {
+    auto session_it = sessions_.find(session);
+    if (session_it == sessions_.end()) {
+        return;
+    }
+    auto it = connections_.find(session_it->second);
+    if (it != connections_.end()) {
+        queueSseEvent(*it->second, "message", response);
+        flushOutput(*it->second);
+    }
+}
+
+void McpHttpTransport::openSseSession(Connection& conn) {
+    conn.session = next_session_++;
+    conn.input.clear();
+    sessions_[conn.session] = conn.fd;
+    transportMetrics().sse_sessions.add(1);
+
+    conn.output += "HTTP/1.1 200 OK\r\n"
+                   "Content-Type: text/event-stream\r\n"
+                   "Cache-Control: no-cache\r\n"
+                   "Connection: keep-alive\r\n\r\n";
+    queueSseEvent(conn, "endpoint", "/message?session=" + std::to_string(conn.session));
+    updateKeepAliveTimer();
+}
+
+void McpHttpTransport::queueSseEvent(Connection& conn, const char* event, const std::string& data) {
+    if (conn.output.size() - conn.output_offset > kSseOutputLimit) {
+        LOG_EVERY_MS(WARN, 1000, "[McpHttpTransport] SSE会话 {} 积压过多，断开连接", conn.session);
+        conn.close_after_write = true;
+        return;
+    }
+    conn.output += "event: ";
+    conn.output += event;
+    conn.output += '\n';
+    // 数据中的每一行都要以"data: "开头
+    size_t begin = 0;
+    while (true) {
+        size_t end = data.find('\n', begin);
+        conn.output += "data: ";
+        conn.output.append(data, begin, end == std::string::npos ? std::string::npos : end - begin);
+        conn.output += '\n';
+        if (end == std::string::npos) {
+            break;
+        }
+        begin = end + 1;
+    }
+    conn.output += '\n';
+}
+
+void McpHttpTransport::flushOutput(Connection& conn) {
+    int fd = conn.fd;
+    while (conn.output_offset < conn.output.size()) {
+        ssize_t written = send(fd, conn.output.data() + conn.output_offset,
+                               conn.output.size() - conn.output_offset, MSG_NOSIGNAL);
+        if (written > 0) {
+            conn.output_offset += static_cast<size_t>(written);
+            conn.last_activity = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!conn.want_write) {
+                conn.want_write = true;
+                loop_->modifyFd(fd, (conn.read_closed ? 0 : kReadEvents) | kWriteEvents);
+            }
+            return;
+        }
+        closeConnection(fd);
+        return;
+    }
+
+    conn.output.clear();
+    conn.output_offset = 0;
+    if (conn.want_write) {
+        conn.want_write = false;
+        loop_->modifyFd(fd, conn.read_closed ? 0 : kReadEvents);
+    }
+    // 还有请求未应答时保持连接，最后一个响应发出后再关闭
+    if (conn.close_after_write && conn.pending.empty()) {
+        closeConnection(fd);
+        return;
+    }
+    // 输出积压时暂停过的流水线请求在这里继续处理
+    if (!conn.input.empty()) {
+        processInput(conn);
+        if (connections_.find(fd) != connections_.end() && !conn.output.empty()) {
+            flushOutput(conn);
+        }
+    }
+}
+
+void McpHttpTransport::closeConnection(int fd) {
+    auto it = connections_.find(fd);
+    if (it == connections_.end()) {
+        return;
+    }
+    if (it->second->session != 0) {
+        sessions_.erase(it->second->session);
+        transportMetrics().sse_sessions.add(-1);
+    }
+    loop_->removeFd(fd);
+    close(fd);
+    connections_.erase(it);
+    transportMetrics().connections.add(-1);
+    updateKeepAliveTimer();
+    updateTimeoutTimer();
+}
+
+void McpHttpTransport::closeAll() {
+    while (!connections_.empty()) {
+        closeConnection(connections_.begin()->first);
+    }
+    if (keepalive_timer_ >= 0) {
+        loop_->cancelTimer(keepalive_timer_);
+        keepalive_timer_ = -1;
+    }
+    if (timeout_timer_ >= 0) {
+        loop_->cancelTimer(timeout_timer_);
+        timeout_timer_ = -1;
+    }
+}
+
+void McpHttpTransport::updateKeepAliveTimer() {
+    // 只在有SSE会话时定时发送注释行，防止中间代理因空闲断开；没有会话时不产生唤醒
+    if (!sessions_.empty() && keepalive_timer_ < 0) {
+        keepalive_timer_ = loop_->addTimer(kSseKeepAliveInterval, kSseKeepAliveInterval, [this]() {
+            for (const auto& session : sessions_) {
+                auto it = connections_.find(session.second);
+                if (it != connections_.end()) {
+                    it->second->output += ": ping\n\n";
+                }
+            }
+            // flushOutput可能关闭连接并修改sessions_，先复制fd列表
+            std::vector<int> fds;
+            for (const auto& session : sessions_) {
+                fds.push_back(session.second);
+            }
+            for (int fd : fds) {
+                auto it = connections_.find(fd);
+                if (it != connections_.end()) {
+                    flushOutput(*it->second);
+                }
+            }
+        });
+    } else if (sessions_.empty() && keepalive_timer_ >= 0) {
+        loop_->cancelTimer(keepalive_timer_);
+        keepalive_timer_ = -1;
+    }
+}
+
+void McpHttpTransport::updateTimeoutTimer() {
+    // 只在有连接时周期检查，空闲的守护进程不产生唤醒
+    bool enabled = options_.request_timeout_ms > 0 || options_.idle_timeout_ms > 0;
+    if (enabled && !connections_.empty() && timeout_timer_ < 0) {
+        timeout_timer_ = loop_->addTimer(kTimeoutCheckInterval, kTimeoutCheckInterval, [this]() { checkTimeouts(); });
+    } else if (connections_.empty() && timeout_timer_ >= 0) {
+        loop_->cancelTimer(timeout_timer_);
+        timeout_timer_ = -1;
+    }
+}
+
+void McpHttpTransport::checkTimeouts() {
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::milliseconds request_timeout(options_.request_timeout_ms);
+    std::chrono::milliseconds idle_timeout(options_.idle_timeout_ms);
+
+    // 关闭连接会修改connections_，先收集超时的fd
+    std::vector<int> request_expired;
+    std::vector<int> idle_expired;
+    for (const auto& entry : connections_) {
+        const Connection& conn = *entry.second;
+        // SSE连接由保活注释和输出上限处理；有请求未应答时等待工具自身的期限
+        if (conn.session != 0 || !conn.pending.empty()) {
+            continue;
+        }
+        // 输出积压时是本端暂停了解析，不算客户端慢
+        bool waiting_for_client = !conn.input.empty() && !conn.read_closed &&
+                                  conn.output.size() - conn.output_offset < kOutputHighWater;
+        if (options_.request_timeout_ms > 0 && waiting_for_client &&
+            now - conn.request_start >= request_timeout) {
+            request_expired.push_back(entry.first);
+        } else if (options_.idle_timeout_ms > 0 && now - conn.last_activity >= idle_timeout) {
+            idle_expired.push_back(entry.first);
+        }
+    }
+
+    for (int fd : request_expired) {
+        auto it = connections_.find(fd);
+        if (it == connections_.end()) {
+            continue;
+        }
+        transportMetrics().timeouts.inc();
+        LOG_EVERY_MS(WARN, 1000, "[McpHttpTransport] 连接 {} 的请求未在 {}ms 内收全，关闭连接",
+                     fd, options_.request_timeout_ms);
+        // 尽力告知客户端，发不完也不再等待
+        Connection& conn = *it->second;
+        conn.input.clear();
+        queueResponse(conn, 408, "", false);
+        flushOutput(conn);
+        closeConnection(fd);
+    }
+    for (int fd : idle_expired) {
+        if (connections_.find(fd) != connections_.end()) {
+            transportMetrics().timeouts.inc();
+            closeConnection(fd);
+        }
+    }
+}
+
+McpStdioTransport::McpStdioTransport(McpRequestHandler handler)
+    : handler_(std::move(handler)), loop_(nullptr), in_fd_(-1), out_fd_(-1), saved_stdout_(-1),
+      saved_in_flags_(-1), saved_out_flags_(-1), in_registered_(false), out_registered_(false),
+      output_offset_(0), input_paused_(false), input_eof_(false) {
+}
+
+McpStdioTransport::~McpStdioTransport() {
+    stop();
+}
+
+bool McpStdioTransport::reserveStdout() {
+    if (g_reserved_stdout >= 0) {
+        return true;
+    }
+    std::cout.flush();
+    int fd = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, 3);
+    if (fd < 0) {
+        return false;
+    }
+    if (dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+        close(fd);
+        return false;
+    }
+    g_reserved_stdout = fd;
+    return true;
+}
+
+void McpStdioTransport::setClosedCallback(std::function<void()> callback) {
+    closed_callback_ = callback;
+}
+
+bool McpStdioTransport::start(EventLoop* loop) {
+    if (running_) {
+        return true;
+    }
+    loop_ = loop;
+
+    // 协议独占原标准输出：复制一份供协议写入，再把fd 1指向标准错误，
+    // 之后std::cout和日志的控制台输出都进入stderr
+    if (g_reserved_stdout < 0 && !reserveStdout()) {
+        std::cerr << "[McpStdioTransport] 错误: 无法接管标准输出: " << strerror(errno) << std::endl;
+        return false;
+    }
+    out_fd_ = g_reserved_stdout;
+    g_reserved_stdout = -1;
+    saved_stdout_ = fcntl(out_fd_, F_DUPFD_CLOEXEC, 3);
+    if (saved_stdout_ < 0) {
+        std::cerr << "[McpStdioTransport] 错误: 无法接管标准输出: " << strerror(errno) << std::endl;
+        stop();
+        return false;
+    }
+    in_fd_ = STDIN_FILENO;
+    // 标准输入输出常与终端共用同一个打开文件描述，O_NONBLOCK会影响同一终端上的其他进程，
+    // 先保存原标志，两者是同一描述时保存的也都是修改前的值
+    saved_in_flags_ = fcntl(in_fd_, F_GETFL, 0);
+    saved_out_flags_ = fcntl(out_fd_, F_GETFL, 0);
+    setNonBlocking(in_fd_);
+    setNonBlocking(out_fd_);
+    input_paused_ = false;
+    input_eof_ = false;
+
+    // 标准输入可能已有数据，注册后循环线程会立即处理，回调用到的状态要先建好
+    alive_ = std::make_shared<bool>(true);
+    in_registered_ = true;
+    if (!loop_->addFd(in_fd_, EPOLLIN, [this](uint32_t events) { onEvent(events); })) {
+        std::cerr << "[McpStdioTransport] 错误: 标准输入不支持epoll（需为管道、终端或socket）" << std::endl;
+        in_registered_ = false;
+        stop();
+        return false;
+    }
+    running_ = true;
+    std::cerr << "[McpStdioTransport] 已在标准输入/输出上提供MCP服务" << std::endl;
+    return true;
+}
+
+void McpStdioTransport::stop() {
+    bool was_running = running_.exchange(false);
+    auto cleanup = [this]() {
+        if (in_registered_) {
+            loop_->removeFd(in_fd_);
+            in_registered_ = false;
+        }
+        if (out_registered_) {
+            loop_->removeFd(out_fd_);
+            out_registered_ = false;
+        }
+        alive_.reset();
+    };
+    if (loop_) {
+        loop_->runSync(cleanup);
+    }
+
+    if (in_fd_ >= 0 && saved_in_flags_ >= 0) {
+        fcntl(in_fd_, F_SETFL, saved_in_flags_);
+    }
+    if (out_fd_ >= 0 && saved_out_flags_ >= 0) {
+        fcntl(out_fd_, F_SETFL, saved_out_flags_);
+    }
+    saved_in_flags_ = -1;
+    saved_out_flags_ = -1;
+
+    if (saved_stdout_ >= 0) {
+        std::cout.flush();
+        dup2(saved_stdout_, STDOUT_FILENO);
+        close(saved_stdout_);
+        saved_stdout_ = -1;
+    }
+    if (out_fd_ >= 0) {
+        close(out_fd_);
+        out_fd_ = -1;
+    }
+    in_fd_ = -1;
+    if (was_running) {
+        std::cerr << "[McpStdioTransport] 已停止" << std::endl;
+    }
+}
+
+void McpStdioTransport::send(const std::string& message) {
+    if (!running_) {
+        return;
+    }
+    loop_->post([this, message]() {
+        writeLine(message);
+    });
+}
+
+void McpStdioTransport::onEvent(uint32_t events) {
+    char buffer[16384];
+    bool eof = false;
+    while (true) {
+        ssize_t bytes = read(in_fd_, buffer, sizeof(buffer));
+        if (bytes > 0) {
+            input_.append(buffer, static_cast<size_t>(bytes));
+            continue;
+        }
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        eof = bytes == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+    (void)events;
+
+    input_eof_ = input_eof_ || eof;
+    processInput();
+}
+
+void McpStdioTransport::processInput() {
+    size_t begin = 0;
+    // 与HTTP一侧相同：输出积压超过高水位时暂停处理，剩余的行等输出写完后继续
+    while (output_.size() - output_offset_ < kOutputHighWater) {
+        size_t end = input_.find('\n', begin);
+        if (end == std::string::npos) {
+            break;
+        }
+        std::string line = input_.substr(begin, end - begin);
+        begin = end + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty()) {
+            continue;
+        }
+        TRACE_SCOPE("mcp", "mcp.stdio_message");
+        transportMetrics().stdio_messages.inc();
+        handler_(line, kMcpOriginStdio, makeResponder(), makeResponder());
+    }
+    input_.erase(0, begin);
+    if (input_.size() > kMaxLineBytes && input_.find('\n') == std::string::npos) {
+        LOG_EVERY_MS(ERROR, 1000, "[McpStdioTransport] 错误: 单行消息超过 {} 字节，已丢弃", kMaxLineBytes);
+        input_.clear();
+    }
+
+    if (output_.size() - output_offset_ >= kOutputHighWater) {
+        // 停止读取标准输入，客户端写满管道后自然被阻塞
+        if (in_registered_) {
+            loop_->removeFd(in_fd_);
+            in_registered_ = false;
+        }
+        input_paused_ = true;
+    } else if (input_eof_) {
+        closeInput();
+    }
+}
+
+void McpStdioTransport::resumeInput() {
+    input_paused_ = false;
+    if (!input_eof_ && running_) {
+        in_registered_ = loop_->addFd(in_fd_, EPOLLIN, [this](uint32_t events) { onEvent(events); });
+    }
+    processInput();
+}
+
+McpResponder McpStdioTransport::makeResponder() {
+    EventLoop* loop = loop_;
+    std::weak_ptr<bool> alive = alive_;
+    return [this, loop, alive](const std::string& response) {
+        if (response.empty()) {
+            return;
+        }
+        if (loop->isInLoopThread()) {
+            writeLine(response);
+            return;
+        }
+        // JSON-RPC响应带有id，异步完成的调用不必按请求顺序输出
+        loop->post([this, alive, response]() {
+            if (!alive.expired()) {
+                writeLine(response);
+            }
+        });
+    };
+}
+
+void McpStdioTransport::writeLine(const std::string& message) {
+    if (out_fd_ < 0) {
+        return;
+    }
+    if (output_.size() - output_offset_ >= kStdioOutputLimit) {
+        LOG_EVERY_MS(ERROR, 1000, "[McpStdioTransport] 错误: 标准输出积压超过 {} 字节，丢弃消息", kStdioOutputLimit);
+        return;
+    }
+    output_ += message;
+    output_ += '\n';
+    flushOutput();
+}
+
+void McpStdioTransport::flushOutput() {
+    while (output_offset_ < output_.size()) {
+        ssize_t written = write(out_fd_, output_.data() + output_offset_, output_.size() - output_offset_);
+        if (written > 0) {
+            output_offset_ += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!out_registered_) {
+                out_registered_ = loop_->addFd(out_fd_, EPOLLOUT, [this](uint32_t) { flushOutput(); });
+            }
+            return;
+        }
+        // 读端已关闭，后续输出全部丢弃
+        LOG_EVERY_MS(ERROR, 1000, "[McpStdioTransport] 错误: 写标准输出失败: {}", strerror(errno));
+        break;
+    }
+    output_.clear();
+    output_offset_ = 0;
+    if (out_registered_) {
+        loop_->removeFd(out_fd_);
+        out_registered_ = false;
+    }
+    if (input_paused_) {
+        resumeInput();
+    }
+}
+
+void McpStdioTransport::closeInput() {
+    if (in_registered_) {
+        loop_->removeFd(in_fd_);
+        in_registered_ = false;
+    }
+    std::cerr << "[McpStdioTransport] 标准输入已关闭" << std::endl;
+    if (closed_callback_) {
+        closed_callback_();
+    }
+}
+
+} // namespace xiaozhi
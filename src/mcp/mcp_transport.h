@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <deque>
+#include <memory>
+#include <chrono>
+#include <functional>
+#include <atomic>
+#include <cstdint>
+
+namespace xiaozhi {
+
+class EventLoop;
+
+// 返回一条消息的响应，空串表示不需要响应（通知、已取消的请求）。
+// 可在任意线程调用，但每条消息只能调用一次
+using McpResponder = std::function<void(const std::string& response)>;
+
+// 向请求来源推送一条JSON-RPC通知，可在任意线程调用多次；
+// 在respond之前推送的通知保证先于响应到达
+using McpNotifier = std::function<void(const std::string& notification)>;
+
+// 处理一条JSON-RPC消息；origin标识请求来源，响应可以在处理函数返回后再交给respond。
+// 能够在响应之外推送消息的来源（SSE会话、stdio）提供notify，POST /mcp为空
+using McpRequestHandler =
+    std::function<void(const std::string& message, uint64_t origin, McpResponder respond, McpNotifier notify)>;
+
+// 请求来源：SSE会话使用会话ID（从1开始），POST /mcp的请求没有会话，共用一个来源
+constexpr uint64_t kMcpOriginHttp = 0;
+constexpr uint64_t kMcpOriginStdio = ~0ULL;
+
+struct McpTransportOptions {
+    std::string bind_address = "127.0.0.1";
+    int port = 8080;                // 0表示由系统分配，用于本地压测
+    bool http = true;
+    bool stdio = false;
+    int max_connections = 64;
+    int request_timeout_ms = 10000; // 一个请求从首字节到收全的期限，0表示不限
+    int idle_timeout_ms = 60000;    // 连接无收发且无待应答请求的最长时间，0表示不限
+};
+
+// HTTP/1.1传输，所有连接在同一个事件循环中以非阻塞方式处理：
+//   POST /mcp                    请求体为JSON-RPC消息，响应作为HTTP响应体返回
+//   GET  /sse                    SSE流，首个endpoint事件给出本会话的消息地址
+//   POST /message?session=<id>   请求体为JSON-RPC消息，返回202，响应经对应的SSE流推送
+// 连接默认保持（HTTP/1.0需Connection: keep-alive），同一连接上流水线发送的
+// 多个请求按到达顺序依次应答，先完成的响应等待前面的请求完成后再发出。
+// 请求头/体迟迟收不全的连接回复408后关闭，空闲超时的连接直接关闭，
+// 避免慢速客户端长期占住连接数上限
+class McpHttpTransport {
+public:
+    explicit McpHttpTransport(McpRequestHandler handler);
+    ~McpHttpTransport();
+
+    McpHttpTransport(const McpHttpTransport&) = delete;
+    McpHttpTransport& operator=(const McpHttpTransport&) = delete;
+
+    bool start(EventLoop* loop, const McpTransportOptions& options);
+    void stop();
+    bool isRunning() const { return running_; }
+
+    int getPort() const { return port_; }
+
+    // 向所有SSE会话推送一条JSON-RPC通知，可在任意线程调用
+    void broadcast(const std::string& message);
+
+private:
+    struct PendingResponse {
+        bool ready = false;
+        int status = 0;
+        std::string body;
+        bool keep_alive = true;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    struct Connection {
+        int fd = -1;
+        uint64_t id = 0;                // fd会被复用，异步响应据此确认连接未变
+        uint64_t session = 0;           // SSE会话ID，0表示普通请求连接
+        std::string input;
+        std::string output;
+        size_t output_offset = 0;
+        bool close_after_write = false;
+        bool want_write = false;
+        bool read_closed = false;       // 对端已半关闭，不再读取
+        std::chrono::steady_clock::time_point last_activity;    // 最近一次收到或发出数据
+        std::chrono::steady_clock::time_point request_start;    // 当前未收全的请求开始接收的时间
+        std::deque<PendingResponse> pending;    // 按请求顺序排列的未发出响应
+        uint64_t pending_base = 0;              // pending.front()的序号
+    };
+
+    void onAccept();
+    void onConnectionEvent(int fd, uint32_t events);
+    bool readInput(Connection& conn);   // 返回false表示对端关闭或出错
+    void processInput(Connection& conn);
+    void handleRequest(Connection& conn, const std::string& method, const std::string& target,
+                       const std::string& body, bool keep_alive);
+    void queueResponse(Connection& conn, int status, const std::string& body, bool keep_alive);
+    uint64_t reserveResponse(Connection& conn, bool keep_alive);
+    void completeResponse(Connection& conn, uint64_t seq, int status, const std::string& body);
+    void writeResponse(Connection& conn, const PendingResponse& response);
+    McpResponder makeResponder(Connection& conn, uint64_t seq);
+    McpResponder makeSseResponder(uint64_t session);
+    void deliverResponse(int fd, uint64_t conn_id, uint64_t seq, const std::string& response, bool flush);
+    void deliverSseMessage(uint64_t session, const std::string& response);
+    void openSseSession(Connection& conn);
+    void queueSseEvent(Connection& conn, const char* event, const std::string& data);
+    void flushOutput(Connection& conn);
+    void closeConnection(int fd);
+    void closeAll();
+    void updateKeepAliveTimer();
+    void updateTimeoutTimer();
+    void checkTimeouts();
+
+    McpRequestHandler handler_;
+    EventLoop* loop_;
+    McpTransportOptions options_;
+    std::atomic<bool> running_{false};
+    int listen_fd_;
+    int port_;
+    int keepalive_timer_;
+    int timeout_timer_;
+
+    // 以下成员只在事件循环线程中访问
+    std::map<int, std::unique_ptr<Connection>> connections_;
+    std::map<uint64_t, int> sessions_;      // SSE会话ID -> 连接fd
+    uint64_t next_session_;
+    uint64_t next_connection_id_;
+    // 启动时创建、停止时在循环线程中释放；迟到的异步响应据此判断传输是否还在
+    std::shared_ptr<bool> alive_;
+};
+
+// stdio传输：标准输入每行一条JSON-RPC消息，响应逐行写到标准输出。
+// 启动后原标准输出只用于协议，fd 1被重定向到标准错误，日志不会混入协议流
+class McpStdioTransport {
+public:
+    explicit McpStdioTransport(McpRequestHandler handler);
+    ~McpStdioTransport();
+
+    McpStdioTransport(const McpStdioTransport&) = delete;
+    McpStdioTransport& operator=(const McpStdioTransport&) = delete;
+
+    bool start(EventLoop* loop);
+    void stop();
+    bool isRunning() const { return running_; }
+
+    // 提前接管标准输出：在main开头调用后，启动前的日志也不会混入协议流
+    static bool reserveStdout();
+
+    // 标准输入关闭（客户端退出）时在事件循环线程中回调
+    void setClosedCallback(std::function<void()> callback);
+
+    // 推送一条JSON-RPC通知，可在任意线程调用
+    void send(const std::string& message);
+
+private:
+    void onEvent(uint32_t events);
+    void processInput();
+    void resumeInput();
+    McpResponder makeResponder();
+    void writeLine(const std::string& message);
+    void flushOutput();
+    void closeInput();
+
+    McpRequestHandler handler_;
+    std::function<void()> closed_callback_;
+    EventLoop* loop_;
+    std::atomic<bool> running_{false};
+    int in_fd_;
+    int out_fd_;
+    int saved_stdout_;
+    int saved_in_flags_;     // 继承来的文件状态标志，stop()时恢复，避免终端遗留O_NONBLOCK
+    int saved_out_flags_;
+    bool in_registered_;
+    bool out_registered_;
+    std::shared_ptr<bool> alive_;
+
+    // 以下成员只在事件循环线程中访问
+    std::string input_;
+    std::string output_;
+    size_t output_offset_;
+    bool input_paused_;      // 输出积压时暂停读取标准输入
+    bool input_eof_;
+};
+
+} // namespace xiaozhi
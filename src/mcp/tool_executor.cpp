@@ -0,0 +1,332 @@
+#include "tool_executor.h"
+#include <iostream>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include "utils/metrics.h"
+#include "utils/trace.h"
+#include "utils/logger.h"
+
+namespace xiaozhi {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr int kMaxAutoWorkers = 4;
+// 停止时等待工作线程退出的时间，超过后分离仍在处理函数中的线程
+constexpr std::chrono::milliseconds kStopGracePeriod(2000);
+
+struct ExecutorMetrics {
+    Gauge& queue_depth = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_tool_queue_depth", "排队等待执行的MCP工具调用数");
+    Gauge& running = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_tool_running", "正在工作线程中执行的MCP工具调用数");
+    Histogram& queue_wait = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_mcp_tool_queue_wait_seconds", "MCP工具调用从提交到开始执行的等待时间");
+    Histogram& latency = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_mcp_tool_latency_seconds", "MCP工具调用从提交到返回结果的总耗时");
+    Counter& timeouts = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_tool_timeouts_total", "超过期限的MCP工具调用数");
+    Counter& cancelled = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_tool_cancelled_total", "被取消的MCP工具调用数");
+    Counter& rejected = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_tool_rejected_total", "因队列已满被拒绝的MCP工具调用数");
+};
+
+ExecutorMetrics& executorMetrics() {
+    static ExecutorMetrics metrics;
+    return metrics;
+}
+
+uint64_t elapsedMicros(Clock::time_point since) {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - since).count());
+}
+
+} // namespace
+
+struct ToolExecutor::Call {
+    std::shared_ptr<const ToolDefinition> tool;
+    ToolValue arguments;
+    ToolStream stream;
+    CancellationToken token;
+    ToolResultCallback done;
+    Clock::time_point submitted;
+    bool started = false;                   // 受State::mutex保护
+    std::atomic<bool> finished{false};      // 结果已回调，之后的结果全部丢弃
+};
+
+struct ToolExecutor::State {
+    std::mutex mutex;
+    std::condition_variable work_cv;
+    std::condition_variable watch_cv;
+    std::condition_variable exit_cv;
+    std::deque<std::shared_ptr<Call>> queue;
+    std::vector<std::shared_ptr<Call>> active;  // 排队中和执行中的调用，供看门狗检查期限
+    std::map<std::string, int> running_per_tool;
+    size_t queue_size = 0;
+    int live_workers = 0;
+    bool stopping = false;
+};
+
+ToolExecutor::ToolExecutor(const ToolExecutorOptions& options) : options_(options) {
+}
+
+ToolExecutor::~ToolExecutor() {
+    stop();
+}
+
+bool ToolExecutor::start() {
+    if (state_) {
+        return true;
+    }
+    int workers = options_.workers;
+    if (workers <= 0) {
+        int cpus = static_cast<int>(std::thread::hardware_concurrency());
+        workers = std::max(1, std::min(cpus, kMaxAutoWorkers));
+    }
+
+    state_ = std::make_shared<State>();
+    state_->queue_size = static_cast<size_t>(std::max(1, options_.queue_size));
+    state_->live_workers = workers;
+    // 线程只持有共享状态，分离后的线程在执行器销毁后仍可安全退出
+    for (int i = 0; i < workers; ++i) {
+        std::thread(&ToolExecutor::workerLoop, state_, i).detach();
+    }
+    std::thread(&ToolExecutor::watchdogLoop, state_).detach();
+    options_.workers = workers;
+
+    std::cout << "[ToolExecutor] 已启动 " << workers << " 个工具执行线程，队列上限: "
+              << state_->queue_size << std::endl;
+    return true;
+}
+
+void ToolExecutor::stop() {
+    if (!state_) {
+        return;
+    }
+    std::shared_ptr<State> state = std::move(state_);
+    std::vector<std::shared_ptr<Call>> pending;
+    {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        state->stopping = true;
+        pending.swap(state->active);
+        state->queue.clear();
+    }
+    state->work_cv.notify_all();
+    state->watch_cv.notify_all();
+    executorMetrics().queue_depth.set(0);
+
+    for (auto& call : pending) {
+        call->token.cancel();
+        finish(*call, "", ToolCallStatus::CANCELLED);
+    }
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    if (!state->exit_cv.wait_for(lock, kStopGracePeriod, [&state]() { return state->live_workers == 0; })) {
+        std::cerr << "[ToolExecutor] 警告: " << state->live_workers
+                  << " 个工具调用未响应取消，已放弃等待" << std::endl;
+    }
+    std::cout << "[ToolExecutor] 已停止" << std::endl;
+}
+
+bool ToolExecutor::isRunning() const {
+    return state_ != nullptr;
+}
+
+CancellationToken ToolExecutor::makeToken(const ToolDefinition& tool) const {
+    int timeout_ms = tool.options.timeout_ms > 0 ? tool.options.timeout_ms : options_.default_timeout_ms;
+    if (timeout_ms <= 0) {
+        return CancellationToken(Clock::time_point::max());
+    }
+    return CancellationToken(Clock::now() + std::chrono::milliseconds(timeout_ms));
+}
+
+void ToolExecutor::submit(std::shared_ptr<const ToolDefinition> tool,
+                          ToolValue arguments,
+                          const ToolStream& stream,
+                          ToolResultCallback done) {
+    auto call = std::make_shared<Call>();
+    call->tool = std::move(tool);
+    call->arguments = std::move(arguments);
+    call->stream = stream;
+    call->token = stream.token();
+    call->done = std::move(done);
+    call->submitted = Clock::now();
+
+    bool accepted = false;
+    if (state_) {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        if (!state_->stopping && state_->queue.size() < state_->queue_size) {
+            state_->queue.push_back(call);
+            state_->active.push_back(call);
+            executorMetrics().queue_depth.set(static_cast<int64_t>(state_->queue.size()));
+            accepted = true;
+        }
+    }
+    if (!accepted) {
+        executorMetrics().rejected.inc();
+        LOG_EVERY_MS(WARN, 1000, "[ToolExecutor] 工具调用队列已满，拒绝调用: {}", call->tool->name);
+        finish(*call, "{\"error\":\"Server busy: tool queue is full\"}", ToolCallStatus::REJECTED);
+        return;
+    }
+    state_->work_cv.notify_one();
+    // 新调用的期限可能早于看门狗当前等待的时间点
+    state_->watch_cv.notify_one();
+}
+
+void ToolExecutor::cancel(const CancellationToken& token) {
+    token.cancel();
+    if (state_) {
+        state_->watch_cv.notify_one();
+    }
+}
+
+size_t ToolExecutor::queueDepth() const {
+    if (!state_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    return state_->queue.size();
+}
+
+int ToolExecutor::workerCount() const {
+    return state_ ? options_.workers : 0;
+}
+
+bool ToolExecutor::finish(Call& call, const std::string& result, ToolCallStatus status) {
+    if (call.finished.exchange(true)) {
+        return false;
+    }
+    executorMetrics().latency.record(elapsedMicros(call.submitted));
+    // 超时或取消时处理函数可能仍在写输出流，先关闭再应答
+    call.stream.close();
+    ToolResultCallback done = std::move(call.done);
+    if (done) {
+        done(result, status);
+    }
+    return true;
+}
+
+void ToolExecutor::expire(Call& call) {
+    // 令牌已失效的调用：过了期限按超时应答，否则是被取消，按约定不再应答
+    if (call.token.deadline() <= Clock::now()) {
+        if (finish(call, ToolRegistry::errorResult("Tool execution timed out: " + call.tool->name),
+                   ToolCallStatus::TIMED_OUT)) {
+            executorMetrics().timeouts.inc();
+            LOG_EVERY_MS(WARN, 1000, "[ToolExecutor] 工具调用超时: {}", call.tool->name);
+        }
+    } else if (finish(call, "", ToolCallStatus::CANCELLED)) {
+        executorMetrics().cancelled.inc();
+    }
+}
+
+void ToolExecutor::workerLoop(std::shared_ptr<State> state, int index) {
+    std::string thread_name = "mcp-tool-" + std::to_string(index);
+    TRACE_THREAD_NAME(thread_name.c_str());
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (true) {
+        // 取队列中第一个所属工具未达并发上限的调用，已结束的调用顺便丢弃
+        std::shared_ptr<Call> call;
+        state->work_cv.wait(lock, [&state, &call]() {
+            if (state->stopping) {
+                return true;
+            }
+            for (auto it = state->queue.begin(); it != state->queue.end();) {
+                const ToolDefinition& tool = *(*it)->tool;
+                if ((*it)->finished.load()) {
+                    it = state->queue.erase(it);
+                    continue;
+                }
+                if (tool.options.max_concurrency <= 0 ||
+                    state->running_per_tool[tool.name] < tool.options.max_concurrency) {
+                    call = *it;
+                    state->queue.erase(it);
+                    return true;
+                }
+                ++it;
+            }
+            return false;
+        });
+        if (state->stopping) {
+            break;
+        }
+
+        call->started = true;
+        ++state->running_per_tool[call->tool->name];
+        executorMetrics().queue_depth.set(static_cast<int64_t>(state->queue.size()));
+        executorMetrics().running.add(1);
+        lock.unlock();
+
+        executorMetrics().queue_wait.record(elapsedMicros(call->submitted));
+        if (!call->finished.load()) {
+            std::string result = ToolRegistry::invokeTool(*call->tool, call->arguments, call->stream);
+            // 响应取消的处理函数会提前返回，结果以取消或超时为准，不能抢在看门狗前当作正常完成
+            if (call->token.isCancelled()) {
+                expire(*call);
+            } else {
+                finish(*call, result, ToolCallStatus::COMPLETED);
+            }
+        }
+
+        executorMetrics().running.add(-1);
+        lock.lock();
+        --state->running_per_tool[call->tool->name];
+        state->active.erase(std::remove(state->active.begin(), state->active.end(), call), state->active.end());
+        // 同一工具被并发上限挡住的调用现在可能可以执行了
+        state->work_cv.notify_all();
+    }
+
+    --state->live_workers;
+    state->exit_cv.notify_all();
+}
+
+void ToolExecutor::watchdogLoop(std::shared_ptr<State> state) {
+    TRACE_THREAD_NAME("mcp-tool-watchdog");
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    while (!state->stopping) {
+        Clock::time_point next = Clock::time_point::max();
+        std::vector<std::shared_ptr<Call>> expired;
+        for (auto it = state->active.begin(); it != state->active.end();) {
+            Call& call = **it;
+            if (!call.finished.load() && call.token.isCancelled()) {
+                expired.push_back(*it);
+            } else if (!call.finished.load()) {
+                next = std::min(next, call.token.deadline());
+            }
+            // 未开始的调用直接移出；执行中的由工作线程在处理函数返回后移出
+            if (!call.started && (call.finished.load() || call.token.isCancelled())) {
+                state->queue.erase(std::remove(state->queue.begin(), state->queue.end(), *it), state->queue.end());
+                it = state->active.erase(it);
+                continue;
+            }
+            ++it;
+        }
+        executorMetrics().queue_depth.set(static_cast<int64_t>(state->queue.size()));
+
+        if (!expired.empty()) {
+            lock.unlock();
+            for (auto& call : expired) {
+                expire(*call);
+            }
+            lock.lock();
+            continue;
+        }
+
+        if (next == Clock::time_point::max()) {
+            state->watch_cv.wait(lock);
+        } else {
+            state->watch_cv.wait_until(lock, next);
+        }
+    }
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <functional>
+#include <cstdint>
+#include "tool_registry.h"
+
+namespace xiaozhi {
+
+struct ToolExecutorOptions {
+    int workers = 0;                // 工作线程数，0表示自动（CPU核数，最多4个）
+    int queue_size = 64;            // 排队等待执行的调用上限，超出时直接拒绝
+    int default_timeout_ms = 30000; // 工具未指定timeout_ms时的调用期限
+};
+
+enum class ToolCallStatus {
+    COMPLETED,      // 处理函数正常返回（包括工具自身报告的错误）
+    TIMED_OUT,      // 超过期限，处理函数可能仍在工作线程中运行
+    CANCELLED,      // 被客户端或停止流程取消
+    REJECTED        // 队列已满
+};
+
+// 调用结束时恰好回调一次，可能在提交线程、工作线程或看门狗线程中执行
+using ToolResultCallback = std::function<void(const std::string& result, ToolCallStatus status)>;
+
+// 有界的工具执行线程池。调用在工作线程中执行，不占用事件循环；
+// 每个调用带有期限，超时或取消时立即回调结果，并通过取消令牌通知处理函数。
+// 工具的max_concurrency限制同一工具同时占用的工作线程数，
+// 一个卡死的工具最多拖住自己的配额，其他工具仍可执行
+class ToolExecutor {
+public:
+    explicit ToolExecutor(const ToolExecutorOptions& options = ToolExecutorOptions());
+    ~ToolExecutor();
+
+    ToolExecutor(const ToolExecutor&) = delete;
+    ToolExecutor& operator=(const ToolExecutor&) = delete;
+
+    bool start();
+    // 取消所有未结束的调用并等待工作线程退出；仍卡在处理函数中的线程
+    // 在宽限期后被分离，它们的结果会被丢弃
+    void stop();
+    bool isRunning() const;
+
+    // 按工具配置和默认期限创建本次调用的取消令牌
+    CancellationToken makeToken(const ToolDefinition& tool) const;
+
+    // 提交调用；arguments应已通过校验并持有参数树（ToolValue::adopt），
+    // 执行期间由本次调用独占；stream携带makeToken创建的取消令牌，回调前被关闭。
+    // 队列已满或执行器未运行时在当前线程以REJECTED回调
+    void submit(std::shared_ptr<const ToolDefinition> tool,
+                ToolValue arguments,
+                const ToolStream& stream,
+                ToolResultCallback done);
+
+    // 取消令牌对应的调用，尚未结束时以CANCELLED回调
+    void cancel(const CancellationToken& token);
+
+    size_t queueDepth() const;
+    int workerCount() const;
+
+private:
+    struct Call;
+    struct State;
+
+    static void workerLoop(std::shared_ptr<State> state, int index);
+    static void watchdogLoop(std::shared_ptr<State> state);
+    // 返回false表示调用已由其他线程结束，本次结果被丢弃
+    static bool finish(Call& call, const std::string& result, ToolCallStatus status);
+    static void expire(Call& call);
+
+    ToolExecutorOptions options_;
+    std::shared_ptr<State> state_;
+};
+
+} // namespace xiaozhi
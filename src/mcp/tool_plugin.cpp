@@ -0,0 +1,372 @@
+#include "tool_plugin.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <json-c/json.h>
+#include <dirent.h>
+#include <dlfcn.h>
+#include "utils/metrics.h"
+
+namespace xiaozhi {
+
+namespace {
+
+struct PluginMetrics {
+    Gauge& loaded = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_plugins_loaded", "已加载的MCP工具插件数");
+    Counter& load_failures = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_plugin_load_failures_total", "加载失败的MCP工具插件数");
+    Histogram& load_time = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_mcp_plugin_load_seconds", "MCP工具插件首次调用时的加载耗时");
+};
+
+PluginMetrics& pluginMetrics() {
+    static PluginMetrics metrics;
+    return metrics;
+}
+
+bool endsWith(const std::string& text, const char* suffix) {
+    size_t length = std::strlen(suffix);
+    return text.size() >= length && text.compare(text.size() - length, length, suffix) == 0;
+}
+
+bool parseFields(json_object* schema_obj, std::vector<ToolParameter>& fields,
+                 const std::string& path, std::string& error);
+
+// inputSchema中的一个属性，与serializeTool输出的形式对应；类型等的合法性由ToolSchema::compile检查
+bool parseParameter(const std::string& name, json_object* schema_obj, ToolParameter& param,
+                    const std::string& path, std::string& error) {
+    if (!json_object_is_type(schema_obj, json_type_object)) {
+        error = path + ": schema must be an object";
+        return false;
+    }
+    param.name = name;
+    json_object* field_obj = nullptr;
+    if (json_object_object_get_ex(schema_obj, "type", &field_obj)) {
+        param.type = json_object_get_string(field_obj);
+    }
+    if (json_object_object_get_ex(schema_obj, "description", &field_obj)) {
+        param.description = json_object_get_string(field_obj);
+    }
+    if (json_object_object_get_ex(schema_obj, "enum", &field_obj) &&
+        json_object_is_type(field_obj, json_type_array)) {
+        for (size_t i = 0; i < json_object_array_length(field_obj); ++i) {
+            param.enum_values.push_back(json_object_get_string(json_object_array_get_idx(field_obj, i)));
+        }
+    }
+    if (json_object_object_get_ex(schema_obj, "minimum", &field_obj)) {
+        param.minimum = json_object_get_double(field_obj);
+    }
+    if (json_object_object_get_ex(schema_obj, "maximum", &field_obj)) {
+        param.maximum = json_object_get_double(field_obj);
+    }
+    if (!parseFields(schema_obj, param.properties, path, error)) {
+        return false;
+    }
+    if (json_object_object_get_ex(schema_obj, "items", &field_obj)) {
+        ToolParameter item;
+        if (!parseParameter("", field_obj, item, path + "[]", error)) {
+            return false;
+        }
+        param.items.push_back(std::move(item));
+    }
+    return true;
+}
+
+// 对象schema的properties和required
+bool parseFields(json_object* schema_obj, std::vector<ToolParameter>& fields,
+                 const std::string& path, std::string& error) {
+    json_object* properties_obj = nullptr;
+    if (!json_object_object_get_ex(schema_obj, "properties", &properties_obj)) {
+        return true;
+    }
+    if (!json_object_is_type(properties_obj, json_type_object)) {
+        error = path + ".properties: must be an object";
+        return false;
+    }
+    json_object_object_foreach(properties_obj, field_name, field_schema) {
+        ToolParameter param;
+        if (!parseParameter(field_name, field_schema, param, path + "." + field_name, error)) {
+            return false;
+        }
+        fields.push_back(std::move(param));
+    }
+
+    json_object* required_obj = nullptr;
+    if (json_object_object_get_ex(schema_obj, "required", &required_obj) &&
+        json_object_is_type(required_obj, json_type_array)) {
+        for (size_t i = 0; i < json_object_array_length(required_obj); ++i) {
+            const char* required = json_object_get_string(json_object_array_get_idx(required_obj, i));
+            auto it = std::find_if(fields.begin(), fields.end(),
+                                   [&](const ToolParameter& param) { return param.name == required; });
+            if (it == fields.end()) {
+                error = path + ".required: unknown property " + required;
+                return false;
+            }
+            it->required = true;
+        }
+    }
+    return true;
+}
+
+bool parseTool(json_object* tool_obj, ToolPluginTool& tool, std::string& error) {
+    json_object* field_obj = nullptr;
+    if (!json_object_is_type(tool_obj, json_type_object) ||
+        !json_object_object_get_ex(tool_obj, "name", &field_obj)) {
+        error = "tool without name";
+        return false;
+    }
+    tool.name = json_object_get_string(field_obj);
+    if (json_object_object_get_ex(tool_obj, "description", &field_obj)) {
+        tool.description = json_object_get_string(field_obj);
+    }
+    if (json_object_object_get_ex(tool_obj, "inputSchema", &field_obj) &&
+        !parseFields(field_obj, tool.parameters, tool.name, error)) {
+        return false;
+    }
+    if (json_object_object_get_ex(tool_obj, "timeout_ms", &field_obj)) {
+        tool.options.timeout_ms = json_object_get_int(field_obj);
+    }
+    if (json_object_object_get_ex(tool_obj, "max_concurrency", &field_obj)) {
+        tool.options.max_concurrency = json_object_get_int(field_obj);
+    }
+    if (json_object_object_get_ex(tool_obj, "idempotent", &field_obj)) {
+        tool.options.idempotent = json_object_get_boolean(field_obj);
+    }
+    if (json_object_object_get_ex(tool_obj, "cache_ttl_ms", &field_obj)) {
+        tool.options.cache_ttl_ms = json_object_get_int(field_obj);
+    }
+    return true;
+}
+
+// 一次调用中宿主回调的状态，通过xiaozhi_tool_call::host取回
+struct HostCall {
+    const ToolStream* stream = nullptr;
+    std::string result;
+    bool has_result = false;
+};
+
+HostCall& hostCall(xiaozhi_tool_call* call) {
+    return *static_cast<HostCall*>(call->host);
+}
+
+void hostSetResult(xiaozhi_tool_call* call, const char* json, size_t size) {
+    HostCall& host = hostCall(call);
+    host.result.assign(json ? json : "", json ? size : 0);
+    host.has_result = true;
+}
+
+int hostWrite(xiaozhi_tool_call* call, const char* text, size_t size) {
+    return hostCall(call).stream->write(std::string(text ? text : "", text ? size : 0)) ? 1 : 0;
+}
+
+void hostProgress(xiaozhi_tool_call* call, double progress, double total, const char* message) {
+    hostCall(call).stream->progress(progress, total, message ? message : "");
+}
+
+int hostIsCancelled(xiaozhi_tool_call* call) {
+    return hostCall(call).stream->isCancelled() ? 1 : 0;
+}
+
+} // namespace
+
+ToolPlugin::ToolPlugin(ToolPluginManifest manifest) : manifest_(std::move(manifest)) {
+}
+
+ToolPlugin::~ToolPlugin() {
+    const xiaozhi_plugin_api* api = api_.load(std::memory_order_acquire);
+    if (api && api->destroy) {
+        api->destroy(instance_);
+    }
+    if (handle_) {
+        dlclose(handle_);
+    }
+    if (api) {
+        pluginMetrics().loaded.add(-1);
+    }
+}
+
+bool ToolPlugin::readManifest(const std::string& path, ToolPluginManifest& manifest, std::string& error) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)),
+                        std::istreambuf_iterator<char>());
+    json_object* root = json_tokener_parse(content.c_str());
+    if (!root || !json_object_is_type(root, json_type_object)) {
+        if (root) {
+            json_object_put(root);
+        }
+        error = "invalid JSON in " + path;
+        return false;
+    }
+
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? std::string(".") : path.substr(0, slash);
+    std::string file_name = slash == std::string::npos ? path : path.substr(slash + 1);
+    manifest.name = file_name.substr(0, file_name.size() - std::strlen(".json"));
+    manifest.library_path = directory + "/" + manifest.name + ".so";
+    manifest.config_json = "{}";
+    manifest.tools.clear();
+
+    bool ok = true;
+    json_object* field_obj = nullptr;
+    if (json_object_object_get_ex(root, "library", &field_obj)) {
+        std::string library = json_object_get_string(field_obj);
+        manifest.library_path = library.compare(0, 1, "/") == 0 ? library : directory + "/" + library;
+    }
+    if (json_object_object_get_ex(root, "abi_version", &field_obj) &&
+        json_object_get_int(field_obj) != XIAOZHI_PLUGIN_ABI_VERSION) {
+        error = "unsupported abi_version " + std::to_string(json_object_get_int(field_obj));
+        ok = false;
+    }
+    if (ok && json_object_object_get_ex(root, "config", &field_obj)) {
+        manifest.config_json = json_object_to_json_string_ext(field_obj, JSON_C_TO_STRING_PLAIN);
+    }
+    json_object* tools_obj = nullptr;
+    if (ok && json_object_object_get_ex(root, "tools", &tools_obj) &&
+        json_object_is_type(tools_obj, json_type_array)) {
+        for (size_t i = 0; ok && i < json_object_array_length(tools_obj); ++i) {
+            ToolPluginTool tool;
+            ok = parseTool(json_object_array_get_idx(tools_obj, i), tool, error);
+            manifest.tools.push_back(std::move(tool));
+        }
+    }
+    json_object_put(root);
+    return ok;
+}
+
+const xiaozhi_plugin_api* ToolPlugin::load(std::string& error) {
+    std::lock_guard<std::mutex> lock(load_mutex_);
+    const xiaozhi_plugin_api* api = api_.load(std::memory_order_relaxed);
+    if (api || load_failed_) {
+        error = load_error_;
+        return api;
+    }
+
+    ScopedTimer timer(pluginMetrics().load_time);
+    auto fail = [&](const std::string& message) -> const xiaozhi_plugin_api* {
+        load_failed_ = true;
+        load_error_ = "Plugin " + manifest_.name + " failed to load: " + message;
+        error = load_error_;
+        if (handle_) {
+            dlclose(handle_);
+            handle_ = nullptr;
+        }
+        pluginMetrics().load_failures.inc();
+        std::cerr << "[ToolPlugin] " << load_error_ << std::endl;
+        return nullptr;
+    };
+
+    // RTLD_LOCAL：插件之间的符号互不可见，同名的内部函数不会互相覆盖
+    handle_ = dlopen(manifest_.library_path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle_) {
+        const char* message = dlerror();
+        return fail(message ? message : "dlopen failed");
+    }
+    auto entry = reinterpret_cast<xiaozhi_plugin_entry_fn>(dlsym(handle_, XIAOZHI_PLUGIN_ENTRY_SYMBOL));
+    if (!entry) {
+        return fail("missing " XIAOZHI_PLUGIN_ENTRY_SYMBOL);
+    }
+    api = entry();
+    if (!api || api->abi_version != XIAOZHI_PLUGIN_ABI_VERSION || !api->call_tool) {
+        return fail("incompatible plugin ABI");
+    }
+    if (api->create) {
+        instance_ = api->create(manifest_.config_json.c_str());
+        if (!instance_) {
+            return fail("create() returned NULL");
+        }
+    }
+
+    api_.store(api, std::memory_order_release);
+    pluginMetrics().loaded.add(1);
+    std::cout << "[ToolPlugin] 已加载插件: " << manifest_.name << " (" << manifest_.library_path << ")" << std::endl;
+    return api;
+}
+
+std::string ToolPlugin::call(const std::string& tool, const ToolValue& arguments, const ToolStream& stream) {
+    const xiaozhi_plugin_api* api = api_.load(std::memory_order_acquire);
+    if (!api) {
+        std::string error;
+        api = load(error);
+        if (!api) {
+            return ToolRegistry::errorResult(error);
+        }
+    }
+
+    const char* arguments_json = arguments.raw()
+        ? json_object_to_json_string_ext(arguments.raw(), JSON_C_TO_STRING_PLAIN) : "{}";
+
+    HostCall host;
+    host.stream = &stream;
+    xiaozhi_tool_call call;
+    call.host = &host;
+    call.set_result = hostSetResult;
+    call.write = hostWrite;
+    call.progress = hostProgress;
+    call.is_cancelled = hostIsCancelled;
+
+    int status = api->call_tool(instance_, tool.c_str(), arguments_json, &call);
+    if (status != 0) {
+        return ToolRegistry::errorResult(host.has_result ? host.result : "Plugin tool failed with status " + std::to_string(status));
+    }
+    if (!host.has_result) {
+        return "{}";
+    }
+    // 结果会原样嵌入JSON-RPC响应，库外代码给出的文本先确认是合法JSON
+    json_object* result_obj = json_tokener_parse(host.result.c_str());
+    if (!result_obj) {
+        return ToolRegistry::errorResult("Plugin returned invalid JSON");
+    }
+    json_object_put(result_obj);
+    return std::move(host.result);
+}
+
+size_t loadToolPlugins(const std::string& directory, ToolRegistry& registry) {
+    DIR* dir = opendir(directory.c_str());
+    if (!dir) {
+        std::cerr << "[ToolPlugin] 无法打开插件目录: " << directory << std::endl;
+        return 0;
+    }
+    std::vector<std::string> manifests;
+    while (dirent* entry = readdir(dir)) {
+        if (entry->d_name[0] != '.' && endsWith(entry->d_name, ".json")) {
+            manifests.push_back(directory + "/" + entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(manifests.begin(), manifests.end());
+
+    size_t registered = 0;
+    for (const auto& path : manifests) {
+        ToolPluginManifest manifest;
+        std::string error;
+        if (!ToolPlugin::readManifest(path, manifest, error)) {
+            std::cerr << "[ToolPlugin] 忽略插件清单 " << path << ": " << error << std::endl;
+            continue;
+        }
+        auto plugin = std::make_shared<ToolPlugin>(std::move(manifest));
+        for (const auto& tool : plugin->manifest().tools) {
+            // 插件不能替换内置工具或先加载的插件中的同名工具
+            if (registry.hasTool(tool.name)) {
+                std::cerr << "[ToolPlugin] 工具已存在，跳过: " << tool.name << std::endl;
+                continue;
+            }
+            std::string name = tool.name;
+            StreamingToolHandler handler = [plugin, name](const ToolValue& arguments, const ToolStream& stream) {
+                return plugin->call(name, arguments, stream);
+            };
+            if (registry.registerTool(tool.name, tool.description, tool.parameters, handler, tool.options)) {
+                ++registered;
+            }
+        }
+    }
+    std::cout << "[ToolPlugin] 从 " << manifests.size() << " 个插件清单注册了 " << registered << " 个工具" << std::endl;
+    return registered;
+}
+
+} // namespace xiaozhi
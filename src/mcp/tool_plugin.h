@@ -0,0 +1,67 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include "tool_registry.h"
+#include "xiaozhi_plugin.h"
+
+namespace xiaozhi {
+
+// 插件清单中声明的一个工具
+struct ToolPluginTool {
+    std::string name;
+    std::string description;
+    std::vector<ToolParameter> parameters;  // 由inputSchema转换
+    ToolOptions options;
+};
+
+// 插件清单，格式见xiaozhi_plugin.h
+struct ToolPluginManifest {
+    std::string name;           // 清单文件名去掉.json
+    std::string library_path;
+    std::string config_json;    // 传给create的配置，没有时为"{}"
+    std::vector<ToolPluginTool> tools;
+};
+
+// 一个插件共享库。构造时不加载，第一次调用工具时才dlopen并创建实例；
+// 加载失败会被记住，之后的调用直接返回同一错误，不反复尝试。
+// 由注册的工具处理函数共同持有，最后一个引用释放时销毁实例并卸载库
+class ToolPlugin {
+public:
+    explicit ToolPlugin(ToolPluginManifest manifest);
+    ~ToolPlugin();
+
+    ToolPlugin(const ToolPlugin&) = delete;
+    ToolPlugin& operator=(const ToolPlugin&) = delete;
+
+    // 读取并解析清单，不打开共享库
+    static bool readManifest(const std::string& path, ToolPluginManifest& manifest, std::string& error);
+
+    const ToolPluginManifest& manifest() const { return manifest_; }
+    bool isLoaded() const { return api_.load(std::memory_order_acquire) != nullptr; }
+
+    // 按需加载后执行工具，返回结果JSON；加载失败或插件返回错误时为{"error":...}
+    std::string call(const std::string& tool, const ToolValue& arguments, const ToolStream& stream);
+
+private:
+    const xiaozhi_plugin_api* load(std::string& error);
+
+    ToolPluginManifest manifest_;
+
+    std::mutex load_mutex_;     // 串行化首次加载
+    // 加载成功后才发布，之后的调用只读这一个原子量
+    std::atomic<const xiaozhi_plugin_api*> api_{nullptr};
+    void* handle_ = nullptr;
+    void* instance_ = nullptr;
+    bool load_failed_ = false;
+    std::string load_error_;
+};
+
+// 扫描directory下的*.json清单并注册其中声明的工具，返回注册的工具数。
+// 只读清单，共享库在工具首次调用时加载；与已有工具重名的工具被跳过
+size_t loadToolPlugins(const std::string& directory, ToolRegistry& registry);
+
+} // namespace xiaozhi
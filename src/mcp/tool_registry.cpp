@@ -1,9 +1,237 @@
 #include "tool_registry.h"
 #include <iostream>
+#include <atomic>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <json-c/json.h>
+#include "utils/metrics.h"
+#include "utils/trace.h"
 
 namespace xiaozhi {
 
-ToolRegistry::ToolRegistry() {
+namespace {
+
+struct ToolMetrics {
+    Counter& calls = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_calls_total", "MCP工具调用次数");
+    Counter& call_errors = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_call_errors_total", "参数错误或工具不存在的MCP调用次数");
+    Histogram& call_time = MetricsRegistry::getInstance().histogram(
+        "xiaozhi_mcp_call_seconds", "MCP工具执行耗时");
+    Gauge& registered = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_tools", "已注册的MCP工具数");
+    Counter& stream_chunks = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_stream_chunks_total", "以通知形式推送的MCP工具结果分块数");
+    Counter& stream_truncated = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_stream_truncated_total", "缓冲的分块结果超过上限被截断的MCP调用数");
+};
+
+ToolMetrics& toolMetrics() {
+    static ToolMetrics metrics;
+    return metrics;
+}
+
+// 不能推送时暂存的内容块总量上限，超过后丢弃并在结果中标记truncated
+constexpr size_t kMaxBufferedStreamBytes = 1024 * 1024;
+// 进度通知的最小间隔，处理函数可以放心地在循环里频繁调用progress
+constexpr std::chrono::milliseconds kMinProgressInterval(50);
+
+std::string jsonString(const std::string& text) {
+    json_object* text_obj = json_object_new_string_len(text.data(), static_cast<int>(text.size()));
+    std::string json = json_object_to_json_string_ext(text_obj, JSON_C_TO_STRING_PLAIN);
+    json_object_put(text_obj);
+    return json;
+}
+
+std::string jsonNumber(double value) {
+    json_object* number_obj = json_object_new_double(value);
+    std::string json = json_object_to_json_string_ext(number_obj, JSON_C_TO_STRING_PLAIN);
+    json_object_put(number_obj);
+    return json;
+}
+
+json_object* parameterSchema(const ToolParameter& param);
+
+// object的properties和required，顶层inputSchema与嵌套对象共用
+void addObjectFields(json_object* schema_obj, const std::vector<ToolParameter>& fields) {
+    json_object* properties_obj = json_object_new_object();
+    json_object* required_array = json_object_new_array();
+    for (const auto& field : fields) {
+        json_object_object_add(properties_obj, field.name.c_str(), parameterSchema(field));
+        if (field.required) {
+            json_object_array_add(required_array, json_object_new_string(field.name.c_str()));
+        }
+    }
+    json_object_object_add(schema_obj, "properties", properties_obj);
+    json_object_object_add(schema_obj, "required", required_array);
+}
+
+json_object* parameterSchema(const ToolParameter& param) {
+    json_object* param_obj = json_object_new_object();
+    if (!param.type.empty()) {
+        json_object_object_add(param_obj, "type", json_object_new_string(param.type.c_str()));
+    }
+    json_object_object_add(param_obj, "description", json_object_new_string(param.description.c_str()));
+    if (!param.enum_values.empty()) {
+        json_object* enum_array = json_object_new_array();
+        for (const auto& value : param.enum_values) {
+            json_object_array_add(enum_array, json_object_new_string(value.c_str()));
+        }
+        json_object_object_add(param_obj, "enum", enum_array);
+    }
+    if (param.minimum) {
+        json_object_object_add(param_obj, "minimum", json_object_new_double(*param.minimum));
+    }
+    if (param.maximum) {
+        json_object_object_add(param_obj, "maximum", json_object_new_double(*param.maximum));
+    }
+    if (param.type == "object" && !param.properties.empty()) {
+        addObjectFields(param_obj, param.properties);
+    }
+    if (!param.items.empty()) {
+        json_object_object_add(param_obj, "items", parameterSchema(param.items.front()));
+    }
+    return param_obj;
+}
+
+// 单个工具的MCP描述：name、description和JSON Schema形式的inputSchema
+std::string serializeTool(const ToolDefinition& tool) {
+    json_object* tool_obj = json_object_new_object();
+    json_object_object_add(tool_obj, "name", json_object_new_string(tool.name.c_str()));
+    json_object_object_add(tool_obj, "description", json_object_new_string(tool.description.c_str()));
+
+    json_object* schema_obj = json_object_new_object();
+    json_object_object_add(schema_obj, "type", json_object_new_string("object"));
+    addObjectFields(schema_obj, tool.parameters);
+    json_object_object_add(tool_obj, "inputSchema", schema_obj);
+
+    std::string json = json_object_to_json_string_ext(tool_obj, JSON_C_TO_STRING_PLAIN);
+    json_object_put(tool_obj);
+    return json;
+}
+
+} // namespace
+
+struct ToolStream::State {
+    std::mutex mutex;
+    ToolNotifier notifier;
+    std::string progress_token;         // 序列化后的progressToken，为空表示客户端未请求推送
+    bool closed = false;
+    size_t chunks = 0;
+    std::vector<std::string> buffered;  // 未推送的内容块，已序列化为JSON对象
+    size_t buffered_bytes = 0;
+    bool truncated = false;
+    bool progress_sent = false;
+    std::chrono::steady_clock::time_point last_progress;
+};
+
+ToolStream::ToolStream() : state_(std::make_shared<State>()) {
+}
+
+ToolStream::ToolStream(const CancellationToken& token, ToolNotifier notifier, const std::string& progress_token)
+    : token_(token), state_(std::make_shared<State>()) {
+    state_->notifier = std::move(notifier);
+    state_->progress_token = progress_token;
+}
+
+bool ToolStream::isStreaming() const {
+    return state_->notifier && !state_->progress_token.empty();
+}
+
+bool ToolStream::write(const std::string& text) const {
+    std::string block = "{\"type\":\"text\",\"text\":" + jsonString(text) + "}";
+
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->closed || token_.isCancelled()) {
+        return false;
+    }
+    if (isStreaming()) {
+        // 持锁推送：close()之后不会再有通知排到最终响应后面
+        state_->notifier("{\"jsonrpc\":\"2.0\",\"method\":\"notifications/tools/content\",\"params\":{"
+                         "\"progressToken\":" + state_->progress_token +
+                         ",\"index\":" + std::to_string(state_->chunks) +
+                         ",\"content\":[" + block + "]}}");
+        ++state_->chunks;
+        toolMetrics().stream_chunks.inc();
+        return true;
+    }
+    if (state_->buffered_bytes + block.size() > kMaxBufferedStreamBytes) {
+        if (!state_->truncated) {
+            state_->truncated = true;
+            toolMetrics().stream_truncated.inc();
+        }
+        return false;
+    }
+    state_->buffered_bytes += block.size();
+    state_->buffered.push_back(std::move(block));
+    ++state_->chunks;
+    return true;
+}
+
+bool ToolStream::progress(double progress, double total, const std::string& message) const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    if (state_->closed || token_.isCancelled()) {
+        return false;
+    }
+    if (!isStreaming()) {
+        return true;
+    }
+    auto now = std::chrono::steady_clock::now();
+    bool done = total > 0 && progress >= total;
+    if (!done && state_->progress_sent && now - state_->last_progress < kMinProgressInterval) {
+        return true;
+    }
+    state_->progress_sent = true;
+    state_->last_progress = now;
+
+    std::string notification = "{\"jsonrpc\":\"2.0\",\"method\":\"notifications/progress\",\"params\":{"
+                               "\"progressToken\":" + state_->progress_token +
+                               ",\"progress\":" + jsonNumber(progress);
+    if (total > 0) {
+        notification += ",\"total\":" + jsonNumber(total);
+    }
+    if (!message.empty()) {
+        notification += ",\"message\":" + jsonString(message);
+    }
+    notification += "}}";
+    state_->notifier(notification);
+    return true;
+}
+
+void ToolStream::close() const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->closed = true;
+}
+
+std::string ToolStream::finish(const std::string& result) const {
+    std::lock_guard<std::mutex> lock(state_->mutex);
+    state_->closed = true;
+    if (state_->chunks == 0) {
+        return result;
+    }
+
+    std::string combined = "{\"content\":[";
+    for (size_t i = 0; i < state_->buffered.size(); ++i) {
+        if (i > 0) {
+            combined += ",";
+        }
+        combined += state_->buffered[i];
+    }
+    combined += "],\"chunks\":" + std::to_string(state_->chunks);
+    if (state_->truncated) {
+        combined += ",\"truncated\":true";
+    }
+    if (!result.empty()) {
+        combined += ",\"structuredContent\":" + result;
+    }
+    combined += "}";
+    state_->buffered.clear();
+    state_->buffered_bytes = 0;
+    return combined;
+}
+
+ToolRegistry::ToolRegistry() : snapshot_(std::make_shared<ToolSnapshot>()) {
     std::cout << "[ToolRegistry] 初始化工具注册表" << std::endl;
 }
 
@@ -11,54 +239,274 @@ ToolRegistry::~ToolRegistry() {
     std::cout << "[ToolRegistry] 工具注册表已销毁" << std::endl;
 }
 
-void ToolRegistry::registerTool(const std::string& name, 
+bool ToolRegistry::registerTool(const std::string& name,
+                              const std::string& description,
+                              const std::vector<ToolParameter>& parameters,
+                              ToolHandler handler,
+                              const ToolOptions& options) {
+    return registerTool(name, description, parameters,
+                        StreamingToolHandler([handler](const ToolValue& arguments, const ToolStream&) {
+                            return handler(arguments.toStringMap());
+                        }),
+                        options);
+}
+
+bool ToolRegistry::registerTool(const std::string& name,
                               const std::string& description,
                               const std::vector<ToolParameter>& parameters,
-                              std::function<std::string(const std::map<std::string, std::string>&)> handler) {
-    ToolDefinition tool;
-    tool.name = name;
-    tool.description = description;
-    tool.parameters = parameters;
-    tool.handler = handler;
-    
-    tools_[name] = tool;
-    
+                              CancellableToolHandler handler,
+                              const ToolOptions& options) {
+    return registerTool(name, description, parameters,
+                        StreamingToolHandler([handler](const ToolValue& arguments, const ToolStream& stream) {
+                            return handler(arguments.toStringMap(), stream.token());
+                        }),
+                        options);
+}
+
+bool ToolRegistry::registerTool(const std::string& name,
+                              const std::string& description,
+                              const std::vector<ToolParameter>& parameters,
+                              TypedToolHandler handler,
+                              const ToolOptions& options) {
+    return registerTool(name, description, parameters,
+                        StreamingToolHandler([handler](const ToolValue& arguments, const ToolStream& stream) {
+                            return handler(arguments, stream.token());
+                        }),
+                        options);
+}
+
+bool ToolRegistry::registerTool(const std::string& name,
+                              const std::string& description,
+                              const std::vector<ToolParameter>& parameters,
+                              StreamingToolHandler handler,
+                              const ToolOptions& options) {
+    std::string error;
+    auto schema = ToolSchema::compile(parameters, &error);
+    if (!schema) {
+        std::cerr << "[ToolRegistry] 错误: 工具 " << name << " 的参数定义无效: " << error << std::endl;
+        return false;
+    }
+
+    auto tool = std::make_shared<ToolDefinition>();
+    tool->name = name;
+    tool->description = description;
+    tool->parameters = parameters;
+    tool->schema = std::move(schema);
+    tool->handler = std::move(handler);
+    tool->options = options;
+
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto next = std::make_shared<ToolSnapshot>(*snapshot());
+        ++next->generation;
+        tool->generation = next->generation;
+        next->tools[name] = std::move(tool);
+        publish(std::move(next));
+    }
+    // 旧定义的缓存结果已不可能命中，尽早释放
+    result_cache_.invalidatePrefix(name + '\n');
+
     std::cout << "[ToolRegistry] 已注册工具: " << name << std::endl;
+    return true;
 }
 
-std::string ToolRegistry::callTool(const std::string& name, 
-                                  const std::map<std::string, std::string>& arguments) {
-    auto it = tools_.find(name);
-    if (it != tools_.end()) {
-        // 验证参数
-        for (const auto& param : it->second.parameters) {
-            if (param.required && arguments.find(param.name) == arguments.end()) {
-                return "{\"error\":\"Missing required parameter: " + param.name + "\"}";
-            }
-        }
-        
-        // 调用工具处理函数
-        try {
-            std::string result = it->second.handler(arguments);
-            return result;
-        } catch (const std::exception& e) {
-            return "{\"error\":\"Tool execution failed: " + std::string(e.what()) + "\"}";
+bool ToolRegistry::unregisterTool(const std::string& name) {
+    {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        auto current = snapshot();
+        if (current->tools.find(name) == current->tools.end()) {
+            return false;
         }
-    } else {
-        return "{\"error\":\"Tool not found: " + name + "\"}";
+        auto next = std::make_shared<ToolSnapshot>(*current);
+        next->tools.erase(name);
+        ++next->generation;
+        publish(std::move(next));
+    }
+    result_cache_.invalidatePrefix(name + '\n');
+
+    std::cout << "[ToolRegistry] 已注销工具: " << name << std::endl;
+    return true;
+}
+
+void ToolRegistry::publish(std::shared_ptr<const ToolSnapshot> next) {
+    toolMetrics().registered.set(static_cast<int64_t>(next->tools.size()));
+    // 旧快照在最后一个持有它的读者释放后销毁
+    std::atomic_store_explicit(&snapshot_, std::move(next), std::memory_order_release);
+}
+
+std::shared_ptr<const ToolSnapshot> ToolRegistry::snapshot() const {
+    return std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+}
+
+std::shared_ptr<const ToolDefinition> ToolRegistry::findTool(const std::string& name) const {
+    auto current = snapshot();
+    auto it = current->tools.find(name);
+    return it != current->tools.end() ? it->second : nullptr;
+}
+
+std::string ToolRegistry::callTool(const std::string& name,
+                                  const ToolValue& arguments,
+                                  const CancellationToken& token) {
+    // 只持有该工具定义的引用，执行期间工具被替换或注销也不受影响
+    auto tool = findTool(name);
+    if (!tool) {
+        toolMetrics().calls.inc();
+        toolMetrics().call_errors.inc();
+        return errorResult("Tool not found: " + name);
+    }
+    std::string error;
+    if (!validateArguments(*tool, arguments, error)) {
+        return errorResult("Invalid arguments: " + error);
+    }
+    if (!isCacheable(*tool)) {
+        return invokeTool(*tool, arguments, ToolStream(token));
+    }
+    std::string key = cacheKey(*tool, arguments);
+    std::string result;
+    if (!lookupResult(key, result)) {
+        result = invokeTool(*tool, arguments, ToolStream(token));
+        storeResult(*tool, key, result);
+    }
+    return result;
+}
+
+std::string ToolRegistry::errorResult(const std::string& message) {
+    return "{\"error\":" + jsonString(message) + "}";
+}
+
+std::string ToolRegistry::cacheKey(const ToolDefinition& tool, const ToolValue& arguments) {
+    return tool.name + '\n' + std::to_string(tool.generation) + '\n' + arguments.canonicalJson();
+}
+
+bool ToolRegistry::lookupResult(const std::string& key, std::string& result) {
+    return result_cache_.lookup(key, result);
+}
+
+void ToolRegistry::storeResult(const ToolDefinition& tool, const std::string& key, const std::string& result) {
+    if (!isCacheable(tool) || result.compare(0, 9, "{\"error\":") == 0) {
+        return;
+    }
+    result_cache_.store(key, result, std::chrono::milliseconds(tool.options.cache_ttl_ms));
+}
+
+void ToolRegistry::setResultCacheBytes(size_t max_bytes) {
+    result_cache_.setMaxBytes(max_bytes);
+}
+
+bool ToolRegistry::validateArguments(const ToolDefinition& tool, const ToolValue& arguments, std::string& error) {
+    if (!tool.schema || tool.schema->validate(arguments, &error)) {
+        return true;
+    }
+    toolMetrics().calls.inc();
+    toolMetrics().call_errors.inc();
+    return false;
+}
+
+std::string ToolRegistry::invokeTool(const ToolDefinition& tool,
+                                     const ToolValue& arguments,
+                                     const ToolStream& stream) {
+    toolMetrics().calls.inc();
+
+    // 调用工具处理函数
+    TRACE_SCOPE("mcp", "mcp.tool_call");
+    try {
+        ScopedTimer timer(toolMetrics().call_time);
+        return stream.finish(tool.handler(arguments, stream));
+    } catch (const std::exception& e) {
+        stream.close();
+        toolMetrics().call_errors.inc();
+        return errorResult("Tool execution failed: " + std::string(e.what()));
     }
 }
 
 std::vector<ToolDefinition> ToolRegistry::getAllTools() const {
+    auto current = snapshot();
     std::vector<ToolDefinition> tool_list;
-    for (const auto& pair : tools_) {
-        tool_list.push_back(pair.second);
+    tool_list.reserve(current->tools.size());
+    for (const auto& pair : current->tools) {
+        tool_list.push_back(*pair.second);
     }
     return tool_list;
 }
 
+void ToolRegistry::setListPageSize(size_t page_size) {
+    list_page_size_.store(page_size, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const ToolListCache> ToolRegistry::listCache() const {
+    auto current = snapshot();
+    size_t page_size = list_page_size_.load(std::memory_order_relaxed);
+    auto cache = std::atomic_load_explicit(&list_cache_, std::memory_order_acquire);
+    if (cache && cache->generation == current->generation && cache->page_size == page_size) {
+        return cache;
+    }
+    cache = buildListCache(*current, page_size);
+    std::atomic_store_explicit(&list_cache_, cache, std::memory_order_release);
+    return cache;
+}
+
+std::shared_ptr<const ToolListCache> ToolRegistry::buildListCache(const ToolSnapshot& snapshot, size_t page_size) {
+    TRACE_SCOPE("mcp", "mcp.tools_list_build");
+    auto cache = std::make_shared<ToolListCache>();
+    cache->generation = snapshot.generation;
+    cache->page_size = page_size;
+    cache->tool_count = snapshot.tools.size();
+
+    std::vector<std::string> tools;
+    tools.reserve(snapshot.tools.size());
+    for (const auto& pair : snapshot.tools) {
+        tools.push_back(serializeTool(*pair.second));
+    }
+
+    auto join = [&tools](size_t begin, size_t end) {
+        std::string array = "[";
+        for (size_t i = begin; i < end; ++i) {
+            if (i > begin) {
+                array += ",";
+            }
+            array += tools[i];
+        }
+        array += "]";
+        return array;
+    };
+
+    cache->all_tools = join(0, tools.size());
+    size_t per_page = page_size > 0 ? page_size : std::max<size_t>(tools.size(), 1);
+    size_t page_count = std::max<size_t>((tools.size() + per_page - 1) / per_page, 1);
+    for (size_t page = 0; page < page_count; ++page) {
+        size_t begin = page * per_page;
+        size_t end = std::min(begin + per_page, tools.size());
+        std::string result = "{\"tools\":" + (page_count == 1 ? cache->all_tools : join(begin, end));
+        if (page + 1 < page_count) {
+            result += ",\"nextCursor\":\"" + makeCursor(snapshot.generation, page + 1) + "\"";
+        }
+        result += "}";
+        cache->pages.push_back(std::move(result));
+    }
+    return cache;
+}
+
+std::string ToolRegistry::makeCursor(uint64_t generation, size_t page) {
+    return std::to_string(generation) + ":" + std::to_string(page);
+}
+
+bool ToolRegistry::parseCursor(const std::string& cursor, uint64_t& generation, size_t& page) {
+    size_t colon = cursor.find(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 >= cursor.size()) {
+        return false;
+    }
+    char* end = nullptr;
+    generation = std::strtoull(cursor.c_str(), &end, 10);
+    if (end != cursor.c_str() + colon) {
+        return false;
+    }
+    page = static_cast<size_t>(std::strtoull(cursor.c_str() + colon + 1, &end, 10));
+    return *end == '\0';
+}
+
 bool ToolRegistry::hasTool(const std::string& name) const {
-    return tools_.find(name) != tools_.end();
+    auto current = snapshot();
+    return current->tools.find(name) != current->tools.end();
 }
 
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
@@ -4,39 +4,205 @@
 #include <map>
 #include <vector>
 #include <functional>
-#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include "xiaozhi_types.h"
+#include "tool_schema.h"
+#include "tool_result_cache.h"
 
 namespace xiaozhi {
 
-struct ToolParameter {
-    std::string name;
-    std::string type;  // "string", "number", "boolean"
-    std::string description;
-    bool required = false;
+// 工具调用的取消令牌：调用超时或客户端发送notifications/cancelled后变为已取消。
+// 线程无法被强制终止，耗时的工具应在循环中检查isCancelled()并尽早返回
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // 默认构造的令牌永不取消，用于同步调用
+    CancellationToken() = default;
+    explicit CancellationToken(Clock::time_point deadline)
+        : state_(std::make_shared<State>()) {
+        state_->deadline = deadline;
+    }
+
+    bool isCancelled() const {
+        return state_ && (state_->cancelled.load(std::memory_order_acquire) ||
+                          Clock::now() >= state_->deadline);
+    }
+
+    void cancel() const {
+        if (state_) {
+            state_->cancelled.store(true, std::memory_order_release);
+        }
+    }
+
+    Clock::time_point deadline() const {
+        return state_ ? state_->deadline : Clock::time_point::max();
+    }
+
+    // 是否为同一次调用的令牌（副本共享状态）
+    bool operator==(const CancellationToken& other) const { return state_ == other.state_; }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{false};
+        Clock::time_point deadline = Clock::time_point::max();
+    };
+    std::shared_ptr<State> state_;
+};
+
+// 发送与某次调用关联的JSON-RPC通知，由传输层提供，可在任意线程调用
+using ToolNotifier = std::function<void(const std::string& notification)>;
+
+// 工具调用的输出流：处理函数边产生边写出内容块，并可报告进度。
+// 请求带有_meta.progressToken且传输能推送通知（SSE会话、stdio）时，内容块以
+// notifications/tools/content、进度以notifications/progress立即发出，服务端不保留
+// 已发出的数据；否则内容块暂存并在调用结束时放入结果，超过上限的部分被丢弃。
+// 副本共享状态，调用结束（返回、超时或取消）后的写入都被丢弃
+class ToolStream {
+public:
+    // 只缓冲、永不取消的流，用于同步调用
+    ToolStream();
+    explicit ToolStream(const CancellationToken& token, ToolNotifier notifier = nullptr,
+                        const std::string& progress_token = std::string());
+
+    const CancellationToken& token() const { return token_; }
+    bool isCancelled() const { return token_.isCancelled(); }
+    // 内容块是否直接推送给客户端
+    bool isStreaming() const;
+
+    // 写出一个文本内容块。返回false表示调用已结束或缓冲已满，处理函数应停止产生输出
+    bool write(const std::string& text) const;
+    // 报告进度，total不大于0表示总量未知；过于频繁的进度会被合并。返回值同write
+    bool progress(double progress, double total = 0, const std::string& message = std::string()) const;
+
+    // 结束输出流，之后的写入都被丢弃；在最终响应发出前调用，保证通知不会晚于响应到达
+    void close() const;
+    // 结束输出流并合成最终结果：未写过内容块时原样返回result，否则返回
+    // {"content":[未推送的内容块],"chunks":总块数,"structuredContent":result}
+    std::string finish(const std::string& result) const;
+
+private:
+    struct State;
+    CancellationToken token_;
+    std::shared_ptr<State> state_;
+};
+
+using ToolHandler = std::function<std::string(const std::map<std::string, std::string>&)>;
+using CancellableToolHandler =
+    std::function<std::string(const std::map<std::string, std::string>&, const CancellationToken&)>;
+// 直接读取带类型的参数视图，参数已按注册时的Schema校验过，处理函数无需再检查类型和范围
+using TypedToolHandler = std::function<std::string(const ToolValue& arguments, const CancellationToken&)>;
+// 通过输出流逐块返回结果，适合输出量大或耗时长的工具；stream.token()为本次调用的取消令牌
+using StreamingToolHandler = std::function<std::string(const ToolValue& arguments, const ToolStream& stream)>;
+
+struct ToolOptions {
+    int timeout_ms = 0;         // 调用期限，0表示使用执行器的默认值
+    int max_concurrency = 0;    // 同时执行的调用数上限，0表示只受工作线程数限制
+    bool idempotent = false;    // 无副作用，相同参数在短时间内可以返回同一结果
+    int cache_ttl_ms = 0;       // idempotent时结果的缓存时长，0表示不缓存
 };
 
 struct ToolDefinition {
     std::string name;
     std::string description;
     std::vector<ToolParameter> parameters;
-    std::function<std::string(const std::map<std::string, std::string>&)> handler;
+    std::shared_ptr<const ToolSchema> schema;   // 由parameters编译，注册后不再修改
+    StreamingToolHandler handler;
+    ToolOptions options;
+    uint64_t generation = 0;    // 注册时的注册表代数，同名工具被替换后旧结果不会被当作新工具的缓存
 };
 
+// 某一时刻的完整工具表，发布后不再修改。持有快照的读者不受并发注册影响
+struct ToolSnapshot {
+    std::map<std::string, std::shared_ptr<const ToolDefinition>> tools;
+    uint64_t generation = 0;    // 每次注册或注销加1
+};
+
+// tools/list的序列化结果，属于某一代快照，生成后不再修改
+struct ToolListCache {
+    uint64_t generation = 0;
+    size_t page_size = 0;
+    size_t tool_count = 0;
+    std::string all_tools;              // 全部工具组成的JSON数组
+    std::vector<std::string> pages;     // 每页完整的result对象，非末页带nextCursor
+};
+
+// 写时复制的工具注册表：注册/注销复制当前表、修改后原子地发布新快照；
+// 查找和列举只原子地取一次快照指针，不与写者或其他读者争用锁。
+// 工具处理函数在快照之外执行，慢工具不会阻塞其他请求或运行时注册
 class ToolRegistry {
 public:
     ToolRegistry();
     ~ToolRegistry();
 
-    // 注册工具
-    void registerTool(const std::string& name, 
+    // 注册工具，同名工具被替换；可在运行时任意线程调用。
+    // 参数定义在此编译为校验器，定义有误时拒绝注册并返回false
+    bool registerTool(const std::string& name,
+                     const std::string& description,
+                     const std::vector<ToolParameter>& parameters,
+                     ToolHandler handler,
+                     const ToolOptions& options = ToolOptions());
+
+    // 注册可响应取消的工具，处理函数收到本次调用的取消令牌
+    bool registerTool(const std::string& name,
+                     const std::string& description,
+                     const std::vector<ToolParameter>& parameters,
+                     CancellableToolHandler handler,
+                     const ToolOptions& options = ToolOptions());
+
+    // 注册读取带类型参数的工具，省去字符串表的构造和处理函数内的类型转换
+    bool registerTool(const std::string& name,
+                     const std::string& description,
+                     const std::vector<ToolParameter>& parameters,
+                     TypedToolHandler handler,
+                     const ToolOptions& options = ToolOptions());
+
+    // 注册流式输出结果的工具
+    bool registerTool(const std::string& name,
                      const std::string& description,
                      const std::vector<ToolParameter>& parameters,
-                     std::function<std::string(const std::map<std::string, std::string>&)> handler);
+                     StreamingToolHandler handler,
+                     const ToolOptions& options = ToolOptions());
+
+    bool unregisterTool(const std::string& name);
+
+    // 在调用线程上同步校验参数并执行工具，可缓存的工具先查结果缓存
+    std::string callTool(const std::string& name,
+                        const ToolValue& arguments,
+                        const CancellationToken& token = CancellationToken());
 
-    // 调用工具
-    std::string callTool(const std::string& name, 
-                        const std::map<std::string, std::string>& arguments);
+    // 工具报告错误的结果对象{"error":"<message>"}，message按JSON转义，可以包含客户端提供的内容
+    static std::string errorResult(const std::string& message);
+
+    // 按工具的Schema校验参数，失败时计入调用错误并在error中给出出错路径
+    static bool validateArguments(const ToolDefinition& tool, const ToolValue& arguments, std::string& error);
+
+    // 按ToolOptions声明可以缓存结果的工具
+    static bool isCacheable(const ToolDefinition& tool) {
+        return tool.options.idempotent && tool.options.cache_ttl_ms > 0;
+    }
+    // 结果缓存的键：工具名、注册代数和规范化后的参数
+    static std::string cacheKey(const ToolDefinition& tool, const ToolValue& arguments);
+    bool lookupResult(const std::string& key, std::string& result);
+    // 保存结果；工具报告的错误（{"error":...}）不缓存
+    void storeResult(const ToolDefinition& tool, const std::string& key, const std::string& result);
+    // 结果缓存的字节上限，0表示关闭
+    void setResultCacheBytes(size_t max_bytes);
+
+    // 执行已查找且参数已校验的工具：记录指标、调用处理函数并结束输出流。
+    // 不访问注册表本身，执行器的工作线程在注册表销毁后仍可安全返回
+    static std::string invokeTool(const ToolDefinition& tool,
+                                  const ToolValue& arguments,
+                                  const ToolStream& stream);
+
+    // 当前快照，列举工具时应只取一次并在同一快照上完成遍历
+    std::shared_ptr<const ToolSnapshot> snapshot() const;
+
+    std::shared_ptr<const ToolDefinition> findTool(const std::string& name) const;
 
     // 获取所有工具
     std::vector<ToolDefinition> getAllTools() const;
@@ -44,8 +210,32 @@ public:
     // 检查工具是否存在
     bool hasTool(const std::string& name) const;
 
+    uint64_t getGeneration() const { return snapshot()->generation; }
+
+    // tools/list每页的工具数，0表示不分页
+    void setListPageSize(size_t page_size);
+
+    // 当前快照对应的序列化工具列表；工具集合变化后的首次调用重新生成，
+    // 之后的调用直接返回同一份缓冲
+    std::shared_ptr<const ToolListCache> listCache() const;
+
+    // 翻页游标："<代数>:<页号>"，工具集合变化后旧游标失效
+    static std::string makeCursor(uint64_t generation, size_t page);
+    static bool parseCursor(const std::string& cursor, uint64_t& generation, size_t& page);
+
 private:
-    std::unordered_map<std::string, ToolDefinition> tools_;
+    void publish(std::shared_ptr<const ToolSnapshot> next);
+    static std::shared_ptr<const ToolListCache> buildListCache(const ToolSnapshot& snapshot, size_t page_size);
+
+    // 只能通过std::atomic_load/atomic_store访问
+    std::shared_ptr<const ToolSnapshot> snapshot_;
+    std::mutex write_mutex_;    // 串行化写者的复制-修改-发布
+
+    ToolResultCache result_cache_;
+
+    std::atomic<size_t> list_page_size_{0};
+    // 同样只通过std::atomic_load/atomic_store访问，并发重建时后写者胜出
+    mutable std::shared_ptr<const ToolListCache> list_cache_;
 };
 
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
@@ -0,0 +1,123 @@
+#include "tool_result_cache.h"
+#include "utils/metrics.h"
+
+namespace xiaozhi {
+
+namespace {
+
+// 每个条目在键和结果之外的大致开销：链表节点、哈希表节点和Entry本身
+constexpr size_t kEntryOverhead = 128;
+
+struct CacheMetrics {
+    Counter& hits = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_result_cache_hits_total", "命中结果缓存的MCP工具调用数");
+    Counter& misses = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_result_cache_misses_total", "未命中结果缓存的MCP工具调用数");
+    Counter& evictions = MetricsRegistry::getInstance().counter(
+        "xiaozhi_mcp_result_cache_evictions_total", "因超出容量被淘汰的缓存结果数");
+    Gauge& bytes = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_mcp_result_cache_bytes", "MCP工具结果缓存占用的字节数");
+};
+
+CacheMetrics& cacheMetrics() {
+    static CacheMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+ToolResultCache::ToolResultCache(size_t max_bytes) : max_bytes_(max_bytes) {
+}
+
+void ToolResultCache::setMaxBytes(size_t max_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    max_bytes_ = max_bytes;
+    evictLocked();
+}
+
+size_t ToolResultCache::maxBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_bytes_;
+}
+
+bool ToolResultCache::lookup(const std::string& key, std::string& result) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(key);
+    if (it == index_.end()) {
+        cacheMetrics().misses.inc();
+        return false;
+    }
+    if (it->second->expires <= Clock::now()) {
+        eraseLocked(it->second);
+        cacheMetrics().misses.inc();
+        return false;
+    }
+    lru_.splice(lru_.begin(), lru_, it->second);
+    result = it->second->result;
+    cacheMetrics().hits.inc();
+    return true;
+}
+
+void ToolResultCache::store(const std::string& key, const std::string& result, std::chrono::milliseconds ttl) {
+    size_t bytes = key.size() + result.size() + kEntryOverhead;
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 单个结果超过上限的一半时不缓存，避免一次写入冲掉所有热点条目
+    if (bytes > max_bytes_ / 2) {
+        return;
+    }
+    auto it = index_.find(key);
+    if (it != index_.end()) {
+        eraseLocked(it->second);
+    }
+    lru_.push_front(Entry{key, result, Clock::now() + ttl, bytes});
+    index_.emplace(lru_.front().key, lru_.begin());
+    bytes_ += bytes;
+    evictLocked();
+}
+
+void ToolResultCache::invalidatePrefix(const std::string& prefix) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        auto next = std::next(it);
+        if (it->key.compare(0, prefix.size(), prefix) == 0) {
+            eraseLocked(it);
+        }
+        it = next;
+    }
+}
+
+void ToolResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    lru_.clear();
+    bytes_ = 0;
+    cacheMetrics().bytes.set(0);
+}
+
+size_t ToolResultCache::bytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return bytes_;
+}
+
+size_t ToolResultCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+void ToolResultCache::eraseLocked(EntryList::iterator it) {
+    bytes_ -= it->bytes;
+    index_.erase(it->key);
+    lru_.erase(it);
+    cacheMetrics().bytes.set(static_cast<int64_t>(bytes_));
+}
+
+void ToolResultCache::evictLocked() {
+    // 从最久未使用的一端淘汰；过期条目在下次被查到时释放
+    while (bytes_ > max_bytes_ && !lru_.empty()) {
+        eraseLocked(std::prev(lru_.end()));
+        cacheMetrics().evictions.inc();
+    }
+    cacheMetrics().bytes.set(static_cast<int64_t>(bytes_));
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace xiaozhi {
+
+// 幂等工具的结果缓存：按键保存序列化后的结果，条目在TTL到期后失效，
+// 总字节数（键+结果+固定开销）超过上限时淘汰最久未使用的条目。可在任意线程调用
+class ToolResultCache {
+public:
+    explicit ToolResultCache(size_t max_bytes = 1024 * 1024);
+
+    // 修改上限，超出部分立即淘汰；0表示关闭缓存
+    void setMaxBytes(size_t max_bytes);
+    size_t maxBytes() const;
+
+    // 命中未过期的条目时复制结果并返回true
+    bool lookup(const std::string& key, std::string& result);
+    void store(const std::string& key, const std::string& result, std::chrono::milliseconds ttl);
+
+    // 删除键以prefix开头的全部条目，工具被替换或注销时调用
+    void invalidatePrefix(const std::string& prefix);
+    void clear();
+
+    size_t bytes() const;
+    size_t size() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Entry {
+        std::string key;
+        std::string result;
+        Clock::time_point expires;
+        size_t bytes;
+    };
+    using EntryList = std::list<Entry>;
+
+    void eraseLocked(EntryList::iterator it);
+    void evictLocked();
+
+    mutable std::mutex mutex_;
+    EntryList lru_;     // 队首为最近使用
+    // 键指向链表节点中的字符串，节点不移动，视图一直有效
+    std::unordered_map<std::string_view, EntryList::iterator> index_;
+    size_t bytes_ = 0;
+    size_t max_bytes_;
+};
+
+} // namespace xiaozhi
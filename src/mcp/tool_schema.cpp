@@ -0,0 +1,471 @@
+#include "tool_schema.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <json-c/json.h>
+
+namespace xiaozhi {
+
+namespace {
+
+// 校验失败时由内向外拼出路径：叶子写入": 原因"，每层在前面补上字段名或下标
+bool fail(std::string* error, const std::string& reason) {
+    if (error) {
+        *error = ": " + reason;
+    }
+    return false;
+}
+
+// 编译参数定义时的错误，path为出错参数的完整路径
+bool failAt(std::string* error, const std::string& path, const std::string& reason) {
+    if (error) {
+        *error = path + ": " + reason;
+    }
+    return false;
+}
+
+void prependPath(std::string* error, const std::string& segment) {
+    if (error) {
+        error->insert(0, segment);
+    }
+}
+
+void appendEscaped(std::string& out, const char* text, size_t length) {
+    static const char kHex[] = "0123456789abcdef";
+    out += '"';
+    for (size_t i = 0; i < length; ++i) {
+        unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += static_cast<char>(c);
+        } else if (c < 0x20) {
+            out += "\\u00";
+            out += kHex[c >> 4];
+            out += kHex[c & 0xf];
+        } else {
+            out += static_cast<char>(c);
+        }
+    }
+    out += '"';
+}
+
+void appendCanonical(std::string& out, json_object* value) {
+    switch (json_object_get_type(value)) {
+    case json_type_null:
+        out += "null";
+        break;
+    case json_type_boolean:
+        out += json_object_get_boolean(value) ? "true" : "false";
+        break;
+    case json_type_int:
+        out += std::to_string(json_object_get_int64(value));
+        break;
+    case json_type_double: {
+        double number = json_object_get_double(value);
+        if (std::isfinite(number) && number == std::floor(number) && std::fabs(number) < 9007199254740992.0) {
+            out += std::to_string(static_cast<int64_t>(number));
+        } else {
+            char buffer[32];
+            std::snprintf(buffer, sizeof(buffer), "%.17g", number);
+            out += buffer;
+        }
+        break;
+    }
+    case json_type_string:
+        appendEscaped(out, json_object_get_string(value), static_cast<size_t>(json_object_get_string_len(value)));
+        break;
+    case json_type_array: {
+        out += '[';
+        size_t length = json_object_array_length(value);
+        for (size_t i = 0; i < length; ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            appendCanonical(out, json_object_array_get_idx(value, i));
+        }
+        out += ']';
+        break;
+    }
+    case json_type_object: {
+        std::vector<std::pair<const char*, json_object*>> fields;
+        json_object_object_foreach(value, key, val) {
+            fields.emplace_back(key, val);
+        }
+        std::sort(fields.begin(), fields.end(), [](const auto& a, const auto& b) {
+            return std::strcmp(a.first, b.first) < 0;
+        });
+        out += '{';
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (i > 0) {
+                out += ',';
+            }
+            appendEscaped(out, fields[i].first, std::strlen(fields[i].first));
+            out += ':';
+            appendCanonical(out, fields[i].second);
+        }
+        out += '}';
+        break;
+    }
+    }
+}
+
+std::string formatBound(double value) {
+    std::string text = std::to_string(value);
+    // 去掉to_string补出的多余小数位
+    text.erase(text.find_last_not_of('0') + 1);
+    if (!text.empty() && text.back() == '.') {
+        text.pop_back();
+    }
+    return text;
+}
+
+} // namespace
+
+ToolValue ToolValue::adopt(json_object* value) {
+    ToolValue view(value);
+    if (value) {
+        view.owner_.reset(value, [](json_object* object) { json_object_put(object); });
+    }
+    return view;
+}
+
+ToolValue ToolValue::fromStringMap(const std::map<std::string, std::string>& arguments) {
+    json_object* object = json_object_new_object();
+    for (const auto& pair : arguments) {
+        json_object_object_add(object, pair.first.c_str(),
+                               json_object_new_string_len(pair.second.data(), static_cast<int>(pair.second.size())));
+    }
+    return adopt(object);
+}
+
+bool ToolValue::isString() const {
+    return value_ && json_object_is_type(value_, json_type_string);
+}
+
+bool ToolValue::isNumber() const {
+    return value_ && (json_object_is_type(value_, json_type_int) || json_object_is_type(value_, json_type_double));
+}
+
+bool ToolValue::isInteger() const {
+    if (!value_) {
+        return false;
+    }
+    if (json_object_is_type(value_, json_type_int)) {
+        return true;
+    }
+    // JSON中的3.0也是整数
+    if (json_object_is_type(value_, json_type_double)) {
+        double number = json_object_get_double(value_);
+        return std::isfinite(number) && number == std::floor(number);
+    }
+    return false;
+}
+
+bool ToolValue::isBool() const {
+    return value_ && json_object_is_type(value_, json_type_boolean);
+}
+
+bool ToolValue::isObject() const {
+    return value_ && json_object_is_type(value_, json_type_object);
+}
+
+bool ToolValue::isArray() const {
+    return value_ && json_object_is_type(value_, json_type_array);
+}
+
+bool ToolValue::has(const char* name) const {
+    return isObject() && json_object_object_get_ex(value_, name, nullptr);
+}
+
+ToolValue ToolValue::get(const char* name) const {
+    json_object* child = nullptr;
+    if (isObject() && json_object_object_get_ex(value_, name, &child)) {
+        return ToolValue(child);
+    }
+    return ToolValue();
+}
+
+ToolValue ToolValue::at(size_t index) const {
+    if (isArray() && index < json_object_array_length(value_)) {
+        return ToolValue(json_object_array_get_idx(value_, index));
+    }
+    return ToolValue();
+}
+
+size_t ToolValue::size() const {
+    if (isArray()) {
+        return json_object_array_length(value_);
+    }
+    if (isObject()) {
+        return static_cast<size_t>(json_object_object_length(value_));
+    }
+    return 0;
+}
+
+std::string_view ToolValue::asString(std::string_view fallback) const {
+    if (!isString()) {
+        return fallback;
+    }
+    return std::string_view(json_object_get_string(value_),
+                            static_cast<size_t>(json_object_get_string_len(value_)));
+}
+
+int64_t ToolValue::asInt(int64_t fallback) const {
+    if (value_ && json_object_is_type(value_, json_type_int)) {
+        return json_object_get_int64(value_);
+    }
+    if (value_ && json_object_is_type(value_, json_type_double)) {
+        return static_cast<int64_t>(json_object_get_double(value_));
+    }
+    return fallback;
+}
+
+double ToolValue::asDouble(double fallback) const {
+    if (value_ && json_object_is_type(value_, json_type_double)) {
+        return json_object_get_double(value_);
+    }
+    if (value_ && json_object_is_type(value_, json_type_int)) {
+        return static_cast<double>(json_object_get_int64(value_));
+    }
+    return fallback;
+}
+
+bool ToolValue::asBool(bool fallback) const {
+    if (isBool()) {
+        return json_object_get_boolean(value_) != 0;
+    }
+    return fallback;
+}
+
+std::map<std::string, std::string> ToolValue::toStringMap() const {
+    std::map<std::string, std::string> arguments;
+    if (!isObject()) {
+        return arguments;
+    }
+    json_object_object_foreach(value_, key, val) {
+        arguments[key] = val ? json_object_get_string(val) : "null";
+    }
+    return arguments;
+}
+
+std::string ToolValue::canonicalJson() const {
+    if (!value_) {
+        return "{}";
+    }
+    std::string out;
+    appendCanonical(out, value_);
+    return out;
+}
+
+std::shared_ptr<const ToolSchema> ToolSchema::compile(const std::vector<ToolParameter>& parameters,
+                                                      std::string* error) {
+    auto schema = std::make_shared<ToolSchema>();
+    schema->nodes_.emplace_back();
+    schema->nodes_[0].type = Type::OBJECT;
+    if (!schema->compileFields(0, parameters, "arguments", error)) {
+        return nullptr;
+    }
+    return schema;
+}
+
+bool ToolSchema::compileNode(const ToolParameter& parameter, const std::string& path, size_t& index,
+                             std::string* error) {
+    static const std::map<std::string, Type> kTypes = {
+        {"", Type::ANY}, {"string", Type::STRING}, {"number", Type::NUMBER}, {"integer", Type::INTEGER},
+        {"boolean", Type::BOOLEAN}, {"object", Type::OBJECT}, {"array", Type::ARRAY},
+    };
+    auto type = kTypes.find(parameter.type);
+    if (type == kTypes.end()) {
+        return failAt(error, path, "unknown type '" + parameter.type + "'");
+    }
+
+    Node node;
+    node.type = type->second;
+    node.required = parameter.required;
+    bool numeric = node.type == Type::NUMBER || node.type == Type::INTEGER;
+    if (!parameter.enum_values.empty() && node.type != Type::STRING) {
+        return failAt(error, path, "enum is only supported for string");
+    }
+    if ((parameter.minimum || parameter.maximum) && !numeric) {
+        return failAt(error, path, "minimum/maximum require number or integer");
+    }
+    if (parameter.minimum && parameter.maximum && *parameter.minimum > *parameter.maximum) {
+        return failAt(error, path, "minimum is greater than maximum");
+    }
+    if (!parameter.properties.empty() && node.type != Type::OBJECT) {
+        return failAt(error, path, "properties require object");
+    }
+    if (!parameter.items.empty() && (node.type != Type::ARRAY || parameter.items.size() > 1)) {
+        return failAt(error, path, "items require array and at most one element type");
+    }
+    node.enum_values = parameter.enum_values;
+    std::sort(node.enum_values.begin(), node.enum_values.end());
+    node.minimum = parameter.minimum;
+    node.maximum = parameter.maximum;
+
+    // 子节点编译时nodes_会扩容，先占位再回填
+    index = nodes_.size();
+    nodes_.push_back(std::move(node));
+    if (nodes_[index].type == Type::OBJECT) {
+        if (!compileFields(index, parameter.properties, path, error)) {
+            return false;
+        }
+    }
+    if (!parameter.items.empty()) {
+        size_t items = kNoNode;
+        if (!compileNode(parameter.items.front(), path + "[]", items, error)) {
+            return false;
+        }
+        nodes_[index].items = items;
+    }
+    return true;
+}
+
+bool ToolSchema::compileFields(size_t index, const std::vector<ToolParameter>& fields,
+                               const std::string& path, std::string* error) {
+    std::vector<std::pair<std::string, size_t>> compiled;
+    size_t required_count = 0;
+    for (const auto& field : fields) {
+        std::string field_path = path + "." + field.name;
+        if (field.name.empty()) {
+            return failAt(error, path, "empty field name");
+        }
+        for (const auto& existing : compiled) {
+            if (existing.first == field.name) {
+                return failAt(error, field_path, "duplicate field");
+            }
+        }
+        size_t child = kNoNode;
+        if (!compileNode(field, field_path, child, error)) {
+            return false;
+        }
+        compiled.emplace_back(field.name, child);
+        if (field.required) {
+            ++required_count;
+        }
+    }
+    std::sort(compiled.begin(), compiled.end());
+    nodes_[index].fields = std::move(compiled);
+    nodes_[index].required_count = required_count;
+    return true;
+}
+
+bool ToolSchema::validate(const ToolValue& arguments, std::string* error) const {
+    json_object* value = arguments.raw();
+    bool valid = value ? validateNode(0, value, error) : validateObject(nodes_[0], nullptr, error);
+    if (!valid) {
+        prependPath(error, "arguments");
+    }
+    return valid;
+}
+
+bool ToolSchema::validateNode(size_t index, json_object* value, std::string* error) const {
+    const Node& node = nodes_[index];
+    switch (node.type) {
+    case Type::ANY:
+        return true;
+
+    case Type::STRING: {
+        if (!value || !json_object_is_type(value, json_type_string)) {
+            return fail(error, "expected string");
+        }
+        if (!node.enum_values.empty()) {
+            std::string_view text(json_object_get_string(value),
+                                  static_cast<size_t>(json_object_get_string_len(value)));
+            auto it = std::lower_bound(node.enum_values.begin(), node.enum_values.end(), text,
+                                       [](const std::string& candidate, std::string_view target) {
+                                           return std::string_view(candidate) < target;
+                                       });
+            if (it == node.enum_values.end() || std::string_view(*it) != text) {
+                return fail(error, "value is not one of the allowed values");
+            }
+        }
+        return true;
+    }
+
+    case Type::NUMBER:
+    case Type::INTEGER: {
+        ToolValue number(value);
+        if (node.type == Type::INTEGER ? !number.isInteger() : !number.isNumber()) {
+            return fail(error, node.type == Type::INTEGER ? "expected integer" : "expected number");
+        }
+        double actual = number.asDouble();
+        if (node.minimum && actual < *node.minimum) {
+            return fail(error, "must be >= " + formatBound(*node.minimum));
+        }
+        if (node.maximum && actual > *node.maximum) {
+            return fail(error, "must be <= " + formatBound(*node.maximum));
+        }
+        return true;
+    }
+
+    case Type::BOOLEAN:
+        if (!value || !json_object_is_type(value, json_type_boolean)) {
+            return fail(error, "expected boolean");
+        }
+        return true;
+
+    case Type::OBJECT:
+        if (!value || !json_object_is_type(value, json_type_object)) {
+            return fail(error, "expected object");
+        }
+        return validateObject(node, value, error);
+
+    case Type::ARRAY: {
+        if (!value || !json_object_is_type(value, json_type_array)) {
+            return fail(error, "expected array");
+        }
+        if (node.items == kNoNode) {
+            return true;
+        }
+        size_t length = json_object_array_length(value);
+        for (size_t i = 0; i < length; ++i) {
+            if (!validateNode(node.items, json_object_array_get_idx(value, i), error)) {
+                prependPath(error, "[" + std::to_string(i) + "]");
+                return false;
+            }
+        }
+        return true;
+    }
+    }
+    return true;
+}
+
+bool ToolSchema::validateObject(const Node& node, json_object* value, std::string* error) const {
+    // 每个传入字段二分查找一次；未声明的字段按JSON Schema默认规则放行
+    size_t required_seen = 0;
+    if (value) {
+        json_object_object_foreach(value, key, child) {
+            std::string_view name(key);
+            auto it = std::lower_bound(node.fields.begin(), node.fields.end(), name,
+                                       [](const std::pair<std::string, size_t>& field, std::string_view target) {
+                                           return std::string_view(field.first) < target;
+                                       });
+            if (it == node.fields.end() || std::string_view(it->first) != name) {
+                continue;
+            }
+            if (!validateNode(it->second, child, error)) {
+                prependPath(error, "." + it->first);
+                return false;
+            }
+            if (nodes_[it->second].required) {
+                ++required_seen;
+            }
+        }
+    }
+
+    if (required_seen < node.required_count) {
+        for (const auto& field : node.fields) {
+            if (nodes_[field.second].required &&
+                !(value && json_object_object_get_ex(value, field.first.c_str(), nullptr))) {
+                fail(error, "missing required field");
+                prependPath(error, "." + field.first);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace xiaozhi
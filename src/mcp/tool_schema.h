@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <map>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <cstdint>
+
+struct json_object;
+
+namespace xiaozhi {
+
+struct ToolParameter {
+    std::string name;
+    std::string type;  // "string", "number", "integer", "boolean", "object", "array"，为空时不限类型
+    std::string description;
+    bool required = false;
+    std::vector<std::string> enum_values;   // string的可选值，为空时不限
+    std::optional<double> minimum;          // number/integer的取值范围（闭区间）
+    std::optional<double> maximum;
+    std::vector<ToolParameter> properties;  // object的字段
+    std::vector<ToolParameter> items;       // array的元素类型，最多一个，为空时不限
+};
+
+// 工具参数的只读视图，直接引用解析后的JSON，不做拷贝和字符串转换。
+// 通过adopt得到的视图（及其副本）持有整棵参数树；get/at返回的子视图只是借用，
+// 不能比持有者活得更久。类型不符或字段不存在时取值函数返回fallback
+class ToolValue {
+public:
+    ToolValue() = default;
+    explicit ToolValue(json_object* value) : value_(value) {}
+
+    // 接管value的一个引用，最后一个副本销毁时释放
+    static ToolValue adopt(json_object* value);
+    // 旧接口的字符串参数，每个字段都是string
+    static ToolValue fromStringMap(const std::map<std::string, std::string>& arguments);
+
+    bool exists() const { return value_ != nullptr; }
+    bool isString() const;
+    bool isNumber() const;      // 整数或浮点数
+    bool isInteger() const;
+    bool isBool() const;
+    bool isObject() const;
+    bool isArray() const;
+
+    bool has(const char* name) const;
+    ToolValue get(const char* name) const;
+    ToolValue at(size_t index) const;
+    size_t size() const;        // 数组元素数或对象字段数
+
+    // 字符串直接指向JSON内部的缓冲，生命周期同视图
+    std::string_view asString(std::string_view fallback = std::string_view()) const;
+    int64_t asInt(int64_t fallback = 0) const;
+    double asDouble(double fallback = 0.0) const;
+    bool asBool(bool fallback = false) const;
+
+    // 旧版处理函数使用的字符串表示，只展开顶层字段
+    std::map<std::string, std::string> toStringMap() const;
+
+    // 规范化的JSON文本：对象字段按名字排序、无空白，整数值的浮点数写成整数，
+    // 语义相同的参数得到相同的文本，用作结果缓存的键。不存在的值写作{}
+    std::string canonicalJson() const;
+
+    json_object* raw() const { return value_; }
+
+private:
+    json_object* value_ = nullptr;
+    std::shared_ptr<json_object> owner_;
+};
+
+// 注册时由参数定义编译出的校验器：字段按名字排序存放，校验时对每个传入字段
+// 做一次二分查找，不分配内存，整体为O(字段数)；必填字段通过计数检查，
+// 只有缺失时才回头查找缺的是哪一个
+class ToolSchema {
+public:
+    // 参数定义有误（未知类型、enum用于非string、范围颠倒等）时返回nullptr并写入error
+    static std::shared_ptr<const ToolSchema> compile(const std::vector<ToolParameter>& parameters,
+                                                     std::string* error = nullptr);
+
+    // 校验顶层参数对象，不存在的参数对象视为空对象。
+    // 失败时error形如"arguments.items[2].volume: expected integer"
+    bool validate(const ToolValue& arguments, std::string* error = nullptr) const;
+
+private:
+    enum class Type { ANY, STRING, NUMBER, INTEGER, BOOLEAN, OBJECT, ARRAY };
+
+    static constexpr size_t kNoNode = static_cast<size_t>(-1);
+
+    struct Node {
+        Type type = Type::ANY;
+        bool required = false;                  // 作为父对象字段时是否必填
+        std::vector<std::string> enum_values;   // 已排序
+        std::optional<double> minimum;
+        std::optional<double> maximum;
+        // object：按名字排序的字段及其节点下标、必填字段数
+        std::vector<std::pair<std::string, size_t>> fields;
+        size_t required_count = 0;
+        // array：元素节点下标，无约束时为kNoNode
+        size_t items = kNoNode;
+    };
+
+    bool compileNode(const ToolParameter& parameter, const std::string& path, size_t& index, std::string* error);
+    bool compileFields(size_t index, const std::vector<ToolParameter>& fields,
+                       const std::string& path, std::string* error);
+    bool validateNode(size_t index, json_object* value, std::string* error) const;
+    bool validateObject(const Node& node, json_object* value, std::string* error) const;
+
+    std::vector<Node> nodes_;   // nodes_[0]为顶层参数对象
+};
+
+} // namespace xiaozhi
@@ -1,20 +1,15 @@
 #include "mqtt_client.h"
 #include <iostream>
-#include <thread>
-#include <chrono>
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
-MqttClient::MqttClient() : connected_(false), should_stop_(false) {
+MqttClient::MqttClient() {
     std::cout << "[MqttClient] 初始化MQTT客户端" << std::endl;
 }
 
 MqttClient::~MqttClient() {
     disconnect();
-    should_stop_ = true;
-    if (client_thread_.joinable()) {
-        client_thread_.join();
-    }
     std::cout << "[MqttClient] MQTT客户端已销毁" << std::endl;
 }
 
@@ -24,11 +19,6 @@ bool MqttClient::connect(const std::string& broker_url, const std::string& clien
     
     std::cout << "[MqttClient] 正在连接到MQTT代理: " << broker_url << std::endl;
     
-    // 启动客户端线程
-    if (!client_thread_.joinable()) {
-        client_thread_ = std::thread(&MqttClient::clientLoop, this);
-    }
-    
     // 模拟连接成功
     connected_ = true;
     
@@ -61,8 +51,8 @@ bool MqttClient::publish(const std::string& topic, const std::string& message) {
         return false;
     }
 
-    std::cout << "[MqttClient] 发布消息到主题 '" << topic << "': " << message.substr(0, 50) 
-              << (message.length() > 50 ? "..." : "") << std::endl;
+    LOG_DEBUG("[MqttClient] 发布消息到主题 '{}': {}{}", topic, message.substr(0, 50),
+              message.length() > 50 ? "..." : "");
     
     return true;
 }
@@ -79,10 +69,6 @@ bool MqttClient::subscribe(const std::string& topic) {
     return true;
 }
 
-void MqttClient::process() {
-    // 处理MQTT相关任务
-}
-
 void MqttClient::setMessageCallback(std::function<void(const std::string&, const std::string&)> callback) {
     message_callback_ = callback;
 }
@@ -91,17 +77,4 @@ void MqttClient::setConnectionStatusCallback(std::function<void(bool connected)>
     connection_status_callback_ = callback;
 }
 
-void MqttClient::clientLoop() {
-    // 模拟客户端主循环
-    while (!should_stop_) {
-        if (connected_) {
-            // 模拟接收消息
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        } else {
-            // 如果断开连接，等待一段时间再尝试
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
-        }
-    }
-}
-
 } // namespace xiaozhi
\ No newline at end of file
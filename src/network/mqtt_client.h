@@ -1,7 +1,6 @@
 #pragma once
 
 #include <string>
-#include <thread>
 #include <mutex>
 #include <atomic>
 #include <functional>
@@ -23,15 +22,12 @@ public:
     bool publish(const std::string& topic, const std::string& message);
     bool subscribe(const std::string& topic);
 
-    void process();
-
     // 设置回调
     void setMessageCallback(std::function<void(const std::string&, const std::string&)> callback);
     void setConnectionStatusCallback(std::function<void(bool connected)> callback);
 
 private:
     std::atomic<bool> connected_{false};
-    std::atomic<bool> should_stop_{false};
 
     std::string broker_url_;
     std::string client_id_;
@@ -41,10 +37,7 @@ private:
     
     std::set<std::string> subscriptions_;
 
-    std::thread client_thread_;
     std::mutex socket_mutex_;
-
-    void clientLoop();
 };
 
 } // namespace xiaozhi
\ No newline at end of file
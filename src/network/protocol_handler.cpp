@@ -1,6 +1,7 @@
 #include "protocol_handler.h"
 #include <iostream>
 #include <json-c/json.h>
+#include "utils/logger.h"
 
 namespace xiaozhi {
 
@@ -16,7 +17,7 @@ std::string ProtocolHandler::handleWebSocketMessage(const std::string& message)
     // 解析WebSocket消息
     json_object* jobj = json_tokener_parse(message.c_str());
     if (!jobj) {
-        std::cerr << "[ProtocolHandler] 错误: 无法解析JSON消息" << std::endl;
+        LOG_EVERY_MS(ERROR, 1000, "[ProtocolHandler] 错误: 无法解析JSON消息");
         return createErrorMessage("Invalid JSON");
     }
 
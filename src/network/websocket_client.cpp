@@ -1,50 +1,221 @@
 #include "websocket_client.h"
 #include <iostream>
 #include <chrono>
-#include <thread>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include "utils/trace.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
+#include "utils/event_loop.h"
+#include "utils/event_loop_pool.h"
+#include "utils/async.h"
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
 
 namespace xiaozhi {
 
-WebsocketClient::WebsocketClient() {
+namespace {
+
+constexpr int kConnectTimeoutMs = 10000;
+constexpr int kIoTimeoutMs = 5000;
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+// Host头：IPv6字面量加方括号，端口为协议默认值时省略
+std::string hostHeader(const std::string& host, const std::string& port, bool secure) {
+    std::string value = host.find(':') != std::string::npos ? "[" + host + "]" : host;
+    if (port != (secure ? "443" : "80")) {
+        value += ":" + port;
+    }
+    return value;
+}
+
+struct WsMetrics {
+    Counter& sent_bytes = MetricsRegistry::getInstance().counter(
+        "xiaozhi_ws_sent_bytes_total", "WebSocket发送字节数（含帧头）");
+    Counter& received_bytes = MetricsRegistry::getInstance().counter(
+        "xiaozhi_ws_received_bytes_total", "WebSocket接收字节数（含帧头）");
+    Counter& reconnects = MetricsRegistry::getInstance().counter(
+        "xiaozhi_ws_reconnects_total", "首次连接之后的重新连接次数");
+    Counter& connection_lost = MetricsRegistry::getInstance().counter(
+        "xiaozhi_ws_connection_lost_total", "连接异常断开次数");
+    Gauge& connected = MetricsRegistry::getInstance().gauge(
+        "xiaozhi_ws_connected", "WebSocket当前是否已连接");
+};
+
+WsMetrics& wsMetrics() {
+    static WsMetrics metrics;
+    return metrics;
+}
+
+} // namespace
+
+WebsocketClient::WebsocketClient()
+    : loop_(nullptr), fd_(-1), cancel_fd_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)),
+      ssl_ctx_(nullptr), ssl_(nullptr), message_opcode_(WsOpcode::TEXT) {
     std::cout << "[WebsocketClient] 初始化WebSocket客户端" << std::endl;
 }
 
 WebsocketClient::~WebsocketClient() {
     disconnect();
-    should_stop_ = true;
-    if (client_thread_.joinable()) {
-        client_thread_.join();
+    // socket已从循环中移除，等待可能正在执行的onReadable结束
+    if (loop_) {
+        loop_->drain();
+    }
+    if (cancel_fd_ >= 0) {
+        close(cancel_fd_);
     }
     std::cout << "[WebsocketClient] WebSocket客户端已销毁" << std::endl;
 }
 
 bool WebsocketClient::connect(const std::string& url) {
+    if (connected_) {
+        return true;
+    }
+    if (connecting_) {
+        std::cerr << "[WebsocketClient] 错误: 已有进行中的连接尝试" << std::endl;
+        return false;
+    }
+    connect_cancelled_ = false;
+    return openConnection(url) && finishConnect();
+}
+
+Async<bool> WebsocketClient::connectAsync(const std::string& url) {
+    if (!loop_) {
+        loop_ = EventLoopPool::getInstance().next();
+    }
+    AsyncPromise<bool> promise(loop_);
+    if (connected_) {
+        promise.resolve(true);
+        return promise.async();
+    }
+    if (connecting_.exchange(true)) {
+        std::cerr << "[WebsocketClient] 错误: 已有进行中的连接尝试" << std::endl;
+        promise.resolve(false);
+        return promise.async();
+    }
+
+    // 上一次尝试的线程已把结果交给事件循环，这里只是回收
+    if (connect_thread_.joinable()) {
+        connect_thread_.join();
+    }
+    connect_cancelled_ = false;
+
+    connect_thread_ = std::thread([this, url, promise]() {
+        TRACE_THREAD_NAME("ws-connect");
+        bool opened = openConnection(url);
+        loop_->post([this, opened, promise]() {
+            // disconnect已中止本次尝试时由它关闭socket
+            bool ok = opened && !connect_cancelled_ && finishConnect();
+            connecting_ = false;
+            promise.resolve(ok);
+        });
+    });
+    return promise.async();
+}
+
+bool WebsocketClient::openConnection(const std::string& url) {
     server_url_ = url;
-    
-    // 模拟连接过程
+
     std::cout << "[WebsocketClient] 正在连接到服务器: " << url << std::endl;
-    
-    // 启动客户端线程
-    if (!client_thread_.joinable()) {
-        client_thread_ = std::thread(&WebsocketClient::clientLoop, this);
-    }
-    
-    // 模拟连接成功
-    connected_ = true;
-    
+
+    bool secure = false;
+    std::string host, port, path;
+    if (!parseUrl(url, secure, host, port, path)) {
+        std::cerr << "[WebsocketClient] 错误: 无效的WebSocket地址: " << url << std::endl;
+        return false;
+    }
+
+    if (!loop_) {
+        loop_ = EventLoopPool::getInstance().next();
+    }
+
+    std::lock_guard<std::mutex> lock(socket_mutex_);
+    if (!openSocket(host, port) ||
+        (secure && !startTls(host)) ||
+        !performHandshake(hostHeader(host, port, secure), path)) {
+        closeSocket();
+        return false;
+    }
+    return true;
+}
+
+bool WebsocketClient::finishConnect() {
+    {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        connected_ = true;
+        // 可读时由事件循环回调，空闲连接不产生任何唤醒
+        if (!loop_->addFd(fd_, EPOLLIN, [this](uint32_t) { onReadable(); })) {
+            connected_ = false;
+            closeSocket();
+            return false;
+        }
+    }
+
+    if (ever_connected_.exchange(true)) {
+        wsMetrics().reconnects.inc();
+    }
+    wsMetrics().connected.set(1);
+
     if (connection_status_callback_) {
         connection_status_callback_(true);
     }
-    
+
     std::cout << "[WebsocketClient] 已连接到服务器" << std::endl;
     return true;
 }
 
+void WebsocketClient::cancelConnect() {
+    if (!connect_thread_.joinable()) {
+        return;
+    }
+    connect_cancelled_ = true;
+    uint64_t one = 1;
+    ssize_t written = write(cancel_fd_, &one, sizeof(one));
+    (void)written;
+    connect_thread_.join();
+    uint64_t pending;
+    while (read(cancel_fd_, &pending, sizeof(pending)) > 0) {
+    }
+
+    // 握手已完成但结果尚未交给事件循环时，socket在这里关闭
+    if (!connected_) {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        closeSocket();
+    }
+}
+
 void WebsocketClient::disconnect() {
-    if (connected_) {
-        connected_ = false;
+    cancelConnect();
+    if (connected_.exchange(false)) {
         std::cout << "[WebsocketClient] 断开服务器连接" << std::endl;
-        
+
+        {
+            std::lock_guard<std::mutex> lock(socket_mutex_);
+            if (fd_ >= 0) {
+                send_buffer_.clear();
+                uint8_t status[2] = {0x03, 0xe8};  // 1000 正常关闭
+                WebsocketFrameCodec::encode(WsOpcode::CLOSE, status, sizeof(status), true, send_buffer_);
+                writeAll(send_buffer_.data(), send_buffer_.size());
+            }
+            closeSocket();
+        }
+        wsMetrics().connected.set(0);
+
         if (connection_status_callback_) {
             connection_status_callback_(false);
         }
@@ -55,34 +226,48 @@ bool WebsocketClient::isConnected() const {
     return connected_;
 }
 
+void WebsocketClient::setEventLoop(EventLoop* loop) {
+    if (connected_ || connecting_) {
+        std::cerr << "[WebsocketClient] 错误: 连接建立后不能更换事件循环" << std::endl;
+        return;
+    }
+    loop_ = loop;
+}
+
+void WebsocketClient::setHeader(const std::string& name, const std::string& value) {
+    for (auto& header : headers_) {
+        if (toLower(header.first) == toLower(name)) {
+            header.second = value;
+            return;
+        }
+    }
+    headers_.emplace_back(name, value);
+}
+
 bool WebsocketClient::sendText(const std::string& message) {
     if (!connected_) {
-        std::cerr << "[WebsocketClient] 错误: 未连接到服务器" << std::endl;
+        LOG_EVERY_MS(ERROR, 1000, "[WebsocketClient] 错误: 未连接到服务器");
         return false;
     }
 
-    // 在实际实现中，这里会通过WebSocket发送文本消息
-    std::cout << "[WebsocketClient] 发送文本消息: " << message.substr(0, 50) 
-              << (message.length() > 50 ? "..." : "") << std::endl;
-    
-    return true;
+    LOG_DEBUG("[WebsocketClient] 发送文本消息: {}{}", message.substr(0, 50), message.length() > 50 ? "..." : "");
+
+    return sendFrame(WsOpcode::TEXT, reinterpret_cast<const uint8_t*>(message.data()), message.size());
 }
 
 bool WebsocketClient::sendBinary(const std::vector<uint8_t>& data) {
+    return sendBinary(data.data(), data.size());
+}
+
+bool WebsocketClient::sendBinary(const uint8_t* data, size_t length) {
     if (!connected_) {
-        std::cerr << "[WebsocketClient] 错误: 未连接到服务器" << std::endl;
+        // 断线期间每个音频包都会走到这里，限流输出
+        LOG_EVERY_MS(ERROR, 1000, "[WebsocketClient] 错误: 未连接到服务器，丢弃音频包");
         return false;
     }
 
-    // 在实际实现中，这里会通过WebSocket发送二进制数据
-    std::cout << "[WebsocketClient] 发送二进制数据，大小: " << data.size() << " 字节" << std::endl;
-    
-    return true;
-}
-
-void WebsocketClient::process() {
-    // 处理网络相关任务
-    // 在实际实现中，这里会处理网络事件和消息
+    // 音频帧每秒数十个，不逐帧打印日志
+    return sendFrame(WsOpcode::BINARY, data, length);
 }
 
 void WebsocketClient::setTextMessageCallback(std::function<void(const std::string&)> callback) {
@@ -97,20 +282,431 @@ void WebsocketClient::setConnectionStatusCallback(std::function<void(bool connec
     connection_status_callback_ = callback;
 }
 
-void WebsocketClient::clientLoop() {
-    // 模拟客户端主循环
-    while (!should_stop_) {
-        if (connected_) {
-            // 模拟接收消息
-            // 在实际实现中，这里会从WebSocket连接接收消息
-            
-            // 模拟一些网络活动
-            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+void WebsocketClient::onReadable() {
+    bool lost = false;
+    {
+        TRACE_SCOPE("network", "ws.recv");
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        if (fd_ < 0) {
+            return;
+        }
+        // TLS可能在内部缓存了多条记录，读到无数据为止
+        while (true) {
+            long n = readSome(read_buffer_, sizeof(read_buffer_));
+            if (n > 0) {
+                wsMetrics().received_bytes.inc(static_cast<uint64_t>(n));
+                codec_.feed(read_buffer_, static_cast<size_t>(n));
+            } else {
+                lost = n < 0;
+                break;
+            }
+        }
+    }
+
+    // 回调在锁外执行，允许回调中直接发送消息
+    while (codec_.next(frame_)) {
+        TRACE_SCOPE("network", "ws.dispatch");
+        if (!dispatchFrame(frame_)) {
+            lost = true;
+            break;
+        }
+    }
+
+    if (codec_.hasError()) {
+        std::cerr << "[WebsocketClient] 错误: 收到无效的WebSocket帧" << std::endl;
+        lost = true;
+    }
+
+    if (lost) {
+        handleConnectionLost();
+    }
+}
+
+bool WebsocketClient::parseUrl(const std::string& url, bool& secure, std::string& host,
+                               std::string& port, std::string& path) {
+    std::string rest;
+    if (url.compare(0, 6, "wss://") == 0) {
+        secure = true;
+        rest = url.substr(6);
+    } else if (url.compare(0, 5, "ws://") == 0) {
+        secure = false;
+        rest = url.substr(5);
+    } else {
+        return false;
+    }
+
+    size_t slash = rest.find('/');
+    std::string authority = rest.substr(0, slash);
+    path = slash == std::string::npos ? "/" : rest.substr(slash);
+
+    if (!authority.empty() && authority[0] == '[') {
+        // IPv6地址: [::1]:8080
+        size_t close = authority.find(']');
+        if (close == std::string::npos) {
+            return false;
+        }
+        host = authority.substr(1, close - 1);
+        port = close + 2 <= authority.size() && authority[close + 1] == ':' ? authority.substr(close + 2) : "";
+    } else {
+        size_t colon = authority.rfind(':');
+        host = authority.substr(0, colon);
+        port = colon == std::string::npos ? "" : authority.substr(colon + 1);
+    }
+
+    if (port.empty()) {
+        port = secure ? "443" : "80";
+    }
+    return !host.empty();
+}
+
+bool WebsocketClient::openSocket(const std::string& host, const std::string& port) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    addrinfo* result = nullptr;
+    int err = getaddrinfo(host.c_str(), port.c_str(), &hints, &result);
+    if (err != 0) {
+        std::cerr << "[WebsocketClient] 错误: 无法解析地址 " << host << ": " << gai_strerror(err) << std::endl;
+        return false;
+    }
+    if (connect_cancelled_) {
+        freeaddrinfo(result);
+        return false;
+    }
+
+    for (addrinfo* ai = result; ai; ai = ai->ai_next) {
+        int fd = socket(ai->ai_family, ai->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        if (::connect(fd, ai->ai_addr, ai->ai_addrlen) != 0 && errno != EINPROGRESS) {
+            close(fd);
+            continue;
+        }
+
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        if (!waitFd(fd, POLLOUT, kConnectTimeoutMs) ||
+            getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len) != 0 || so_error != 0) {
+            close(fd);
+            continue;
+        }
+
+        // 音频帧小而频繁，关闭Nagle算法避免攒包延迟
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        fd_ = fd;
+        break;
+    }
+    freeaddrinfo(result);
+
+    if (fd_ < 0) {
+        std::cerr << "[WebsocketClient] 错误: 无法连接到 " << host << ":" << port << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool WebsocketClient::startTls(const std::string& host) {
+    ssl_ctx_ = SSL_CTX_new(TLS_client_method());
+    if (!ssl_ctx_) {
+        return false;
+    }
+    SSL_CTX_set_default_verify_paths(ssl_ctx_);
+    SSL_CTX_set_verify(ssl_ctx_, SSL_VERIFY_PEER, nullptr);
+
+    ssl_ = SSL_new(ssl_ctx_);
+    if (!ssl_) {
+        return false;
+    }
+    SSL_set_fd(ssl_, fd_);
+    SSL_set_tlsext_host_name(ssl_, host.c_str());
+    SSL_set1_host(ssl_, host.c_str());
+
+    while (true) {
+        int ret = SSL_connect(ssl_);
+        if (ret == 1) {
+            return true;
+        }
+
+        int err = SSL_get_error(ssl_, ret);
+        if ((err == SSL_ERROR_WANT_READ && waitSocket(POLLIN, kConnectTimeoutMs)) ||
+            (err == SSL_ERROR_WANT_WRITE && waitSocket(POLLOUT, kConnectTimeoutMs))) {
+            continue;
+        }
+        if (connect_cancelled_) {
+            return false;
+        }
+
+        char reason[256];
+        ERR_error_string_n(ERR_get_error(), reason, sizeof(reason));
+        std::cerr << "[WebsocketClient] 错误: TLS握手失败: " << reason << std::endl;
+        return false;
+    }
+}
+
+bool WebsocketClient::performHandshake(const std::string& host_header, const std::string& path) {
+    std::string key = WebsocketFrameCodec::generateKey();
+    std::string request = "GET " + path + " HTTP/1.1\r\n"
+                          "Host: " + host_header + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n";
+    for (const auto& header : headers_) {
+        request += header.first + ": " + header.second + "\r\n";
+    }
+    request += "\r\n";
+
+    if (!writeAll(reinterpret_cast<const uint8_t*>(request.data()), request.size())) {
+        std::cerr << "[WebsocketClient] 错误: 发送握手请求失败" << std::endl;
+        return false;
+    }
+
+    std::string response;
+    uint8_t buffer[1024];
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kConnectTimeoutMs);
+    size_t header_end = std::string::npos;
+    while (header_end == std::string::npos) {
+        if (connect_cancelled_) {
+            return false;
+        }
+        int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        if (remaining <= 0 || response.size() > 16384) {
+            std::cerr << "[WebsocketClient] 错误: 等待握手响应超时" << std::endl;
+            return false;
+        }
+
+        long n = readSome(buffer, sizeof(buffer));
+        if (n < 0) {
+            std::cerr << "[WebsocketClient] 错误: 握手期间连接被关闭" << std::endl;
+            return false;
+        }
+        if (n == 0) {
+            waitSocket(POLLIN, remaining);
+            continue;
+        }
+        response.append(reinterpret_cast<const char*>(buffer), static_cast<size_t>(n));
+        header_end = response.find("\r\n\r\n");
+    }
+
+    std::string headers = toLower(response.substr(0, header_end));
+    if (headers.compare(0, 12, "http/1.1 101") != 0) {
+        std::cerr << "[WebsocketClient] 错误: 服务器拒绝升级: "
+                  << response.substr(0, response.find("\r\n")) << std::endl;
+        return false;
+    }
+
+    // Accept值区分大小写，从原始响应中按小写副本的位置截取
+    size_t accept_pos = headers.find("sec-websocket-accept:");
+    if (accept_pos == std::string::npos) {
+        std::cerr << "[WebsocketClient] 错误: 握手响应缺少Sec-WebSocket-Accept" << std::endl;
+        return false;
+    }
+    size_t value_start = response.find_first_not_of(" \t", accept_pos + 21);
+    size_t value_end = response.find("\r\n", value_start);
+    std::string accept = response.substr(value_start, value_end - value_start);
+    if (accept != WebsocketFrameCodec::computeAcceptKey(key)) {
+        std::cerr << "[WebsocketClient] 错误: Sec-WebSocket-Accept校验失败" << std::endl;
+        return false;
+    }
+
+    // 服务器可能紧跟握手响应发送了首帧
+    codec_.reset();
+    message_buffer_.clear();
+    if (response.size() > header_end + 4) {
+        codec_.feed(reinterpret_cast<const uint8_t*>(response.data()) + header_end + 4,
+                    response.size() - header_end - 4);
+    }
+    return true;
+}
+
+bool WebsocketClient::waitSocket(short events, int timeout_ms) {
+    if (fd_ < 0) {
+        return false;
+    }
+    return waitFd(fd_, events, timeout_ms);
+}
+
+bool WebsocketClient::waitFd(int fd, short events, int timeout_ms) {
+    pollfd pfds[2] = {{fd, events, 0}, {cancel_fd_, POLLIN, 0}};
+    int ready;
+    do {
+        ready = poll(pfds, cancel_fd_ >= 0 ? 2 : 1, timeout_ms);
+    } while (ready < 0 && errno == EINTR);
+    return ready > 0 && pfds[1].revents == 0 && pfds[0].revents != 0;
+}
+
+bool WebsocketClient::writeAll(const uint8_t* data, size_t length) {
+    size_t offset = 0;
+    while (offset < length) {
+        if (fd_ < 0) {
+            return false;
+        }
+
+        if (ssl_) {
+            int n = SSL_write(ssl_, data + offset, static_cast<int>(length - offset));
+            if (n > 0) {
+                offset += static_cast<size_t>(n);
+                continue;
+            }
+            int err = SSL_get_error(ssl_, n);
+            if ((err == SSL_ERROR_WANT_WRITE && waitSocket(POLLOUT, kIoTimeoutMs)) ||
+                (err == SSL_ERROR_WANT_READ && waitSocket(POLLIN, kIoTimeoutMs))) {
+                continue;
+            }
+            return false;
+        }
+
+        ssize_t n = ::send(fd_, data + offset, length - offset, MSG_NOSIGNAL);
+        if (n > 0) {
+            offset += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!waitSocket(POLLOUT, kIoTimeoutMs)) {
+                return false;
+            }
         } else {
-            // 如果断开连接，等待一段时间再尝试
-            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            return false;
         }
     }
+    return true;
+}
+
+long WebsocketClient::readSome(uint8_t* buffer, size_t length) {
+    if (fd_ < 0) {
+        return -1;
+    }
+
+    if (ssl_) {
+        int n = SSL_read(ssl_, buffer, static_cast<int>(length));
+        if (n > 0) {
+            return n;
+        }
+        int err = SSL_get_error(ssl_, n);
+        return (err == SSL_ERROR_WANT_READ || err == SSL_ERROR_WANT_WRITE) ? 0 : -1;
+    }
+
+    ssize_t n = ::recv(fd_, buffer, length, 0);
+    if (n > 0) {
+        return static_cast<long>(n);
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return 0;
+    }
+    return -1;
+}
+
+bool WebsocketClient::sendFrame(WsOpcode opcode, const uint8_t* data, size_t length) {
+    TRACE_SCOPE("network", "ws.send");
+    bool ok;
+    size_t wire_bytes;
+    {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        send_buffer_.clear();
+        WebsocketFrameCodec::encode(opcode, data, length, true, send_buffer_);
+        wire_bytes = send_buffer_.size();
+        ok = writeAll(send_buffer_.data(), wire_bytes);
+    }
+    if (ok) {
+        wsMetrics().sent_bytes.inc(wire_bytes);
+    }
+
+    if (!ok) {
+        std::cerr << "[WebsocketClient] 错误: 发送失败" << std::endl;
+        handleConnectionLost();
+    }
+    return ok;
+}
+
+bool WebsocketClient::dispatchFrame(WsFrame& frame) {
+    switch (frame.opcode) {
+        case WsOpcode::PING:
+            sendFrame(WsOpcode::PONG, frame.payload.data(), frame.payload.size());
+            return true;
+        case WsOpcode::PONG:
+            return true;
+        case WsOpcode::CLOSE:
+            return false;
+        case WsOpcode::TEXT:
+        case WsOpcode::BINARY:
+            message_opcode_ = frame.opcode;
+            if (!frame.fin) {
+                message_buffer_ = std::move(frame.payload);
+                return true;
+            }
+            break;
+        case WsOpcode::CONTINUATION:
+            // 拼接后的消息与单帧使用同一上限，超出时以1009关闭连接
+            if (frame.payload.size() > WebsocketFrameCodec::kMaxPayload - message_buffer_.size()) {
+                std::cerr << "[WebsocketClient] 错误: 分片消息超过"
+                          << WebsocketFrameCodec::kMaxPayload << "字节" << std::endl;
+                message_buffer_.clear();
+                message_buffer_.shrink_to_fit();
+                uint8_t status[2] = {0x03, 0xf1};  // 1009 消息过大
+                sendFrame(WsOpcode::CLOSE, status, sizeof(status));
+                return false;
+            }
+            message_buffer_.insert(message_buffer_.end(), frame.payload.begin(), frame.payload.end());
+            if (!frame.fin) {
+                return true;
+            }
+            frame.payload.swap(message_buffer_);
+            message_buffer_.clear();
+            break;
+        default:
+            return true;
+    }
+
+    if (message_opcode_ == WsOpcode::TEXT) {
+        if (text_message_callback_) {
+            text_message_callback_(std::string(frame.payload.begin(), frame.payload.end()));
+        }
+    } else if (binary_message_callback_) {
+        binary_message_callback_(frame.payload);
+    }
+    return true;
+}
+
+void WebsocketClient::closeSocket() {
+    if (ssl_) {
+        SSL_free(ssl_);
+        ssl_ = nullptr;
+    }
+    if (ssl_ctx_) {
+        SSL_CTX_free(ssl_ctx_);
+        ssl_ctx_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        if (loop_) {
+            loop_->removeFd(fd_);
+        }
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+void WebsocketClient::handleConnectionLost() {
+    if (!connected_.exchange(false)) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(socket_mutex_);
+        closeSocket();
+    }
+    wsMetrics().connection_lost.inc();
+    wsMetrics().connected.set(0);
+    std::cerr << "[WebsocketClient] 与服务器的连接已断开" << std::endl;
+
+    if (connection_status_callback_) {
+        connection_status_callback_(false);
+    }
 }
 
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
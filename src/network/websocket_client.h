@@ -1,50 +1,107 @@
 #pragma once
 
 #include <string>
-#include <thread>
+#include <vector>
 #include <mutex>
 #include <atomic>
+#include <thread>
 #include <functional>
+#include <utility>
 #include "xiaozhi_types.h"
+#include "websocket_frame.h"
+
+struct ssl_st;
+struct ssl_ctx_st;
 
 namespace xiaozhi {
 
+class EventLoop;
+template <typename T>
+class Async;
+
 class WebsocketClient {
 public:
     WebsocketClient();
     ~WebsocketClient();
 
+    // 支持ws://与wss://，握手完成后返回
     bool connect(const std::string& url);
+    // 在后台线程中解析地址并完成TCP/TLS/WebSocket握手，不阻塞调用方（如事件循环线程）。
+    // 结果在事件循环中交给续延，成功时连接状态回调也在事件循环中执行；
+    // 同一时刻只允许一次连接尝试，disconnect会中止进行中的尝试
+    Async<bool> connectAsync(const std::string& url);
     void disconnect();
     bool isConnected() const;
 
+    // 握手时附加的请求头（如Authorization、Device-Id），需在connect之前设置
+    void setHeader(const std::string& name, const std::string& value);
+
+    // 把socket注册到外部事件循环，消息回调在该循环的线程中执行；需在connect之前设置。
+    // 未设置时在首次connect时从共享的EventLoopPool分配一个循环
+    void setEventLoop(EventLoop* loop);
+
     // 发送文本消息
     bool sendText(const std::string& message);
-    
+
     // 发送二进制数据（如音频）
     bool sendBinary(const std::vector<uint8_t>& data);
+    bool sendBinary(const uint8_t* data, size_t length);
 
-    void process();
-
-    // 设置消息回调
+    // 设置消息回调，在网络线程中调用
     void setTextMessageCallback(std::function<void(const std::string&)> callback);
     void setBinaryMessageCallback(std::function<void(const std::vector<uint8_t>&)> callback);
     void setConnectionStatusCallback(std::function<void(bool connected)> callback);
 
 private:
     std::atomic<bool> connected_{false};
-    std::atomic<bool> should_stop_{false};
+    std::atomic<bool> ever_connected_{false};   // 用于区分首次连接与重连
+    std::atomic<bool> connecting_{false};       // connectAsync的结果尚未交给事件循环
+    std::atomic<bool> connect_cancelled_{false};
 
     std::string server_url_;
-    
+    std::vector<std::pair<std::string, std::string>> headers_;
+
     std::function<void(const std::string&)> text_message_callback_;
     std::function<void(const std::vector<uint8_t>&)> binary_message_callback_;
     std::function<void(bool)> connection_status_callback_;
 
-    std::thread client_thread_;
-    std::mutex socket_mutex_;
+    EventLoop* loop_;
+    std::mutex socket_mutex_;        // 保护socket/SSL读写和发送缓冲
+
+    int fd_;
+    int cancel_fd_;                  // eventfd，disconnect时唤醒连接线程中的等待
+    std::thread connect_thread_;
+    ssl_ctx_st* ssl_ctx_;
+    ssl_st* ssl_;
+    WebsocketFrameCodec codec_;
+    std::vector<uint8_t> send_buffer_;      // 复用的发送帧缓冲
+    std::vector<uint8_t> message_buffer_;   // 分片消息拼接
+    WsOpcode message_opcode_;
+    uint8_t read_buffer_[16384];
+    WsFrame frame_;
+
+    void onReadable();
+
+    bool openConnection(const std::string& url);   // 阻塞地完成握手，不注册到事件循环
+    bool finishConnect();                          // 注册socket并通知连接建立
+    void cancelConnect();
+
+    bool parseUrl(const std::string& url, bool& secure, std::string& host,
+                  std::string& port, std::string& path);
+    bool openSocket(const std::string& host, const std::string& port);
+    bool startTls(const std::string& host);
+    bool performHandshake(const std::string& host_header, const std::string& path);
+
+    // 以下I/O函数需持有socket_mutex_
+    bool waitSocket(short events, int timeout_ms);
+    bool waitFd(int fd, short events, int timeout_ms);   // cancel_fd_被触发时返回false
+    bool writeAll(const uint8_t* data, size_t length);
+    long readSome(uint8_t* buffer, size_t length);   // >0读到数据，0暂无数据，<0连接关闭或出错
 
-    void clientLoop();
+    bool sendFrame(WsOpcode opcode, const uint8_t* data, size_t length);
+    bool dispatchFrame(WsFrame& frame);   // 返回false表示对端关闭连接
+    void closeSocket();
+    void handleConnectionLost();
 };
 
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
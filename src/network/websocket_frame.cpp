@@ -0,0 +1,146 @@
+#include "websocket_frame.h"
+#include <cstring>
+#include <openssl/sha.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+
+namespace xiaozhi {
+
+namespace {
+
+const char* kWebsocketGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+std::string base64Encode(const unsigned char* data, size_t length) {
+    std::string out(4 * ((length + 2) / 3), '\0');
+    int written = EVP_EncodeBlock(reinterpret_cast<unsigned char*>(&out[0]), data, static_cast<int>(length));
+    out.resize(written > 0 ? written : 0);
+    return out;
+}
+
+} // namespace
+
+void WebsocketFrameCodec::encode(WsOpcode opcode, const uint8_t* data, size_t length, bool mask,
+                                 std::vector<uint8_t>& out) {
+    out.push_back(static_cast<uint8_t>(0x80 | static_cast<uint8_t>(opcode)));
+
+    uint8_t mask_bit = mask ? 0x80 : 0x00;
+    if (length < 126) {
+        out.push_back(static_cast<uint8_t>(mask_bit | length));
+    } else if (length <= 0xffff) {
+        out.push_back(static_cast<uint8_t>(mask_bit | 126));
+        out.push_back(static_cast<uint8_t>(length >> 8));
+        out.push_back(static_cast<uint8_t>(length & 0xff));
+    } else {
+        out.push_back(static_cast<uint8_t>(mask_bit | 127));
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            out.push_back(static_cast<uint8_t>((static_cast<uint64_t>(length) >> shift) & 0xff));
+        }
+    }
+
+    if (!mask) {
+        out.insert(out.end(), data, data + length);
+        return;
+    }
+
+    uint8_t key[4];
+    RAND_bytes(key, sizeof(key));
+    out.insert(out.end(), key, key + 4);
+
+    size_t payload_start = out.size();
+    out.resize(payload_start + length);
+    uint8_t* payload = out.data() + payload_start;
+    for (size_t i = 0; i < length; ++i) {
+        payload[i] = data[i] ^ key[i & 3];
+    }
+}
+
+void WebsocketFrameCodec::feed(const uint8_t* data, size_t length) {
+    // 已消费的数据超过一半时再整体前移，避免每帧都搬移缓冲
+    if (read_pos_ > 0 && read_pos_ * 2 >= buffer_.size()) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + read_pos_);
+        read_pos_ = 0;
+    }
+    buffer_.insert(buffer_.end(), data, data + length);
+}
+
+bool WebsocketFrameCodec::next(WsFrame& frame) {
+    if (error_) {
+        return false;
+    }
+
+    size_t available = buffer_.size() - read_pos_;
+    const uint8_t* p = buffer_.data() + read_pos_;
+    if (available < 2) {
+        return false;
+    }
+
+    bool fin = (p[0] & 0x80) != 0;
+    uint8_t opcode = p[0] & 0x0f;
+    bool masked = (p[1] & 0x80) != 0;
+    uint64_t length = p[1] & 0x7f;
+    size_t header = 2;
+
+    if (length == 126) {
+        if (available < 4) return false;
+        length = (static_cast<uint64_t>(p[2]) << 8) | p[3];
+        header = 4;
+    } else if (length == 127) {
+        if (available < 10) return false;
+        length = 0;
+        for (int i = 0; i < 8; ++i) {
+            length = (length << 8) | p[2 + i];
+        }
+        header = 10;
+    }
+
+    if (length > kMaxPayload) {
+        error_ = true;
+        return false;
+    }
+
+    size_t mask_offset = header;
+    if (masked) {
+        header += 4;
+    }
+    if (available < header + length) {
+        return false;
+    }
+
+    frame.opcode = static_cast<WsOpcode>(opcode);
+    frame.fin = fin;
+    frame.payload.assign(p + header, p + header + length);
+    if (masked) {
+        const uint8_t* key = p + mask_offset;
+        for (size_t i = 0; i < frame.payload.size(); ++i) {
+            frame.payload[i] ^= key[i & 3];
+        }
+    }
+
+    read_pos_ += header + length;
+    if (read_pos_ == buffer_.size()) {
+        buffer_.clear();
+        read_pos_ = 0;
+    }
+    return true;
+}
+
+void WebsocketFrameCodec::reset() {
+    buffer_.clear();
+    read_pos_ = 0;
+    error_ = false;
+}
+
+std::string WebsocketFrameCodec::generateKey() {
+    unsigned char nonce[16];
+    RAND_bytes(nonce, sizeof(nonce));
+    return base64Encode(nonce, sizeof(nonce));
+}
+
+std::string WebsocketFrameCodec::computeAcceptKey(const std::string& key) {
+    std::string source = key + kWebsocketGuid;
+    unsigned char digest[SHA_DIGEST_LENGTH];
+    SHA1(reinterpret_cast<const unsigned char*>(source.data()), source.size(), digest);
+    return base64Encode(digest, sizeof(digest));
+}
+
+} // namespace xiaozhi
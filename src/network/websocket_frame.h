@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace xiaozhi {
+
+enum class WsOpcode : uint8_t {
+    CONTINUATION = 0x0,
+    TEXT = 0x1,
+    BINARY = 0x2,
+    CLOSE = 0x8,
+    PING = 0x9,
+    PONG = 0xA
+};
+
+struct WsFrame {
+    WsOpcode opcode = WsOpcode::TEXT;
+    bool fin = true;
+    std::vector<uint8_t> payload;
+};
+
+// RFC 6455 帧编解码，客户端与测试用的本地服务端共用
+class WebsocketFrameCodec {
+public:
+    // 编码一帧追加到out，客户端发送的帧必须mask
+    static void encode(WsOpcode opcode, const uint8_t* data, size_t length, bool mask,
+                       std::vector<uint8_t>& out);
+
+    // 追加从socket读到的数据
+    void feed(const uint8_t* data, size_t length);
+
+    // 取出下一个完整帧（已去掩码），数据不足时返回false
+    bool next(WsFrame& frame);
+
+    // 收到格式错误或超长的帧
+    bool hasError() const { return error_; }
+
+    void reset();
+
+    // 握手用的Sec-WebSocket-Key与对应的Sec-WebSocket-Accept
+    static std::string generateKey();
+    static std::string computeAcceptKey(const std::string& key);
+
+    static constexpr size_t kMaxPayload = 16 * 1024 * 1024;
+
+private:
+    std::vector<uint8_t> buffer_;
+    size_t read_pos_ = 0;
+    bool error_ = false;
+};
+
+} // namespace xiaozhi
@@ -0,0 +1,111 @@
+#include "async.h"
+#include <cerrno>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+namespace xiaozhi {
+
+namespace {
+
+struct FdWait {
+    bool done = false;
+    int timer_id = -1;
+};
+
+void writeRemaining(EventLoop* loop, int fd, std::shared_ptr<std::string> data, size_t offset,
+                    std::chrono::milliseconds timeout, AsyncPromise<ssize_t> promise) {
+    while (offset < data->size()) {
+        ssize_t written = write(fd, data->data() + offset, data->size() - offset);
+        if (written > 0) {
+            offset += static_cast<size_t>(written);
+            continue;
+        }
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            asyncWaitFd(*loop, fd, EPOLLOUT, timeout).then(
+                [loop, fd, data, offset, timeout, promise](uint32_t ready) {
+                    if (!ready) {
+                        promise.resolve(-1);
+                        return;
+                    }
+                    writeRemaining(loop, fd, data, offset, timeout, promise);
+                });
+            return;
+        }
+        promise.resolve(-1);
+        return;
+    }
+    promise.resolve(static_cast<ssize_t>(data->size()));
+}
+
+} // namespace
+
+Async<bool> asyncDelay(EventLoop& loop, std::chrono::milliseconds delay) {
+    AsyncPromise<bool> promise(&loop);
+    loop.addTimer(delay, std::chrono::milliseconds(0), [promise]() { promise.resolve(true); });
+    return promise.async();
+}
+
+Async<uint32_t> asyncWaitFd(EventLoop& loop, int fd, uint32_t events, std::chrono::milliseconds timeout) {
+    AsyncPromise<uint32_t> promise(&loop);
+    EventLoop* target = &loop;
+
+    // 注册和超时定时器都在循环线程中完成，保证两者的回调看到一致的状态
+    detail::runInLoop(target, [target, fd, events, timeout, promise]() {
+        auto wait = std::make_shared<FdWait>();
+        bool added = target->addFd(fd, events, [target, fd, wait, promise](uint32_t ready) {
+            if (wait->done) {
+                return;
+            }
+            wait->done = true;
+            target->removeFd(fd);
+            if (wait->timer_id >= 0) {
+                target->cancelTimer(wait->timer_id);
+            }
+            promise.resolve(ready);
+        });
+        if (!added) {
+            promise.resolve(0);
+            return;
+        }
+        if (timeout.count() > 0) {
+            wait->timer_id = target->addTimer(timeout, std::chrono::milliseconds(0),
+                                              [target, fd, wait, promise]() {
+                if (wait->done) {
+                    return;
+                }
+                wait->done = true;
+                target->removeFd(fd);
+                promise.resolve(0);
+            });
+        }
+    });
+    return promise.async();
+}
+
+Async<ssize_t> asyncRead(EventLoop& loop, int fd, void* buffer, size_t length, std::chrono::milliseconds timeout) {
+    return asyncWaitFd(loop, fd, EPOLLIN, timeout).then([fd, buffer, length](uint32_t ready) -> ssize_t {
+        if (!ready) {
+            return -1;
+        }
+        ssize_t bytes;
+        do {
+            bytes = read(fd, buffer, length);
+        } while (bytes < 0 && errno == EINTR);
+        return bytes;
+    });
+}
+
+Async<ssize_t> asyncWrite(EventLoop& loop, int fd, std::string data, std::chrono::milliseconds timeout) {
+    AsyncPromise<ssize_t> promise(&loop);
+    auto shared = std::make_shared<std::string>(std::move(data));
+    EventLoop* target = &loop;
+    detail::runInLoop(target, [target, fd, shared, timeout, promise]() {
+        writeRemaining(target, fd, shared, 0, timeout, promise);
+    });
+    return promise.async();
+}
+
+} // namespace xiaozhi
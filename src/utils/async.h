@@ -0,0 +1,181 @@
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <sys/types.h>
+#include "event_loop.h"
+
+namespace xiaozhi {
+
+// 基于续延的异步结果，用于在事件循环上顺序地编写协议代码：
+//
+//     asyncRead(loop, fd, buffer, size, timeout)
+//         .then([](ssize_t n) { ...; return asyncWrite(loop, fd, reply); })
+//         .then([](ssize_t written) { ... });
+//
+// 续延总是在结果所属的事件循环线程中执行（完成方不在该线程时通过post转发），
+// then()得到的Async与原Async属于同一循环，即使中间步骤在其他循环上完成，整条链
+// 仍回到发起的循环执行，因此链上的步骤之间不需要加锁。then()返回Async时自动展开；返回void的
+// 续延得到Async<bool>（完成时为true）。项目使用C++17，这里用续延代替C++20协程。
+template <typename T>
+class Async;
+
+namespace detail {
+
+template <typename T>
+struct AsyncState {
+    explicit AsyncState(EventLoop* owner) : loop(owner) {}
+
+    EventLoop* loop;
+    std::mutex mutex;
+    bool ready = false;
+    T value{};
+    std::function<void(T)> continuation;
+};
+
+template <typename T>
+struct AsyncValue { using type = T; };
+template <>
+struct AsyncValue<void> { using type = bool; };
+
+template <typename T>
+struct IsAsync : std::false_type {};
+template <typename T>
+struct IsAsync<Async<T>> : std::true_type {};
+
+template <typename T>
+struct AsyncUnwrap { using type = typename AsyncValue<T>::type; };
+template <typename T>
+struct AsyncUnwrap<Async<T>> { using type = T; };
+
+// 已在目标循环线程中时直接执行，否则投递过去
+inline void runInLoop(EventLoop* loop, EventLoop::Task task) {
+    if (loop->isInLoopThread()) {
+        task();
+    } else {
+        loop->post(std::move(task));
+    }
+}
+
+} // namespace detail
+
+// 异步结果的生产端，可在任意线程完成；只应完成一次，重复完成被忽略
+template <typename T>
+class AsyncPromise {
+public:
+    explicit AsyncPromise(EventLoop* loop) : state_(std::make_shared<detail::AsyncState<T>>(loop)) {}
+
+    Async<T> async() const { return Async<T>(state_); }
+
+    void resolve(T value) const {
+        std::function<void(T)> continuation;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            if (state_->ready) {
+                return;
+            }
+            state_->ready = true;
+            state_->value = value;
+            continuation.swap(state_->continuation);
+        }
+        if (continuation) {
+            detail::runInLoop(state_->loop, [continuation, value]() { continuation(value); });
+        }
+    }
+
+private:
+    std::shared_ptr<detail::AsyncState<T>> state_;
+};
+
+template <typename T>
+class Async {
+public:
+    using ValueType = T;
+
+    Async() = default;
+    explicit Async(std::shared_ptr<detail::AsyncState<T>> state) : state_(std::move(state)) {}
+
+    bool valid() const { return state_ != nullptr; }
+    EventLoop* loop() const { return state_ ? state_->loop : nullptr; }
+
+    // 注册续延，每个Async只能调用一次
+    template <typename F>
+    auto then(F&& callback) -> Async<typename detail::AsyncUnwrap<std::invoke_result_t<F, T>>::type> {
+        using Result = std::invoke_result_t<F, T>;
+        using Next = typename detail::AsyncUnwrap<Result>::type;
+
+        AsyncPromise<Next> promise(state_->loop);
+        std::function<void(T)> continuation =
+            [callback = std::forward<F>(callback), promise](T value) mutable {
+                if constexpr (detail::IsAsync<Result>::value) {
+                    Result inner = callback(std::move(value));
+                    inner.then([promise](Next next) { promise.resolve(std::move(next)); });
+                } else if constexpr (std::is_void<Result>::value) {
+                    callback(std::move(value));
+                    promise.resolve(true);
+                } else {
+                    promise.resolve(callback(std::move(value)));
+                }
+            };
+
+        bool ready;
+        {
+            std::lock_guard<std::mutex> lock(state_->mutex);
+            ready = state_->ready;
+            if (!ready) {
+                state_->continuation = std::move(continuation);
+            }
+        }
+        if (ready) {
+            T value = state_->value;
+            detail::runInLoop(state_->loop, [continuation, value]() mutable { continuation(value); });
+        }
+        return promise.async();
+    }
+
+private:
+    std::shared_ptr<detail::AsyncState<T>> state_;
+};
+
+// 在loop中执行task，结果在loop中交给后续续延
+template <typename F>
+auto asyncPost(EventLoop& loop, F&& task) -> Async<typename detail::AsyncValue<std::invoke_result_t<F>>::type> {
+    using Result = std::invoke_result_t<F>;
+    using Value = typename detail::AsyncValue<Result>::type;
+
+    AsyncPromise<Value> promise(&loop);
+    loop.post([task = std::forward<F>(task), promise]() mutable {
+        if constexpr (std::is_void<Result>::value) {
+            task();
+            promise.resolve(true);
+        } else {
+            promise.resolve(task());
+        }
+    });
+    return promise.async();
+}
+
+// delay之后完成，结果恒为true
+Async<bool> asyncDelay(EventLoop& loop, std::chrono::milliseconds delay);
+
+// 等待fd就绪，结果为就绪的事件位；超时或注册失败时为0。timeout为0表示不超时。
+// 同一fd在同一循环中只能有一个注册者，等待期间不能再对该fd调用addFd
+Async<uint32_t> asyncWaitFd(EventLoop& loop, int fd, uint32_t events,
+                            std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+// 可读后读取一次，结果为读取的字节数，超时或出错时为-1、对端关闭时为0。
+// fd须为非阻塞模式，buffer在完成前必须保持有效
+Async<ssize_t> asyncRead(EventLoop& loop, int fd, void* buffer, size_t length,
+                         std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+// 写出全部数据（EAGAIN时等待可写），结果为写出的字节数，超时或出错时为-1
+Async<ssize_t> asyncWrite(EventLoop& loop, int fd, std::string data,
+                          std::chrono::milliseconds timeout = std::chrono::milliseconds(0));
+
+} // namespace xiaozhi
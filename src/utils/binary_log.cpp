@@ -0,0 +1,367 @@
+#include "binary_log.h"
+#include "log_format.h"
+#include <iostream>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace xiaozhi {
+
+namespace {
+
+constexpr char kMagic[8] = {'X', 'Z', 'B', 'L', 'O', 'G', 0, 0};
+constexpr uint16_t kVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+constexpr size_t kFileHeaderSize = 16;
+constexpr size_t kRecordHeaderSize = 8;
+constexpr size_t kMinFileBytes = 64 * 1024;
+
+constexpr uint8_t kRecordFormat = 1;
+constexpr uint8_t kRecordEvent = 2;
+
+void appendField(std::string& out, const std::string& value) {
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(value.size(), 0xFFFF));
+    out.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    out.append(value.data(), length);
+}
+
+bool readField(const char* data, size_t size, size_t& pos, std::string& value) {
+    uint16_t length;
+    if (pos + sizeof(length) > size) {
+        return false;
+    }
+    memcpy(&length, data + pos, sizeof(length));
+    pos += sizeof(length);
+    if (pos + length > size) {
+        return false;
+    }
+    value.assign(data + pos, length);
+    pos += length;
+    return true;
+}
+
+// 解码一个参数并追加为文本，与appendLogArg的输出保持一致
+bool appendDecodedArg(std::string& out, const char* payload, size_t length, size_t& pos) {
+    if (pos >= length) {
+        return false;
+    }
+    auto type = static_cast<BinaryArgType>(payload[pos++]);
+    char buffer[32];
+    int n = 0;
+    switch (type) {
+        case BinaryArgType::INT: {
+            int64_t value;
+            if (pos + sizeof(value) > length) return false;
+            memcpy(&value, payload + pos, sizeof(value));
+            pos += sizeof(value);
+            n = snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+            break;
+        }
+        case BinaryArgType::UINT: {
+            uint64_t value;
+            if (pos + sizeof(value) > length) return false;
+            memcpy(&value, payload + pos, sizeof(value));
+            pos += sizeof(value);
+            n = snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+            break;
+        }
+        case BinaryArgType::DOUBLE: {
+            double value;
+            if (pos + sizeof(value) > length) return false;
+            memcpy(&value, payload + pos, sizeof(value));
+            pos += sizeof(value);
+            n = snprintf(buffer, sizeof(buffer), "%g", value);
+            break;
+        }
+        case BinaryArgType::POINTER: {
+            uint64_t value;
+            if (pos + sizeof(value) > length) return false;
+            memcpy(&value, payload + pos, sizeof(value));
+            pos += sizeof(value);
+            n = value ? snprintf(buffer, sizeof(buffer), "0x%llx", static_cast<unsigned long long>(value))
+                      : snprintf(buffer, sizeof(buffer), "(nil)");
+            break;
+        }
+        case BinaryArgType::BOOL:
+            if (pos + 1 > length) return false;
+            out += payload[pos++] ? "true" : "false";
+            return true;
+        case BinaryArgType::CHAR:
+            if (pos + 1 > length) return false;
+            out += payload[pos++];
+            return true;
+        case BinaryArgType::STRING: {
+            std::string value;
+            if (!readField(payload, length, pos, value)) return false;
+            out += value;
+            return true;
+        }
+        default:
+            pos = length;
+            return false;
+    }
+    out.append(buffer, static_cast<size_t>(std::max(n, 0)));
+    return true;
+}
+
+} // namespace
+
+std::string formatBinaryLogMessage(const std::string& format, const char* payload, size_t length) {
+    // 无参数的调用点在文本模式下原样输出格式串，这里保持一致
+    if (length == 0) {
+        return format;
+    }
+
+    std::string out;
+    size_t pos = 0;
+    for (const char* p = format.c_str(); *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            if (!appendDecodedArg(out, payload, length, pos)) {
+                out += "{}";
+            }
+            ++p;
+            continue;
+        }
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            ++p;
+        }
+        out += *p;
+    }
+    return out;
+}
+
+BinaryLogWriter::BinaryLogWriter()
+    : max_file_bytes_(0), max_files_(1), fd_(-1), base_(nullptr), offset_(0) {
+}
+
+BinaryLogWriter::~BinaryLogWriter() {
+    close();
+}
+
+bool BinaryLogWriter::open(const std::string& path, size_t max_file_bytes, int max_files) {
+    close();
+    path_ = path;
+    max_file_bytes_ = std::max(max_file_bytes, kMinFileBytes);
+    max_files_ = std::max(max_files, 1);
+    formats_.clear();
+
+    // 保留上次运行的日志，新进程总是从空文件开始
+    if (access(path_.c_str(), F_OK) == 0) {
+        return rotate();
+    }
+    return mapNewFile();
+}
+
+void BinaryLogWriter::close() {
+    unmapFile();
+}
+
+bool BinaryLogWriter::mapNewFile() {
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        std::cerr << "[BinaryLog] 错误: 无法创建日志文件 " << path_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 预先分配磁盘块，避免写入映射区时因空间不足触发SIGBUS
+    int result = posix_fallocate(fd_, 0, static_cast<off_t>(max_file_bytes_));
+    if (result != 0 && ftruncate(fd_, static_cast<off_t>(max_file_bytes_)) != 0) {
+        std::cerr << "[BinaryLog] 错误: 无法分配日志文件空间: " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, max_file_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        std::cerr << "[BinaryLog] 错误: 无法映射日志文件: " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    base_ = static_cast<uint8_t*>(mapped);
+
+    memcpy(base_, kMagic, sizeof(kMagic));
+    memcpy(base_ + 8, &kVersion, sizeof(kVersion));
+    memcpy(base_ + 12, &kByteOrderMark, sizeof(kByteOrderMark));
+    offset_ = kFileHeaderSize;
+
+    for (const auto& format : formats_) {
+        if (!appendFormat(format)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BinaryLogWriter::unmapFile() {
+    if (base_) {
+        msync(base_, offset_, MS_SYNC);
+        munmap(base_, max_file_bytes_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        // 去掉未使用的预分配空间
+        if (ftruncate(fd_, static_cast<off_t>(offset_)) != 0) {
+            std::cerr << "[BinaryLog] 警告: 无法截断日志文件: " << strerror(errno) << std::endl;
+        }
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool BinaryLogWriter::rotate() {
+    unmapFile();
+
+    if (max_files_ <= 1) {
+        unlink(path_.c_str());
+    } else {
+        for (int i = max_files_ - 2; i >= 1; --i) {
+            std::string from = path_ + "." + std::to_string(i);
+            std::string to = path_ + "." + std::to_string(i + 1);
+            rename(from.c_str(), to.c_str());
+        }
+        rename(path_.c_str(), (path_ + ".1").c_str());
+    }
+    return mapNewFile();
+}
+
+bool BinaryLogWriter::append(uint8_t kind, uint8_t level, uint32_t id,
+                             const void* first, size_t first_length,
+                             const void* second, size_t second_length) {
+    if (!base_) {
+        return false;
+    }
+    size_t payload_length = first_length + second_length;
+    size_t needed = kRecordHeaderSize + payload_length;
+    if (payload_length > 0xFFFF || kFileHeaderSize + needed + 1 > max_file_bytes_) {
+        return false;
+    }
+    // 保留结尾至少一个0字节作为结束标记
+    if (offset_ + needed + 1 > max_file_bytes_) {
+        if (!rotate() || offset_ + needed + 1 > max_file_bytes_) {
+            return false;
+        }
+    }
+
+    uint8_t* record = base_ + offset_;
+    uint16_t stored_length = static_cast<uint16_t>(payload_length);
+    record[1] = level;
+    memcpy(record + 2, &stored_length, sizeof(stored_length));
+    memcpy(record + 4, &id, sizeof(id));
+    if (first_length) {
+        memcpy(record + kRecordHeaderSize, first, first_length);
+    }
+    if (second_length) {
+        memcpy(record + kRecordHeaderSize + first_length, second, second_length);
+    }
+    // 类型字节最后写入，进程中途崩溃时残缺记录仍被视为文件结尾
+    __atomic_store_n(record, kind, __ATOMIC_RELEASE);
+    offset_ += needed;
+    return true;
+}
+
+bool BinaryLogWriter::appendFormat(const LogFormatInfo& format) {
+    std::string payload;
+    payload.append(reinterpret_cast<const char*>(&format.line), sizeof(format.line));
+    appendField(payload, format.file);
+    appendField(payload, format.function);
+    appendField(payload, format.format);
+    return append(kRecordFormat, format.level, format.id, payload.data(), payload.size(), nullptr, 0);
+}
+
+bool BinaryLogWriter::writeFormat(const LogFormatInfo& format) {
+    // 先写再登记：若写入时触发轮转，新文件只重放之前的格式，避免重复
+    bool written = appendFormat(format);
+    formats_.push_back(format);
+    return written;
+}
+
+bool BinaryLogWriter::writeEvent(uint8_t level, uint32_t format_id, int64_t timestamp_ns,
+                                 const char* payload, size_t length) {
+    return append(kRecordEvent, level, format_id, &timestamp_ns, sizeof(timestamp_ns), payload, length);
+}
+
+void BinaryLogWriter::sync() {
+    if (base_) {
+        msync(base_, offset_, MS_ASYNC);
+    }
+}
+
+bool readBinaryLog(const std::string& path, const std::function<void(const BinaryLogEvent&)>& callback) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        std::cerr << "[BinaryLog] 错误: 无法打开 " << path << std::endl;
+        return false;
+    }
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    uint16_t version = 0;
+    uint32_t byte_order = 0;
+    if (content.size() < kFileHeaderSize || memcmp(content.data(), kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "[BinaryLog] 错误: 不是二进制日志文件: " << path << std::endl;
+        return false;
+    }
+    memcpy(&version, content.data() + 8, sizeof(version));
+    memcpy(&byte_order, content.data() + 12, sizeof(byte_order));
+    if (version != kVersion || byte_order != kByteOrderMark) {
+        std::cerr << "[BinaryLog] 错误: 不支持的版本或字节序: " << path << std::endl;
+        return false;
+    }
+
+    std::unordered_map<uint32_t, LogFormatInfo> formats;
+    const char* data = content.data();
+    size_t size = content.size();
+    size_t pos = kFileHeaderSize;
+    while (pos + kRecordHeaderSize <= size && data[pos] != 0) {
+        uint8_t kind = static_cast<uint8_t>(data[pos]);
+        uint8_t level = static_cast<uint8_t>(data[pos + 1]);
+        uint16_t length;
+        uint32_t id;
+        memcpy(&length, data + pos + 2, sizeof(length));
+        memcpy(&id, data + pos + 4, sizeof(id));
+        const char* payload = data + pos + kRecordHeaderSize;
+        if (pos + kRecordHeaderSize + length > size) {
+            break;
+        }
+        pos += kRecordHeaderSize + length;
+
+        if (kind == kRecordFormat) {
+            LogFormatInfo format;
+            size_t field = sizeof(format.line);
+            format.id = id;
+            format.level = level;
+            if (length < field) {
+                continue;
+            }
+            memcpy(&format.line, payload, sizeof(format.line));
+            if (readField(payload, length, field, format.file) &&
+                readField(payload, length, field, format.function) &&
+                readField(payload, length, field, format.format)) {
+                formats[id] = format;
+            }
+        } else if (kind == kRecordEvent && length >= sizeof(int64_t)) {
+            BinaryLogEvent event;
+            memcpy(&event.timestamp_ns, payload, sizeof(event.timestamp_ns));
+            event.level = level;
+            auto it = formats.find(id);
+            if (it != formats.end()) {
+                event.format = &it->second;
+                event.message = formatBinaryLogMessage(it->second.format, payload + sizeof(int64_t),
+                                                       length - sizeof(int64_t));
+            } else {
+                event.message = "<未知格式 #" + std::to_string(id) + ">";
+            }
+            callback(event);
+        }
+    }
+    return true;
+}
+
+} // namespace xiaozhi
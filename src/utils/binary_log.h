@@ -0,0 +1,86 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstdint>
+#include <cstddef>
+
+namespace xiaozhi {
+
+// 二进制日志文件布局（本机字节序）：
+//   文件头 16 字节: "XZBLOG\0\0" | uint16 版本 | uint16 保留 | uint32 字节序标记
+//   记录头  8 字节: uint8 类型 | uint8 级别 | uint16 负载长度 | uint32 格式ID
+//   FORMAT 负载: uint32 行号 | 文件名 | 函数名 | 格式串（各为uint16长度 + 字节）
+//   EVENT  负载: int64 时间戳(ns) | 编码后的参数（见log_format.h中的BinaryArgType）
+// 文件预分配为固定大小并以0填充，类型字节为0处即为有效数据的结尾。
+// 每个文件开头重放全部格式定义，轮转后的任一文件都能单独解码。
+
+// 调用点的静态格式信息，ID在进程内唯一
+struct LogFormatInfo {
+    uint32_t id = 0;
+    uint8_t level = 0;
+    uint32_t line = 0;
+    std::string file;
+    std::string function;
+    std::string format;
+};
+
+// 格式ID 1 保留给不经过调用点注册的整行文本（Logger::info等接口），负载为单个字符串参数
+constexpr uint32_t kBinaryLogTextFormatId = 1;
+
+// 按格式串把编码后的参数还原成文本；参数不足时保留"{}"，负载为空时格式串原样输出
+std::string formatBinaryLogMessage(const std::string& format, const char* payload, size_t length);
+
+// 内存映射的定长轮转文件：path写满后依次改名为path.1 ... path.N，最旧的文件被删除
+class BinaryLogWriter {
+public:
+    BinaryLogWriter();
+    ~BinaryLogWriter();
+
+    BinaryLogWriter(const BinaryLogWriter&) = delete;
+    BinaryLogWriter& operator=(const BinaryLogWriter&) = delete;
+
+    // 已存在的path先轮转为path.1，再新建文件
+    bool open(const std::string& path, size_t max_file_bytes, int max_files);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    bool writeFormat(const LogFormatInfo& format);
+    bool writeEvent(uint8_t level, uint32_t format_id, int64_t timestamp_ns,
+                    const char* payload, size_t length);
+
+    // 异步回写已映射的脏页
+    void sync();
+
+private:
+    bool mapNewFile();
+    void unmapFile();
+    bool rotate();
+    bool append(uint8_t kind, uint8_t level, uint32_t id,
+                const void* first, size_t first_length,
+                const void* second, size_t second_length);
+    bool appendFormat(const LogFormatInfo& format);
+
+    std::string path_;
+    size_t max_file_bytes_;
+    int max_files_;
+    int fd_;
+    uint8_t* base_;
+    size_t offset_;
+
+    // 已写出的格式定义，轮转后在新文件开头重放
+    std::vector<LogFormatInfo> formats_;
+};
+
+struct BinaryLogEvent {
+    int64_t timestamp_ns = 0;
+    uint8_t level = 0;
+    const LogFormatInfo* format = nullptr;
+    std::string message;
+};
+
+// 顺序解码一个二进制日志文件，文件头无效时返回false
+bool readBinaryLog(const std::string& path, const std::function<void(const BinaryLogEvent&)>& callback);
+
+} // namespace xiaozhi
@@ -4,6 +4,7 @@
 #include <fstream>
 #include <json-c/json.h>
 #include <cstdlib>
+#include <algorithm>
 #include <pwd.h>
 #include <unistd.h>
 
@@ -40,12 +41,20 @@ bool ConfigManager::loadConfig(const std::string& filepath) {
         audio_config_.sample_rate = 16000;
         audio_config_.channels = 1;
         audio_config_.opus_bitrate = 32000;
+        audio_config_.frame_pool_size = 64;
+        audio_config_.duplex_sync = false;
+        audio_config_.backend = "alsa";
+        audio_config_.input_file = "";
+        audio_config_.output_file = "";
+        audio_config_.file_realtime = true;
+        audio_config_.file_loop = false;
         
         mcp_config_.enabled = true;
         mcp_config_.port = 8080;
         
         network_config_.reconnect_interval = 5;
         network_config_.timeout = 30;
+        network_config_.loop_threads = 0;
         
         std::cout << "[ConfigManager] 使用默认配置" << std::endl;
         return false;
@@ -109,6 +118,41 @@ bool ConfigManager::loadConfig(const std::string& filepath) {
         if (json_object_object_get_ex(audio_obj, "opus_bitrate", &bitrate_obj)) {
             audio_config_.opus_bitrate = json_object_get_int(bitrate_obj);
         }
+        
+        json_object* pool_size_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "frame_pool_size", &pool_size_obj)) {
+            audio_config_.frame_pool_size = json_object_get_int(pool_size_obj);
+        }
+        
+        json_object* duplex_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "duplex_sync", &duplex_obj)) {
+            audio_config_.duplex_sync = json_object_get_boolean(duplex_obj);
+        }
+        
+        json_object* backend_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "backend", &backend_obj)) {
+            audio_config_.backend = json_object_get_string(backend_obj);
+        }
+        
+        json_object* input_file_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "input_file", &input_file_obj)) {
+            audio_config_.input_file = json_object_get_string(input_file_obj);
+        }
+        
+        json_object* output_file_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "output_file", &output_file_obj)) {
+            audio_config_.output_file = json_object_get_string(output_file_obj);
+        }
+        
+        json_object* file_realtime_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "file_realtime", &file_realtime_obj)) {
+            audio_config_.file_realtime = json_object_get_boolean(file_realtime_obj);
+        }
+        
+        json_object* file_loop_obj = nullptr;
+        if (json_object_object_get_ex(audio_obj, "file_loop", &file_loop_obj)) {
+            audio_config_.file_loop = json_object_get_boolean(file_loop_obj);
+        }
     }
 
     // 解析MCP配置
@@ -123,6 +167,66 @@ bool ConfigManager::loadConfig(const std::string& filepath) {
         if (json_object_object_get_ex(mcp_obj, "port", &port_obj)) {
             mcp_config_.port = json_object_get_int(port_obj);
         }
+        
+        json_object* bind_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "bind_address", &bind_obj)) {
+            mcp_config_.bind_address = json_object_get_string(bind_obj);
+        }
+        
+        json_object* http_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "http", &http_obj)) {
+            mcp_config_.http = json_object_get_boolean(http_obj);
+        }
+        
+        json_object* stdio_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "stdio", &stdio_obj)) {
+            mcp_config_.stdio = json_object_get_boolean(stdio_obj);
+        }
+        
+        json_object* max_conn_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "max_connections", &max_conn_obj)) {
+            mcp_config_.max_connections = json_object_get_int(max_conn_obj);
+        }
+
+        json_object* request_timeout_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "http_request_timeout_ms", &request_timeout_obj)) {
+            mcp_config_.http_request_timeout_ms = json_object_get_int(request_timeout_obj);
+        }
+
+        json_object* idle_timeout_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "http_idle_timeout_ms", &idle_timeout_obj)) {
+            mcp_config_.http_idle_timeout_ms = json_object_get_int(idle_timeout_obj);
+        }
+
+        json_object* tool_workers_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "tool_workers", &tool_workers_obj)) {
+            mcp_config_.tool_workers = json_object_get_int(tool_workers_obj);
+        }
+
+        json_object* tool_queue_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "tool_queue_size", &tool_queue_obj)) {
+            mcp_config_.tool_queue_size = json_object_get_int(tool_queue_obj);
+        }
+
+        json_object* tool_timeout_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "tool_timeout_ms", &tool_timeout_obj)) {
+            mcp_config_.tool_timeout_ms = json_object_get_int(tool_timeout_obj);
+        }
+
+        json_object* page_size_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "tools_page_size", &page_size_obj)) {
+            mcp_config_.tools_page_size = json_object_get_int(page_size_obj);
+        }
+
+        json_object* cache_bytes_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "tool_cache_bytes", &cache_bytes_obj)) {
+            mcp_config_.tool_cache_bytes = json_object_get_int(cache_bytes_obj);
+        }
+
+        json_object* plugin_dir_obj = nullptr;
+        if (json_object_object_get_ex(mcp_obj, "plugin_dir", &plugin_dir_obj)) {
+            mcp_config_.plugin_dir = json_object_get_string(plugin_dir_obj);
+        }
     }
 
     // 解析网络配置
@@ -137,6 +241,159 @@ bool ConfigManager::loadConfig(const std::string& filepath) {
         if (json_object_object_get_ex(network_obj, "timeout", &timeout_obj)) {
             network_config_.timeout = json_object_get_int(timeout_obj);
         }
+        
+        json_object* loop_threads_obj = nullptr;
+        if (json_object_object_get_ex(network_obj, "loop_threads", &loop_threads_obj)) {
+            network_config_.loop_threads = json_object_get_int(loop_threads_obj);
+        }
+    }
+
+    // 解析实时调度配置
+    json_object* realtime_obj = nullptr;
+    if (json_object_object_get_ex(root, "realtime", &realtime_obj)) {
+        json_object* lock_obj = nullptr;
+        if (json_object_object_get_ex(realtime_obj, "lock_memory", &lock_obj)) {
+            realtime_config_.lock_memory = json_object_get_boolean(lock_obj);
+        }
+        
+        json_object* prefault_obj = nullptr;
+        if (json_object_object_get_ex(realtime_obj, "prefault_stack_kb", &prefault_obj)) {
+            realtime_config_.prefault_stack_kb = json_object_get_int(prefault_obj);
+        }
+        // 值直接用于在栈上alloca，负数或超过栈大小都会在启动时崩溃
+        int max_prefault_kb = RealtimeManager::maxPrefaultStackKb();
+        int prefault_kb = std::max(0, std::min(realtime_config_.prefault_stack_kb, max_prefault_kb));
+        if (prefault_kb != realtime_config_.prefault_stack_kb) {
+            std::cerr << "[ConfigManager] 警告: realtime.prefault_stack_kb=" << realtime_config_.prefault_stack_kb
+                      << " 超出范围 [0, " << max_prefault_kb << "]，已调整为 " << prefault_kb << std::endl;
+            realtime_config_.prefault_stack_kb = prefault_kb;
+        }
+        
+        for (int i = 0; i < static_cast<int>(ThreadRole::COUNT); ++i) {
+            const char* role_name = RealtimeManager::roleToString(static_cast<ThreadRole>(i));
+            json_object* thread_obj = nullptr;
+            if (!json_object_object_get_ex(realtime_obj, role_name, &thread_obj)) {
+                continue;
+            }
+            
+            json_object* priority_obj = nullptr;
+            if (json_object_object_get_ex(thread_obj, "priority", &priority_obj)) {
+                realtime_config_.threads[i].priority = json_object_get_int(priority_obj);
+            }
+            
+            json_object* cpu_obj = nullptr;
+            if (json_object_object_get_ex(thread_obj, "cpu", &cpu_obj)) {
+                realtime_config_.threads[i].cpu = json_object_get_int(cpu_obj);
+            }
+        }
+    }
+
+    // 解析追踪配置
+    json_object* trace_obj = nullptr;
+    if (json_object_object_get_ex(root, "trace", &trace_obj)) {
+        json_object* enabled_obj = nullptr;
+        if (json_object_object_get_ex(trace_obj, "enabled", &enabled_obj)) {
+            trace_config_.enabled = json_object_get_boolean(enabled_obj);
+        }
+        
+        json_object* output_obj = nullptr;
+        if (json_object_object_get_ex(trace_obj, "output_file", &output_obj)) {
+            trace_config_.output_file = json_object_get_string(output_obj);
+        }
+        
+        json_object* buffer_obj = nullptr;
+        if (json_object_object_get_ex(trace_obj, "buffer_events", &buffer_obj)) {
+            trace_config_.buffer_events = json_object_get_int(buffer_obj);
+        }
+    }
+
+    // 解析指标端点配置
+    json_object* metrics_obj = nullptr;
+    if (json_object_object_get_ex(root, "metrics", &metrics_obj)) {
+        json_object* enabled_obj = nullptr;
+        if (json_object_object_get_ex(metrics_obj, "enabled", &enabled_obj)) {
+            metrics_config_.enabled = json_object_get_boolean(enabled_obj);
+        }
+        
+        json_object* bind_obj = nullptr;
+        if (json_object_object_get_ex(metrics_obj, "bind_address", &bind_obj)) {
+            metrics_config_.bind_address = json_object_get_string(bind_obj);
+        }
+        
+        json_object* port_obj = nullptr;
+        if (json_object_object_get_ex(metrics_obj, "port", &port_obj)) {
+            metrics_config_.port = json_object_get_int(port_obj);
+        }
+    }
+
+    // 解析日志配置
+    json_object* logging_obj = nullptr;
+    if (json_object_object_get_ex(root, "logging", &logging_obj)) {
+        json_object* level_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "level", &level_obj) &&
+            !Logger::parseLevel(json_object_get_string(level_obj), logging_config_.level)) {
+            std::cerr << "[ConfigManager] 警告: 未知的日志级别: " << json_object_get_string(level_obj) << std::endl;
+        }
+        
+        json_object* file_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "file", &file_obj)) {
+            logging_config_.file = json_object_get_string(file_obj);
+        }
+        
+        json_object* async_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "async", &async_obj)) {
+            logging_config_.async = json_object_get_boolean(async_obj);
+        }
+        
+        json_object* ring_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "ring_records", &ring_obj)) {
+            logging_config_.ring_records = json_object_get_int(ring_obj);
+        }
+        
+        json_object* overflow_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "overflow", &overflow_obj)) {
+            std::string overflow = json_object_get_string(overflow_obj);
+            logging_config_.overflow = overflow == "block" ? LogOverflowPolicy::BLOCK : LogOverflowPolicy::DROP;
+        }
+        
+        json_object* interval_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "flush_interval_ms", &interval_obj)) {
+            logging_config_.flush_interval_ms = json_object_get_int(interval_obj);
+        }
+        
+        json_object* binary_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "binary", &binary_obj)) {
+            logging_config_.binary = json_object_get_boolean(binary_obj);
+        }
+        
+        json_object* binary_file_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "binary_file", &binary_file_obj)) {
+            logging_config_.binary_file = json_object_get_string(binary_file_obj);
+        }
+        
+        json_object* max_kb_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "binary_max_file_kb", &max_kb_obj)) {
+            logging_config_.binary_max_file_kb = json_object_get_int(max_kb_obj);
+        }
+        
+        json_object* max_files_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "binary_max_files", &max_files_obj)) {
+            logging_config_.binary_max_files = json_object_get_int(max_files_obj);
+        }
+        
+        json_object* modules_obj = nullptr;
+        if (json_object_object_get_ex(logging_obj, "modules", &modules_obj)) {
+            logging_config_.module_levels.clear();
+            json_object_object_foreach(modules_obj, module, module_level_obj) {
+                LogLevel module_level;
+                if (Logger::parseLevel(json_object_get_string(module_level_obj), module_level)) {
+                    logging_config_.module_levels[module] = module_level;
+                } else {
+                    std::cerr << "[ConfigManager] 警告: 模块 " << module << " 的日志级别无效: "
+                              << json_object_get_string(module_level_obj) << std::endl;
+                }
+            }
+        }
     }
 
     json_object_put(root); // 释放内存
@@ -182,6 +439,20 @@ bool ConfigManager::saveConfig(const std::string& filepath) {
                           json_object_new_int(audio_config_.channels));
     json_object_object_add(audio_obj, "opus_bitrate", 
                           json_object_new_int(audio_config_.opus_bitrate));
+    json_object_object_add(audio_obj, "frame_pool_size", 
+                          json_object_new_int(audio_config_.frame_pool_size));
+    json_object_object_add(audio_obj, "duplex_sync", 
+                          json_object_new_boolean(audio_config_.duplex_sync));
+    json_object_object_add(audio_obj, "backend", 
+                          json_object_new_string(audio_config_.backend.c_str()));
+    json_object_object_add(audio_obj, "input_file", 
+                          json_object_new_string(audio_config_.input_file.c_str()));
+    json_object_object_add(audio_obj, "output_file", 
+                          json_object_new_string(audio_config_.output_file.c_str()));
+    json_object_object_add(audio_obj, "file_realtime", 
+                          json_object_new_boolean(audio_config_.file_realtime));
+    json_object_object_add(audio_obj, "file_loop", 
+                          json_object_new_boolean(audio_config_.file_loop));
     json_object_object_add(root, "audio", audio_obj);
 
     // MCP配置
@@ -190,6 +461,30 @@ bool ConfigManager::saveConfig(const std::string& filepath) {
                           json_object_new_boolean(mcp_config_.enabled));
     json_object_object_add(mcp_obj, "port", 
                           json_object_new_int(mcp_config_.port));
+    json_object_object_add(mcp_obj, "bind_address", 
+                          json_object_new_string(mcp_config_.bind_address.c_str()));
+    json_object_object_add(mcp_obj, "http", 
+                          json_object_new_boolean(mcp_config_.http));
+    json_object_object_add(mcp_obj, "stdio", 
+                          json_object_new_boolean(mcp_config_.stdio));
+    json_object_object_add(mcp_obj, "max_connections", 
+                          json_object_new_int(mcp_config_.max_connections));
+    json_object_object_add(mcp_obj, "http_request_timeout_ms", 
+                          json_object_new_int(mcp_config_.http_request_timeout_ms));
+    json_object_object_add(mcp_obj, "http_idle_timeout_ms", 
+                          json_object_new_int(mcp_config_.http_idle_timeout_ms));
+    json_object_object_add(mcp_obj, "tool_workers", 
+                          json_object_new_int(mcp_config_.tool_workers));
+    json_object_object_add(mcp_obj, "tool_queue_size", 
+                          json_object_new_int(mcp_config_.tool_queue_size));
+    json_object_object_add(mcp_obj, "tool_timeout_ms", 
+                          json_object_new_int(mcp_config_.tool_timeout_ms));
+    json_object_object_add(mcp_obj, "tools_page_size", 
+                          json_object_new_int(mcp_config_.tools_page_size));
+    json_object_object_add(mcp_obj, "tool_cache_bytes", 
+                          json_object_new_int(mcp_config_.tool_cache_bytes));
+    json_object_object_add(mcp_obj, "plugin_dir", 
+                          json_object_new_string(mcp_config_.plugin_dir.c_str()));
     json_object_object_add(root, "mcp", mcp_obj);
 
     // 网络配置
@@ -198,8 +493,77 @@ bool ConfigManager::saveConfig(const std::string& filepath) {
                           json_object_new_int(network_config_.reconnect_interval));
     json_object_object_add(network_obj, "timeout", 
                           json_object_new_int(network_config_.timeout));
+    json_object_object_add(network_obj, "loop_threads", 
+                          json_object_new_int(network_config_.loop_threads));
     json_object_object_add(root, "network", network_obj);
 
+    // 实时调度配置
+    json_object* realtime_obj = json_object_new_object();
+    json_object_object_add(realtime_obj, "lock_memory", 
+                          json_object_new_boolean(realtime_config_.lock_memory));
+    json_object_object_add(realtime_obj, "prefault_stack_kb", 
+                          json_object_new_int(realtime_config_.prefault_stack_kb));
+    for (int i = 0; i < static_cast<int>(ThreadRole::COUNT); ++i) {
+        json_object* thread_obj = json_object_new_object();
+        json_object_object_add(thread_obj, "priority", 
+                              json_object_new_int(realtime_config_.threads[i].priority));
+        json_object_object_add(thread_obj, "cpu", 
+                              json_object_new_int(realtime_config_.threads[i].cpu));
+        json_object_object_add(realtime_obj, RealtimeManager::roleToString(static_cast<ThreadRole>(i)), 
+                              thread_obj);
+    }
+    json_object_object_add(root, "realtime", realtime_obj);
+
+    // 追踪配置
+    json_object* trace_obj = json_object_new_object();
+    json_object_object_add(trace_obj, "enabled", 
+                          json_object_new_boolean(trace_config_.enabled));
+    json_object_object_add(trace_obj, "output_file", 
+                          json_object_new_string(trace_config_.output_file.c_str()));
+    json_object_object_add(trace_obj, "buffer_events", 
+                          json_object_new_int(trace_config_.buffer_events));
+    json_object_object_add(root, "trace", trace_obj);
+
+    // 指标端点配置
+    json_object* metrics_obj = json_object_new_object();
+    json_object_object_add(metrics_obj, "enabled", 
+                          json_object_new_boolean(metrics_config_.enabled));
+    json_object_object_add(metrics_obj, "bind_address", 
+                          json_object_new_string(metrics_config_.bind_address.c_str()));
+    json_object_object_add(metrics_obj, "port", 
+                          json_object_new_int(metrics_config_.port));
+    json_object_object_add(root, "metrics", metrics_obj);
+
+    // 日志配置
+    json_object* logging_obj = json_object_new_object();
+    json_object_object_add(logging_obj, "level", 
+                          json_object_new_string(Logger::levelToString(logging_config_.level)));
+    json_object_object_add(logging_obj, "file", 
+                          json_object_new_string(logging_config_.file.c_str()));
+    json_object_object_add(logging_obj, "async", 
+                          json_object_new_boolean(logging_config_.async));
+    json_object_object_add(logging_obj, "ring_records", 
+                          json_object_new_int(logging_config_.ring_records));
+    json_object_object_add(logging_obj, "overflow", 
+                          json_object_new_string(logging_config_.overflow == LogOverflowPolicy::BLOCK ? "block" : "drop"));
+    json_object_object_add(logging_obj, "flush_interval_ms", 
+                          json_object_new_int(logging_config_.flush_interval_ms));
+    json_object_object_add(logging_obj, "binary", 
+                          json_object_new_boolean(logging_config_.binary));
+    json_object_object_add(logging_obj, "binary_file", 
+                          json_object_new_string(logging_config_.binary_file.c_str()));
+    json_object_object_add(logging_obj, "binary_max_file_kb", 
+                          json_object_new_int(logging_config_.binary_max_file_kb));
+    json_object_object_add(logging_obj, "binary_max_files", 
+                          json_object_new_int(logging_config_.binary_max_files));
+    json_object* modules_obj = json_object_new_object();
+    for (const auto& module : logging_config_.module_levels) {
+        json_object_object_add(modules_obj, module.first.c_str(),
+                              json_object_new_string(Logger::levelToString(module.second)));
+    }
+    json_object_object_add(logging_obj, "modules", modules_obj);
+    json_object_object_add(root, "logging", logging_obj);
+
     // 写入文件
     std::ofstream file(path);
     if (!file.is_open()) {
@@ -3,6 +3,10 @@
 #include <string>
 #include <map>
 #include "xiaozhi_types.h"
+#include "realtime.h"
+#include "trace.h"
+#include "metrics.h"
+#include "logger.h"
 
 namespace xiaozhi {
 
@@ -18,16 +22,36 @@ struct AudioConfig {
     int sample_rate;
     int channels;
     int opus_bitrate;
+    int frame_pool_size = 64;  // 预分配的音频帧数
+    bool duplex_sync = false;  // 链接采集/播放流并补偿时钟漂移
+    std::string backend = "alsa";   // 音频后端: alsa | file | null
+    std::string input_file;         // file后端的采集输入文件 (WAV或raw)
+    std::string output_file;        // file后端的播放输出文件
+    bool file_realtime = true;      // file/null后端按真实时间节拍读写
+    bool file_loop = false;         // 输入文件结束后循环
 };
 
 struct McpConfig {
     bool enabled;
     int port;
+    std::string bind_address = "127.0.0.1";
+    bool http = true;           // HTTP/1.1 + SSE传输，监听port
+    bool stdio = false;         // 标准输入/输出传输，启用后控制台日志改写到stderr
+    int max_connections = 64;
+    int http_request_timeout_ms = 10000;    // HTTP请求从首字节到收全的期限，超时回复408，0表示不限
+    int http_idle_timeout_ms = 60000;       // HTTP连接空闲超过该时间即关闭，0表示不限
+    int tool_workers = 0;           // 工具执行线程数，0表示自动（CPU核数，最多4个）
+    int tool_queue_size = 64;       // 排队等待执行的工具调用上限
+    int tool_timeout_ms = 30000;    // 工具调用默认期限
+    int tools_page_size = 0;        // tools/list每页工具数，0表示一次返回全部
+    int tool_cache_bytes = 1048576; // 幂等工具结果缓存上限，0表示关闭
+    std::string plugin_dir;         // 工具插件清单和共享库所在目录，为空时不加载插件
 };
 
 struct NetworkConfig {
     int reconnect_interval;
     int timeout;
+    int loop_threads = 0;   // 共享事件循环线程数，0表示自动（CPU核数，最多2个）
 };
 
 class ConfigManager {
@@ -42,12 +66,20 @@ public:
     AudioConfig getAudioConfig() const { return audio_config_; }
     McpConfig getMcpConfig() const { return mcp_config_; }
     NetworkConfig getNetworkConfig() const { return network_config_; }
+    RealtimeConfig getRealtimeConfig() const { return realtime_config_; }
+    TraceConfig getTraceConfig() const { return trace_config_; }
+    MetricsConfig getMetricsConfig() const { return metrics_config_; }
+    LoggingConfig getLoggingConfig() const { return logging_config_; }
 
     // 设置配置
     void setServerConfig(const ServerConfig& config) { server_config_ = config; }
     void setAudioConfig(const AudioConfig& config) { audio_config_ = config; }
     void setMcpConfig(const McpConfig& config) { mcp_config_ = config; }
     void setNetworkConfig(const NetworkConfig& config) { network_config_ = config; }
+    void setRealtimeConfig(const RealtimeConfig& config) { realtime_config_ = config; }
+    void setTraceConfig(const TraceConfig& config) { trace_config_ = config; }
+    void setMetricsConfig(const MetricsConfig& config) { metrics_config_ = config; }
+    void setLoggingConfig(const LoggingConfig& config) { logging_config_ = config; }
 
 private:
     ConfigManager() = default;
@@ -57,6 +89,10 @@ private:
     AudioConfig audio_config_;
     McpConfig mcp_config_;
     NetworkConfig network_config_;
+    RealtimeConfig realtime_config_;
+    TraceConfig trace_config_;
+    MetricsConfig metrics_config_;
+    LoggingConfig logging_config_;
 
     std::string config_path_;
 };
@@ -0,0 +1,351 @@
+#include "event_loop.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <csignal>
+#include <condition_variable>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/signalfd.h>
+
+namespace xiaozhi {
+
+namespace {
+
+constexpr int kMaxEvents = 32;
+
+uint64_t makeToken(int fd, uint32_t generation) {
+    return (static_cast<uint64_t>(generation) << 32) | static_cast<uint32_t>(fd);
+}
+
+timespec toTimespec(std::chrono::milliseconds duration) {
+    timespec ts;
+    ts.tv_sec = static_cast<time_t>(duration.count() / 1000);
+    ts.tv_nsec = static_cast<long>(duration.count() % 1000) * 1000000L;
+    return ts;
+}
+
+} // namespace
+
+EventLoop::EventLoop() : epoll_fd_(-1), wake_fd_(-1) {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        std::cerr << "[EventLoop] 错误: 无法创建epoll/eventfd: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = makeToken(wake_fd_, 0);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) != 0) {
+        std::cerr << "[EventLoop] 错误: 无法注册eventfd: " << strerror(errno) << std::endl;
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (int fd : owned_fds_) {
+        close(fd);
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+    }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+    }
+}
+
+bool EventLoop::addFd(int fd, uint32_t events, IoCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return registerFdLocked(fd, events, nextGenerationLocked(), std::move(callback));
+}
+
+uint32_t EventLoop::nextGenerationLocked() {
+    uint32_t generation = next_generation_++;
+    if (next_generation_ == 0) {
+        next_generation_ = 1;
+    }
+    return generation;
+}
+
+bool EventLoop::registerFdLocked(int fd, uint32_t events, uint32_t generation, IoCallback callback) {
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = makeToken(fd, generation);
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) != 0) {
+        std::cerr << "[EventLoop] 错误: 无法注册fd " << fd << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+    handlers_[fd] = {generation, std::make_shared<IoCallback>(std::move(callback))};
+    return true;
+}
+
+bool EventLoop::modifyFd(int fd, uint32_t events) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = handlers_.find(fd);
+    if (it == handlers_.end()) {
+        return false;
+    }
+    epoll_event event{};
+    event.events = events;
+    event.data.u64 = makeToken(fd, it->second.generation);
+    return epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &event) == 0;
+}
+
+void EventLoop::removeFd(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (handlers_.erase(fd) > 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+int EventLoop::addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval,
+                        TimerCallback callback) {
+    int fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[EventLoop] 错误: 无法创建timerfd: " << strerror(errno) << std::endl;
+        return -1;
+    }
+
+    bool repeat = interval.count() > 0;
+    int timer_id;
+    {
+        // 先登记再启动，立即到期的定时器也能在回调中查到自己
+        std::lock_guard<std::mutex> lock(mutex_);
+        timer_id = next_timer_id_++;
+        if (next_timer_id_ < 0) {
+            next_timer_id_ = 1;
+        }
+        uint32_t generation = nextGenerationLocked();
+        bool added = registerFdLocked(fd, EPOLLIN, generation, [this, timer_id, repeat, callback](uint32_t) {
+            {
+                // 持锁读取：并发的cancelTimer要么在此之前已注销（这里查不到），
+                // 要么等到读取结束后才关闭fd，不会读到已关闭或被复用的fd
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = timers_.find(timer_id);
+                if (it == timers_.end()) {
+                    return;
+                }
+                auto handler = handlers_.find(it->second.fd);
+                if (handler == handlers_.end() || handler->second.generation != it->second.generation) {
+                    return;
+                }
+                uint64_t expirations;
+                if (read(it->second.fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                    return;
+                }
+                if (!repeat) {
+                    releaseTimerLocked(it);
+                }
+            }
+            callback();
+        });
+        if (!added) {
+            close(fd);
+            return -1;
+        }
+        owned_fds_.insert(fd);
+        timers_[timer_id] = {fd, generation};
+    }
+
+    // it_value为0表示停止定时器，立即触发时取1ns
+    itimerspec spec{};
+    spec.it_value = toTimespec(delay);
+    if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0) {
+        spec.it_value.tv_nsec = 1;
+    }
+    spec.it_interval = toTimespec(interval);
+    timerfd_settime(fd, 0, &spec, nullptr);
+    return timer_id;
+}
+
+void EventLoop::cancelTimer(int timer_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = timers_.find(timer_id);
+    if (it != timers_.end()) {
+        releaseTimerLocked(it);
+    }
+}
+
+void EventLoop::releaseTimerLocked(std::map<int, Timer>::iterator it) {
+    int fd = it->second.fd;
+    auto handler = handlers_.find(fd);
+    if (handler != handlers_.end() && handler->second.generation == it->second.generation) {
+        handlers_.erase(handler);
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    }
+    if (owned_fds_.erase(fd) > 0) {
+        close(fd);
+    }
+    timers_.erase(it);
+}
+
+bool EventLoop::blockSignals(const std::vector<int>& signals) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals) {
+        sigaddset(&mask, signo);
+    }
+    int err = pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+    if (err != 0) {
+        std::cerr << "[EventLoop] 错误: 无法屏蔽信号: " << strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool EventLoop::watchSignals(const std::vector<int>& signals, SignalCallback callback) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signo : signals) {
+        sigaddset(&mask, signo);
+    }
+    int fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (fd < 0) {
+        std::cerr << "[EventLoop] 错误: 无法创建signalfd: " << strerror(errno) << std::endl;
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        owned_fds_.insert(fd);
+    }
+    bool added = addFd(fd, EPOLLIN, [fd, callback](uint32_t) {
+        signalfd_siginfo info;
+        while (read(fd, &info, sizeof(info)) == sizeof(info)) {
+            callback(static_cast<int>(info.ssi_signo));
+        }
+    });
+    if (!added) {
+        closeOwnedFd(fd);
+    }
+    return added;
+}
+
+void EventLoop::post(Task task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(std::move(task));
+    }
+    wakeup();
+}
+
+void EventLoop::run() {
+    loop_thread_ = std::this_thread::get_id();
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = true;
+    }
+
+    epoll_event events[kMaxEvents];
+    while (!stop_requested_) {
+        int count = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "[EventLoop] 错误: epoll_wait失败: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        for (int i = 0; i < count; ++i) {
+            int fd = static_cast<int>(events[i].data.u64 & 0xFFFFFFFFu);
+            uint32_t generation = static_cast<uint32_t>(events[i].data.u64 >> 32);
+            if (generation == 0) {
+                uint64_t value;
+                ssize_t bytes = read(wake_fd_, &value, sizeof(value));
+                (void)bytes;
+                continue;
+            }
+
+            // 回调在锁外执行，允许回调中增删fd；同一批次中已被移除的fd跳过
+            std::shared_ptr<IoCallback> callback;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                auto it = handlers_.find(fd);
+                if (it == handlers_.end() || it->second.generation != generation) {
+                    continue;
+                }
+                callback = it->second.callback;
+            }
+            (*callback)(events[i].events);
+        }
+
+        runTasks();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    runTasks();
+    stop_requested_ = false;
+    loop_thread_ = std::thread::id();
+}
+
+void EventLoop::stop() {
+    stop_requested_ = true;
+    wakeup();
+}
+
+void EventLoop::runSync(const Task& task) {
+    if (isInLoopThread()) {
+        task();
+        return;
+    }
+
+    std::mutex done_mutex;
+    std::condition_variable done_cv;
+    bool done = false;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!running_) {
+            lock.unlock();
+            task();
+            return;
+        }
+        // 任务按投递顺序执行，执行到这里时之前的回调和任务都已结束
+        tasks_.push_back([&]() {
+            task();
+            std::lock_guard<std::mutex> done_lock(done_mutex);
+            done = true;
+            done_cv.notify_one();
+        });
+    }
+    wakeup();
+
+    std::unique_lock<std::mutex> done_lock(done_mutex);
+    done_cv.wait(done_lock, [&done] { return done; });
+}
+
+void EventLoop::drain() {
+    runSync([]() {});
+}
+
+void EventLoop::wakeup() {
+    uint64_t value = 1;
+    ssize_t written = write(wake_fd_, &value, sizeof(value));
+    (void)written;
+}
+
+void EventLoop::runTasks() {
+    std::vector<Task> tasks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) {
+        task();
+    }
+}
+
+void EventLoop::closeOwnedFd(int fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (owned_fds_.erase(fd) > 0) {
+        close(fd);
+    }
+}
+
+} // namespace xiaozhi
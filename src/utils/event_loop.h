@@ -0,0 +1,99 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <set>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+
+namespace xiaozhi {
+
+// 基于epoll的事件循环：文件描述符就绪、timerfd定时器、signalfd信号和跨线程投递的任务
+// 都在run()所在的线程中回调。没有事件时epoll_wait无限期阻塞，空闲时不产生唤醒。
+class EventLoop {
+public:
+    using IoCallback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using SignalCallback = std::function<void(int signo)>;
+    using Task = std::function<void()>;
+
+    EventLoop();
+    ~EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    bool isValid() const { return epoll_fd_ >= 0 && wake_fd_ >= 0; }
+
+    // 注册文件描述符，events为EPOLLIN/EPOLLOUT等（水平触发）；可在任意线程调用。
+    // 关闭fd之前必须先removeFd，移除后尚未分发的就绪事件会被丢弃
+    bool addFd(int fd, uint32_t events, IoCallback callback);
+    bool modifyFd(int fd, uint32_t events);
+    void removeFd(int fd);
+
+    // 定时器：delay后首次触发，interval为0时只触发一次；返回定时器ID，失败返回-1。
+    // ID单调递增、不会复用，取消已触发的单次定时器或未知ID时什么也不做
+    int addTimer(std::chrono::milliseconds delay, std::chrono::milliseconds interval, TimerCallback callback);
+    void cancelTimer(int timer_id);
+
+    // 通过signalfd在事件循环中处理信号。信号必须先用blockSignals在所有线程中屏蔽，
+    // 因此blockSignals应在main开头、创建任何线程之前调用
+    bool watchSignals(const std::vector<int>& signals, SignalCallback callback);
+    static bool blockSignals(const std::vector<int>& signals);
+
+    // 跨线程投递任务，在事件循环线程中按投递顺序执行
+    void post(Task task);
+
+    // 阻塞运行直到stop()
+    void run();
+    void stop();
+
+    // 在循环线程中执行task并等待其完成，此前投递的任务和正在执行的回调也都已结束；
+    // 已在循环线程中或循环未运行时直接在当前线程执行
+    void runSync(const Task& task);
+
+    // 等待此前投递的任务和正在执行的回调全部结束，用于组件析构前确认回调不再访问自身
+    void drain();
+    bool isInLoopThread() const { return loop_thread_.load() == std::this_thread::get_id(); }
+
+private:
+    struct Handler {
+        uint32_t generation;
+        std::shared_ptr<IoCallback> callback;
+    };
+
+    // 定时器ID对应的timerfd及其注册代数，代数与handlers_中的一致时fd才仍属于该定时器
+    struct Timer {
+        int fd;
+        uint32_t generation;
+    };
+
+    uint32_t nextGenerationLocked();
+    bool registerFdLocked(int fd, uint32_t events, uint32_t generation, IoCallback callback);
+    void releaseTimerLocked(std::map<int, Timer>::iterator it);
+    void wakeup();
+    void runTasks();
+    void closeOwnedFd(int fd);
+
+    int epoll_fd_;
+    int wake_fd_;
+
+    std::mutex mutex_;
+    std::map<int, Handler> handlers_;
+    uint32_t next_generation_ = 1;      // 区分复用了同一编号的fd，0留给wake_fd_
+    std::set<int> owned_fds_;           // 由事件循环创建的timerfd/signalfd
+    std::map<int, Timer> timers_;
+    int next_timer_id_ = 1;
+    std::vector<Task> tasks_;
+    bool running_ = false;              // 受mutex_保护，drain()据此判断投递的任务是否还会执行
+
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<std::thread::id> loop_thread_{std::thread::id()};
+};
+
+} // namespace xiaozhi
@@ -0,0 +1,93 @@
+#include "event_loop_pool.h"
+#include <iostream>
+#include <algorithm>
+#include "realtime.h"
+#include "trace.h"
+
+namespace xiaozhi {
+
+namespace {
+
+constexpr int kMaxAutoThreads = 2;
+
+} // namespace
+
+EventLoopPool& EventLoopPool::getInstance() {
+    static EventLoopPool instance;
+    return instance;
+}
+
+EventLoopPool::EventLoopPool() : configured_threads_(0), started_(false) {
+}
+
+EventLoopPool::~EventLoopPool() {
+    stop();
+}
+
+void EventLoopPool::configure(int threads) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (started_) {
+        std::cerr << "[EventLoopPool] 警告: 事件循环已启动，线程数配置不生效" << std::endl;
+        return;
+    }
+    configured_threads_ = threads;
+}
+
+EventLoop* EventLoopPool::next() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!started_) {
+            start();
+        }
+    }
+    size_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+    return loops_[index % loops_.size()].get();
+}
+
+size_t EventLoopPool::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return loops_.size();
+}
+
+void EventLoopPool::start() {
+    int count = configured_threads_;
+    if (count <= 0) {
+        int cpus = static_cast<int>(std::thread::hardware_concurrency());
+        count = std::max(1, std::min(cpus, kMaxAutoThreads));
+    }
+
+    for (int i = 0; i < count; ++i) {
+        loops_.emplace_back(new EventLoop());
+        thread_names_.push_back("loop-" + std::to_string(i));
+    }
+    for (int i = 0; i < count; ++i) {
+        threads_.emplace_back(&EventLoopPool::loopThread, this, static_cast<size_t>(i));
+    }
+    started_ = true;
+    std::cout << "[EventLoopPool] 已启动 " << count << " 个事件循环线程" << std::endl;
+}
+
+void EventLoopPool::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (threads_.empty()) {
+        return;
+    }
+    for (auto& loop : loops_) {
+        loop->stop();
+    }
+    for (auto& thread : threads_) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads_.clear();
+    // 循环对象保留到进程退出，组件析构时仍可安全地removeFd；停止后不再重新启动
+}
+
+void EventLoopPool::loopThread(size_t index) {
+    RealtimeManager::getInstance().applyToCurrentThread(ThreadRole::NETWORK);
+    TRACE_THREAD_NAME(thread_names_[index].c_str());
+    loops_[index]->run();
+}
+
+} // namespace xiaozhi
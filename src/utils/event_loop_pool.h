@@ -0,0 +1,47 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "event_loop.h"
+
+namespace xiaozhi {
+
+// 固定数量的事件循环线程，由各网络和协议组件共享，取代“每个组件一个线程”。
+// 首次调用next()时按配置的线程数启动；线程按ThreadRole::NETWORK设置调度策略
+class EventLoopPool {
+public:
+    static EventLoopPool& getInstance();
+
+    // 线程数，<=0表示自动（CPU核数，最多2个）；只在启动前生效
+    void configure(int threads);
+
+    // 轮询分配一个事件循环；组件应在整个生命周期内固定使用同一个循环
+    EventLoop* next();
+    size_t size() const;
+
+    // 停止并回收全部线程，进程退出前调用
+    void stop();
+
+private:
+    EventLoopPool();
+    ~EventLoopPool();
+    EventLoopPool(const EventLoopPool&) = delete;
+    EventLoopPool& operator=(const EventLoopPool&) = delete;
+
+    void start();
+    void loopThread(size_t index);
+
+    mutable std::mutex mutex_;
+    int configured_threads_;
+    bool started_;
+    std::vector<std::unique_ptr<EventLoop>> loops_;
+    std::vector<std::string> thread_names_;     // 追踪只保存名称指针，需与线程同寿命
+    std::vector<std::thread> threads_;
+    std::atomic<size_t> next_index_{0};
+};
+
+} // namespace xiaozhi
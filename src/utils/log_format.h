@@ -0,0 +1,184 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <type_traits>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+
+namespace xiaozhi {
+
+// 日志参数格式化：按类型直接追加到输出缓冲，整数和浮点不经过iostream
+inline void appendLogArg(std::string& out, const std::string& value) {
+    out += value;
+}
+
+inline void appendLogArg(std::string& out, const char* value) {
+    out += value ? value : "(null)";
+}
+
+inline void appendLogArg(std::string& out, char* value) {
+    appendLogArg(out, static_cast<const char*>(value));
+}
+
+inline void appendLogArg(std::string& out, char value) {
+    out += value;
+}
+
+inline void appendLogArg(std::string& out, bool value) {
+    out += value ? "true" : "false";
+}
+
+template <typename T>
+void appendLogArg(std::string& out, const T& value) {
+    char buffer[32];
+    if constexpr (std::is_enum<T>::value) {
+        appendLogArg(out, static_cast<typename std::underlying_type<T>::type>(value));
+        return;
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        int n = snprintf(buffer, sizeof(buffer), "%lld", static_cast<long long>(value));
+        out.append(buffer, static_cast<size_t>(n));
+    } else if constexpr (std::is_integral<T>::value) {
+        int n = snprintf(buffer, sizeof(buffer), "%llu", static_cast<unsigned long long>(value));
+        out.append(buffer, static_cast<size_t>(n));
+    } else if constexpr (std::is_floating_point<T>::value) {
+        int n = snprintf(buffer, sizeof(buffer), "%g", static_cast<double>(value));
+        out.append(buffer, static_cast<size_t>(n));
+    } else if constexpr (std::is_pointer<T>::value) {
+        int n = snprintf(buffer, sizeof(buffer), "%p", static_cast<const void*>(value));
+        out.append(buffer, static_cast<size_t>(n));
+    } else {
+        // 其他类型要求支持operator<<
+        std::ostringstream stream;
+        stream << value;
+        out += stream.str();
+    }
+}
+
+// 依次替换fmt中的"{}"，"{{"和"}}"输出字面大括号；占位符多于参数时原样保留
+inline void formatLogMessage(std::string& out, const char* fmt) {
+    for (const char* p = fmt; *p; ++p) {
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            ++p;
+        }
+        out += *p;
+    }
+}
+
+template <typename T, typename... Rest>
+void formatLogMessage(std::string& out, const char* fmt, const T& value, const Rest&... rest) {
+    for (const char* p = fmt; *p; ++p) {
+        if (p[0] == '{' && p[1] == '}') {
+            appendLogArg(out, value);
+            formatLogMessage(out, p + 2, rest...);
+            return;
+        }
+        if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}')) {
+            ++p;
+        }
+        out += *p;
+    }
+}
+
+// 二进制日志模式下的参数编码：每个参数为1字节类型标记加原始字节，格式化推迟到解码端
+enum class BinaryArgType : uint8_t {
+    INT = 1,        // int64
+    UINT = 2,       // uint64
+    DOUBLE = 3,     // double
+    STRING = 4,     // uint16长度 + 字节
+    BOOL = 5,       // uint8
+    CHAR = 6,       // uint8
+    POINTER = 7     // uint64
+};
+
+// 单条记录的参数缓冲，与日志环形缓冲的槽位大小一致；放不下的参数整体丢弃并标记截断
+struct BinaryArgBuffer {
+    static constexpr size_t kCapacity = 496;
+
+    char data[kCapacity];
+    size_t size = 0;
+    bool truncated = false;
+
+    void put(BinaryArgType type, const void* value, size_t length) {
+        if (truncated || size + 1 + length > kCapacity) {
+            truncated = true;
+            return;
+        }
+        data[size++] = static_cast<char>(type);
+        memcpy(data + size, value, length);
+        size += length;
+    }
+
+    void putString(const char* value, size_t length) {
+        // 字符串过长时只保留能放下的前缀
+        if (truncated || size + 3 > kCapacity) {
+            truncated = true;
+            return;
+        }
+        length = std::min(length, kCapacity - size - 3);
+        uint16_t stored = static_cast<uint16_t>(length);
+        data[size++] = static_cast<char>(BinaryArgType::STRING);
+        memcpy(data + size, &stored, sizeof(stored));
+        memcpy(data + size + sizeof(stored), value, length);
+        size += sizeof(stored) + length;
+    }
+};
+
+inline void appendBinaryArg(BinaryArgBuffer& out, const std::string& value) {
+    out.putString(value.data(), value.size());
+}
+
+inline void appendBinaryArg(BinaryArgBuffer& out, const char* value) {
+    const char* text = value ? value : "(null)";
+    out.putString(text, strlen(text));
+}
+
+inline void appendBinaryArg(BinaryArgBuffer& out, char* value) {
+    appendBinaryArg(out, static_cast<const char*>(value));
+}
+
+inline void appendBinaryArg(BinaryArgBuffer& out, char value) {
+    out.put(BinaryArgType::CHAR, &value, 1);
+}
+
+inline void appendBinaryArg(BinaryArgBuffer& out, bool value) {
+    uint8_t stored = value ? 1 : 0;
+    out.put(BinaryArgType::BOOL, &stored, 1);
+}
+
+template <typename T>
+void appendBinaryArg(BinaryArgBuffer& out, const T& value) {
+    if constexpr (std::is_enum<T>::value) {
+        appendBinaryArg(out, static_cast<typename std::underlying_type<T>::type>(value));
+    } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+        int64_t stored = static_cast<int64_t>(value);
+        out.put(BinaryArgType::INT, &stored, sizeof(stored));
+    } else if constexpr (std::is_integral<T>::value) {
+        uint64_t stored = static_cast<uint64_t>(value);
+        out.put(BinaryArgType::UINT, &stored, sizeof(stored));
+    } else if constexpr (std::is_floating_point<T>::value) {
+        double stored = static_cast<double>(value);
+        out.put(BinaryArgType::DOUBLE, &stored, sizeof(stored));
+    } else if constexpr (std::is_pointer<T>::value) {
+        uint64_t stored = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+        out.put(BinaryArgType::POINTER, &stored, sizeof(stored));
+    } else {
+        // 其他类型只能在调用线程转成文本
+        std::string text;
+        appendLogArg(text, value);
+        out.putString(text.data(), text.size());
+    }
+}
+
+inline void appendBinaryArgs(BinaryArgBuffer&) {
+}
+
+template <typename T, typename... Rest>
+void appendBinaryArgs(BinaryArgBuffer& out, const T& value, const Rest&... rest) {
+    appendBinaryArg(out, value);
+    appendBinaryArgs(out, rest...);
+}
+
+} // namespace xiaozhi
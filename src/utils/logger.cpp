@@ -1,117 +1,600 @@
 #include "logger.h"
 #include "utils.h"
-#include <iomanip>
-#include <sstream>
-#include <cstdarg>
+#include "metrics.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <climits>
+#include <fcntl.h>
 #include <pwd.h>
 #include <unistd.h>
+#include <sys/uio.h>
 
 namespace xiaozhi {
 
+// 单条日志记录：定长槽位，超长消息截断，入队时不分配内存。
+// format_id为0时text是格式化好的文本，否则是二进制模式下编码的参数
+struct LogRecord {
+    static constexpr size_t kMaxMessage = BinaryArgBuffer::kCapacity;
+
+    int64_t timestamp_ns;
+    LogLevel level;
+    uint32_t format_id;
+    uint16_t length;
+    char text[kMaxMessage];
+
+    void assign(int64_t ts, LogLevel lvl, uint32_t id, const char* data, size_t size) {
+        timestamp_ns = ts;
+        level = lvl;
+        format_id = id;
+        length = static_cast<uint16_t>(std::min(size, kMaxMessage));
+        memcpy(text, data, length);
+        if (id == 0 && size > kMaxMessage) {
+            memcpy(text + kMaxMessage - 3, "...", 3);
+        }
+    }
+};
+
+// 单生产者单消费者环形缓冲：生产者为所属线程，消费者为持有drain_mutex_的线程
+class LogRing {
+public:
+    explicit LogRing(size_t capacity) : slots_(roundUpPowerOfTwo(capacity)), mask_(slots_.size() - 1) {}
+
+    // 直接写入槽位，只拷贝消息的实际长度
+    bool push(int64_t timestamp_ns, LogLevel level, uint32_t format_id, const char* data, size_t length) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= slots_.size()) {
+            return false;
+        }
+        slots_[head & mask_].assign(timestamp_ns, level, format_id, data, length);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    void drainTo(std::vector<LogRecord>& out) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        uint64_t head = head_.load(std::memory_order_acquire);
+        for (; tail < head; ++tail) {
+            out.push_back(slots_[tail & mask_]);
+        }
+        tail_.store(tail, std::memory_order_release);
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    std::atomic<bool> orphaned{false};  // 所属线程已退出，排空后移除
+
+private:
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 16;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<LogRecord> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<uint64_t> head_{0};
+    alignas(64) std::atomic<uint64_t> tail_{0};
+};
+
+namespace {
+
+// 线程退出时标记其缓冲，后台线程写完剩余记录后释放
+struct ThreadRingHolder {
+    std::shared_ptr<LogRing> ring;
+    ~ThreadRingHolder() {
+        if (ring) {
+            ring->orphaned.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadRingHolder t_ring_holder;
+
+Counter& droppedCounter() {
+    static Counter& counter = MetricsRegistry::getInstance().counter(
+        "xiaozhi_log_dropped_total", "日志缓冲溢出丢弃的记录数");
+    return counter;
+}
+
+void ensureParentDirectory(const std::string& path) {
+    std::string dir_path = path.substr(0, path.find_last_of('/'));
+    (void)system(("mkdir -p " + dir_path).c_str()); // 忽略返回值以避免警告
+}
+
+// writev在部分写入时推进iovec继续写，直到全部写出或出错
+void writeVector(int fd, struct iovec* iov, int count) {
+    while (count > 0) {
+        int batch = std::min(count, IOV_MAX);
+        ssize_t written = writev(fd, iov, batch);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        while (batch > 0 && static_cast<size_t>(written) >= iov->iov_len) {
+            written -= static_cast<ssize_t>(iov->iov_len);
+            ++iov;
+            --count;
+            --batch;
+        }
+        if (batch > 0 && written > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= static_cast<size_t>(written);
+        }
+    }
+}
+
+} // namespace
+
 Logger& Logger::getInstance() {
     static Logger instance;
     return instance;
 }
 
-Logger::Logger() {
-    // 检查环境变量设置日志级别
+Logger::Logger() : log_fd_(-1) {
+    // 检查环境变量设置日志级别，优先于配置文件
     const char* log_level = std::getenv("XIAOZHI_LOG_LEVEL");
-    if (log_level) {
-        std::string level_str(log_level);
-        if (level_str == "DEBUG") {
-            log_level_ = LogLevel::DEBUG;
-        } else if (level_str == "INFO") {
-            log_level_ = LogLevel::INFO;
-        } else if (level_str == "WARN") {
-            log_level_ = LogLevel::WARN;
-        } else if (level_str == "ERROR") {
-            log_level_ = LogLevel::ERROR;
-        }
-    }
-    
+    LogLevel level;
+    if (log_level && parseLevel(log_level, level)) {
+        log_level_ = level;
+        level_from_env_ = true;
+    }
+
+    // ID 1 留给整行文本记录
+    LogFormatInfo text_format;
+    text_format.id = kBinaryLogTextFormatId;
+    text_format.format = "{}";
+    formats_.push_back(text_format);
+
     // 设置默认日志文件
-    setLogFile("~/.local/share/xiaozhi/logs/xiaozhi.log");
+    setLogFile(LoggingConfig().file);
+    startWriter();
 }
 
 Logger::~Logger() {
-    if (log_file_.is_open()) {
-        log_file_.close();
+    stopWriter();
+    drainAll();
+    if (log_fd_ >= 0) {
+        close(log_fd_);
+    }
+}
+
+void Logger::configure(const LoggingConfig& config) {
+    if (!level_from_env_) {
+        log_level_ = config.level;
+    }
+    {
+        std::lock_guard<std::mutex> lock(modules_mutex_);
+        module_overrides_ = config.module_levels;
+        applyModuleOverrides();
+    }
+    ring_records_ = std::max(config.ring_records, 16);
+    overflow_policy_ = static_cast<int>(config.overflow);
+    flush_interval_ms_ = std::max(config.flush_interval_ms, 1);
+    setLogFile(config.file);
+    setBinaryFile(config);
+
+    if (config.async) {
+        async_ = true;
+        startWriter();
+    } else {
+        // 切换到同步模式前写出已缓冲的记录
+        stopWriter();
+        drainAll();
+        async_ = false;
     }
 }
 
 void Logger::setLogLevel(LogLevel level) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
     log_level_ = level;
 }
 
-void Logger::setLogFile(const std::string& filepath) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    if (log_file_.is_open()) {
-        log_file_.close();
+void Logger::setModuleLevel(const std::string& module, LogLevel level) {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    module_overrides_[module] = level;
+    applyModuleOverrides();
+}
+
+void Logger::clearModuleLevel(const std::string& module) {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    module_overrides_.erase(module);
+    applyModuleOverrides();
+}
+
+std::map<std::string, LogLevel> Logger::getModuleLevels() {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    return module_overrides_;
+}
+
+std::vector<std::string> Logger::getActiveModules() {
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    std::vector<std::string> names;
+    for (const auto& module : modules_) {
+        names.push_back(module.directory + "/" + module.name);
+    }
+    return names;
+}
+
+LogModule* Logger::resolveModule(LogSite& site) {
+    // 由__FILE__取出所在目录和不含扩展名的文件名，例如 src/network/websocket_client.cpp -> network, websocket_client
+    std::string path = site.file;
+    size_t slash = path.find_last_of('/');
+    std::string filename = slash == std::string::npos ? path : path.substr(slash + 1);
+    std::string name = filename.substr(0, filename.find('.'));
+    std::string directory;
+    if (slash != std::string::npos && slash > 0) {
+        size_t parent = path.find_last_of('/', slash - 1);
+        size_t start = parent == std::string::npos ? 0 : parent + 1;
+        directory = path.substr(start, slash - start);
+    }
+
+    std::lock_guard<std::mutex> lock(modules_mutex_);
+    LogModule* module = site.module.load(std::memory_order_relaxed);
+    if (module) {
+        return module;
     }
-    
+    for (auto& existing : modules_) {
+        if (existing.name == name && existing.directory == directory) {
+            module = &existing;
+            break;
+        }
+    }
+    if (!module) {
+        modules_.emplace_back();
+        module = &modules_.back();
+        module->directory = directory;
+        module->name = name;
+        applyModuleOverrides();
+    }
+    site.module.store(module, std::memory_order_release);
+    return module;
+}
+
+void Logger::applyModuleOverrides() {
+    for (auto& module : modules_) {
+        auto it = module_overrides_.find(module.name);
+        if (it == module_overrides_.end()) {
+            it = module_overrides_.find(module.directory);
+        }
+        module.level = it == module_overrides_.end() ? -1 : static_cast<int>(it->second);
+    }
+}
+
+void Logger::setLogFile(const std::string& filepath) {
     // 扩展波浪号路径
     std::string expanded_filepath = expandHomeDirectory(filepath);
-    
+
     // 创建目录（如果不存在）
-    std::string dir_path = expanded_filepath.substr(0, expanded_filepath.find_last_of('/'));
-    (void)system(("mkdir -p " + dir_path).c_str()); // 忽略返回值以避免警告
-    
-    log_file_.open(expanded_filepath, std::ios::app);
-    if (!log_file_.is_open()) {
+    ensureParentDirectory(expanded_filepath);
+
+    int fd = open(expanded_filepath.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd < 0) {
         std::cerr << "无法打开日志文件: " << expanded_filepath << std::endl;
     }
+
+    // 先写出旧文件对应的记录再切换
+    drainAll();
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    if (log_fd_ >= 0) {
+        close(log_fd_);
+    }
+    log_fd_ = fd;
+}
+
+void Logger::setBinaryFile(const LoggingConfig& config) {
+    std::unique_ptr<BinaryLogWriter> writer;
+    if (config.binary) {
+        std::string path = expandHomeDirectory(config.binary_file);
+        ensureParentDirectory(path);
+        writer.reset(new BinaryLogWriter());
+        if (!writer->open(path, static_cast<size_t>(std::max(config.binary_max_file_kb, 0)) * 1024,
+                          config.binary_max_files)) {
+            std::cerr << "[Logger] 无法打开二进制日志文件，继续使用文本日志: " << path << std::endl;
+            writer.reset();
+        }
+    }
+
+    // 已缓冲的记录按切换前的模式写出
+    binary_ = false;
+    drainAll();
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    binary_writer_ = std::move(writer);
+    written_formats_ = 0;
+    binary_ = binary_writer_ != nullptr;
+}
+
+uint32_t Logger::registerFormat(LogSite& site, const char* fmt) {
+    std::lock_guard<std::mutex> lock(formats_mutex_);
+    uint32_t format_id = site.format_id.load(std::memory_order_relaxed);
+    if (format_id != 0) {
+        return format_id;
+    }
+
+    LogFormatInfo format;
+    format.id = static_cast<uint32_t>(formats_.size() + 1);
+    format.level = static_cast<uint8_t>(site.level);
+    format.line = static_cast<uint32_t>(site.line);
+    format.file = site.file;
+    format.function = site.function;
+    format.format = fmt;
+    formats_.push_back(format);
+    site.format_id.store(format.id, std::memory_order_release);
+    return format.id;
+}
+
+std::string Logger::decodeRecord(const LogRecord& record) {
+    std::lock_guard<std::mutex> lock(formats_mutex_);
+    if (record.format_id == 0 || record.format_id > formats_.size()) {
+        return std::string(record.text, record.length);
+    }
+    const LogFormatInfo& format = formats_[record.format_id - 1];
+    std::string message = formatBinaryLogMessage(format.format, record.text, record.length);
+    return format.function.empty() ? message : format.function + ": " + message;
 }
 
 void Logger::debug(const std::string& message) {
-    if (log_level_ <= LogLevel::DEBUG) {
+    if (isEnabled(LogLevel::DEBUG)) {
         writeLog(LogLevel::DEBUG, message);
     }
 }
 
 void Logger::info(const std::string& message) {
-    if (log_level_ <= LogLevel::INFO) {
+    if (isEnabled(LogLevel::INFO)) {
         writeLog(LogLevel::INFO, message);
     }
 }
 
 void Logger::warn(const std::string& message) {
-    if (log_level_ <= LogLevel::WARN) {
+    if (isEnabled(LogLevel::WARN)) {
         writeLog(LogLevel::WARN, message);
     }
 }
 
 void Logger::error(const std::string& message) {
-    if (log_level_ <= LogLevel::ERROR) {
+    if (isEnabled(LogLevel::ERROR)) {
         writeLog(LogLevel::ERROR, message);
     }
 }
 
+void Logger::flush() {
+    drainAll();
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    if (binary_writer_) {
+        binary_writer_->sync();
+    }
+}
+
 void Logger::writeLog(LogLevel level, const std::string& message) {
-    std::lock_guard<std::mutex> lock(log_mutex_);
-    
-    std::string timestamp = getCurrentTimestamp();
-    std::string level_str = levelToString(level);
-    
-    std::string log_line = timestamp + " [" + level_str + "] " + message + "\n";
-    
-    // 输出到控制台
-    if (level >= LogLevel::WARN) {
-        std::cerr << log_line;
-    } else {
-        std::cout << log_line;
+    submit(level, 0, message.data(), message.size());
+}
+
+void Logger::submit(LogLevel level, uint32_t format_id, const char* data, size_t length) {
+    int64_t timestamp_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+
+    if (!async_) {
+        LogRecord record;
+        record.assign(timestamp_ns, level, format_id, data, length);
+        std::lock_guard<std::mutex> lock(drain_mutex_);
+        writeRecords(&record, 1);
+        return;
+    }
+
+    LogRing* ring = currentRing();
+    while (!ring->push(timestamp_ns, level, format_id, data, length)) {
+        if (overflow_policy_ != static_cast<int>(LogOverflowPolicy::BLOCK) || !running_) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            droppedCounter().inc();
+            return;
+        }
+        writer_cv_.notify_one();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+LogRing* Logger::currentRing() {
+    if (t_ring_holder.ring) {
+        return t_ring_holder.ring.get();
+    }
+
+    // 线程首次写日志时分配缓冲
+    auto ring = std::make_shared<LogRing>(static_cast<size_t>(ring_records_.load()));
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings_.push_back(ring);
+    }
+    t_ring_holder.ring = ring;
+    return ring.get();
+}
+
+void Logger::startWriter() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    writer_thread_ = std::thread(&Logger::writerLoop, this);
+}
+
+void Logger::stopWriter() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    writer_cv_.notify_all();
+    if (writer_thread_.joinable()) {
+        writer_thread_.join();
+    }
+}
+
+void Logger::writerLoop() {
+    while (running_) {
+        {
+            std::unique_lock<std::mutex> lock(writer_mutex_);
+            writer_cv_.wait_for(lock, std::chrono::milliseconds(flush_interval_ms_.load()),
+                                [this] { return !running_; });
+        }
+        drainAll();
+    }
+}
+
+void Logger::drainAll() {
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex_);
+        rings = rings_;
+    }
+
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    std::vector<LogRecord> records;
+    for (const auto& ring : rings) {
+        ring->drainTo(records);
+    }
+
+    // 溢出时补一条告警，便于在日志中定位丢失的时间段
+    uint64_t dropped = dropped_.load(std::memory_order_relaxed);
+    if (dropped > reported_dropped_) {
+        std::string message = "[Logger] 日志缓冲溢出，已丢弃 " +
+                              std::to_string(dropped - reported_dropped_) + " 条记录";
+        LogRecord notice;
+        notice.assign(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::system_clock::now().time_since_epoch()).count(),
+                      LogLevel::WARN, 0, message.data(), message.size());
+        records.push_back(notice);
+        reported_dropped_ = dropped;
+    }
+
+    if (!records.empty()) {
+        writeRecords(records.data(), records.size());
+    }
+
+    // 释放已退出线程的空缓冲
+    std::lock_guard<std::mutex> rings_lock(rings_mutex_);
+    rings_.erase(std::remove_if(rings_.begin(), rings_.end(),
+                                [](const std::shared_ptr<LogRing>& ring) {
+                                    return ring->orphaned.load(std::memory_order_acquire) && ring->empty();
+                                }),
+                 rings_.end());
+}
+
+void Logger::writeRecords(LogRecord* records, size_t count) {
+    // 各线程缓冲内有序，合并后按时间戳排序；stable_sort会申请临时缓冲，单条时跳过
+    if (count > 1) {
+        std::stable_sort(records, records + count,
+                         [](const LogRecord& a, const LogRecord& b) { return a.timestamp_ns < b.timestamp_ns; });
+    }
+
+    bool binary = binary_writer_ != nullptr;
+    if (binary) {
+        writeBinaryRecords(records, count);
+    }
+
+    // 前缀格式: "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] "，同一秒内复用strftime结果。
+    // iovec指向line_prefixes_和decoded_lines_的元素，填充期间两者不能再扩容
+    if (line_prefixes_.size() < count) {
+        line_prefixes_.resize(count);
+        decoded_lines_.resize(count);
+    }
+    time_t cached_second = -1;
+    char second_text[32] = {0};
+
+    static char newline[] = "\n";
+    file_iov_.clear();
+    out_iov_.clear();
+    err_iov_.clear();
+    for (size_t i = 0; i < count; ++i) {
+        // 二进制模式下完整记录已在文件中，控制台只保留告警和错误
+        if (binary && records[i].level < LogLevel::WARN) {
+            continue;
+        }
+
+        time_t second = static_cast<time_t>(records[i].timestamp_ns / 1000000000);
+        int millis = static_cast<int>(records[i].timestamp_ns / 1000000 % 1000);
+        if (second != cached_second) {
+            struct tm local_time;
+            localtime_r(&second, &local_time);
+            strftime(second_text, sizeof(second_text), "%Y-%m-%d %H:%M:%S", &local_time);
+            cached_second = second;
+        }
+        LinePrefix& prefix = line_prefixes_[i];
+        int n = snprintf(prefix.text, sizeof(prefix.text), "%s.%03d [%s] ",
+                         second_text, millis, levelToString(records[i].level));
+        prefix.length = static_cast<size_t>(std::max(0, std::min<int>(n, sizeof(prefix.text) - 1)));
+
+        struct iovec line[3] = {
+            {prefix.text, prefix.length},
+            {records[i].text, records[i].length},
+            {newline, 1}
+        };
+        if (records[i].format_id != 0) {
+            decoded_lines_[i] = decodeRecord(records[i]);
+            line[1] = {&decoded_lines_[i][0], decoded_lines_[i].size()};
+        }
+        // 输出到控制台
+        auto& console = records[i].level >= LogLevel::WARN ? err_iov_ : out_iov_;
+        console.insert(console.end(), line, line + 3);
+        if (!binary) {
+            file_iov_.insert(file_iov_.end(), line, line + 3);
+        }
+    }
+
+    if (!out_iov_.empty()) {
+        writeVector(STDOUT_FILENO, out_iov_.data(), static_cast<int>(out_iov_.size()));
+    }
+    if (!err_iov_.empty()) {
+        writeVector(STDERR_FILENO, err_iov_.data(), static_cast<int>(err_iov_.size()));
     }
-    
     // 写入日志文件
-    if (log_file_.is_open()) {
-        log_file_ << log_line;
-        log_file_.flush();
+    if (log_fd_ >= 0 && !file_iov_.empty()) {
+        writeVector(log_fd_, file_iov_.data(), static_cast<int>(file_iov_.size()));
     }
 }
 
-std::string Logger::levelToString(LogLevel level) {
+void Logger::writeBinaryRecords(const LogRecord* records, size_t count) {
+    // 先补写新登记的格式；记录入队前已完成登记，这里一定能看到
+    {
+        std::lock_guard<std::mutex> lock(formats_mutex_);
+        for (; written_formats_ < formats_.size(); ++written_formats_) {
+            binary_writer_->writeFormat(formats_[written_formats_]);
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const LogRecord& record = records[i];
+        uint8_t level = static_cast<uint8_t>(record.level);
+        if (record.format_id != 0) {
+            binary_writer_->writeEvent(level, record.format_id, record.timestamp_ns, record.text, record.length);
+        } else {
+            BinaryArgBuffer text;
+            text.putString(record.text, record.length);
+            binary_writer_->writeEvent(level, kBinaryLogTextFormatId, record.timestamp_ns, text.data, text.size);
+        }
+    }
+}
+
+bool Logger::parseLevel(const std::string& text, LogLevel& level) {
+    if (text == "DEBUG") {
+        level = LogLevel::DEBUG;
+    } else if (text == "INFO") {
+        level = LogLevel::INFO;
+    } else if (text == "WARN") {
+        level = LogLevel::WARN;
+    } else if (text == "ERROR") {
+        level = LogLevel::ERROR;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* Logger::levelToString(LogLevel level) {
     switch (level) {
         case LogLevel::DEBUG: return "DEBUG";
         case LogLevel::INFO: return "INFO";
@@ -121,18 +604,4 @@ std::string Logger::levelToString(LogLevel level) {
     }
 }
 
-std::string Logger::getCurrentTimestamp() {
-    auto now = std::chrono::system_clock::now();
-    auto time_t = std::chrono::system_clock::to_time_t(now);
-    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(
-        now.time_since_epoch()) % 1000;
-
-    char buffer[100];
-    strftime(buffer, sizeof(buffer), "%Y-%m-%d %H:%M:%S", localtime(&time_t));
-    
-    std::ostringstream oss;
-    oss << buffer << '.' << std::setfill('0') << std::setw(3) << ms.count();
-    return oss.str();
-}
-
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
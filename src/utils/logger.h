@@ -1,10 +1,24 @@
 #pragma once
 
 #include <string>
-#include <fstream>
-#include <iostream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <atomic>
 #include <mutex>
+#include <condition_variable>
 #include <chrono>
+#include "log_format.h"
+#include "binary_log.h"
+
+struct iovec;
+
+// 编译期最低日志级别 (0=DEBUG, 1=INFO, 2=WARN, 3=ERROR)，低于该级别的LOG_*调用点整体删除
+#ifndef XIAOZHI_MIN_LOG_LEVEL
+#define XIAOZHI_MIN_LOG_LEVEL 0
+#endif
 
 namespace xiaozhi {
 
@@ -15,37 +29,333 @@ enum class LogLevel {
     ERROR = 3
 };
 
+// 线程本地缓冲写满时的处理方式
+enum class LogOverflowPolicy {
+    DROP = 0,   // 丢弃新记录并计数，调用线程永不阻塞（默认）
+    BLOCK = 1   // 等待后台线程腾出空间，只适合非实时线程
+};
+
+struct LoggingConfig {
+    LogLevel level = LogLevel::INFO;
+    std::string file = "~/.local/share/xiaozhi/logs/xiaozhi.log";
+    bool async = true;                  // 关闭后在调用线程同步写入
+    int ring_records = 256;             // 每个线程的缓冲记录数
+    LogOverflowPolicy overflow = LogOverflowPolicy::DROP;
+    int flush_interval_ms = 50;         // 后台线程批量写入的间隔
+    // 二进制模式：LOG_*调用点只记录格式ID、时间戳和原始参数，写入内存映射的定长轮转文件，
+    // 用xiaozhi-logdecode还原为文本；控制台只输出WARN及以上级别
+    bool binary = false;
+    std::string binary_file = "~/.local/share/xiaozhi/logs/xiaozhi.blog";
+    int binary_max_file_kb = 4096;      // 单个文件大小上限
+    int binary_max_files = 4;           // 含当前文件在内保留的文件数
+    // 按模块覆盖日志级别，键为源码目录（如"network"）或文件名（如"websocket_client"），文件名优先
+    std::map<std::string, LogLevel> module_levels;
+};
+
+// 同一源文件内的调用点共享的模块级别槽位
+struct LogModule {
+    std::string directory;
+    std::string name;
+    std::atomic<int> level{-1};         // -1 表示跟随全局级别
+};
+
+// LOG_*宏在每个调用点定义的静态描述，二进制模式下首次执行时登记格式串并分配ID
+struct LogSite {
+    constexpr LogSite(LogLevel lvl, const char* source_file, int source_line, const char* source_function)
+        : level(lvl), file(source_file), line(source_line), function(source_function) {}
+
+    const LogLevel level;
+    const char* const file;
+    const int line;
+    const char* const function;
+    std::atomic<uint32_t> format_id{0};
+    std::atomic<LogModule*> module{nullptr};
+};
+
+// 高频路径的限流：按次数采样（每N次放行一次）或按时间（每个间隔最多放行一次），
+// 按时间限流时被抑制的次数随下一条放行的日志一起报告
+class LogRateLimiter {
+public:
+    constexpr LogRateLimiter(uint64_t every_n, int64_t interval_ms)
+        : every_n_(every_n), interval_ns_(interval_ms * 1000000) {}
+
+    bool allow(uint64_t& suppressed) {
+        suppressed = 0;
+        if (every_n_ > 0) {
+            return count_.fetch_add(1, std::memory_order_relaxed) % every_n_ == 0;
+        }
+        int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        int64_t next = next_ns_.load(std::memory_order_relaxed);
+        if (now < next || !next_ns_.compare_exchange_strong(next, now + interval_ns_, std::memory_order_relaxed)) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    const uint64_t every_n_;
+    const int64_t interval_ns_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<int64_t> next_ns_{0};
+    std::atomic<uint64_t> suppressed_{0};
+};
+
+struct LogRecord;
+class LogRing;
+
+// 异步日志：调用线程只把记录拷入自己的无锁环形缓冲，
+// 由后台线程按时间排序后用writev批量写入控制台和日志文件
 class Logger {
 public:
     static Logger& getInstance();
 
+    void configure(const LoggingConfig& config);
+
     void setLogLevel(LogLevel level);
+    LogLevel getLogLevel() const { return log_level_.load(std::memory_order_relaxed); }
     void setLogFile(const std::string& filepath);
 
+    // 运行期调整模块级别，立即作用于该模块已执行过和尚未执行的调用点
+    void setModuleLevel(const std::string& module, LogLevel level);
+    void clearModuleLevel(const std::string& module);
+    std::map<std::string, LogLevel> getModuleLevels();
+    // 已有调用点执行过的模块，格式为"目录/文件名"
+    std::vector<std::string> getActiveModules();
+
     void debug(const std::string& message);
     void info(const std::string& message);
     void warn(const std::string& message);
     void error(const std::string& message);
 
+    // 运行期和编译期级别都满足时返回true，LOG_*宏据此跳过参数求值和格式化
+    bool isEnabled(LogLevel level) const {
+        return static_cast<int>(level) >= XIAOZHI_MIN_LOG_LEVEL &&
+               level >= log_level_.load(std::memory_order_relaxed);
+    }
+
+    // LOG_*调用点的级别判断：模块有覆盖时用模块级别，否则用全局级别
+    bool isEnabled(LogSite& site) {
+        if (static_cast<int>(site.level) < XIAOZHI_MIN_LOG_LEVEL) {
+            return false;
+        }
+        LogModule* module = site.module.load(std::memory_order_acquire);
+        if (!module) {
+            module = resolveModule(site);
+        }
+        int level = module->level.load(std::memory_order_relaxed);
+        if (level < 0) {
+            level = static_cast<int>(log_level_.load(std::memory_order_relaxed));
+        }
+        return static_cast<int>(site.level) >= level;
+    }
+
+    // 类型安全的格式化日志，fmt中的"{}"依次替换为参数；无参数时fmt原样输出
+    template<typename... Args>
+    void log(LogLevel level, const std::string& fmt, const Args&... args) {
+        log(level, fmt.c_str(), args...);
+    }
+
     template<typename... Args>
-    void log(LogLevel level, const std::string& fmt, Args... args);
+    void log(LogLevel level, const char* fmt, const Args&... args) {
+        logAt(level, nullptr, fmt, args...);
+    }
+
+    // 带调用位置前缀的版本
+    template<typename... Args>
+    void logAt(LogLevel level, const char* where, const char* fmt, const Args&... args) {
+        if (isEnabled(level)) {
+            formatAndWrite(level, where, fmt, args...);
+        }
+    }
+
+    template<typename... Args>
+    void logAt(LogLevel level, const char* where, const std::string& fmt, const Args&... args) {
+        logAt(level, where, fmt.c_str(), args...);
+    }
+
+    // LOG_*宏的入口，级别已由isEnabled(site)判断：
+    // 字面量格式串在二进制模式下只编码参数，其余情况按文本格式化
+    template<size_t N, typename... Args>
+    void logSite(LogSite& site, const char (&fmt)[N], const Args&... args) {
+        if (!binary_.load(std::memory_order_relaxed)) {
+            formatAndWrite(site.level, site.function, fmt, args...);
+            return;
+        }
+        uint32_t format_id = site.format_id.load(std::memory_order_acquire);
+        if (format_id == 0) {
+            format_id = registerFormat(site, fmt);
+        }
+        BinaryArgBuffer buffer;
+        appendBinaryArgs(buffer, args...);
+        submit(site.level, format_id, buffer.data, buffer.size);
+    }
+
+    // 可变缓冲或运行期拼接的格式串不能作为静态格式登记
+    template<size_t N, typename... Args>
+    void logSite(LogSite& site, char (&fmt)[N], const Args&... args) {
+        formatAndWrite(site.level, site.function, static_cast<const char*>(fmt), args...);
+    }
+
+    template<typename... Args>
+    void logSite(LogSite& site, const std::string& fmt, const Args&... args) {
+        formatAndWrite(site.level, site.function, fmt.c_str(), args...);
+    }
+
+    // 立即写出所有线程缓冲中的记录
+    void flush();
+
+    // 缓冲溢出被丢弃的记录总数
+    uint64_t getDroppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+    static bool parseLevel(const std::string& text, LogLevel& level);
+    static const char* levelToString(LogLevel level);
 
 private:
     Logger();
     ~Logger();
 
-    LogLevel log_level_{LogLevel::INFO};
-    std::ofstream log_file_;
-    std::mutex log_mutex_;
-    
+    template<typename... Args>
+    void formatAndWrite(LogLevel level, const char* where, const char* fmt, const Args&... args) {
+        // 每个线程复用同一个格式化缓冲，预热后不再分配内存
+        thread_local std::string buffer;
+        buffer.clear();
+        if (where) {
+            buffer += where;
+            buffer += ": ";
+        }
+        if constexpr (sizeof...(Args) == 0) {
+            buffer += fmt;
+        } else {
+            formatLogMessage(buffer, fmt, args...);
+        }
+        writeLog(level, buffer);
+    }
+
+    std::atomic<LogLevel> log_level_{LogLevel::INFO};
+    std::atomic<bool> async_{true};
+    std::atomic<int> overflow_policy_{static_cast<int>(LogOverflowPolicy::DROP)};
+    std::atomic<int> ring_records_{256};
+    std::atomic<int> flush_interval_ms_{50};
+    std::atomic<bool> binary_{false};
+    bool level_from_env_ = false;
+
+    // 日志文件描述符，由drain_mutex_保护
+    int log_fd_;
+
+    // 二进制日志文件及已写出的格式数，由drain_mutex_保护
+    std::unique_ptr<BinaryLogWriter> binary_writer_;
+    size_t written_formats_ = 0;
+
+    // 模块槽位（deque保证地址稳定，调用点缓存其指针）和按名称的级别覆盖
+    std::deque<LogModule> modules_;
+    std::map<std::string, LogLevel> module_overrides_;
+    std::mutex modules_mutex_;
+
+    // 已登记的调用点格式，下标为ID-1，只追加
+    std::vector<LogFormatInfo> formats_;
+    std::mutex formats_mutex_;
+
+    std::vector<std::shared_ptr<LogRing>> rings_;
+    std::mutex rings_mutex_;
+
+    // 串行化消费端：后台线程、flush()和同步模式写入
+    std::mutex drain_mutex_;
+    uint64_t reported_dropped_ = 0;
+    std::atomic<uint64_t> dropped_{0};
+
+    // writeRecords的临时缓冲，在drain_mutex_下复用，同步模式逐条写入时不再分配
+    struct LinePrefix {
+        char text[48];
+        size_t length;
+    };
+    std::vector<LinePrefix> line_prefixes_;
+    std::vector<std::string> decoded_lines_;
+    std::vector<iovec> file_iov_;
+    std::vector<iovec> out_iov_;
+    std::vector<iovec> err_iov_;
+
+    std::thread writer_thread_;
+    std::atomic<bool> running_{false};
+    std::mutex writer_mutex_;
+    std::condition_variable writer_cv_;
+
     void writeLog(LogLevel level, const std::string& message);
-    std::string levelToString(LogLevel level);
-    std::string getCurrentTimestamp();
+    void submit(LogLevel level, uint32_t format_id, const char* data, size_t length);
+    uint32_t registerFormat(LogSite& site, const char* fmt);
+    LogModule* resolveModule(LogSite& site);
+    void applyModuleOverrides();
+    void setBinaryFile(const LoggingConfig& config);
+    std::string decodeRecord(const LogRecord& record);
+    LogRing* currentRing();
+    void writerLoop();
+    void drainAll();
+    void writeRecords(LogRecord* records, size_t count);
+    void writeBinaryRecords(const LogRecord* records, size_t count);
+    void startWriter();
+    void stopWriter();
 };
 
-#define LOG_DEBUG(msg) xiaozhi::Logger::getInstance().debug("[DEBUG] " + std::string(__FUNCTION__) + ": " + msg)
-#define LOG_INFO(msg) xiaozhi::Logger::getInstance().info("[INFO] " + std::string(__FUNCTION__) + ": " + msg)
-#define LOG_WARN(msg) xiaozhi::Logger::getInstance().warn("[WARN] " + std::string(__FUNCTION__) + ": " + msg)
-#define LOG_ERROR(msg) xiaozhi::Logger::getInstance().error("[ERROR] " + std::string(__FUNCTION__) + ": " + msg)
+// 用法: LOG_DEBUG("收到 {} 字节, 序号 {}", size, seq)
+// 级别未启用时不求值参数、不格式化；低于XIAOZHI_MIN_LOG_LEVEL的级别编译为死代码，
+// 仍参与类型检查以免参数变量产生未使用告警
+#define XZ_LOG_AT(level, ...) \
+    do { \
+        static xiaozhi::LogSite xz_site_(level, __FILE__, __LINE__, __FUNCTION__); \
+        auto& xz_logger_ = xiaozhi::Logger::getInstance(); \
+        if (xz_logger_.isEnabled(xz_site_)) { \
+            xz_logger_.logSite(xz_site_, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define XZ_LOG_DISABLED(level, ...) \
+    do { \
+        if (false) { \
+            xiaozhi::Logger::getInstance().logAt(level, __FUNCTION__, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define XZ_LOG_LIMITED(level, every_n, interval_ms, ...) \
+    do { \
+        static xiaozhi::LogSite xz_site_(level, __FILE__, __LINE__, __FUNCTION__); \
+        static xiaozhi::LogSite xz_summary_site_(level, __FILE__, __LINE__, __FUNCTION__); \
+        static xiaozhi::LogRateLimiter xz_limiter_(every_n, interval_ms); \
+        auto& xz_logger_ = xiaozhi::Logger::getInstance(); \
+        uint64_t xz_suppressed_ = 0; \
+        if (xz_logger_.isEnabled(xz_site_) && xz_limiter_.allow(xz_suppressed_)) { \
+            xz_logger_.logSite(xz_site_, __VA_ARGS__); \
+            if (xz_suppressed_ > 0) { \
+                xz_logger_.logSite(xz_summary_site_, "同一调用点在上次输出后被限流 {} 次", xz_suppressed_); \
+            } \
+        } \
+    } while (0)
+
+#if XIAOZHI_MIN_LOG_LEVEL <= 0
+#define LOG_DEBUG(...) XZ_LOG_AT(xiaozhi::LogLevel::DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) XZ_LOG_DISABLED(xiaozhi::LogLevel::DEBUG, __VA_ARGS__)
+#endif
+
+#if XIAOZHI_MIN_LOG_LEVEL <= 1
+#define LOG_INFO(...) XZ_LOG_AT(xiaozhi::LogLevel::INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) XZ_LOG_DISABLED(xiaozhi::LogLevel::INFO, __VA_ARGS__)
+#endif
+
+#if XIAOZHI_MIN_LOG_LEVEL <= 2
+#define LOG_WARN(...) XZ_LOG_AT(xiaozhi::LogLevel::WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) XZ_LOG_DISABLED(xiaozhi::LogLevel::WARN, __VA_ARGS__)
+#endif
+
+#define LOG_ERROR(...) XZ_LOG_AT(xiaozhi::LogLevel::ERROR, __VA_ARGS__)
+
+// 逐包/逐帧路径使用的限流版本，level为DEBUG/INFO/WARN/ERROR:
+//   LOG_EVERY_N(DEBUG, 100, "已发送 {} 个音频包", count)   每100次输出一次
+//   LOG_EVERY_MS(WARN, 1000, "编码失败: {}", error)         每秒最多一次，并报告期间被抑制的次数
+#define LOG_EVERY_N(level, n, ...) XZ_LOG_LIMITED(xiaozhi::LogLevel::level, (n), 0, __VA_ARGS__)
+#define LOG_EVERY_MS(level, ms, ...) XZ_LOG_LIMITED(xiaozhi::LogLevel::level, 0, (ms), __VA_ARGS__)
 
-} // namespace xiaozhi
\ No newline at end of file
+} // namespace xiaozhi
@@ -0,0 +1,226 @@
+#include "metrics.h"
+#include <sstream>
+#include <fstream>
+#include <iomanip>
+#include <cmath>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace xiaozhi {
+
+void Histogram::record(uint64_t value) {
+    buckets_[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+int Histogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(kLinearBuckets)) {
+        return static_cast<int>(value);
+    }
+    int exponent = 63 - __builtin_clzll(value);
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int sub = static_cast<int>((value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return kLinearBuckets + (exponent - 4) * kSubBuckets + sub;
+}
+
+uint64_t Histogram::bucketLowerBound(int index) {
+    if (index < kLinearBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = 4 + (index - kLinearBuckets) / kSubBuckets;
+    uint64_t sub = static_cast<uint64_t>((index - kLinearBuckets) % kSubBuckets);
+    return (1ull << exponent) + (sub << (exponent - kSubBucketBits));
+}
+
+uint64_t Histogram::bucketUpperBound(int index) {
+    if (index < kLinearBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    int exponent = 4 + (index - kLinearBuckets) / kSubBuckets;
+    return bucketLowerBound(index) + (1ull << (exponent - kSubBucketBits)) - 1;
+}
+
+double Histogram::quantile(double q) const {
+    uint64_t total = count();
+    if (total == 0) {
+        return 0.0;
+    }
+
+    uint64_t rank = static_cast<uint64_t>(std::ceil(q * total));
+    rank = std::max<uint64_t>(1, std::min(rank, total));
+    uint64_t seen = 0;
+    for (int i = 0; i < kBucketCount; ++i) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return (bucketLowerBound(i) + bucketUpperBound(i)) / 2.0;
+        }
+    }
+    // 记录与读取并发时计数可能暂时不一致，返回最高桶
+    return static_cast<double>(bucketUpperBound(kBucketCount - 1));
+}
+
+uint64_t Histogram::countBelowPowerOfTwo(int exponent) const {
+    int end;
+    if (exponent <= 4) {
+        end = 1 << std::max(exponent, 0);
+    } else if (exponent > kMaxExponent) {
+        end = kBucketCount;
+    } else {
+        end = kLinearBuckets + (exponent - 4) * kSubBuckets;
+    }
+
+    uint64_t total = 0;
+    for (int i = 0; i < end; ++i) {
+        total += buckets_[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+MetricsRegistry& MetricsRegistry::getInstance() {
+    static MetricsRegistry instance;
+    return instance;
+}
+
+Counter& MetricsRegistry::counter(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = counters_[name];
+    if (!entry.metric) {
+        entry.help = help;
+        entry.metric.reset(new Counter());
+    }
+    return *entry.metric;
+}
+
+Gauge& MetricsRegistry::gauge(const std::string& name, const std::string& help) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = gauges_[name];
+    if (!entry.metric) {
+        entry.help = help;
+        entry.metric.reset(new Gauge());
+    }
+    return *entry.metric;
+}
+
+Histogram& MetricsRegistry::histogram(const std::string& name, const std::string& help, double scale) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = histograms_[name];
+    if (!entry.metric) {
+        entry.help = help;
+        entry.metric.reset(new Histogram(scale));
+    }
+    return *entry.metric;
+}
+
+const Counter* MetricsRegistry::findCounter(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = counters_.find(name);
+    return it != counters_.end() ? it->second.metric.get() : nullptr;
+}
+
+const Gauge* MetricsRegistry::findGauge(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = gauges_.find(name);
+    return it != gauges_.end() ? it->second.metric.get() : nullptr;
+}
+
+const Histogram* MetricsRegistry::findHistogram(const std::string& name) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = histograms_.find(name);
+    return it != histograms_.end() ? it->second.metric.get() : nullptr;
+}
+
+std::string MetricsRegistry::renderPrometheus() const {
+    std::ostringstream out;
+    out << std::setprecision(9);
+
+    ProcessStats process = sampleProcessStats();
+    out << "# HELP process_cpu_seconds_total 进程累计CPU时间\n"
+        << "# TYPE process_cpu_seconds_total counter\n"
+        << "process_cpu_seconds_total " << process.cpu_seconds << "\n"
+        << "# HELP process_resident_memory_bytes 进程常驻内存\n"
+        << "# TYPE process_resident_memory_bytes gauge\n"
+        << "process_resident_memory_bytes " << process.resident_bytes << "\n"
+        << "# HELP xiaozhi_uptime_seconds 进程运行时间\n"
+        << "# TYPE xiaozhi_uptime_seconds gauge\n"
+        << "xiaozhi_uptime_seconds " << process.uptime_seconds << "\n";
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& pair : counters_) {
+        out << "# HELP " << pair.first << " " << pair.second.help << "\n"
+            << "# TYPE " << pair.first << " counter\n"
+            << pair.first << " " << pair.second.metric->value() << "\n";
+    }
+
+    for (const auto& pair : gauges_) {
+        out << "# HELP " << pair.first << " " << pair.second.help << "\n"
+            << "# TYPE " << pair.first << " gauge\n"
+            << pair.first << " " << pair.second.metric->value() << "\n";
+    }
+
+    // 按2的幂边界输出累积桶，边界固定，跨抓取周期保持一致
+    for (const auto& pair : histograms_) {
+        const Histogram& histogram = *pair.second.metric;
+        double scale = histogram.getScale();
+        uint64_t count = histogram.count();
+
+        out << "# HELP " << pair.first << " " << pair.second.help << "\n"
+            << "# TYPE " << pair.first << " histogram\n";
+        for (int exponent = 0; exponent <= 26; ++exponent) {
+            out << pair.first << "_bucket{le=\"" << static_cast<double>(1ull << exponent) * scale << "\"} "
+                << histogram.countBelowPowerOfTwo(exponent) << "\n";
+        }
+        out << pair.first << "_bucket{le=\"+Inf\"} " << count << "\n"
+            << pair.first << "_sum " << histogram.sum() * scale << "\n"
+            << pair.first << "_count " << count << "\n";
+    }
+
+    return out.str();
+}
+
+ProcessStats MetricsRegistry::sampleProcessStats() {
+    ProcessStats stats;
+    long ticks = sysconf(_SC_CLK_TCK);
+    long page_size = sysconf(_SC_PAGESIZE);
+
+    // /proc/self/stat: comm字段可能含空格，从最后一个')'之后开始解析
+    std::ifstream stat_file("/proc/self/stat");
+    std::string stat;
+    std::getline(stat_file, stat);
+    size_t paren = stat.rfind(')');
+    if (paren != std::string::npos && ticks > 0) {
+        std::istringstream fields(stat.substr(paren + 2));
+        std::string field;
+        unsigned long long utime = 0, stime = 0, start_ticks = 0;
+        // 第3个字段(state)起算，utime/stime为第14/15个字段，starttime为第22个
+        for (int index = 3; index <= 22 && fields >> field; ++index) {
+            if (index == 14) utime = std::strtoull(field.c_str(), nullptr, 10);
+            else if (index == 15) stime = std::strtoull(field.c_str(), nullptr, 10);
+            else if (index == 22) start_ticks = std::strtoull(field.c_str(), nullptr, 10);
+        }
+        stats.cpu_seconds = static_cast<double>(utime + stime) / ticks;
+
+        std::ifstream uptime_file("/proc/uptime");
+        double system_uptime = 0.0;
+        if (uptime_file >> system_uptime) {
+            stats.uptime_seconds = std::max(0.0, system_uptime - static_cast<double>(start_ticks) / ticks);
+        }
+    }
+
+    std::ifstream statm_file("/proc/self/statm");
+    uint64_t size_pages = 0, resident_pages = 0;
+    if (statm_file >> size_pages >> resident_pages && page_size > 0) {
+        stats.resident_bytes = resident_pages * static_cast<uint64_t>(page_size);
+    }
+
+    long phys_pages = sysconf(_SC_PHYS_PAGES);
+    if (phys_pages > 0 && page_size > 0) {
+        stats.total_memory_bytes = static_cast<uint64_t>(phys_pages) * static_cast<uint64_t>(page_size);
+    }
+    return stats;
+}
+
+} // namespace xiaozhi
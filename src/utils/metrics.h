@@ -0,0 +1,139 @@
+#pragma once
+
+#include <string>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace xiaozhi {
+
+struct MetricsConfig {
+    bool enabled = false;                     // 启动/metrics HTTP端点
+    std::string bind_address = "127.0.0.1";   // 集中采集时改为0.0.0.0
+    int port = 9100;
+};
+
+// 单调递增计数器
+class Counter {
+public:
+    void inc(uint64_t n = 1) { value_.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value_{0};
+};
+
+// 可增可减的瞬时值
+class Gauge {
+public:
+    void set(int64_t value) { value_.store(value, std::memory_order_relaxed); }
+    void add(int64_t delta) { value_.fetch_add(delta, std::memory_order_relaxed); }
+    int64_t value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<int64_t> value_{0};
+};
+
+// HDR风格直方图：0~15线性分桶，之后每个2的幂区间再分8个子桶，
+// 相对误差不超过12.5%；记录只做原子加法，不加锁
+class Histogram {
+public:
+    static constexpr int kLinearBuckets = 16;
+    static constexpr int kSubBucketBits = 3;
+    static constexpr int kSubBuckets = 1 << kSubBucketBits;
+    static constexpr int kMaxExponent = 40;
+    static constexpr int kBucketCount = kLinearBuckets + (kMaxExponent - 4 + 1) * kSubBuckets;
+
+    // scale: 导出时原始值乘以该系数，例如微秒记录、按秒导出时为1e-6
+    explicit Histogram(double scale = 1e-6) : scale_(scale) {}
+
+    void record(uint64_t value);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+    double getScale() const { return scale_; }
+
+    // 按桶估算分位数（原始单位），无样本时返回0
+    double quantile(double q) const;
+
+    // 小于2^exponent的样本数，用于按2的幂边界导出Prometheus累积桶
+    uint64_t countBelowPowerOfTwo(int exponent) const;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index);
+
+private:
+    double scale_;
+    std::atomic<uint64_t> buckets_[kBucketCount] = {};
+    std::atomic<uint64_t> count_{0};
+    std::atomic<uint64_t> sum_{0};
+};
+
+// 作用域计时：析构时把经过的微秒数记入直方图
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram& histogram)
+        : histogram_(histogram), start_(std::chrono::steady_clock::now()) {}
+
+    ~ScopedTimer() {
+        histogram_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start_).count()));
+    }
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Histogram& histogram_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+// 进程级资源占用，取自/proc/self
+struct ProcessStats {
+    double uptime_seconds = 0.0;
+    double cpu_seconds = 0.0;          // 用户态+内核态累计CPU时间
+    uint64_t resident_bytes = 0;
+    uint64_t total_memory_bytes = 0;   // 系统物理内存，用于计算占用百分比
+};
+
+// 指标注册表：按名称注册一次，之后热路径只持有返回的引用，
+// 注册后的对象地址在进程生命周期内保持不变
+class MetricsRegistry {
+public:
+    static MetricsRegistry& getInstance();
+
+    Counter& counter(const std::string& name, const std::string& help);
+    Gauge& gauge(const std::string& name, const std::string& help);
+    Histogram& histogram(const std::string& name, const std::string& help, double scale = 1e-6);
+
+    // 查询已注册指标，不存在时返回nullptr
+    const Counter* findCounter(const std::string& name) const;
+    const Gauge* findGauge(const std::string& name) const;
+    const Histogram* findHistogram(const std::string& name) const;
+
+    // Prometheus文本格式 (version 0.0.4)
+    std::string renderPrometheus() const;
+
+    static ProcessStats sampleProcessStats();
+
+private:
+    MetricsRegistry() = default;
+    ~MetricsRegistry() = default;
+
+    template <typename T>
+    struct Entry {
+        std::string help;
+        std::unique_ptr<T> metric;
+    };
+
+    std::map<std::string, Entry<Counter>> counters_;
+    std::map<std::string, Entry<Gauge>> gauges_;
+    std::map<std::string, Entry<Histogram>> histograms_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace xiaozhi
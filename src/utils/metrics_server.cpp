@@ -0,0 +1,151 @@
+#include "metrics_server.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/eventfd.h>
+#include <sys/time.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+namespace xiaozhi {
+
+MetricsServer::MetricsServer() : listen_fd_(-1), wake_fd_(-1), port_(0) {
+}
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(const MetricsConfig& config) {
+    if (running_) {
+        return true;
+    }
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(config.port));
+    if (inet_pton(AF_INET, config.bind_address.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "[MetricsServer] 错误: 无效的监听地址: " << config.bind_address << std::endl;
+        return false;
+    }
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        std::cerr << "[MetricsServer] 错误: 无法创建socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    socklen_t len = sizeof(addr);
+    if (bind(listen_fd_, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+        listen(listen_fd_, 8) != 0 ||
+        getsockname(listen_fd_, reinterpret_cast<sockaddr*>(&addr), &len) != 0) {
+        std::cerr << "[MetricsServer] 错误: 无法监听 " << config.bind_address << ":" << config.port
+                  << ": " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    port_ = ntohs(addr.sin_port);
+
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wake_fd_ < 0) {
+        std::cerr << "[MetricsServer] 错误: 无法创建eventfd: " << strerror(errno) << std::endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    running_ = true;
+    server_thread_ = std::thread(&MetricsServer::serverLoop, this);
+    std::cout << "[MetricsServer] 指标端点已启动: http://" << config.bind_address << ":" << port_
+              << "/metrics" << std::endl;
+    return true;
+}
+
+void MetricsServer::stop() {
+    running_ = false;
+    if (wake_fd_ >= 0) {
+        uint64_t value = 1;
+        ssize_t written = write(wake_fd_, &value, sizeof(value));
+        (void)written;
+    }
+    if (server_thread_.joinable()) {
+        server_thread_.join();
+    }
+    if (listen_fd_ >= 0) {
+        close(listen_fd_);
+        listen_fd_ = -1;
+    }
+    if (wake_fd_ >= 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+}
+
+void MetricsServer::serverLoop() {
+    pollfd fds[2] = {{listen_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    while (running_) {
+        if (poll(fds, 2, -1) <= 0 || !(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        int fd = accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            continue;
+        }
+        handleConnection(fd);
+        close(fd);
+    }
+}
+
+void MetricsServer::handleConnection(int fd) {
+    // 抓取端发送的请求很小，读到头部结束即可，避免慢客户端拖住服务线程
+    timeval timeout{1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    std::string request;
+    char buffer[1024];
+    while (request.size() < 8192 && request.find("\r\n\r\n") == std::string::npos) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n <= 0) {
+            break;
+        }
+        request.append(buffer, static_cast<size_t>(n));
+    }
+
+    std::string status;
+    std::string body;
+    if (request.compare(0, 13, "GET /metrics ") == 0 || request.compare(0, 13, "GET /metrics?") == 0) {
+        status = "200 OK";
+        body = MetricsRegistry::getInstance().renderPrometheus();
+    } else if (request.compare(0, 4, "GET ") == 0) {
+        status = "404 Not Found";
+        body = "not found\n";
+    } else {
+        status = "405 Method Not Allowed";
+        body = "method not allowed\n";
+    }
+
+    std::string response = "HTTP/1.1 " + status + "\r\n"
+                           "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                           "Connection: close\r\n\r\n" + body;
+
+    size_t sent = 0;
+    while (sent < response.size()) {
+        ssize_t n = send(fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            break;
+        }
+        sent += static_cast<size_t>(n);
+    }
+}
+
+} // namespace xiaozhi
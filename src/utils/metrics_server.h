@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include "metrics.h"
+
+namespace xiaozhi {
+
+// 极简HTTP服务：GET /metrics 返回MetricsRegistry的Prometheus文本，
+// 单线程逐个处理连接，只用于集中采集抓取
+class MetricsServer {
+public:
+    MetricsServer();
+    ~MetricsServer();
+
+    bool start(const MetricsConfig& config);
+    void stop();
+    bool isRunning() const { return running_; }
+
+    int getPort() const { return port_; }
+
+private:
+    void serverLoop();
+    void handleConnection(int fd);
+
+    std::atomic<bool> running_{false};
+    int listen_fd_;
+    int wake_fd_;       // stop()通过eventfd唤醒服务线程，空闲时不定时轮询
+    int port_;
+    std::thread server_thread_;
+};
+
+} // namespace xiaozhi
@@ -0,0 +1,188 @@
+#include "realtime.h"
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <pthread.h>
+#include <sched.h>
+#include <alloca.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+namespace xiaozhi {
+
+RealtimeManager& RealtimeManager::getInstance() {
+    static RealtimeManager instance;
+    return instance;
+}
+
+void RealtimeManager::configure(const RealtimeConfig& config) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    config_ = config;
+}
+
+bool RealtimeManager::lockProcessMemory() {
+    RealtimeConfig config;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        config = config_;
+    }
+
+    if (!config.lock_memory) {
+        return false;
+    }
+
+    bool locked = mlockall(MCL_CURRENT | MCL_FUTURE) == 0;
+    std::string error = locked ? "" : std::strerror(errno);
+
+    if (locked) {
+        prefaultStack(static_cast<size_t>(config.prefault_stack_kb) * 1024);
+        std::cout << "[RealtimeManager] 进程内存已锁定 (mlockall)" << std::endl;
+    } else {
+        std::cerr << "[RealtimeManager] 警告: 无法锁定进程内存: " << error
+                  << " (检查 LimitMEMLOCK 或 CAP_IPC_LOCK)" << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    memory_locked_ = locked;
+    memory_error_ = error;
+    return locked;
+}
+
+void RealtimeManager::applyToCurrentThread(ThreadRole role) {
+    ThreadSchedStatus status;
+    bool prefault = false;
+    size_t prefault_bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        status.requested = config_.threads[static_cast<int>(role)];
+        prefault = config_.lock_memory;
+        prefault_bytes = static_cast<size_t>(config_.prefault_stack_kb) * 1024;
+    }
+    status.name = roleToString(role);
+
+    // 未配置任何策略时不记录，保持默认调度
+    if (status.requested.priority <= 0 && status.requested.cpu < 0) {
+        return;
+    }
+
+    pthread_t self = pthread_self();
+
+    if (status.requested.cpu >= 0) {
+        long cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+        if (status.requested.cpu < cpu_count) {
+            cpu_set_t cpuset;
+            CPU_ZERO(&cpuset);
+            CPU_SET(status.requested.cpu, &cpuset);
+            int err = pthread_setaffinity_np(self, sizeof(cpuset), &cpuset);
+            status.affinity_granted = err == 0;
+            if (err != 0) {
+                status.error = std::string("affinity: ") + std::strerror(err);
+            }
+        } else {
+            status.error = "affinity: CPU " + std::to_string(status.requested.cpu) + " 不存在";
+        }
+    }
+
+    if (status.requested.priority > 0) {
+        sched_param param{};
+        param.sched_priority = std::min(status.requested.priority, sched_get_priority_max(SCHED_FIFO));
+        int err = pthread_setschedparam(self, SCHED_FIFO, &param);
+        status.sched_granted = err == 0;
+        if (err != 0) {
+            if (!status.error.empty()) status.error += "; ";
+            status.error += std::string("SCHED_FIFO: ") + std::strerror(err);
+        }
+    }
+
+    // 内存已锁定时预触碰本线程栈，避免首次使用时缺页
+    if (prefault && prefault_bytes > 0) {
+        prefaultStack(prefault_bytes);
+        status.stack_prefaulted = true;
+    }
+
+    pthread_setname_np(self, ("xz-" + status.name).substr(0, 15).c_str());
+
+    if (status.error.empty()) {
+        std::cout << "[RealtimeManager] 线程 " << status.name << " 调度已设置 (优先级: "
+                  << status.requested.priority << ", CPU: " << status.requested.cpu << ")" << std::endl;
+    } else {
+        std::cerr << "[RealtimeManager] 警告: 线程 " << status.name << " 调度设置未完全生效: "
+                  << status.error << std::endl;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& existing : thread_status_) {
+        if (existing.name == status.name) {
+            existing = status;
+            return;
+        }
+    }
+    thread_status_.push_back(status);
+}
+
+bool RealtimeManager::isMemoryLocked() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return memory_locked_;
+}
+
+std::vector<ThreadSchedStatus> RealtimeManager::getThreadStatus() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return thread_status_;
+}
+
+void RealtimeManager::printReport() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::cout << "实时调度:" << std::endl;
+    std::cout << "  内存锁定: " << (memory_locked_ ? "已生效" : (config_.lock_memory ? "失败 (" + memory_error_ + ")" : "未启用"))
+              << std::endl;
+    if (thread_status_.empty()) {
+        std::cout << "  线程策略: 未配置" << std::endl;
+    }
+    for (const auto& status : thread_status_) {
+        std::cout << "  " << status.name << ": SCHED_FIFO "
+                  << (status.requested.priority > 0 ? (status.sched_granted ? "已生效" : "失败") : "未请求")
+                  << ", CPU绑定 "
+                  << (status.requested.cpu >= 0 ? (status.affinity_granted ? "已生效" : "失败") : "未请求");
+        if (!status.error.empty()) {
+            std::cout << " (" << status.error << ")";
+        }
+        std::cout << std::endl;
+    }
+}
+
+const char* RealtimeManager::roleToString(ThreadRole role) {
+    switch (role) {
+        case ThreadRole::CAPTURE: return "capture";
+        case ThreadRole::PLAYBACK: return "playback";
+        case ThreadRole::NETWORK: return "network";
+        case ThreadRole::AI: return "ai";
+        default: return "unknown";
+    }
+}
+
+int RealtimeManager::maxPrefaultStackKb() {
+    // 为预触碰时已在使用的栈帧留出的余量
+    constexpr rlim_t kStackMarginKb = 256;
+    // 栈大小不受限时glibc按架构默认值创建线程栈，按最小的常见值2MB估计
+    constexpr rlim_t kUnlimitedStackKb = 2048;
+
+    rlimit limit{};
+    rlim_t stack_kb = kUnlimitedStackKb;
+    if (getrlimit(RLIMIT_STACK, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY) {
+        stack_kb = limit.rlim_cur / 1024;
+    }
+    return stack_kb > kStackMarginKb ? static_cast<int>(stack_kb - kStackMarginKb) : 0;
+}
+
+void RealtimeManager::prefaultStack(size_t bytes) {
+    // 在栈上分配并写入，使对应页面提前映射并被mlockall锁定
+    volatile unsigned char* buffer = static_cast<volatile unsigned char*>(alloca(bytes));
+    long page_size = sysconf(_SC_PAGESIZE);
+    for (size_t i = 0; i < bytes; i += static_cast<size_t>(page_size)) {
+        buffer[i] = 0;
+    }
+}
+
+} // namespace xiaozhi
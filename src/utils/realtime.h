@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstddef>
+
+namespace xiaozhi {
+
+// 需要单独设置调度策略的线程角色
+enum class ThreadRole {
+    CAPTURE = 0,
+    PLAYBACK,
+    NETWORK,
+    AI,
+    COUNT
+};
+
+struct ThreadSchedConfig {
+    int priority = 0;  // SCHED_FIFO优先级 (1-99)，0表示保持SCHED_OTHER
+    int cpu = -1;      // 绑定的CPU核心，-1表示不绑定
+};
+
+struct RealtimeConfig {
+    bool lock_memory = false;      // 启动时调用mlockall锁定内存
+    int prefault_stack_kb = 256;   // 预先触碰的线程栈大小，避免运行中缺页
+    ThreadSchedConfig threads[static_cast<int>(ThreadRole::COUNT)];
+};
+
+// 单个线程的实际生效情况
+struct ThreadSchedStatus {
+    std::string name;
+    ThreadSchedConfig requested;
+    bool sched_granted = false;
+    bool affinity_granted = false;
+    bool stack_prefaulted = false;
+    std::string error;
+};
+
+class RealtimeManager {
+public:
+    static RealtimeManager& getInstance();
+
+    void configure(const RealtimeConfig& config);
+
+    // 锁定进程内存并预触碰主线程栈，返回是否成功
+    bool lockProcessMemory();
+
+    // 在线程入口处调用，为当前线程应用对应角色的调度策略和CPU绑定
+    void applyToCurrentThread(ThreadRole role);
+
+    bool isMemoryLocked() const;
+    std::vector<ThreadSchedStatus> getThreadStatus() const;
+    void printReport() const;
+
+    static const char* roleToString(ThreadRole role);
+
+    // prefault_stack_kb的上限：栈大小限制（RLIMIT_STACK，线程默认栈大小同样取自它）
+    // 减去调用方已用栈的余量，超过后alloca会越过栈底
+    static int maxPrefaultStackKb();
+
+private:
+    RealtimeManager() = default;
+    ~RealtimeManager() = default;
+
+    void prefaultStack(size_t bytes);
+
+    RealtimeConfig config_;
+    bool memory_locked_ = false;
+    std::string memory_error_;
+    std::vector<ThreadSchedStatus> thread_status_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace xiaozhi
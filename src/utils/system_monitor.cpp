@@ -0,0 +1,191 @@
+#include "system_monitor.h"
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+
+namespace xiaozhi {
+
+namespace {
+
+constexpr const char* kThermalRoot = "/sys/class/thermal";
+
+// 取"Key:   value kB"形式的一行中的数值
+uint64_t meminfoValue(const std::string& content, const char* key) {
+    size_t pos = content.find(key);
+    if (pos == std::string::npos) {
+        return 0;
+    }
+    return std::strtoull(content.c_str() + pos + std::strlen(key), nullptr, 10);
+}
+
+} // namespace
+
+SystemMonitor::SystemMonitor()
+    : stat_fd_(openReadOnly("/proc/stat")),
+      meminfo_fd_(openReadOnly("/proc/meminfo")),
+      uptime_fd_(openReadOnly("/proc/uptime")),
+      loadavg_fd_(openReadOnly("/proc/loadavg")),
+      snapshot_(std::make_shared<SystemSnapshot>()) {
+    discoverThermalZones();
+}
+
+SystemMonitor::~SystemMonitor() {
+    for (int fd : {stat_fd_, meminfo_fd_, uptime_fd_, loadavg_fd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    for (const auto& zone : thermal_zones_) {
+        close(zone.fd);
+    }
+}
+
+int SystemMonitor::openReadOnly(const std::string& path) {
+    return open(path.c_str(), O_RDONLY | O_CLOEXEC);
+}
+
+bool SystemMonitor::readFile(int fd, std::string& content) {
+    // procfs和sysfs每次从偏移0读取都会重新生成内容，无需重新打开
+    content.clear();
+    if (fd < 0) {
+        return false;
+    }
+    char chunk[4096];
+    off_t offset = 0;
+    while (true) {
+        ssize_t bytes = pread(fd, chunk, sizeof(chunk), offset);
+        if (bytes > 0) {
+            content.append(chunk, static_cast<size_t>(bytes));
+            offset += bytes;
+            continue;
+        }
+        return bytes == 0 && !content.empty();
+    }
+}
+
+void SystemMonitor::discoverThermalZones() {
+    DIR* dir = opendir(kThermalRoot);
+    if (!dir) {
+        return;
+    }
+    std::vector<std::string> names;
+    while (dirent* entry = readdir(dir)) {
+        if (std::strncmp(entry->d_name, "thermal_zone", 12) == 0) {
+            names.push_back(entry->d_name);
+        }
+    }
+    closedir(dir);
+    std::sort(names.begin(), names.end());
+
+    for (const auto& name : names) {
+        std::string base = std::string(kThermalRoot) + "/" + name;
+        ThermalZone zone;
+        zone.fd = openReadOnly(base + "/temp");
+        if (zone.fd < 0) {
+            continue;
+        }
+        int type_fd = openReadOnly(base + "/type");
+        if (readFile(type_fd, zone.type)) {
+            zone.type.erase(zone.type.find_last_not_of("\n") + 1);
+        } else {
+            zone.type = name;
+        }
+        if (type_fd >= 0) {
+            close(type_fd);
+        }
+        thermal_zones_.push_back(std::move(zone));
+    }
+    std::cout << "[SystemMonitor] 发现 " << thermal_zones_.size() << " 个温区" << std::endl;
+}
+
+void SystemMonitor::sample() {
+    std::lock_guard<std::mutex> lock(sample_mutex_);
+    auto snapshot = std::make_shared<SystemSnapshot>();
+    snapshot->sampled_at = std::chrono::steady_clock::now();
+
+    // 首行"cpu  user nice system idle iowait irq softirq steal ..."，guest已计入user
+    if (readFile(stat_fd_, buffer_) && buffer_.compare(0, 4, "cpu ") == 0) {
+        const char* cursor = buffer_.c_str() + 4;
+        uint64_t fields[8] = {0};
+        for (auto& field : fields) {
+            char* end = nullptr;
+            field = std::strtoull(cursor, &end, 10);
+            cursor = end;
+        }
+        uint64_t total = 0;
+        for (uint64_t field : fields) {
+            total += field;
+        }
+        uint64_t idle = fields[3] + fields[4];
+        if (sequence_ > 0 && total > prev_total_ticks_) {
+            uint64_t total_delta = total - prev_total_ticks_;
+            uint64_t idle_delta = idle > prev_idle_ticks_ ? idle - prev_idle_ticks_ : 0;
+            snapshot->cpu_usage_percent = 100.0 * static_cast<double>(total_delta - std::min(total_delta, idle_delta)) /
+                                          static_cast<double>(total_delta);
+        }
+        prev_total_ticks_ = total;
+        prev_idle_ticks_ = idle;
+
+        for (size_t pos = buffer_.find("\ncpu"); pos != std::string::npos; pos = buffer_.find("\ncpu", pos + 1)) {
+            ++snapshot->cpu_count;
+        }
+    }
+
+    if (readFile(meminfo_fd_, buffer_)) {
+        snapshot->memory_total_bytes = meminfoValue(buffer_, "MemTotal:") * 1024;
+        snapshot->memory_available_bytes = meminfoValue(buffer_, "MemAvailable:") * 1024;
+        if (snapshot->memory_total_bytes > 0) {
+            snapshot->memory_usage_percent =
+                100.0 * static_cast<double>(snapshot->memory_total_bytes - std::min(
+                    snapshot->memory_available_bytes, snapshot->memory_total_bytes)) /
+                static_cast<double>(snapshot->memory_total_bytes);
+        }
+    }
+
+    if (readFile(uptime_fd_, buffer_)) {
+        snapshot->uptime_seconds = std::strtod(buffer_.c_str(), nullptr);
+    }
+
+    if (readFile(loadavg_fd_, buffer_)) {
+        const char* cursor = buffer_.c_str();
+        for (double& load : snapshot->load_average) {
+            char* end = nullptr;
+            load = std::strtod(cursor, &end);
+            cursor = end;
+        }
+    }
+
+    for (const auto& zone : thermal_zones_) {
+        if (!readFile(zone.fd, buffer_)) {
+            continue;
+        }
+        // 温区以毫摄氏度为单位
+        ThermalZoneReading reading;
+        reading.type = zone.type;
+        reading.celsius = std::strtod(buffer_.c_str(), nullptr) / 1000.0;
+        if (!snapshot->has_temperature || reading.celsius > snapshot->temperature_celsius) {
+            snapshot->temperature_celsius = reading.celsius;
+        }
+        snapshot->has_temperature = true;
+        snapshot->thermal_zones.push_back(std::move(reading));
+    }
+
+    snapshot->sequence = ++sequence_;
+    std::atomic_store_explicit(&snapshot_, std::shared_ptr<const SystemSnapshot>(std::move(snapshot)),
+                               std::memory_order_release);
+}
+
+std::shared_ptr<const SystemSnapshot> SystemMonitor::snapshot() {
+    auto current = std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+    if (current->sequence == 0) {
+        sample();
+        current = std::atomic_load_explicit(&snapshot_, std::memory_order_acquire);
+    }
+    return current;
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+
+namespace xiaozhi {
+
+struct ThermalZoneReading {
+    std::string type;           // /sys/class/thermal/thermal_zoneN/type，如cpu-thermal
+    double celsius = 0.0;
+};
+
+// 一次采样的整机状态，发布后不再修改
+struct SystemSnapshot {
+    uint64_t sequence = 0;              // 第几次采样，0表示尚未采样
+    std::chrono::steady_clock::time_point sampled_at;
+    double cpu_usage_percent = 0.0;     // 与上一次采样之间的整机CPU占用，首次采样为0
+    int cpu_count = 0;
+    uint64_t memory_total_bytes = 0;
+    uint64_t memory_available_bytes = 0;
+    double memory_usage_percent = 0.0;
+    double uptime_seconds = 0.0;
+    double load_average[3] = {0.0, 0.0, 0.0};
+    bool has_temperature = false;
+    double temperature_celsius = 0.0;   // 各温区中的最高温度
+    std::vector<ThermalZoneReading> thermal_zones;
+};
+
+// 整机状态采样：/proc/stat、/proc/meminfo、/proc/uptime、/proc/loadavg和各温区的
+// 文件在构造时打开一次，之后每次采样只对已打开的描述符做pread，CPU占用由相邻两次
+// 采样的计数差得出。采样通常由定时器在后台触发，读取方只取最新快照，不接触文件系统
+class SystemMonitor {
+public:
+    SystemMonitor();
+    ~SystemMonitor();
+
+    SystemMonitor(const SystemMonitor&) = delete;
+    SystemMonitor& operator=(const SystemMonitor&) = delete;
+
+    // 采样一次并发布新快照，可在任意线程调用
+    void sample();
+
+    // 最新快照；从未采样过时先同步采样一次
+    std::shared_ptr<const SystemSnapshot> snapshot();
+
+private:
+    struct ThermalZone {
+        std::string type;
+        int fd = -1;
+    };
+
+    static int openReadOnly(const std::string& path);
+    static bool readFile(int fd, std::string& content);
+    void discoverThermalZones();
+
+    int stat_fd_;
+    int meminfo_fd_;
+    int uptime_fd_;
+    int loadavg_fd_;
+    std::vector<ThermalZone> thermal_zones_;
+
+    std::mutex sample_mutex_;       // 串行化采样，保护上一次的CPU计数
+    std::string buffer_;
+    uint64_t prev_total_ticks_ = 0;
+    uint64_t prev_idle_ticks_ = 0;
+    uint64_t sequence_ = 0;
+
+    // 只通过std::atomic_load/atomic_store访问
+    std::shared_ptr<const SystemSnapshot> snapshot_;
+};
+
+} // namespace xiaozhi
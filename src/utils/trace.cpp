@@ -0,0 +1,218 @@
+#include "trace.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace xiaozhi {
+
+// 单个线程的事件环形缓冲：只有所属线程写入，head_以release发布，
+// 导出线程按acquire读取并丢弃拷贝期间可能被覆盖的事件
+class TraceBuffer {
+public:
+    explicit TraceBuffer(size_t capacity)
+        : events_(std::max<size_t>(capacity, 64)),
+          tid_(static_cast<int>(syscall(SYS_gettid))) {}
+
+    void push(const TraceEvent& event) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        events_[head % events_.size()] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    std::vector<TraceEvent> snapshot(uint64_t& dropped) const {
+        size_t capacity = events_.size();
+        uint64_t end = head_.load(std::memory_order_acquire);
+        uint64_t begin = end > capacity ? end - capacity : 0;
+
+        std::vector<TraceEvent> result;
+        result.reserve(static_cast<size_t>(end - begin));
+        for (uint64_t i = begin; i < end; ++i) {
+            result.push_back(events_[i % capacity]);
+        }
+
+        // 拷贝期间写入线程可能已绕回覆盖最旧的事件
+        uint64_t after = head_.load(std::memory_order_acquire);
+        uint64_t overwritten = after > capacity ? after - capacity : 0;
+        size_t skip = overwritten > begin ? static_cast<size_t>(std::min<uint64_t>(overwritten - begin, result.size())) : 0;
+        result.erase(result.begin(), result.begin() + skip);
+
+        dropped = (after > capacity ? after - capacity : 0);
+        return result;
+    }
+
+    int getTid() const { return tid_; }
+
+    std::string name;   // 受Tracer::buffers_mutex_保护
+
+private:
+    std::vector<TraceEvent> events_;
+    std::atomic<uint64_t> head_{0};
+    int tid_;
+};
+
+namespace {
+
+thread_local TraceBuffer* t_buffer = nullptr;
+thread_local const char* t_thread_name = nullptr;
+
+void writeJsonString(std::ostream& out, const char* text) {
+    out << '"';
+    for (const char* p = text ? text : ""; *p; ++p) {
+        if (*p == '"' || *p == '\\') {
+            out << '\\';
+        }
+        out << *p;
+    }
+    out << '"';
+}
+
+} // namespace
+
+Tracer& Tracer::getInstance() {
+    static Tracer instance;
+    return instance;
+}
+
+void Tracer::configure(const TraceConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        config_ = config;
+    }
+    setEnabled(config.enabled);
+}
+
+TraceConfig Tracer::getConfig() const {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    return config_;
+}
+
+void Tracer::setEnabled(bool enabled) {
+#ifndef XIAOZHI_TRACING
+    if (enabled) {
+        std::cerr << "[Tracer] 警告: 编译时未启用追踪 (ENABLE_TRACING=OFF)，不会记录事件" << std::endl;
+    }
+#endif
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Tracer::setThreadName(const char* name) {
+    t_thread_name = name;
+    if (t_buffer) {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        t_buffer->name = name;
+    }
+}
+
+void Tracer::record(const char* category, const char* name, uint64_t start_ns,
+                    uint64_t duration_ns, char phase, int64_t value) {
+    TraceBuffer* buffer = currentBuffer();
+    TraceEvent event;
+    event.category = category;
+    event.name = name;
+    event.start_ns = start_ns;
+    event.duration_ns = duration_ns;
+    event.value = value;
+    event.phase = phase;
+    buffer->push(event);
+}
+
+TraceBuffer* Tracer::currentBuffer() {
+    if (t_buffer) {
+        return t_buffer;
+    }
+
+    // 线程首次记录时分配缓冲；Tracer持有共享指针，线程退出后事件仍可导出
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    auto buffer = std::make_shared<TraceBuffer>(static_cast<size_t>(std::max(config_.buffer_events, 0)));
+    if (t_thread_name) {
+        buffer->name = t_thread_name;
+    }
+    buffers_.push_back(buffer);
+    t_buffer = buffer.get();
+    return t_buffer;
+}
+
+bool Tracer::dumpChromeJson(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        std::cerr << "[Tracer] 错误: 无法写入追踪文件: " << path << std::endl;
+        return false;
+    }
+
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    std::vector<std::string> names;
+    {
+        std::lock_guard<std::mutex> lock(buffers_mutex_);
+        buffers = buffers_;
+        for (const auto& buffer : buffers_) {
+            names.push_back(buffer->name);
+        }
+    }
+
+    int pid = static_cast<int>(getpid());
+    size_t total = 0;
+    uint64_t total_dropped = 0;
+    bool first = true;
+
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << std::fixed << std::setprecision(3);
+
+    for (size_t b = 0; b < buffers.size(); ++b) {
+        int tid = buffers[b]->getTid();
+        if (!names[b].empty()) {
+            out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+                << ",\"tid\":" << tid << ",\"args\":{\"name\":";
+            writeJsonString(out, names[b].c_str());
+            out << "}}";
+            first = false;
+        }
+
+        uint64_t dropped = 0;
+        std::vector<TraceEvent> events = buffers[b]->snapshot(dropped);
+        total_dropped += dropped;
+        total += events.size();
+
+        for (const TraceEvent& event : events) {
+            out << (first ? "" : ",\n") << "{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":";
+            writeJsonString(out, event.category);
+            out << ",\"ph\":\"" << event.phase << "\",\"ts\":" << event.start_ns / 1000.0
+                << ",\"pid\":" << pid << ",\"tid\":" << tid;
+            if (event.phase == 'X') {
+                out << ",\"dur\":" << event.duration_ns / 1000.0;
+            } else if (event.phase == 'i') {
+                out << ",\"s\":\"t\"";
+            } else if (event.phase == 'C') {
+                out << ",\"args\":{\"value\":" << event.value << "}";
+            }
+            out << "}";
+            first = false;
+        }
+    }
+    out << "\n]}\n";
+
+    if (!out.good()) {
+        std::cerr << "[Tracer] 错误: 写入追踪文件失败: " << path << std::endl;
+        return false;
+    }
+
+    std::cout << "[Tracer] 已导出 " << total << " 个追踪事件到 " << path;
+    if (total_dropped > 0) {
+        std::cout << " (环形缓冲已覆盖最早的 " << total_dropped << " 个事件)";
+    }
+    std::cout << std::endl;
+    return true;
+}
+
+uint64_t Tracer::nowNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace xiaozhi
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <cstdint>
+
+namespace xiaozhi {
+
+struct TraceConfig {
+    bool enabled = false;                               // 启动即开始记录
+    std::string output_file = "/tmp/xiaozhi-trace.json"; // SIGUSR1和trace dump的默认输出
+    int buffer_events = 8192;                           // 每个线程环形缓冲的事件数
+};
+
+struct TraceEvent {
+    const char* category;   // 类别和名称必须是字符串字面量，记录时只保存指针
+    const char* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+    int64_t value;          // 计数器事件的取值
+    char phase;             // 'X' 区间, 'i' 瞬时, 'C' 计数器
+};
+
+class TraceBuffer;
+
+// 流水线追踪：每个线程写自己的环形缓冲（单写者，无锁），
+// 时间戳取CLOCK_MONOTONIC，导出时合并为Chrome trace JSON
+class Tracer {
+public:
+    static Tracer& getInstance();
+
+    void configure(const TraceConfig& config);
+    TraceConfig getConfig() const;
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_.load(std::memory_order_relaxed); }
+
+    // 为当前线程命名，显示为trace中的线程轨道名
+    void setThreadName(const char* name);
+
+    void record(const char* category, const char* name, uint64_t start_ns,
+                uint64_t duration_ns, char phase, int64_t value = 0);
+
+    // 导出Chrome trace JSON，可直接在chrome://tracing或ui.perfetto.dev中打开
+    bool dumpChromeJson(const std::string& path) const;
+
+    static uint64_t nowNs();
+
+private:
+    Tracer() = default;
+    ~Tracer() = default;
+
+    TraceBuffer* currentBuffer();
+
+    std::atomic<bool> enabled_{false};
+    TraceConfig config_;
+
+    // 仅在线程首次记录和导出时加锁
+    mutable std::mutex buffers_mutex_;
+    std::vector<std::shared_ptr<TraceBuffer>> buffers_;
+};
+
+// 作用域区间事件：构造时记录开始时间，析构时写入缓冲
+class TraceScope {
+public:
+    TraceScope(const char* category, const char* name)
+        : category_(category), name_(name),
+          start_ns_(Tracer::getInstance().isEnabled() ? Tracer::nowNs() : 0) {}
+
+    ~TraceScope() {
+        if (start_ns_ != 0) {
+            Tracer::getInstance().record(category_, name_, start_ns_, Tracer::nowNs() - start_ns_, 'X');
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* category_;
+    const char* name_;
+    uint64_t start_ns_;
+};
+
+#define XZ_TRACE_CONCAT_INNER(a, b) a##b
+#define XZ_TRACE_CONCAT(a, b) XZ_TRACE_CONCAT_INNER(a, b)
+
+#ifdef XIAOZHI_TRACING
+#define TRACE_SCOPE(category, name) \
+    xiaozhi::TraceScope XZ_TRACE_CONCAT(trace_scope_, __LINE__)(category, name)
+#define TRACE_INSTANT(category, name) \
+    do { \
+        if (xiaozhi::Tracer::getInstance().isEnabled()) \
+            xiaozhi::Tracer::getInstance().record(category, name, xiaozhi::Tracer::nowNs(), 0, 'i'); \
+    } while (0)
+#define TRACE_COUNTER(category, name, value) \
+    do { \
+        if (xiaozhi::Tracer::getInstance().isEnabled()) \
+            xiaozhi::Tracer::getInstance().record(category, name, xiaozhi::Tracer::nowNs(), 0, 'C', \
+                                                  static_cast<int64_t>(value)); \
+    } while (0)
+#define TRACE_THREAD_NAME(name) xiaozhi::Tracer::getInstance().setThreadName(name)
+#else
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_INSTANT(category, name) ((void)0)
+#define TRACE_COUNTER(category, name, value) ((void)0)
+#define TRACE_THREAD_NAME(name) ((void)0)
+#endif
+
+} // namespace xiaozhi
@@ -0,0 +1,210 @@
+// 二进制日志的行为测试：写入的记录经xiaozhi-logdecode还原为文本，包括跨轮转文件的解码。
+// 用法: test_binary_log <xiaozhi-logdecode路径>
+#include "test_support.h"
+#include "utils/binary_log.h"
+#include "utils/logger.h"
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/stat.h>
+
+using namespace xiaozhi;
+
+namespace {
+
+std::string g_decoder;
+std::string g_directory;
+
+bool fileExists(const std::string& path) {
+    return access(path.c_str(), F_OK) == 0;
+}
+
+bool startsWith(const std::string& text, const std::string& prefix) {
+    return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// 运行解码工具，返回每行中"] "之后的部分（去掉时间戳和级别，级别单独返回）
+struct DecodedLine {
+    std::string level;
+    std::string text;
+};
+
+std::vector<DecodedLine> runDecoder(const std::string& arguments, int* exit_code = nullptr) {
+    std::vector<DecodedLine> lines;
+    FILE* pipe = popen((g_decoder + " " + arguments).c_str(), "r");
+    if (!pipe) {
+        return lines;
+    }
+    std::string line;
+    char buffer[4096];
+    while (fgets(buffer, sizeof(buffer), pipe)) {
+        line += buffer;
+        if (line.back() != '\n') {
+            continue;
+        }
+        line.pop_back();
+        size_t open = line.find(" [");
+        size_t close = line.find("] ", open);
+        if (open != std::string::npos && close != std::string::npos) {
+            lines.push_back({line.substr(open + 2, close - open - 2), line.substr(close + 2)});
+        }
+        line.clear();
+    }
+    int status = pclose(pipe);
+    if (exit_code) {
+        *exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+    }
+    return lines;
+}
+
+std::string expectedMessage(int i) {
+    return "worker: 第" + std::to_string(i) + "条 比例=0.5 名称=item-" + std::to_string(i) +
+           " 完成=" + (i % 2 == 0 ? "true" : "false");
+}
+
+// 直接用BinaryLogWriter写出记录，每10条一条WARN；单个文件最小64KB，约1300条轮转一次
+void writeEvents(const std::string& path, size_t max_file_bytes, int max_files, int count) {
+    BinaryLogWriter writer;
+    EXPECT_TRUE(writer.open(path, max_file_bytes, max_files));
+
+    LogFormatInfo format;
+    format.id = 2;
+    format.level = static_cast<uint8_t>(LogLevel::INFO);
+    format.line = 42;
+    format.file = "src/test/worker.cpp";
+    format.function = "worker";
+    format.format = "第{}条 比例={} 名称={} 完成={}";
+    EXPECT_TRUE(writer.writeFormat(format));
+
+    for (int i = 0; i < count; ++i) {
+        BinaryArgBuffer args;
+        appendBinaryArgs(args, i, 0.5, "item-" + std::to_string(i), i % 2 == 0);
+        uint8_t level = static_cast<uint8_t>(i % 10 == 0 ? LogLevel::WARN : LogLevel::INFO);
+        EXPECT_TRUE(writer.writeEvent(level, format.id, 1700000000000000000LL + i * 1000000LL, args.data, args.size));
+    }
+    writer.close();
+}
+
+void testRoundTripAcrossRotation() {
+    std::string path = g_directory + "/rotate.blog";
+    const int kCount = 5000;
+    writeEvents(path, 64 * 1024, 32, kCount);
+    EXPECT_TRUE(fileExists(path + ".1"));
+    EXPECT_TRUE(fileExists(path + ".2"));
+
+    // 默认按时间顺序包含全部轮转文件，记录既不丢失也不重复
+    int exit_code = -1;
+    auto lines = runDecoder(path, &exit_code);
+    EXPECT_EQ(exit_code, 0);
+    EXPECT_EQ(lines.size(), static_cast<size_t>(kCount));
+    for (size_t i = 0; i < lines.size() && i < static_cast<size_t>(kCount); ++i) {
+        EXPECT_EQ(lines[i].text, expectedMessage(static_cast<int>(i)));
+        EXPECT_EQ(lines[i].level, std::string(i % 10 == 0 ? "WARN" : "INFO"));
+    }
+
+    // 每个轮转文件开头重放格式定义，单独解码时也能还原
+    auto rotated = runDecoder("--single " + path + ".1");
+    EXPECT_TRUE(!rotated.empty());
+    bool all_decoded = true;
+    for (const auto& line : rotated) {
+        all_decoded = all_decoded && startsWith(line.text, "worker: 第");
+    }
+    EXPECT_TRUE(all_decoded);
+
+    // --level过滤和--location输出源文件位置
+    auto warnings = runDecoder("--level WARN " + path);
+    EXPECT_EQ(warnings.size(), static_cast<size_t>(kCount / 10));
+    auto located = runDecoder("--location --single " + path);
+    EXPECT_TRUE(!located.empty() && startsWith(located[0].text, "src/test/worker.cpp:42 worker: "));
+}
+
+void testOldestFilesDropped() {
+    // 只保留3个文件：最旧的记录被删除，解码结果是以最后一条结尾的连续后缀
+    std::string path = g_directory + "/limited.blog";
+    const int kCount = 6000;
+    writeEvents(path, 64 * 1024, 3, kCount);
+    EXPECT_TRUE(fileExists(path + ".2"));
+    EXPECT_TRUE(!fileExists(path + ".3"));
+
+    auto lines = runDecoder(path);
+    EXPECT_TRUE(!lines.empty() && lines.size() < static_cast<size_t>(kCount));
+    size_t first = kCount - lines.size();
+    for (size_t i = 0; i < lines.size(); ++i) {
+        EXPECT_EQ(lines[i].text, expectedMessage(static_cast<int>(first + i)));
+    }
+}
+
+void testLoggerBinaryMode() {
+#if XIAOZHI_MIN_LOG_LEVEL <= 1
+    // 经过Logger的完整路径：LOG_*调用点登记格式并编码参数，Logger::info写整行文本
+    LoggingConfig config;
+    config.level = LogLevel::INFO;
+    config.file = g_directory + "/text.log";
+    config.binary = true;
+    config.binary_file = g_directory + "/logger.blog";
+    config.overflow = LogOverflowPolicy::BLOCK;    // 连续写入时不丢记录
+    config.binary_max_file_kb = 64;
+    config.binary_max_files = 16;
+    Logger& logger = Logger::getInstance();
+    logger.configure(config);
+
+    const int kCount = 4000;
+    for (int i = 0; i < kCount; ++i) {
+        LOG_INFO("轮次 {}/{}: {}", i, kCount, "ok");
+    }
+    logger.info("整行文本 {} 不是占位符");
+    logger.flush();
+    EXPECT_TRUE(fileExists(config.binary_file + ".1"));
+
+    auto lines = runDecoder(config.binary_file);
+    EXPECT_EQ(lines.size(), static_cast<size_t>(kCount + 1));
+    for (size_t i = 0; i < lines.size() && i < static_cast<size_t>(kCount); ++i) {
+        std::string expected = "轮次 " + std::to_string(i) + "/" + std::to_string(kCount) + ": ok";
+        EXPECT_TRUE(endsWith(lines[i].text, expected));
+    }
+    if (lines.size() == static_cast<size_t>(kCount + 1)) {
+        EXPECT_EQ(lines.back().text, std::string("整行文本 {} 不是占位符"));
+    }
+
+    config.binary = false;
+    logger.configure(config);
+#endif
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <xiaozhi-logdecode路径>" << std::endl;
+        return 2;
+    }
+    g_decoder = argv[1];
+
+    const char* tmp = getenv("TMPDIR");
+    std::string pattern = std::string(tmp && *tmp ? tmp : "/tmp") + "/xiaozhi_blog_XXXXXX";
+    std::vector<char> directory(pattern.begin(), pattern.end());
+    directory.push_back('\0');
+    if (!mkdtemp(directory.data())) {
+        std::cerr << "无法创建临时目录: " << pattern << std::endl;
+        return 2;
+    }
+    g_directory = directory.data();
+
+    RUN_TEST(testRoundTripAcrossRotation);
+    RUN_TEST(testOldestFilesDropped);
+    RUN_TEST(testLoggerBinaryMode);
+
+    int result = test::finish();
+    if (result == 0) {
+        std::string command = "rm -rf '" + g_directory + "'";
+        int removed = system(command.c_str());
+        (void)removed;
+    }
+    return result;
+}
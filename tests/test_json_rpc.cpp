@@ -0,0 +1,149 @@
+// JsonRpcHandler的行为测试：字段类型不符（包括JSON null）的请求得到错误响应而不是使进程退出，
+// 覆盖信封字段、工具名和tools/list的分页游标
+#include "test_support.h"
+#include "mcp/json_rpc_handler.h"
+#include "mcp/tool_registry.h"
+#include <string>
+#include <map>
+#include <json-c/json.h>
+
+using namespace xiaozhi;
+
+namespace {
+
+struct ParsedResponse {
+    bool valid = false;
+    int error_code = 0;         // 0表示没有error字段
+    std::string id = "absent";  // 序列化后的id
+    bool has_result = false;
+};
+
+ParsedResponse parse(const std::string& response) {
+    ParsedResponse parsed;
+    json_object* root = json_tokener_parse(response.c_str());
+    if (!root || !json_object_is_type(root, json_type_object)) {
+        if (root) {
+            json_object_put(root);
+        }
+        return parsed;
+    }
+    parsed.valid = true;
+    json_object* field = nullptr;
+    if (json_object_object_get_ex(root, "error", &field)) {
+        json_object* code = nullptr;
+        if (json_object_object_get_ex(field, "code", &code)) {
+            parsed.error_code = json_object_get_int(code);
+        }
+    }
+    if (json_object_object_get_ex(root, "id", &field)) {
+        parsed.id = json_object_to_json_string_ext(field, JSON_C_TO_STRING_PLAIN);
+    }
+    parsed.has_result = json_object_object_get_ex(root, "result", nullptr);
+    json_object_put(root);
+    return parsed;
+}
+
+class Fixture {
+public:
+    Fixture() : handler_(registry_) {
+        registry_.registerTool("echo", "返回固定结果", {}, ToolHandler([](const std::map<std::string, std::string>&) {
+            return std::string("{\"ok\":true}");
+        }));
+    }
+
+    ParsedResponse call(const std::string& request) { return parse(handler_.handleRequest(request)); }
+    std::string raw(const std::string& request) { return handler_.handleRequest(request); }
+
+private:
+    ToolRegistry registry_;
+    JsonRpcHandler handler_;
+};
+
+void testValidRequests() {
+    Fixture fixture;
+    ParsedResponse ping = fixture.call(R"({"jsonrpc":"2.0","method":"ping","id":1})");
+    EXPECT_TRUE(ping.valid && ping.has_result);
+    EXPECT_EQ(ping.id, std::string("1"));
+
+    ParsedResponse call = fixture.call(R"({"jsonrpc":"2.0","method":"tools/call","id":"a","params":{"name":"echo"}})");
+    EXPECT_TRUE(call.valid && call.has_result);
+    EXPECT_EQ(call.error_code, 0);
+}
+
+void testInvalidEnvelope() {
+    Fixture fixture;
+    // jsonrpc和method为null或非字符串时按无效请求应答，id为null
+    const char* requests[] = {
+        R"({"jsonrpc":null,"method":"ping","id":1})",
+        R"({"jsonrpc":2,"method":"ping","id":1})",
+        R"({"jsonrpc":"1.0","method":"ping","id":1})",
+        R"({"jsonrpc":"2.0","method":null,"id":1})",
+        R"({"jsonrpc":"2.0","method":5,"id":1})",
+        R"({"jsonrpc":"2.0","method":{"x":1},"id":1})",
+        R"({"jsonrpc":"2.0","id":1})",
+    };
+    for (const char* request : requests) {
+        ParsedResponse response = fixture.call(request);
+        EXPECT_TRUE(response.valid);
+        EXPECT_EQ(response.error_code, -32600);
+        EXPECT_EQ(response.id, std::string("null"));
+    }
+
+    // 批量中的无效元素只影响自身
+    std::string batch = fixture.raw(
+        R"([{"jsonrpc":"2.0","method":null,"id":1},{"jsonrpc":"2.0","method":"ping","id":2}])");
+    EXPECT_TRUE(batch.find("-32600") != std::string::npos);
+    EXPECT_TRUE(batch.find("\"id\":2") != std::string::npos);
+}
+
+void testInvalidToolName() {
+    Fixture fixture;
+    const char* requests[] = {
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7,"params":{"name":null}})",
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7,"params":{"name":42}})",
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7,"params":{"name":["echo"]}})",
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7,"params":{}})",
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7,"params":null})",
+        R"({"jsonrpc":"2.0","method":"tools/call","id":7})",
+    };
+    for (const char* request : requests) {
+        ParsedResponse response = fixture.call(request);
+        EXPECT_TRUE(response.valid);
+        EXPECT_EQ(response.error_code, -32602);
+        EXPECT_EQ(response.id, std::string("7"));
+    }
+
+    // arguments为null时按没有参数处理
+    ParsedResponse response = fixture.call(
+        R"({"jsonrpc":"2.0","method":"tools/call","id":8,"params":{"name":"echo","arguments":null}})");
+    EXPECT_TRUE(response.valid && response.has_result);
+}
+
+void testInvalidCursor() {
+    Fixture fixture;
+    const char* requests[] = {
+        R"({"jsonrpc":"2.0","method":"tools/list","id":3,"params":{"cursor":null}})",
+        R"({"jsonrpc":"2.0","method":"tools/list","id":3,"params":{"cursor":12}})",
+        R"({"jsonrpc":"2.0","method":"tools/list","id":3,"params":{"cursor":"garbage"}})",
+    };
+    for (const char* request : requests) {
+        ParsedResponse response = fixture.call(request);
+        EXPECT_TRUE(response.valid);
+        EXPECT_EQ(response.error_code, -32602);
+        EXPECT_EQ(response.id, std::string("3"));
+    }
+
+    // 没有cursor时返回第一页
+    ParsedResponse response = fixture.call(R"({"jsonrpc":"2.0","method":"tools/list","id":4,"params":{}})");
+    EXPECT_TRUE(response.valid && response.has_result);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(testValidRequests);
+    RUN_TEST(testInvalidEnvelope);
+    RUN_TEST(testInvalidToolName);
+    RUN_TEST(testInvalidCursor);
+    return test::finish();
+}
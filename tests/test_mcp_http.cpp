@@ -0,0 +1,310 @@
+// McpHttpTransport请求解析的行为测试：分段到达的请求头、超限请求、流水线应答顺序和慢速请求超时
+#include "test_support.h"
+#include "mcp/mcp_transport.h"
+#include "utils/event_loop.h"
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+using namespace xiaozhi;
+
+namespace {
+
+struct HttpResponse {
+    int status = 0;
+    std::string body;
+};
+
+// 在独立线程中运行事件循环和传输，处理函数原样返回请求体；
+// 请求体为数字n时在另一个线程中延迟(10-n)*10ms后应答，后发的请求先完成
+class TestServer {
+public:
+    explicit TestServer(McpTransportOptions options = McpTransportOptions())
+        : transport_([this](const std::string& message, uint64_t, McpResponder respond, McpNotifier) {
+              handle(message, std::move(respond));
+          }) {
+        options.port = 0;
+        thread_ = std::thread([this]() { loop_.run(); });
+        started_ = transport_.start(&loop_, options);
+    }
+
+    ~TestServer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+        transport_.stop();
+        loop_.stop();
+        thread_.join();
+    }
+
+    bool started() const { return started_; }
+    int port() const { return transport_.getPort(); }
+
+private:
+    void handle(const std::string& message, McpResponder respond) {
+        char* end = nullptr;
+        long n = std::strtol(message.c_str(), &end, 10);
+        if (message.empty() || *end != '\0') {
+            respond(message);
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        workers_.emplace_back([n, message, respond]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds((10 - n) * 10));
+            respond(message);
+        });
+    }
+
+    EventLoop loop_;
+    McpHttpTransport transport_;
+    std::thread thread_;
+    bool started_ = false;
+    std::mutex mutex_;
+    std::vector<std::thread> workers_;
+};
+
+int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void sendAll(int fd, const std::string& data) {
+    size_t offset = 0;
+    while (offset < data.size()) {
+        ssize_t written = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (written <= 0) {
+            return;
+        }
+        offset += static_cast<size_t>(written);
+    }
+}
+
+std::string postRequest(const std::string& body, const std::string& extra_headers = "") {
+    return "POST /mcp HTTP/1.1\r\nHost: localhost\r\n" + extra_headers +
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+// 读取count个完整响应，超时或连接关闭时返回已读到的部分；closed报告对端是否已关闭
+std::vector<HttpResponse> readResponses(int fd, size_t count, int timeout_ms, bool* closed = nullptr) {
+    std::vector<HttpResponse> responses;
+    std::string buffer;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+    if (closed) {
+        *closed = false;
+    }
+
+    while (responses.size() < count) {
+        size_t header_end = buffer.find("\r\n\r\n");
+        if (header_end != std::string::npos) {
+            size_t length_pos = buffer.find("Content-Length: ");
+            size_t length = length_pos < header_end ? std::strtoul(buffer.c_str() + length_pos + 16, nullptr, 10) : 0;
+            if (buffer.size() >= header_end + 4 + length) {
+                HttpResponse response;
+                response.status = std::atoi(buffer.c_str() + 9);
+                response.body = buffer.substr(header_end + 4, length);
+                responses.push_back(response);
+                buffer.erase(0, header_end + 4 + length);
+                continue;
+            }
+        }
+
+        int remaining = static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            deadline - std::chrono::steady_clock::now()).count());
+        pollfd pfd{fd, POLLIN, 0};
+        if (remaining <= 0 || poll(&pfd, 1, remaining) <= 0) {
+            break;
+        }
+        char chunk[4096];
+        ssize_t bytes = recv(fd, chunk, sizeof(chunk), 0);
+        if (bytes <= 0) {
+            if (closed) {
+                *closed = true;
+            }
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(bytes));
+    }
+    return responses;
+}
+
+bool waitForClose(int fd, int timeout_ms) {
+    pollfd pfd{fd, POLLIN, 0};
+    char chunk[4096];
+    while (poll(&pfd, 1, timeout_ms) > 0) {
+        ssize_t bytes = recv(fd, chunk, sizeof(chunk), 0);
+        if (bytes <= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void testSplitHeaders() {
+    TestServer server;
+    EXPECT_TRUE(server.started());
+    int fd = connectTo(server.port());
+    EXPECT_TRUE(fd >= 0);
+
+    // 在请求行、头部名称、\r\n\r\n中间和请求体中间断开，每段单独到达
+    std::string request = postRequest("{\"split\":true}");
+    const size_t cuts[] = {4, 20, 40, request.find("\r\n\r\n") + 1, request.find("\r\n\r\n") + 3, request.size() - 3};
+    size_t offset = 0;
+    for (size_t cut : cuts) {
+        sendAll(fd, request.substr(offset, cut - offset));
+        offset = cut;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    sendAll(fd, request.substr(offset));
+
+    auto responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].status, 200);
+        EXPECT_EQ(responses[0].body, std::string("{\"split\":true}"));
+    }
+
+    // 逐字节发送的请求在同一连接上同样能被解析
+    std::string byte_request = postRequest("bytes");
+    for (char c : byte_request) {
+        sendAll(fd, std::string(1, c));
+    }
+    responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].body, std::string("bytes"));
+    }
+    close(fd);
+}
+
+void testOversizedRequests() {
+    TestServer server;
+
+    // Content-Length超过1MB：413后关闭连接，不等待请求体
+    int fd = connectTo(server.port());
+    sendAll(fd, "POST /mcp HTTP/1.1\r\nContent-Length: 2000000\r\n\r\n");
+    bool closed = false;
+    auto responses = readResponses(fd, 1, 2000, &closed);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].status, 413);
+    }
+    EXPECT_TRUE(waitForClose(fd, 2000));
+    close(fd);
+
+    // 请求头超过8KB仍未结束：431
+    fd = connectTo(server.port());
+    sendAll(fd, "POST /mcp HTTP/1.1\r\nX-Padding: " + std::string(9000, 'a'));
+    responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].status, 431);
+    }
+    EXPECT_TRUE(waitForClose(fd, 2000));
+    close(fd);
+
+    // 不支持分块传输：501
+    fd = connectTo(server.port());
+    sendAll(fd, "POST /mcp HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n0\r\n\r\n");
+    responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].status, 501);
+    }
+    close(fd);
+}
+
+void testPipelinedOrdering() {
+    TestServer server;
+    int fd = connectTo(server.port());
+
+    // 一次写入多个请求，处理函数按相反顺序完成，响应仍须按请求顺序返回
+    std::string batch;
+    for (int i = 1; i <= 5; ++i) {
+        batch += postRequest(std::to_string(i));
+    }
+    // 夹在异步请求中间的同步应答也要排队
+    batch += postRequest("sync");
+    batch += "GET /mcp HTTP/1.1\r\n\r\n";
+    sendAll(fd, batch);
+
+    auto responses = readResponses(fd, 7, 3000);
+    EXPECT_EQ(responses.size(), 7u);
+    if (responses.size() == 7) {
+        for (int i = 0; i < 5; ++i) {
+            EXPECT_EQ(responses[i].status, 200);
+            EXPECT_EQ(responses[i].body, std::to_string(i + 1));
+        }
+        EXPECT_EQ(responses[5].body, std::string("sync"));
+        EXPECT_EQ(responses[6].status, 405);
+    }
+
+    // Connection: close的请求应答后关闭，之后流水线发来的请求被丢弃
+    sendAll(fd, postRequest("last", "Connection: close\r\n") + postRequest("dropped"));
+    bool closed = false;
+    responses = readResponses(fd, 2, 2000, &closed);
+    EXPECT_EQ(responses.size(), 1u);
+    EXPECT_TRUE(closed);
+    close(fd);
+}
+
+void testStalledRequestTimeout() {
+    McpTransportOptions options;
+    options.request_timeout_ms = 200;
+    options.idle_timeout_ms = 0;
+    TestServer server(options);
+
+    // 请求头迟迟收不全：到期后回复408并关闭连接
+    int fd = connectTo(server.port());
+    sendAll(fd, "POST /mcp HTTP/1.1\r\nHost: loc");
+    auto responses = readResponses(fd, 1, 3000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].status, 408);
+    }
+    EXPECT_TRUE(waitForClose(fd, 2000));
+    close(fd);
+
+    // 没有未收全请求的keep-alive连接不受请求期限影响
+    fd = connectTo(server.port());
+    sendAll(fd, postRequest("alive"));
+    responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1500));
+    sendAll(fd, postRequest("again"));
+    responses = readResponses(fd, 1, 2000);
+    EXPECT_EQ(responses.size(), 1u);
+    if (responses.size() == 1) {
+        EXPECT_EQ(responses[0].body, std::string("again"));
+    }
+    close(fd);
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(testSplitHeaders);
+    RUN_TEST(testOversizedRequests);
+    RUN_TEST(testPipelinedOrdering);
+    RUN_TEST(testStalledRequestTimeout);
+    return test::finish();
+}
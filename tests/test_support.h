@@ -0,0 +1,59 @@
+// 行为测试的最小断言工具：每个测试文件编译成一个独立的可执行文件，由ctest运行。
+// 断言失败时打印位置和实际值后继续执行，finish()返回非0表示有断言失败
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace xiaozhi {
+namespace test {
+
+inline int& failureCount() {
+    static int count = 0;
+    return count;
+}
+
+inline void reportFailure(const char* file, int line, const std::string& message) {
+    ++failureCount();
+    std::cerr << file << ":" << line << ": 失败: " << message << std::endl;
+}
+
+template <typename A, typename B>
+void expectEqual(const A& actual, const B& expected, const char* actual_text, const char* expected_text,
+                 const char* file, int line) {
+    if (!(actual == expected)) {
+        std::ostringstream message;
+        message << actual_text << " == " << expected_text << "\n  实际值: " << actual
+                << "\n  期望值: " << expected;
+        reportFailure(file, line, message.str());
+    }
+}
+
+inline int finish() {
+    if (failureCount() == 0) {
+        std::cout << "全部通过" << std::endl;
+        return 0;
+    }
+    std::cerr << failureCount() << " 个断言失败" << std::endl;
+    return 1;
+}
+
+} // namespace test
+} // namespace xiaozhi
+
+#define EXPECT_TRUE(cond)                                                       \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            ::xiaozhi::test::reportFailure(__FILE__, __LINE__, #cond);          \
+        }                                                                       \
+    } while (0)
+
+#define EXPECT_EQ(actual, expected) \
+    ::xiaozhi::test::expectEqual((actual), (expected), #actual, #expected, __FILE__, __LINE__)
+
+#define RUN_TEST(fn)                                            \
+    do {                                                        \
+        std::cout << "[ RUN ] " << #fn << std::endl;            \
+        fn();                                                   \
+    } while (0)
@@ -0,0 +1,175 @@
+// ToolSchema参数校验的行为测试：嵌套路径、enum、取值范围、必填字段和参数定义本身的错误
+#include "test_support.h"
+#include "mcp/tool_schema.h"
+#include <string>
+#include <vector>
+#include <json-c/json.h>
+
+using namespace xiaozhi;
+
+namespace {
+
+ToolParameter param(const std::string& name, const std::string& type, bool required = false) {
+    ToolParameter parameter;
+    parameter.name = name;
+    parameter.type = type;
+    parameter.required = required;
+    return parameter;
+}
+
+// 播放列表工具的参数：顶层必填volume(integer 0~100)和mode(enum)，
+// tracks为对象数组，每个元素必填title，可选gain(number -12~12)和meta.lang(enum)
+std::vector<ToolParameter> playlistParameters() {
+    ToolParameter volume = param("volume", "integer", true);
+    volume.minimum = 0;
+    volume.maximum = 100;
+
+    ToolParameter mode = param("mode", "string", true);
+    mode.enum_values = {"shuffle", "repeat", "once"};
+
+    ToolParameter lang = param("lang", "string");
+    lang.enum_values = {"zh", "en"};
+    ToolParameter meta = param("meta", "object");
+    meta.properties = {lang};
+
+    ToolParameter gain = param("gain", "number");
+    gain.minimum = -12;
+    gain.maximum = 12;
+
+    ToolParameter track = param("", "object");
+    track.properties = {param("title", "string", true), gain, meta};
+    ToolParameter tracks = param("tracks", "array");
+    tracks.items = {track};
+
+    return {volume, mode, tracks, param("note", "")};
+}
+
+// 解析JSON并校验，返回错误信息，通过时返回空串
+std::string validate(const ToolSchema& schema, const char* json) {
+    ToolValue arguments = ToolValue::adopt(json_tokener_parse(json));
+    std::string error;
+    if (schema.validate(arguments, &error)) {
+        return "";
+    }
+    return error;
+}
+
+void testValidArguments() {
+    std::string error;
+    auto schema = ToolSchema::compile(playlistParameters(), &error);
+    EXPECT_TRUE(schema != nullptr);
+    if (!schema) {
+        return;
+    }
+    EXPECT_EQ(validate(*schema, R"({"volume":50,"mode":"once"})"), std::string());
+    EXPECT_EQ(validate(*schema,
+                       R"({"volume":0,"mode":"repeat","note":[1,"x"],"extra":true,)"
+                       R"("tracks":[{"title":"a"},{"title":"b","gain":-12,"meta":{"lang":"en"}}]})"),
+              std::string());
+    // 边界值属于闭区间，整数值的浮点数也算integer
+    EXPECT_EQ(validate(*schema, R"({"volume":100.0,"mode":"shuffle","tracks":[{"title":"c","gain":12}]})"),
+              std::string());
+}
+
+void testNestedPaths() {
+    auto schema = ToolSchema::compile(playlistParameters());
+    if (!schema) {
+        EXPECT_TRUE(schema != nullptr);
+        return;
+    }
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":[{"title":"a"},{"title":3}]})"),
+              std::string("arguments.tracks[1].title: expected string"));
+    EXPECT_EQ(validate(*schema,
+                       R"({"volume":1,"mode":"once","tracks":[{"title":"a","meta":{"lang":"fr"}}]})"),
+              std::string("arguments.tracks[0].meta.lang: value is not one of the allowed values"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":{"title":"a"}})"),
+              std::string("arguments.tracks: expected array"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":["a"]})"),
+              std::string("arguments.tracks[0]: expected object"));
+    EXPECT_EQ(validate(*schema, R"([1,2])"), std::string("arguments: expected object"));
+}
+
+void testEnum() {
+    auto schema = ToolSchema::compile(playlistParameters());
+    if (!schema) {
+        EXPECT_TRUE(schema != nullptr);
+        return;
+    }
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"loop"})"),
+              std::string("arguments.mode: value is not one of the allowed values"));
+    // 大小写敏感
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"Once"})"),
+              std::string("arguments.mode: value is not one of the allowed values"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":1})"), std::string("arguments.mode: expected string"));
+}
+
+void testRange() {
+    auto schema = ToolSchema::compile(playlistParameters());
+    if (!schema) {
+        EXPECT_TRUE(schema != nullptr);
+        return;
+    }
+    EXPECT_EQ(validate(*schema, R"({"volume":101,"mode":"once"})"), std::string("arguments.volume: must be <= 100"));
+    EXPECT_EQ(validate(*schema, R"({"volume":-1,"mode":"once"})"), std::string("arguments.volume: must be >= 0"));
+    EXPECT_EQ(validate(*schema, R"({"volume":50.5,"mode":"once"})"), std::string("arguments.volume: expected integer"));
+    EXPECT_EQ(validate(*schema, R"({"volume":"50","mode":"once"})"), std::string("arguments.volume: expected integer"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":[{"title":"a","gain":12.5}]})"),
+              std::string("arguments.tracks[0].gain: must be <= 12"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":[{"title":"a","gain":-12.01}]})"),
+              std::string("arguments.tracks[0].gain: must be >= -12"));
+}
+
+void testMissingRequired() {
+    auto schema = ToolSchema::compile(playlistParameters());
+    if (!schema) {
+        EXPECT_TRUE(schema != nullptr);
+        return;
+    }
+    EXPECT_EQ(validate(*schema, R"({"mode":"once"})"), std::string("arguments.volume: missing required field"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1})"), std::string("arguments.mode: missing required field"));
+    EXPECT_EQ(validate(*schema, R"({"volume":1,"mode":"once","tracks":[{"gain":1}]})"),
+              std::string("arguments.tracks[0].title: missing required field"));
+    // null不算提供了必填字段
+    EXPECT_EQ(validate(*schema, R"({"volume":null,"mode":"once"})").empty(), false);
+
+    // 不存在的参数对象视为空对象：有必填字段时失败（按字段名顺序报告第一个），没有时通过
+    std::string error;
+    EXPECT_EQ(schema->validate(ToolValue(), &error), false);
+    EXPECT_EQ(error, std::string("arguments.mode: missing required field"));
+    auto optional_only = ToolSchema::compile({param("note", "string")});
+    EXPECT_TRUE(optional_only && optional_only->validate(ToolValue()));
+}
+
+void testInvalidDefinitions() {
+    std::string error;
+    EXPECT_TRUE(ToolSchema::compile({param("x", "float")}, &error) == nullptr);
+    EXPECT_EQ(error, std::string("arguments.x: unknown type 'float'"));
+
+    ToolParameter enum_on_integer = param("x", "integer");
+    enum_on_integer.enum_values = {"1"};
+    EXPECT_TRUE(ToolSchema::compile({enum_on_integer}, &error) == nullptr);
+    EXPECT_EQ(error, std::string("arguments.x: enum is only supported for string"));
+
+    ToolParameter reversed = param("x", "number");
+    reversed.minimum = 2;
+    reversed.maximum = 1;
+    EXPECT_TRUE(ToolSchema::compile({reversed}, &error) == nullptr);
+    EXPECT_EQ(error, std::string("arguments.x: minimum is greater than maximum"));
+
+    ToolParameter nested = param("outer", "object");
+    nested.properties = {param("a", "string"), param("a", "string")};
+    EXPECT_TRUE(ToolSchema::compile({nested}, &error) == nullptr);
+    EXPECT_EQ(error, std::string("arguments.outer.a: duplicate field"));
+}
+
+} // namespace
+
+int main() {
+    RUN_TEST(testValidArguments);
+    RUN_TEST(testNestedPaths);
+    RUN_TEST(testEnum);
+    RUN_TEST(testRange);
+    RUN_TEST(testMissingRequired);
+    RUN_TEST(testInvalidDefinitions);
+    return test::finish();
+}
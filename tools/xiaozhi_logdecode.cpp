@@ -0,0 +1,116 @@
+#include "utils/binary_log.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+using namespace xiaozhi;
+
+namespace {
+
+const char* kLevelNames[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+
+int parseLevel(const std::string& text) {
+    for (int i = 0; i < 4; ++i) {
+        if (text == kLevelNames[i]) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 与文本日志相同的行格式: "YYYY-mm-dd HH:MM:SS.mmm [LEVEL] 函数: 消息"
+void printEvent(const BinaryLogEvent& event, bool with_location) {
+    time_t second = static_cast<time_t>(event.timestamp_ns / 1000000000);
+    int millis = static_cast<int>(event.timestamp_ns / 1000000 % 1000);
+    struct tm local_time;
+    localtime_r(&second, &local_time);
+    char time_text[32];
+    strftime(time_text, sizeof(time_text), "%Y-%m-%d %H:%M:%S", &local_time);
+
+    std::string line = time_text;
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%03d [%s] ", millis,
+             event.level < 4 ? kLevelNames[event.level] : "UNKNOWN");
+    line += suffix;
+    if (event.format && with_location && !event.format->file.empty()) {
+        line += event.format->file + ":" + std::to_string(event.format->line) + " ";
+    }
+    if (event.format && !event.format->function.empty()) {
+        line += event.format->function + ": ";
+    }
+    line += event.message;
+    std::cout << line << '\n';
+}
+
+// 按从旧到新的顺序列出path及其轮转文件path.N ... path.1
+std::vector<std::string> expandRotated(const std::string& path) {
+    std::vector<std::string> files;
+    for (int i = 1; access((path + "." + std::to_string(i)).c_str(), F_OK) == 0; ++i) {
+        files.insert(files.begin(), path + "." + std::to_string(i));
+    }
+    files.push_back(path);
+    return files;
+}
+
+void printUsage(const char* program) {
+    std::cout << "用法: " << program << " [选项] <日志文件>..." << std::endl;
+    std::cout << "  --level <LEVEL>    只输出该级别及以上的记录 (DEBUG/INFO/WARN/ERROR)" << std::endl;
+    std::cout << "  --location         在每行前输出源文件和行号" << std::endl;
+    std::cout << "  --single           只解码给定文件，不自动包含轮转出的 .1 .2 ... 文件" << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int min_level = 0;
+    bool with_location = false;
+    bool single = false;
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--level" && i + 1 < argc) {
+            min_level = parseLevel(argv[++i]);
+            if (min_level < 0) {
+                std::cerr << "未知的日志级别: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (arg == "--location") {
+            with_location = true;
+        } else if (arg == "--single") {
+            single = true;
+        } else if (arg == "--help" || arg == "-h") {
+            printUsage(argv[0]);
+            return 0;
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::cerr << "未知选项: " << arg << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.empty()) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (const auto& path : paths) {
+        std::vector<std::string> files = single ? std::vector<std::string>{path} : expandRotated(path);
+        for (const auto& file : files) {
+            ok = readBinaryLog(file, [&](const BinaryLogEvent& event) {
+                if (event.level >= min_level) {
+                    printEvent(event, with_location);
+                }
+            }) && ok;
+        }
+    }
+    std::cout.flush();
+    return ok ? 0 : 1;
+}